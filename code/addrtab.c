@@ -0,0 +1,618 @@
+/* addrtab.c: ADDRESS-KEYED HASH TABLES
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: An address table maps the addresses of objects to values,
+ * hashing on the address, and stays valid when a moving pool moves the
+ * keys.  Only the entries whose keys actually moved are rehashed, and
+ * that rehashing is spread over subsequent operations on the table.
+ *
+ * .design: <design/addrtab/>.
+ */
+
+#include "addrtab.h"
+#include "mpm.h"
+
+SRCID(addrtab, "$Id$");
+
+
+/* AddrTabSTEP -- number of logged entries rehashed per operation
+ *
+ * <design/addrtab/#log.step>.
+ */
+
+#define AddrTabSTEP ((Count)4)
+
+#define entryOfRing(node) RING_ELT(AddrTabEntry, ring, node)
+
+/* addrTabLogged -- is a live entry on a log? */
+
+#define addrTabLogged(e) (!RingIsSingle(&(e)->ring))
+
+/* addrTabLogIndex -- the log for entries with a given key
+ *
+ * Mixes some address bits above the object alignment, so that the keys
+ * of consecutive objects are spread across the logs.
+ */
+
+#define addrTabLogIndex(key) \
+  ((Index)(((Word)(key) >> 3 ^ (Word)(key) >> 9) & (AddrTabLOGS - 1)))
+
+
+/* AddrTabCheck -- check an address table */
+
+Bool AddrTabCheck(AddrTab tab)
+{
+  CHECKS(AddrTab, tab);
+  CHECKU(Arena, tab->arena);
+  CHECKL(RootCheck(tab->root));
+  CHECKD(Table, tab->index);
+  CHECKD_NOSIG(Ring, &tab->chunkRing);
+  CHECKD_NOSIG(Ring, &tab->freeRing);
+  CHECKL(tab->logCount <= tab->count);
+  CHECKL(tab->logNext < AddrTabLOGS);
+  /* The logs are too many to check each time. */
+  return TRUE;
+}
+
+
+/* addrTabLog -- put an entry on the log for its key
+ *
+ * Called when an entry's key may no longer match the address it is
+ * indexed under. <design/addrtab/#log.invariant>.
+ */
+
+static void addrTabLog(AddrTab tab, AddrTabEntry e)
+{
+  AVER(e->key != NULL);
+  AVER(!addrTabLogged(e));
+  RingAppend(&tab->logs[addrTabLogIndex(e->key)], &e->ring);
+  ++tab->logCount;
+}
+
+
+/* addrTabUnlog -- take an entry off its log */
+
+static void addrTabUnlog(AddrTab tab, AddrTabEntry e)
+{
+  AVER(addrTabLogged(e));
+  AVER(tab->logCount > 0);
+  RingRemove(&e->ring);
+  --tab->logCount;
+}
+
+
+/* addrTabScan -- scan the keys and values of a table
+ *
+ * This is the scanning function for the table's root, which is
+ * scanned at each flip. A key that is fixed to a different address
+ * puts its entry on the log for the new address.
+ * <design/addrtab/#root>.
+ */
+
+static mps_res_t addrTabScan(mps_ss_t mps_ss, void *p, size_t s)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  AddrTab tab = p;
+  Ring node, nextNode;
+  Res res;
+
+  AVERT(ScanState, ss);
+  AVERT(AddrTab, tab);
+  UNUSED(s);
+
+  TRACE_SCAN_BEGIN(ss) {
+    RING_FOR(node, &tab->chunkRing, nextNode) {
+      AddrTabChunk chunk = RING_ELT(AddrTabChunk, chunkRing, node);
+      Index i;
+      for (i = 0; i < AddrTabChunkENTRIES; ++i) {
+        AddrTabEntry e = &chunk->entries[i];
+        if (e->key == NULL)
+          continue;
+        if (TRACE_FIX1(ss, e->key)) {
+          Addr old = e->key;
+          res = TRACE_FIX2(ss, &e->key);
+          if (res != ResOK)
+            return res;
+          AVER(e->key != NULL); /* fixed at rank EXACT */
+          if (e->key != old) {
+            if (addrTabLogged(e))
+              addrTabUnlog(tab, e);
+            addrTabLog(tab, e);
+          }
+        }
+        if (TRACE_FIX1(ss, e->value)) {
+          res = TRACE_FIX2(ss, &e->value);
+          if (res != ResOK)
+            return res;
+        }
+      }
+    }
+  } TRACE_SCAN_END(ss);
+
+  return ResOK;
+}
+
+
+/* Index allocation, using the control pool */
+
+static void *addrTabIndexAlloc(void *closure, size_t size)
+{
+  void *p;
+  Res res;
+
+  res = ControlAlloc(&p, (Arena)closure, size);
+  if (res != ResOK)
+    return NULL;
+  return p;
+}
+
+static void addrTabIndexFree(void *closure, void *p, size_t size)
+{
+  ControlFree((Arena)closure, p, size);
+}
+
+
+/* addrTabIndex -- index an entry under its key
+ *
+ * If a stale entry is indexed under the same address, it is evicted.
+ * Its key has moved away, so it is logged and will be indexed under
+ * its new address when it is rehashed.
+ */
+
+static Res addrTabIndex(AddrTab tab, AddrTabEntry e)
+{
+  TableValue value;
+  Res res;
+
+  AVER(e->key != NULL);
+  AVER(e->hashed == NULL);
+
+  if (TableLookup(&value, tab->index, (TableKey)e->key)) {
+    AddrTabEntry stale = value;
+    AVER(stale != e);
+    AVER(stale->hashed == e->key);
+    AVER(stale->key != e->key);
+    AVER(addrTabLogged(stale));
+    stale->hashed = NULL;
+    res = TableRedefine(tab->index, (TableKey)e->key, e);
+    AVER(res == ResOK);
+  } else {
+    res = TableDefine(tab->index, (TableKey)e->key, e);
+    if (res != ResOK)
+      return res;
+  }
+  e->hashed = e->key;
+  return ResOK;
+}
+
+
+/* addrTabUnindex -- remove an entry from the index */
+
+static void addrTabUnindex(AddrTab tab, AddrTabEntry e)
+{
+  if (e->hashed != NULL) {
+    Res res = TableRemove(tab->index, (TableKey)e->hashed);
+    AVER(res == ResOK);
+    UNUSED(res);
+    ++tab->removed;
+    e->hashed = NULL;
+  }
+}
+
+
+/* addrTabRehash -- take an entry off its log and index it afresh
+ *
+ * If the index can't be extended, the entry goes back on the end of
+ * its log.
+ */
+
+static Res addrTabRehash(AddrTab tab, AddrTabEntry e)
+{
+  Res res;
+
+  AVER(e->key != NULL);
+
+  addrTabUnlog(tab, e);
+  if (e->hashed != e->key) {
+    addrTabUnindex(tab, e);
+    res = addrTabIndex(tab, e);
+    if (res != ResOK) {
+      addrTabLog(tab, e);
+      return res;
+    }
+  }
+  return ResOK;
+}
+
+
+/* addrTabDrain -- rehash every entry on one log */
+
+static Res addrTabDrain(AddrTab tab, Ring log)
+{
+  while (!RingIsSingle(log)) {
+    Res res = addrTabRehash(tab, entryOfRing(RingNext(log)));
+    if (res != ResOK)
+      return res;
+  }
+  return ResOK;
+}
+
+
+/* addrTabCompact -- rebuild the index without its deleted slots
+ *
+ * <design/addrtab/#index.compact>. If there isn't enough memory, the
+ * old index remains in use.
+ */
+
+static void addrTabCompact(AddrTab tab)
+{
+  Table index;
+  Ring node, nextNode;
+  Res res;
+
+  res = TableCreate(&index, tab->count + 1, addrTabIndexAlloc,
+                    addrTabIndexFree, tab->arena, (TableKey)0, (TableKey)1);
+  if (res != ResOK)
+    return;
+
+  RING_FOR(node, &tab->chunkRing, nextNode) {
+    AddrTabChunk chunk = RING_ELT(AddrTabChunk, chunkRing, node);
+    Index i;
+    for (i = 0; i < AddrTabChunkENTRIES; ++i) {
+      AddrTabEntry e = &chunk->entries[i];
+      if (e->hashed != NULL) {
+        res = TableDefine(index, (TableKey)e->hashed, e);
+        if (res != ResOK) {
+          TableDestroy(index);
+          return;
+        }
+      }
+    }
+  }
+
+  TableDestroy(tab->index);
+  tab->index = index;
+  tab->removed = 0;
+}
+
+
+/* addrTabStep -- do a bounded amount of maintenance
+ *
+ * Called at the start of each operation on the table. The logs are
+ * visited in turn. A failure to rehash leaves the entry on its log,
+ * where addrTabFind will still find it.
+ */
+
+static void addrTabStep(AddrTab tab)
+{
+  Count done = 0;
+
+  while (done < AddrTabSTEP && tab->logCount > 0) {
+    Ring log = &tab->logs[tab->logNext];
+    if (RingIsSingle(log)) {
+      tab->logNext = (tab->logNext + 1) % AddrTabLOGS;
+      continue;
+    }
+    if (addrTabRehash(tab, entryOfRing(RingNext(log))) != ResOK)
+      break;
+    ++done;
+  }
+
+  if (tab->removed > tab->index->length / 4)
+    addrTabCompact(tab);
+}
+
+
+/* addrTabSearch -- find an entry by exhaustive search
+ *
+ * Only used when the index can't be brought up to date.
+ */
+
+static AddrTabEntry addrTabSearch(AddrTab tab, Addr key)
+{
+  Ring node, nextNode;
+
+  RING_FOR(node, &tab->chunkRing, nextNode) {
+    AddrTabChunk chunk = RING_ELT(AddrTabChunk, chunkRing, node);
+    Index i;
+    for (i = 0; i < AddrTabChunkENTRIES; ++i)
+      if (chunk->entries[i].key == key)
+        return &chunk->entries[i];
+  }
+  return NULL;
+}
+
+
+/* addrTabFind -- find the live entry for a key, or NULL
+ *
+ * <design/addrtab/#lookup>.
+ */
+
+static AddrTabEntry addrTabFind(AddrTab tab, Addr key)
+{
+  Ring log = &tab->logs[addrTabLogIndex(key)];
+  TableValue value;
+
+  for (;;) {
+    if (TableLookup(&value, tab->index, (TableKey)key)) {
+      AddrTabEntry e = value;
+      if (e->key == key)
+        return e;
+      /* <design/addrtab/#lookup.stale> */
+      if (addrTabRehash(tab, e) != ResOK)
+        break;
+    } else if (RingIsSingle(log)) {
+      /* <design/addrtab/#lookup.miss> */
+      return NULL;
+    } else if (addrTabDrain(tab, log) != ResOK) {
+      break;
+    }
+  }
+
+  return addrTabSearch(tab, key);
+}
+
+
+/* addrTabChunkCreate -- add a chunk of free entries to a table */
+
+static Res addrTabChunkCreate(AddrTab tab)
+{
+  AddrTabChunk chunk;
+  void *p;
+  Index i;
+  Res res;
+
+  res = ControlAlloc(&p, tab->arena, sizeof(AddrTabChunkStruct));
+  if (res != ResOK)
+    return res;
+  chunk = p;
+
+  for (i = 0; i < AddrTabChunkENTRIES; ++i) {
+    AddrTabEntry e = &chunk->entries[i];
+    e->key = NULL;
+    e->value = NULL;
+    e->hashed = NULL;
+    RingInit(&e->ring);
+    RingAppend(&tab->freeRing, &e->ring);
+  }
+  RingInit(&chunk->chunkRing);
+  RingAppend(&tab->chunkRing, &chunk->chunkRing);
+
+  return ResOK;
+}
+
+
+/* AddrTabCreate -- create an address table */
+
+Res AddrTabCreate(AddrTab *tabReturn, Arena arena)
+{
+  AddrTab tab;
+  void *p;
+  Index i;
+  Res res;
+
+  AVER(tabReturn != NULL);
+  AVERT(Arena, arena);
+
+  res = ControlAlloc(&p, arena, sizeof(AddrTabStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  tab = p;
+
+  /* The table keys exclude 0 and 1, neither of which can be the
+     address of an object in the arena. */
+  res = TableCreate(&tab->index, AddrTabChunkENTRIES, addrTabIndexAlloc,
+                    addrTabIndexFree, arena, (TableKey)0, (TableKey)1);
+  if (res != ResOK)
+    goto failTable;
+
+  tab->arena = arena;
+  tab->removed = 0;
+  tab->count = 0;
+  RingInit(&tab->chunkRing);
+  RingInit(&tab->freeRing);
+  tab->logCount = 0;
+  tab->logNext = 0;
+  for (i = 0; i < AddrTabLOGS; ++i)
+    RingInit(&tab->logs[i]);
+  tab->sig = AddrTabSig;
+
+  res = RootCreateFun(&tab->root, arena, RankEXACT, addrTabScan, tab, 0);
+  if (res != ResOK)
+    goto failRoot;
+
+  AVERT(AddrTab, tab);
+  *tabReturn = tab;
+  return ResOK;
+
+failRoot:
+  tab->sig = SigInvalid;
+  for (i = 0; i < AddrTabLOGS; ++i)
+    RingFinish(&tab->logs[i]);
+  RingFinish(&tab->freeRing);
+  RingFinish(&tab->chunkRing);
+  TableDestroy(tab->index);
+failTable:
+  ControlFree(arena, tab, sizeof(AddrTabStruct));
+failAlloc:
+  return res;
+}
+
+
+/* AddrTabDestroy -- destroy an address table */
+
+void AddrTabDestroy(AddrTab tab)
+{
+  Arena arena;
+  Ring node, nextNode;
+  Index i;
+
+  AVERT(AddrTab, tab);
+  arena = tab->arena;
+
+  RootDestroy(tab->root);
+  TableDestroy(tab->index);
+
+  RING_FOR(node, &tab->chunkRing, nextNode) {
+    AddrTabChunk chunk = RING_ELT(AddrTabChunk, chunkRing, node);
+    for (i = 0; i < AddrTabChunkENTRIES; ++i) {
+      AddrTabEntry e = &chunk->entries[i];
+      if (!RingIsSingle(&e->ring))
+        RingRemove(&e->ring);
+      RingFinish(&e->ring);
+    }
+    RingRemove(&chunk->chunkRing);
+    RingFinish(&chunk->chunkRing);
+    ControlFree(arena, chunk, sizeof(AddrTabChunkStruct));
+  }
+
+  tab->sig = SigInvalid;
+  for (i = 0; i < AddrTabLOGS; ++i)
+    RingFinish(&tab->logs[i]);
+  RingFinish(&tab->freeRing);
+  RingFinish(&tab->chunkRing);
+  ControlFree(arena, tab, sizeof(AddrTabStruct));
+}
+
+
+/* AddrTabLookup -- look up the value associated with a key */
+
+Bool AddrTabLookup(Addr *valueReturn, AddrTab tab, Addr key)
+{
+  AddrTabEntry e;
+
+  AVER(valueReturn != NULL);
+  AVERT(AddrTab, tab);
+  AVER(key != NULL);
+
+  addrTabStep(tab);
+  e = addrTabFind(tab, key);
+  if (e == NULL)
+    return FALSE;
+  *valueReturn = e->value;
+  return TRUE;
+}
+
+
+/* AddrTabDefine -- associate a value with a key
+ *
+ * Replaces the value if the key is already in the table.
+ */
+
+Res AddrTabDefine(AddrTab tab, Addr key, Addr value)
+{
+  AddrTabEntry e;
+  Res res;
+
+  AVERT(AddrTab, tab);
+  AVER(key != NULL);
+  AVER(key != (Addr)1);
+
+  addrTabStep(tab);
+  e = addrTabFind(tab, key);
+  if (e != NULL) {
+    e->value = value;
+    return ResOK;
+  }
+
+  if (RingIsSingle(&tab->freeRing)) {
+    res = addrTabChunkCreate(tab);
+    if (res != ResOK)
+      return res;
+  }
+  e = entryOfRing(RingNext(&tab->freeRing));
+  RingRemove(&e->ring);
+  AVER(e->key == NULL);
+  AVER(e->hashed == NULL);
+
+  e->key = key;
+  e->value = value;
+  res = addrTabIndex(tab, e);
+  if (res != ResOK) {
+    e->key = NULL;
+    e->value = NULL;
+    RingAppend(&tab->freeRing, &e->ring);
+    return res;
+  }
+  ++tab->count;
+  return ResOK;
+}
+
+
+/* AddrTabRemove -- remove a key and its value from a table */
+
+Bool AddrTabRemove(AddrTab tab, Addr key)
+{
+  AddrTabEntry e;
+
+  AVERT(AddrTab, tab);
+  AVER(key != NULL);
+
+  addrTabStep(tab);
+  e = addrTabFind(tab, key);
+  if (e == NULL)
+    return FALSE;
+
+  addrTabUnindex(tab, e);
+  if (addrTabLogged(e))
+    addrTabUnlog(tab, e);
+  e->key = NULL;
+  e->value = NULL;
+  RingAppend(&tab->freeRing, &e->ring);
+  AVER(tab->count > 0);
+  --tab->count;
+  return TRUE;
+}
+
+
+/* AddrTabCount -- return the number of keys in a table */
+
+Count AddrTabCount(AddrTab tab)
+{
+  AVERT(AddrTab, tab);
+  return tab->count;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,131 @@
+/* addrtab.h: ADDRESS-KEYED HASH TABLES INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * See <design/addrtab/>.
+ */
+
+#ifndef addrtab_h
+#define addrtab_h
+
+#include "mpmtypes.h"
+#include "mpm.h"
+#include "ring.h"
+#include "table.h"
+
+
+/* AddrTabEntry -- one association in an address table
+ *
+ * A free entry has a NULL key and is on the table's free ring. A live
+ * entry is "logged" if it is on one of the table's logs, which it must
+ * be whenever its key differs from the address it is indexed under.
+ * <design/addrtab/#log.invariant>.
+ */
+
+typedef struct AddrTabEntryStruct *AddrTabEntry;
+
+typedef struct AddrTabEntryStruct {
+  Addr key;             /* current address of the key, or NULL if free */
+  Addr value;           /* value associated with the key */
+  Addr hashed;          /* address indexed under, or NULL if unindexed */
+  RingStruct ring;      /* link in a log or the free ring */
+} AddrTabEntryStruct;
+
+
+/* AddrTabChunk -- a block of entries in control memory
+ *
+ * Entries never move, so the index can refer to them directly.
+ */
+
+#define AddrTabChunkENTRIES ((Count)64)
+
+typedef struct AddrTabChunkStruct *AddrTabChunk;
+
+typedef struct AddrTabChunkStruct {
+  RingStruct chunkRing;         /* link in the table's ring of chunks */
+  AddrTabEntryStruct entries[AddrTabChunkENTRIES];
+} AddrTabChunkStruct;
+
+
+/* AddrTab -- an address-keyed hash table
+ *
+ * Logged entries are divided between AddrTabLOGS logs according to a
+ * hash of their current keys. <design/addrtab/#log.partition>.
+ */
+
+#define AddrTabLOGS ((Count)64)
+
+#define AddrTabSig ((Sig)0x519ADD7B) /* SIGnature ADDress TaBle */
+
+typedef struct AddrTabStruct *AddrTab;
+
+typedef struct AddrTabStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  Root root;                    /* exact root for keys and values */
+  Table index;                  /* hashed address to entry */
+  Count removed;                /* index removals since it was built */
+  Count count;                  /* number of live entries */
+  RingStruct chunkRing;         /* ring of chunks of entries */
+  RingStruct freeRing;          /* ring of free entries */
+  Count logCount;               /* number of logged entries */
+  Index logNext;                /* next log for addrTabStep to visit */
+  RingStruct logs[AddrTabLOGS]; /* rings of entries that need rehashing */
+} AddrTabStruct;
+
+#define AddrTabArena(tab) ((tab)->arena)
+
+
+extern Bool AddrTabCheck(AddrTab tab);
+extern Res AddrTabCreate(AddrTab *tabReturn, Arena arena);
+extern void AddrTabDestroy(AddrTab tab);
+extern Bool AddrTabLookup(Addr *valueReturn, AddrTab tab, Addr key);
+extern Res AddrTabDefine(AddrTab tab, Addr key, Addr value);
+extern Bool AddrTabRemove(AddrTab tab, Addr key);
+extern Count AddrTabCount(AddrTab tab);
+
+
+#endif /* addrtab_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,378 @@
+/* addrtabtest.c: ADDRESS TABLE TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Build an address table keyed by moving strings, and use it while
+ * incremental collections are stepped through, checking it against a
+ * model after each operation.  The values are strings that are only
+ * reachable through the table.  See <design/addrtab/>.
+ */
+
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "fmtdy.h"
+#include "testlib.h"
+#include "mpslib.h"
+#include "mps.h"
+#include "mpstd.h"
+
+#include <stdio.h> /* printf */
+#include <string.h> /* strlen */
+
+
+#define testArenaSIZE     ((size_t)64<<20)
+#define KEYS 1000
+#define COLLECTIONS 10
+#define STEPS 100000
+#define OPS 20
+
+#define UNINIT 0x041412ED
+
+#define DYLAN_ALIGN 4 /* depends on value defined in fmtdy.c */
+
+
+/* size_tAlignUp -- align w up to alignment a */
+
+#define size_tAlignUp(w, a) (((w) + (a) - 1) & ~((size_t)(a) - 1))
+
+
+static mps_word_t bogus_class;
+
+static mps_word_t wrapper_wrapper[] = {
+  UNINIT,                       /* wrapper */
+  UNINIT,                       /* class */
+  0,                            /* Extra word */
+  (mps_word_t)4<<2|2,                     /* F */
+  (mps_word_t)2<<(MPS_WORD_WIDTH - 8),    /* V */
+  (mps_word_t)1<<2|1,                     /* VL */
+  1                             /* patterns */
+};
+
+static mps_word_t string_wrapper[] = {
+  UNINIT,                       /* wrapper */
+  UNINIT,                       /* class */
+  0,                            /* extra word */
+  0,                            /* F */
+  (mps_word_t)2<<(MPS_WORD_WIDTH - 8)|(mps_word_t)3<<3|4,   /* V */
+  1                             /* VL */
+};
+
+
+static void initialise_wrapper(mps_word_t *wrapper)
+{
+  wrapper[0] = (mps_word_t)&wrapper_wrapper;
+  wrapper[1] = (mps_word_t)&bogus_class;
+}
+
+
+/* alloc_string -- create a dylan string object
+ *
+ * .assume.dylan-obj
+ */
+
+static mps_word_t *alloc_string(const char *s, mps_ap_t ap)
+{
+  size_t l;
+  size_t objsize;
+  void *p;
+  mps_word_t *object;
+
+  l = strlen(s)+1;
+  objsize = (2 + (l+sizeof(mps_word_t)-1)/sizeof(mps_word_t))
+            * sizeof(mps_word_t);
+  objsize = size_tAlignUp(objsize, DYLAN_ALIGN);
+  do {
+    die(mps_reserve(&p, ap, objsize), "Reserve Leaf\n");
+    object = p;
+    object[0] = (mps_word_t)string_wrapper;
+    object[1] = l << 2 | 1;
+    memcpy(&object[2], s, l);
+  } while(!mps_commit(ap, p, objsize));
+  return object;
+}
+
+
+/* number_text -- write a decimal number into a buffer */
+
+static char *number_text(char *buf, size_t size, size_t n)
+{
+  size_t i = size - 1;
+
+  buf[i] = '\0';
+  do {
+    buf[--i] = (char)('0' + n % 10);
+    n /= 10;
+  } while (n > 0);
+  return &buf[i];
+}
+
+
+/* number_string -- create a string containing a decimal number */
+
+static mps_word_t *number_string(size_t n, mps_ap_t ap)
+{
+  char buf[32];
+  return alloc_string(number_text(buf, sizeof buf, n), ap);
+}
+
+
+/* The keys, in an exact root so that they can move, and a model of
+ * the table's contents. */
+
+static mps_word_t *keys[KEYS];
+static size_t model[KEYS];       /* value number, or 0 if absent */
+static size_t modelCount;
+
+
+typedef struct state_s {
+  mps_arena_t arena;
+  mps_addrtab_t tab;
+  mps_ap_t ap;
+  size_t next;                   /* next value number */
+} state_s, *state_t;
+
+
+/* check_key -- check the table's entry for one key */
+
+static void check_key(state_t state, size_t i)
+{
+  mps_addr_t p;
+  mps_word_t *value;
+  char buf[32];
+  char *expected;
+
+  if (!mps_addrtab_lookup(&p, state->tab, keys[i])) {
+    if (model[i] != 0)
+      error("Key %"PRIuLONGEST" not found.\n", (ulongest_t)i);
+    return;
+  }
+  if (model[i] == 0)
+    error("Removed key %"PRIuLONGEST" found.\n", (ulongest_t)i);
+  value = p;
+  Insist(value[0] == (mps_word_t)string_wrapper);
+  expected = number_text(buf, sizeof buf, model[i]);
+  if (strcmp((char *)&value[2], expected) != 0)
+    error("Key %"PRIuLONGEST" has value \"%s\", expected \"%s\".\n",
+          (ulongest_t)i, (char *)&value[2], expected);
+}
+
+
+/* check -- check the table against the model */
+
+static void check(state_t state)
+{
+  size_t i;
+
+  for (i = 0; i < KEYS; ++i)
+    check_key(state, i);
+  Insist(mps_addrtab_count(state->tab) == modelCount);
+}
+
+
+/* define -- give a key a fresh value */
+
+static void define(state_t state, size_t i)
+{
+  size_t n = state->next++;
+  mps_word_t *value = number_string(n, state->ap);
+  die(mps_addrtab_define(state->tab, keys[i], value), "mps_addrtab_define");
+  if (model[i] == 0)
+    ++modelCount;
+  model[i] = n;
+}
+
+
+/* remove -- remove a key */
+
+static void remove_key(state_t state, size_t i)
+{
+  mps_bool_t b = mps_addrtab_remove(state->tab, keys[i]);
+  if (b != (model[i] != 0))
+    error("mps_addrtab_remove of key %"PRIuLONGEST" returned %d.\n",
+          (ulongest_t)i, b);
+  if (model[i] != 0)
+    --modelCount;
+  model[i] = 0;
+}
+
+
+/* step -- do some random operations on the table
+ *
+ * Newly allocated strings may reuse the addresses of keys that have
+ * moved, so check that they are not found in the table.
+ */
+
+static void step(state_t state)
+{
+  size_t k;
+
+  for (k = 0; k < OPS; ++k) {
+    size_t i = rnd() % KEYS;
+    mps_addr_t p;
+    switch (rnd() % 4) {
+    case 0:
+      define(state, i);
+      break;
+    case 1:
+      remove_key(state, i);
+      break;
+    case 2:
+      check_key(state, i);
+      break;
+    default:
+      if (mps_addrtab_lookup(&p, state->tab,
+                             alloc_string("spong", state->ap)))
+        error("Fresh object found in table.\n");
+      break;
+    }
+  }
+}
+
+
+/* reverse_keys -- reverse the order of the keys and the model */
+
+static void reverse_keys(void)
+{
+  size_t i;
+
+  for (i = 0; i < KEYS / 2; ++i) {
+    size_t j = KEYS - 1 - i;
+    mps_word_t *key = keys[i];
+    size_t n = model[i];
+    keys[i] = keys[j];
+    model[i] = model[j];
+    keys[j] = key;
+    model[j] = n;
+  }
+}
+
+
+static void test(state_t state)
+{
+  mps_arena_t arena = state->arena;
+  size_t i, j;
+
+  for (i = 0; i < KEYS; ++i) {
+    keys[i] = number_string(i, state->ap);
+    if (rnd() % 2 == 0)
+      define(state, i);
+  }
+  check(state);
+
+  /* Use the table while stepping through incremental collections,
+     which move the keys and values. */
+  for (i = 0; i < COLLECTIONS; ++i) {
+    die(mps_arena_start_collect(arena), "mps_arena_start_collect");
+    mps_arena_clamp(arena);
+    for (j = 0; j < STEPS; ++j) {
+      step(state);
+      if (!mps_arena_step(arena, 0.0, 0.0))
+        break;
+    }
+    mps_arena_park(arena);
+    check(state);
+    mps_arena_release(arena);
+  }
+
+  /* Collect twice without using the table, reversing the keys in
+     between so that they are copied in a different order and move
+     onto addresses that other entries are still indexed under. */
+  for (i = 0; i < 2; ++i) {
+    die(mps_arena_collect(arena), "mps_arena_collect");
+    mps_arena_release(arena);
+    reverse_keys();
+  }
+  check(state);
+
+  /* Empty the table. */
+  for (i = 0; i < KEYS; ++i)
+    remove_key(state, i);
+  check(state);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+  mps_pool_t pool;
+  mps_fmt_t fmt;
+  mps_root_t root;
+  state_s state;
+
+  testlib_init(argc, argv);
+
+  initialise_wrapper(wrapper_wrapper);
+  initialise_wrapper(string_wrapper);
+
+  die(mps_arena_create(&arena, mps_arena_class_vm(), testArenaSIZE),
+      "arena_create\n");
+  die(mps_root_create_area(&root, arena, mps_rank_exact(), 0,
+                           keys, keys + KEYS, mps_scan_area, NULL),
+      "Keys Root Create\n");
+  die(mps_fmt_create_A(&fmt, arena, dylan_fmt_A()), "Format Create\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, fmt);
+    die(mps_pool_create_k(&pool, arena, mps_class_amcz(), args),
+        "Pool Create\n");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&state.ap, pool, mps_rank_exact()), "AP Create\n");
+  die(mps_addrtab_create(&state.tab, arena), "mps_addrtab_create");
+  state.arena = arena;
+  state.next = 1;
+
+  test(&state);
+
+  mps_arena_park(arena);
+  mps_addrtab_destroy(state.tab);
+  mps_ap_destroy(state.ap);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(fmt);
+  mps_root_destroy(root);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -48,6 +48,26 @@ static mps_addr_t ambigRoots[ambigRootsCOUNT];
 static size_t scale;            /* Overall scale factor. */
 static unsigned long nCollsStart;
 static unsigned long nCollsDone;
+static unsigned lastPhase = MPS_GC_PHASE_END;
+static unsigned long phaseEnds;
+
+
+/* phaseHook -- check that the collector goes through the phases in order */
+
+static void phaseHook(mps_arena_t a, unsigned phase, void *closure)
+{
+  Insist(a == arena);
+  Insist(closure == &phaseEnds);
+  if (phase == MPS_GC_PHASE_CONDEMN)
+    /* A trace may be abandoned if it has nothing to condemn. */
+    Insist(lastPhase == MPS_GC_PHASE_END
+           || lastPhase == MPS_GC_PHASE_CONDEMN);
+  else
+    Insist(phase == lastPhase + 1);
+  lastPhase = phase;
+  if (phase == MPS_GC_PHASE_END)
+    ++phaseEnds;
+}
 
 
 /* report -- report statistics from any messages */
@@ -69,16 +89,39 @@ static void report(void)
 
     } else if (type == mps_message_type_gc()) {
       size_t live, condemned, not_condemned;
+      size_t i, length, histCount = 0, histSize = 0;
       
       nCollsDone += 1;
       live = mps_message_gc_live_size(arena, message);
       condemned = mps_message_gc_condemned_size(arena, message);
       not_condemned = mps_message_gc_not_condemned_size(arena, message);
 
+      /* The histogram counts every preserved object, and AMC's live
+         size is exact, so they must agree. */
+      length = mps_message_gc_histogram_length(arena, message);
+      for (i = 0; i < length; ++i) {
+        mps_addr_t klass;
+        size_t count, size;
+        mps_message_gc_histogram_entry(arena, message, i,
+                                       &klass, &count, &size);
+        Insist(count > 0);
+        histCount += count;
+        histSize += size;
+      }
+      Insist(histSize == live);
+
       printf("\n  Collection %lu finished:\n", nCollsDone);
       printf("    live %"PRIuLONGEST"\n", (ulongest_t)live);
       printf("    condemned %"PRIuLONGEST"\n", (ulongest_t)condemned);
       printf("    not_condemned %"PRIuLONGEST"\n", (ulongest_t)not_condemned);
+      printf("    histogram: %"PRIuLONGEST" classes, %"PRIuLONGEST
+             " objects\n", (ulongest_t)length, (ulongest_t)histCount);
+      printf("    times: condemn %g flip %g scan %g reclaim %g\n",
+             mps_message_gc_phase_time(arena, message, MPS_GC_PHASE_CONDEMN),
+             mps_message_gc_phase_time(arena, message, MPS_GC_PHASE_FLIP),
+             mps_message_gc_phase_time(arena, message, MPS_GC_PHASE_SCAN),
+             mps_message_gc_phase_time(arena, message, MPS_GC_PHASE_RECLAIM));
+      printf("    max pause %g\n", mps_message_gc_max_pause(arena, message));
       printf("    clock: %"PRIuLONGEST"\n", (ulongest_t)mps_message_clock(arena, message));
       printf("}\n");
     } else {
@@ -288,6 +331,36 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
 
   (void)mps_commit(busy_ap, busy_init, 64);
   mps_arena_park(arena);
+
+  {
+    mps_arena_stats_s stats;
+    mps_arena_stats(arena, &stats);
+    Insist(stats.traces >= collections);
+    Insist(stats.root_scans > 0);
+    Insist(stats.fix_refs >= stats.seg_refs);
+    Insist(stats.seg_refs >= stats.white_seg_refs);
+    Insist(stats.white_seg_refs > 0);
+    Insist(stats.forwarded > 0);
+    Insist(stats.reclaimed_size > 0);
+    Insist(stats.traces == phaseEnds);
+    Insist(lastPhase == MPS_GC_PHASE_END);
+  }
+
+  {
+    mps_gen_stats_s gens[genCOUNT + 1];
+    size_t g, n = mps_pool_gen_stats(pool, gens, genCOUNT + 1);
+    Insist(n == genCOUNT + 1); /* one per generation, and the top gen */
+    for (g = 0; g < n; ++g) {
+      Insist(gens[g].chain == (g < genCOUNT ? chain : NULL));
+      Insist(gens[g].gen == (g < genCOUNT ? g : 0));
+      Insist(gens[g].total_size
+             == gens[g].free_size + gens[g].buffered_size
+             + gens[g].new_size + gens[g].old_size
+             + gens[g].new_deferred_size + gens[g].old_deferred_size);
+    }
+    Insist(gens[0].collections > 0);
+  }
+
   mps_ap_destroy(busy_ap);
   mps_ap_destroy(ap);
   mps_root_destroy(exactRoot);
@@ -317,6 +390,8 @@ int main(int argc, char *argv[])
   } MPS_ARGS_END(args);
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_gc_start());
+  mps_arena_gc_phase_hook_set(arena, phaseHook, &phaseEnds);
+  mps_arena_gc_histogram_set(arena, 64);
   die(mps_thread_reg(&thread, arena), "thread_reg");
   test(mps_class_amc(), exactRootsCOUNT);
   test(mps_class_amcz(), 0);
@@ -53,6 +53,25 @@ static void check_allocated_size(mps_pool_t pool, mps_ap_t ap, size_t allocated)
 }
 
 
+/* check_free_stats -- check the summary of the pool's free blocks */
+
+static void check_free_stats(mps_pool_t pool)
+{
+  mps_pool_free_stats_s stats;
+  size_t i, blocks = 0, size = 0;
+
+  mps_pool_free_stats(pool, &stats);
+  Insist(stats.free_block_size <= stats.free_size);
+  Insist(stats.largest <= stats.free_block_size);
+  for (i = 0; i < MPS_FREE_BUCKETS; ++i) {
+    blocks += stats.count[i];
+    size += stats.size[i];
+  }
+  Insist(blocks == stats.free_blocks);
+  Insist(size == stats.free_block_size);
+}
+
+
 /* stress -- create a pool of the requested type and allocate in it */
 
 static mps_res_t stress(mps_arena_t arena, mps_pool_debug_option_s *options,
@@ -131,6 +150,7 @@ static mps_res_t stress(mps_arena_t arena, mps_pool_debug_option_s *options,
       allocated += ss[i] + debugOverhead;
     }
     check_allocated_size(pool, ap, allocated);
+    check_free_stats(pool);
   }
 
 allocFail:
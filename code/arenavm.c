@@ -736,6 +736,7 @@ static Res VMArenaGrow(Arena arena, LocusPref pref, Size size)
   chunkSize = vmArena->extendBy;
 
   EVENT3(vmArenaExtendStart, size, chunkSize, ArenaReserved(arena));
+  PROBE2(arena_grow_begin, arena, size);
 
   /* .chunk-create.fail: If we fail, try again with a smaller size */
   {
@@ -758,6 +759,7 @@ static Res VMArenaGrow(Arena arena, LocusPref pref, Size size)
       for(; chunkSize > chunkHalf; chunkSize -= sliceSize) {
         if(chunkSize < chunkMin) {
           EVENT2(vmArenaExtendFail, chunkMin, ArenaReserved(arena));
+          PROBE2(arena_grow_end, arena, (Size)0);
           return res;
         }
         res = VMChunkCreate(&newChunk, vmArena, chunkSize);
@@ -769,6 +771,7 @@ static Res VMArenaGrow(Arena arena, LocusPref pref, Size size)
   
 vmArenaGrow_Done:
   EVENT2(vmArenaExtendDone, chunkSize, ArenaReserved(arena));
+  PROBE2(arena_grow_end, arena, chunkSize);
   vmArena->extended(arena,
                     newChunk->base,
                     AddrOffset(newChunk->base, newChunk->limit));
@@ -1040,6 +1043,7 @@ static Size arenaUnmapSpare(Arena arena, Size size, Chunk filter)
      or else "node" and "next" are in discontiguous spans of spare
      pages (otherwise "node" would have been deleted on the previous
      iteration). */
+  PROBE2(arena_purge_begin, arena, size);
   node = &vmArena->spareRing;
   while (RingNext(node) != &vmArena->spareRing && purged < size) {
     Ring next = RingNext(node);
@@ -1057,6 +1061,7 @@ static Size arenaUnmapSpare(Arena arena, Size size, Chunk filter)
       node = next;
     }
   }
+  PROBE2(arena_purge_end, arena, purged);
 
   return purged;
 }
@@ -0,0 +1,395 @@
+/* awlloadtest.c: AWL LOAD BARRIER TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Build a weak table of moving strings in an AWL pool with a software
+ * load barrier, and read it through mps_awl_load while incremental
+ * collections are stepped through, checking that every load returns
+ * the current address of a reachable string.  Then check that
+ * collection clears the entries of unreachable strings.  See
+ * <design/poolawl/#load>.
+ */
+
+#include "mpscawl.h"
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "fmtdy.h"
+#include "testlib.h"
+#include "testthr.h"
+#include "mpslib.h"
+#include "mps.h"
+#include "mpstd.h"
+
+#include <stdio.h> /* printf */
+#include <string.h> /* strlen */
+
+
+#define testArenaSIZE     ((size_t)64<<20)
+#define TABLE_SLOTS 199
+#define COLLECTIONS 10
+#define STEPS 100000
+
+#define UNINIT 0x041412ED
+
+#define DYLAN_ALIGN 4 /* depends on value defined in fmtdy.c */
+
+
+/* size_tAlignUp -- align w up to alignment a */
+
+#define size_tAlignUp(w, a) (((w) + (a) - 1) & ~((size_t)(a) - 1))
+
+
+static mps_word_t bogus_class;
+
+static mps_word_t wrapper_wrapper[] = {
+  UNINIT,                       /* wrapper */
+  UNINIT,                       /* class */
+  0,                            /* Extra word */
+  (mps_word_t)4<<2|2,                     /* F */
+  (mps_word_t)2<<(MPS_WORD_WIDTH - 8),    /* V */
+  (mps_word_t)1<<2|1,                     /* VL */
+  1                             /* patterns */
+};
+
+static mps_word_t string_wrapper[] = {
+  UNINIT,                       /* wrapper */
+  UNINIT,                       /* class */
+  0,                            /* extra word */
+  0,                            /* F */
+  (mps_word_t)2<<(MPS_WORD_WIDTH - 8)|(mps_word_t)3<<3|4,   /* V */
+  1                             /* VL */
+};
+
+static mps_word_t table_wrapper[] = {
+  UNINIT,                       /* wrapper */
+  UNINIT,                       /* class */
+  0,                            /* extra word */
+  (mps_word_t)1<<2|1,                     /* F */
+  (mps_word_t)2<<(MPS_WORD_WIDTH - 8)|2,  /* V */
+  1                             /* VL */
+};
+
+
+static void initialise_wrapper(mps_word_t *wrapper)
+{
+  wrapper[0] = (mps_word_t)&wrapper_wrapper;
+  wrapper[1] = (mps_word_t)&bogus_class;
+}
+
+
+/* alloc_string -- create a dylan string object
+ *
+ * .assume.dylan-obj
+ */
+
+static mps_word_t *alloc_string(const char *s, mps_ap_t ap)
+{
+  size_t l;
+  size_t objsize;
+  void *p;
+  mps_word_t *object;
+
+  l = strlen(s)+1;
+  objsize = (2 + (l+sizeof(mps_word_t)-1)/sizeof(mps_word_t))
+            * sizeof(mps_word_t);
+  objsize = size_tAlignUp(objsize, DYLAN_ALIGN);
+  do {
+    die(mps_reserve(&p, ap, objsize), "Reserve Leaf\n");
+    object = p;
+    object[0] = (mps_word_t)string_wrapper;
+    object[1] = l << 2 | 1;
+    memcpy(&object[2], s, l);
+  } while(!mps_commit(ap, p, objsize));
+  return object;
+}
+
+
+/* alloc_table -- create a table with n variable slots
+ *
+ * .assume.dylan-obj
+ */
+
+static mps_word_t *alloc_table(size_t n, mps_ap_t ap)
+{
+  size_t objsize;
+  void *p;
+  mps_word_t *object;
+
+  objsize = (3 + n) * sizeof(mps_word_t);
+  objsize = size_tAlignUp(objsize, MPS_PF_ALIGN);
+  do {
+    size_t i;
+
+    die(mps_reserve(&p, ap, objsize), "Reserve Table\n");
+    object = p;
+    object[0] = (mps_word_t)table_wrapper;
+    object[1] = 0;
+    object[2] = n << 2 | 1;
+    for(i = 0; i < n; ++i) {
+      object[3+i] = 0;
+    }
+  } while(!mps_commit(ap, p, objsize));
+  return object;
+}
+
+
+static void set_table_slot(mps_word_t *table, size_t n, mps_word_t *p)
+{
+  cdie(table[0] == (mps_word_t)table_wrapper, "set_table_slot");
+  table[3+n] = (mps_word_t)p;
+}
+
+
+/* The strings kept alive, in an exact root so that they can move. */
+
+static mps_word_t *preserve[TABLE_SLOTS];
+
+
+typedef struct tables_s {
+  mps_arena_t arena;
+  mps_pool_t weakpool;
+  mps_word_t *weak;                     /* the weak table */
+  mps_ap_t weakap, leafap;
+} tables_s, *tables_t;
+
+
+/* populate -- populate the weak table in a thread
+ *
+ * We use a thread to populate the table to avoid leaving any
+ * references to its contents in registers, so that we can test its
+ * weakness properly.
+ */
+
+static void *populate(void *state)
+{
+  tables_t tables = state;
+  size_t i;
+  mps_thr_t me;
+  mps_root_t root;
+
+  die(mps_thread_reg(&me, tables->arena), "mps_thread_reg(populate)");
+  die(mps_root_create_thread(&root, tables->arena, me, &state),
+      "mps_root_create_thread(populate)");
+
+  tables->weak = alloc_table(TABLE_SLOTS, tables->weakap);
+
+  for(i = 0; i < TABLE_SLOTS; ++i) {
+    mps_word_t *string;
+    if (rnd() % 2 == 0) {
+      string = alloc_string("iamalive", tables->leafap);
+      preserve[i] = string;
+    } else {
+      string = alloc_string("iamdead", tables->leafap);
+      preserve[i] = NULL;
+    }
+    set_table_slot(tables->weak, i, string);
+  }
+
+  mps_root_destroy(root);
+  mps_thread_dereg(me);
+
+  return NULL;
+}
+
+
+/* load -- load the nth slot of the weak table through the barrier */
+
+static mps_word_t *load(tables_t tables, size_t n)
+{
+  mps_addr_t *slot = (mps_addr_t *)&tables->weak[3+n];
+  return mps_awl_load(tables->weakpool, slot);
+}
+
+
+/* check -- check the entries of the weak table
+ *
+ * Only the entries of reachable strings are loaded, since loading the
+ * others during a collection would keep them alive.  If dead is TRUE,
+ * the table has just been collected, so the other entries must have
+ * been cleared.
+ */
+
+static void check(tables_t tables, mps_bool_t dead)
+{
+  size_t i;
+
+  for(i = 0; i < TABLE_SLOTS; ++i) {
+    if (preserve[i] != NULL) {
+      mps_word_t *string = load(tables, i);
+      if (string != preserve[i])
+        error("Stale reference loaded from weak table, "
+              "slot %"PRIuLONGEST".\n", (ulongest_t)i);
+      Insist(string[0] == (mps_word_t)string_wrapper);
+      Insist(strcmp((char *)&string[2], "iamalive") == 0);
+    } else if (dead && load(tables, i) != NULL) {
+      error("Strongly unreachable weak table entry found, "
+            "slot %"PRIuLONGEST".\n", (ulongest_t)i);
+    }
+  }
+}
+
+
+static void test(mps_arena_t arena, tables_t tables)
+{
+  testthr_t thr;
+  size_t i, j;
+
+  testthr_create(&thr, populate, tables);
+  testthr_join(&thr, NULL);
+
+  /* Read the table while stepping through incremental collections,
+     which move the strings. */
+  for(i = 0; i < COLLECTIONS; ++i) {
+    die(mps_arena_start_collect(arena), "mps_arena_start_collect");
+    mps_arena_clamp(arena);
+    for(j = 0; j < STEPS; ++j) {
+      check(tables, FALSE);
+      (void)alloc_string("spong", tables->leafap);
+      if (!mps_arena_step(arena, 0.0, 0.0))
+        break;
+    }
+    mps_arena_park(arena);
+    check(tables, FALSE);
+    mps_arena_release(arena);
+  }
+
+  die(mps_arena_collect(arena), "mps_arena_collect");
+  mps_arena_release(arena);
+  check(tables, TRUE);
+}
+
+
+/* setup -- set up pools for the test */
+
+struct guff_s {
+  mps_arena_t arena;
+  mps_thr_t thr;
+};
+
+static void *setup(void *v, size_t s)
+{
+  struct guff_s *guff;
+  mps_arena_t arena;
+  mps_pool_t leafpool;
+  mps_fmt_t dylanfmt, dylanweakfmt;
+  mps_root_t stack, root;
+  mps_thr_t thr;
+  tables_s tables;
+
+  guff = (struct guff_s *)v;
+  (void)s;
+  arena = guff->arena;
+  thr = guff->thr;
+
+  die(mps_root_create_thread(&stack, arena, thr, v),
+      "Root Create\n");
+  die(mps_root_create_area(&root, arena, mps_rank_exact(), 0,
+                           preserve, preserve + TABLE_SLOTS,
+                           mps_scan_area, NULL),
+      "Preserve Root Create\n");
+  die(mps_fmt_create_A(&dylanfmt, arena, dylan_fmt_A()),
+      "Format Create\n");
+  die(mps_fmt_create_A(&dylanweakfmt, arena, dylan_fmt_A_weak()),
+      "Format Create (weak)\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, dylanfmt);
+    die(mps_pool_create_k(&leafpool, arena, mps_class_amcz(), args),
+        "Leaf Pool Create\n");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, dylanweakfmt);
+    MPS_ARGS_ADD(args, MPS_KEY_AWL_LOAD_BARRIER, TRUE);
+    die(mps_pool_create_k(&tables.weakpool, arena, mps_class_awl(), args),
+        "Table Pool Create\n");
+  } MPS_ARGS_END(args);
+
+  tables.arena = arena;
+  die(mps_ap_create(&tables.leafap, leafpool, mps_rank_exact()),
+      "Leaf AP Create\n");
+  die(mps_ap_create(&tables.weakap, tables.weakpool, mps_rank_weak()),
+      "Weak AP Create\n");
+
+  test(arena, &tables);
+
+  mps_arena_park(arena);
+  mps_ap_destroy(tables.weakap);
+  mps_ap_destroy(tables.leafap);
+  mps_pool_destroy(tables.weakpool);
+  mps_pool_destroy(leafpool);
+  mps_fmt_destroy(dylanweakfmt);
+  mps_fmt_destroy(dylanfmt);
+  mps_root_destroy(root);
+  mps_root_destroy(stack);
+
+  return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+  struct guff_s guff;
+  mps_arena_t arena;
+  mps_thr_t thread;
+  void *r;
+
+  testlib_init(argc, argv);
+
+  initialise_wrapper(wrapper_wrapper);
+  initialise_wrapper(string_wrapper);
+  initialise_wrapper(table_wrapper);
+
+  die(mps_arena_create(&arena, mps_arena_class_vm(), testArenaSIZE),
+      "arena_create\n");
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  guff.arena = arena;
+  guff.thr = thread;
+  mps_tramp(&r, setup, &guff, 0);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -17,6 +17,13 @@
  * synchronized with the mutator must take care when reading these
  * fields.  Such functions are marked with this tag.
  *
+ * .sample: When the arena is being profiled (see <code/profile.c>),
+ * the limit of a mutator buffer in a formatted pool is lowered to the
+ * next sample point, so that the reservation which crosses the sample
+ * point goes out of line to BufferFill.  The buffer is then trapped
+ * until the sampled object is committed, so that BufferTrip can
+ * record it.  See <design/profile/#buffer>.
+ *
  * TRANSGRESSIONS
  *
  * .trans.mod: pool->bufferSerial is directly accessed by this module
@@ -95,6 +102,9 @@ Bool BufferCheck(Buffer buffer)
     /* request.dylan.170429.sol.zero_). */
     /* .. _request.dylan.170429.sol.zero: https://info.ravenbrook.com/project/mps/import/2001-11-05/mmprevol/request/dylan/170429 */
 
+    if (buffer->mode & BufferModeSAMPLED)
+      CHECKL(buffer->ap_s.limit == (Addr)0);
+
     if (BufferIsTrapped(buffer)) {
       /* .check.use-trapped: This checking function uses BufferIsTrapped, */
       /* So BufferIsTrapped can't do checking as that would cause an */
@@ -138,7 +148,8 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 "Arena $P\n",       (WriteFP)buffer->arena,
                 "Pool $P\n",        (WriteFP)buffer->pool,
                 buffer->isMutator ? "Mutator" : "Internal", " Buffer\n",
-                "mode $C$C$C$C (TRANSITION, LOGGED, FLIPPED, ATTACHED)\n",
+                "mode $C$C$C$C$C (SAMPLED, TRANSITION, LOGGED, FLIPPED, ATTACHED)\n",
+                (WriteFC)((buffer->mode & BufferModeSAMPLED)    ? 's' : '_'),
                 (WriteFC)((buffer->mode & BufferModeTRANSITION) ? 't' : '_'),
                 (WriteFC)((buffer->mode & BufferModeLOGGED)     ? 'l' : '_'),
                 (WriteFC)((buffer->mode & BufferModeFLIPPED)    ? 'f' : '_'),
@@ -154,6 +165,8 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 "poolLimit $A\n",   (WriteFA)buffer->poolLimit,
                 "alignment $W\n",   (WriteFW)buffer->alignment,
                 "rampCount $U\n",   (WriteFU)buffer->rampCount,
+                "sampleBase $A\n",  (WriteFA)buffer->sampleBase,
+                "sampleRemaining $W\n", (WriteFW)buffer->sampleRemaining,
                 NULL);
 }
 
@@ -185,7 +198,8 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   buffer->pool = pool;
   RingInit(&buffer->poolRing);
   buffer->isMutator = isMutator;
-  if (ArenaGlobals(arena)->bufferLogging) {
+  if (ArenaGlobals(arena)->bufferLogging
+      || (isMutator && EVENT_KIND_ENABLED(Object))) {
     buffer->mode = BufferModeLOGGED;
   } else {
     buffer->mode = 0;
@@ -203,6 +217,9 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   buffer->ap_s.limit = (mps_addr_t)0;
   buffer->poolLimit = (Addr)0;
   buffer->rampCount = 0;
+  buffer->sampleBase = (Addr)0;
+  buffer->sampleRemaining = SizeMAX;
+  buffer->sampleIndex = 0;
 
   /* .init.sig-serial: Now the vanilla stuff is initialized, sign the
      buffer and give it a serial number. It can then be safely checked
@@ -292,6 +309,18 @@ void BufferDetach(Buffer buffer, Pool pool)
     init = BufferGetInit(buffer);
     limit = BufferLimit(buffer);
     spare = AddrOffset(init, limit);
+
+    /* Carry the distance to the next sample point over to the next
+       region. See .sample. */
+    AVER((buffer->mode & BufferModeSAMPLED) == 0);
+    if (buffer->sampleRemaining != SizeMAX) {
+      Size used = AddrOffset(buffer->sampleBase, init);
+      if (used < buffer->sampleRemaining)
+        buffer->sampleRemaining -= used;
+      else
+        buffer->sampleRemaining = 0;
+    }
+
     buffer->emptySize += spare;
     if (buffer->isMutator) {
       ArenaGlobals(buffer->arena)->emptyMutatorSize += spare;
@@ -308,6 +337,7 @@ void BufferDetach(Buffer buffer, Pool pool)
     buffer->ap_s.alloc = (mps_addr_t)0;
     buffer->ap_s.limit = (mps_addr_t)0;
     buffer->poolLimit = (Addr)0;
+    buffer->sampleBase = (Addr)0;
     buffer->mode &=
       ~(BufferModeATTACHED|BufferModeFLIPPED|BufferModeTRANSITION);
 
@@ -403,6 +433,67 @@ Bool BufferIsMutator(Buffer buffer)
 }
 
 
+/* bufferProfile -- profile that samples allocation in buffer, or NULL
+ *
+ * Only objects allocated by the mutator in formatted pools are
+ * sampled, because the profile needs their class.  See .sample.
+ */
+
+static Profile bufferProfile(Buffer buffer)
+{
+  Format format;
+
+  if (!buffer->isMutator || !PoolFormat(&format, BufferPool(buffer)))
+    return NULL;
+  return ArenaProfile(BufferArena(buffer));
+}
+
+
+/* bufferLimit -- limit of the AP when it is not trapped
+ *
+ * This is the pool's limit, lowered to the next sample point if there
+ * is one in the buffer.  See .sample.
+ */
+
+static Addr bufferLimit(Buffer buffer)
+{
+  if (buffer->sampleRemaining < AddrOffset(buffer->sampleBase,
+                                           buffer->poolLimit))
+    return AddrAlignUp(AddrAdd(buffer->sampleBase,
+                               buffer->sampleRemaining),
+                       buffer->alignment);
+  return buffer->poolLimit;
+}
+
+
+/* bufferSample -- sample the object just reserved, if it's time
+ *
+ * The object is the "size" bytes below "alloc".  If it crosses the
+ * sample point, start a sample and trap the buffer so that
+ * BufferTrip is called when the object is committed.  See .sample.
+ */
+
+static void bufferSample(Buffer buffer, Size size)
+{
+  Profile profile = bufferProfile(buffer);
+
+  if (profile == NULL) {
+    buffer->sampleRemaining = SizeMAX;
+  } else if (AddrOffset(buffer->sampleBase, buffer->ap_s.alloc)
+             > buffer->sampleRemaining) {
+    if (ProfileReserve(&buffer->sampleIndex, profile, buffer, size)) {
+      buffer->mode |= BufferModeSAMPLED;
+      buffer->ap_s.limit = (Addr)0;
+    }
+    buffer->sampleBase = buffer->ap_s.alloc;
+    buffer->sampleRemaining = ProfileInterval(profile);
+  }
+
+  if (!BufferIsTrapped(buffer))
+    buffer->ap_s.limit = bufferLimit(buffer);
+}
+
+
 /* BufferSetUnflipped
  *
  * Unflip a buffer if it was flipped.  */
@@ -414,7 +505,7 @@ static void BufferSetUnflipped(Buffer buffer)
   buffer->mode &= ~BufferModeFLIPPED;
   /* restore ap_s.limit if appropriate */
   if (!BufferIsTrapped(buffer)) {
-    buffer->ap_s.limit = buffer->poolLimit;
+    buffer->ap_s.limit = bufferLimit(buffer);
   }
   buffer->initAtFlip = (Addr)0;
 }
@@ -434,6 +525,8 @@ void BufferSetAllocAddr(Buffer buffer, Addr addr)
 
   buffer->ap_s.init = addr;
   buffer->ap_s.alloc = addr;
+  if (addr < buffer->sampleBase)
+    buffer->sampleBase = addr;
 }
 
 
@@ -527,14 +620,20 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
   buffer->base = base;
   buffer->ap_s.init = init;
   buffer->ap_s.alloc = AddrAdd(init, size);
+  buffer->poolLimit = limit;
+  buffer->sampleBase = init;
+  if (buffer->sampleRemaining == SizeMAX) {
+    Profile profile = bufferProfile(buffer);
+    if (profile != NULL)
+      buffer->sampleRemaining = ProfileInterval(profile);
+  }
   /* only set limit if not logged */
   if ((buffer->mode & BufferModeLOGGED) == 0) {
-    buffer->ap_s.limit = limit;
+    buffer->ap_s.limit = bufferLimit(buffer);
   } else {
     AVER(buffer->ap_s.limit == (Addr)0);
   }
   AVER(buffer->initAtFlip == (Addr)0);
-  buffer->poolLimit = limit;
 
   filled = AddrOffset(init, limit);
   buffer->fillSize += filled;
@@ -561,7 +660,8 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
  * BufferFill is entered by the "reserve" operation on a buffer if there
  * isn't enough room between "alloc" and "limit" to satisfy an
  * allocation request.  This might be because the buffer has been
- * trapped and "limit" has been set to zero.  */
+ * trapped and "limit" has been set to zero, or lowered to a sample
+ * point (.sample).  */
 
 Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
 {
@@ -579,7 +679,8 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
 
   /* If we're here because the buffer was trapped, then we attempt */
   /* the allocation here. */
-  if (!BufferIsReset(buffer) && buffer->ap_s.limit == (Addr)0) {
+  if (!BufferIsReset(buffer)
+      && (Addr)buffer->ap_s.limit < buffer->poolLimit) {
     /* .fill.unflip: If the buffer is flipped then we unflip the buffer. */
     if (buffer->mode & BufferModeFLIPPED) {
       BufferSetUnflipped(buffer);
@@ -593,6 +694,7 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
       if (buffer->mode & BufferModeLOGGED) {
         EVENT3(BufferReserve, buffer, buffer->ap_s.init, size);
       }
+      bufferSample(buffer, size);
       *pReturn = buffer->ap_s.init;
       return ResOK;
     }
@@ -605,7 +707,9 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
   BufferDetach(buffer, pool);
 
   /* Ask the pool for some memory. */
+  PROBE2(buffer_fill_begin, buffer, size);
   res = Method(Pool, pool, bufferFill)(&base, &limit, pool, buffer, size);
+  PROBE2(buffer_fill_end, buffer, res);
   if (res != ResOK)
     return res;
 
@@ -616,6 +720,7 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
   if (buffer->mode & BufferModeLOGGED) {
     EVENT3(BufferReserve, buffer, buffer->ap_s.init, size);
   }
+  bufferSample(buffer, size);
 
   *pReturn = base;
   return res;
@@ -715,9 +820,35 @@ Bool BufferTrip(Buffer buffer, Addr p, Size size)
     /* (.fill.unflip) because the buffer is still trapped) */
     buffer->ap_s.init = p;
     buffer->ap_s.alloc = p;
+    /* .trip.sample: If the object was sampled, sample it again when */
+    /* it is reserved again. */
+    if (buffer->mode & BufferModeSAMPLED) {
+      Profile profile = ArenaProfile(buffer->arena);
+      if (profile != NULL)
+        ProfileCancel(profile, buffer->sampleIndex, buffer);
+      buffer->mode &= ~BufferModeSAMPLED;
+      buffer->sampleBase = p;
+      buffer->sampleRemaining = 0;
+    }
     return FALSE;
   }
 
+  /* Record the sampled object, now that it is initialized, and */
+  /* untrap the buffer.  See .sample. */
+  if (buffer->mode & BufferModeSAMPLED) {
+    Profile profile = ArenaProfile(buffer->arena);
+    Format format;
+
+    buffer->mode &= ~BufferModeSAMPLED;
+    if (profile != NULL && PoolFormat(&format, pool)) {
+      Addr ref = AddrAdd(p, format->headerSize);
+      ProfileCommit(profile, buffer->sampleIndex, buffer, ref,
+                    format->klass(ref));
+    }
+    if (!BufferIsTrapped(buffer))
+      buffer->ap_s.limit = bufferLimit(buffer);
+  }
+
   /* Emit event including class if logged */
   if (buffer->mode & BufferModeLOGGED) {
     Bool b;
@@ -824,12 +955,14 @@ void BufferReassignSeg(Buffer buffer, Seg seg)
 /* BufferIsTrapped
  *
  * Indicates whether the buffer is trapped - either by MPS or the
- * mutator.  See .ap.async.  */
+ * mutator, or because the reserved object is sampled (.sample).  See
+ * .ap.async.  */
 
 Bool BufferIsTrapped(Buffer buffer)
 {
   /* Can't check buffer, see .check.use-trapped */
-  return (buffer->mode & (BufferModeFLIPPED|BufferModeLOGGED)) != 0;
+  return (buffer->mode & (BufferModeFLIPPED|BufferModeLOGGED
+                          |BufferModeSAMPLED)) != 0;
 }
 
 
@@ -77,7 +77,10 @@
  *
  * When the MPS is build with AVER_AND_CHECK_ALL (in a "cool" variety) the
  * static variable CheckLevel controls the frequency and detail of
- * consistency checking on structures.
+ * consistency checking on structures.  When it is built with
+ * AVER_AND_CHECK_SAMPLED (see config.h) CheckLevel is a variable that
+ * is raised to CHECKLEVEL_SAMPLED during sampled checks: see
+ * CHECK_SAMPLE below.
  *
  * By default, CHECKLEVEL is defined to a static value in config.h, though
  * it can be overridden on the compiler command line, e.g.
@@ -114,6 +117,41 @@ extern unsigned CheckLevel;
 #endif
 
 
+/* CHECK_SAMPLE -- run a statement on a sampled fraction of calls
+ *
+ * In a sampled checking build, CheckSampleCountdown counts the calls
+ * remaining until the next sample.  On a sampled call, the "sampled"
+ * statement runs with CheckLevel raised to CHECKLEVEL_SAMPLED; on
+ * other calls, the "unsampled" statement runs at CheckLevelMINIMAL,
+ * as in the hot variety.  See <design/check/#sampled>.
+ *
+ * The countdown is not protected by a lock.  Threads racing on it may
+ * take a sample early or late, which does no harm, but it never wraps
+ * around, because only counts above 1 are decremented.
+ */
+
+#if defined(AVER_AND_CHECK_SAMPLED)
+
+extern size_t CheckSampleCountdown;
+extern void CheckSampleBegin(void);
+extern void CheckSampleEnd(void);
+extern void CheckSampleSet(size_t interval);
+
+#define CHECK_SAMPLE(sampled, unsampled) \
+  BEGIN \
+    if (LIKELY(CheckSampleCountdown > 1)) { \
+      --CheckSampleCountdown; \
+      unsampled; \
+    } else { \
+      CheckSampleBegin(); \
+      sampled; \
+      CheckSampleEnd(); \
+    } \
+  END
+
+#endif /* AVER_AND_CHECK_SAMPLED */
+
+
 /* AVER, AVERT, AVERC, AVERP -- MPM assertions
  *
  * AVER and friends are used to assert conditions in the code.
@@ -135,6 +173,11 @@ extern unsigned CheckLevel;
  * check in critical parts of the code, use AVER_CRITICAL etc., but
  * only when you've *proved* that this makes a difference to
  * performance that affects requirements.
+ *
+ * In a sampled checking build, AVERT and AVERC call the check method
+ * at CHECKLEVEL_SAMPLED on a sampled fraction of calls (see
+ * CHECK_SAMPLE above), and the critical variants are discarded as in
+ * the hot variety.
  */
 
 #if defined(AVER_AND_CHECK_NONE)
@@ -145,6 +188,16 @@ extern unsigned CheckLevel;
 #define AVERP(cond, dflt)           (DISCARD_EXP(cond), dflt)
 #define AVERPC(cond, condstring, dflt) (DISCARD_EXP(cond), dflt)
 
+#elif defined(AVER_AND_CHECK_SAMPLED)
+
+#define AVER(cond)                  ASSERT(cond, #cond)
+#define AVERT(type, val) \
+  CHECK_SAMPLE(ASSERT_TYPECHECK(type, val), ASSERT_TYPECHECK(type, val))
+#define AVERC(klass, val) \
+  CHECK_SAMPLE(ASSERT_CLASSCHECK(klass, val), ASSERT_CLASSCHECK(klass, val))
+#define AVERP(cond, dflt)           ASSERTP(cond, #cond, dflt)
+#define AVERPC                      ASSERTP
+
 #else
 
 #define AVER(cond)                  ASSERT(cond, #cond)
@@ -282,6 +335,26 @@ extern unsigned CheckLevel;
     } \
   END
 
+#elif defined(AVER_AND_CHECK_SAMPLED)
+
+/* In a sampled checking build, CheckLevel is almost always MINIMAL,
+ * so test for that first. */
+
+#define CHECK_BY_LEVEL(minimal, shallow, deep) \
+  BEGIN \
+    if (LIKELY(CheckLevel == CheckLevelMINIMAL)) { \
+      minimal; \
+    } else if (CheckLevel == CheckLevelSHALLOW) { \
+      shallow; \
+    } else { \
+      deep; \
+    } \
+  END
+
+#endif
+
+#if defined(AVER_AND_CHECK_ALL) || defined(AVER_AND_CHECK_SAMPLED)
+
 #define CHECKL(cond) \
   CHECK_BY_LEVEL(NOOP, \
                  ASSERT(cond, #cond), \
@@ -73,6 +73,11 @@ typedef union EventClockUnion {
           (*(EventClockUnion *)&(clock)).half.high, \
           (*(EventClockUnion *)&(clock)).half.low)
 
+#define EVENT_CLOCK_SPRINT(s, clock) \
+  sprintf(s, "%08lX%08lX", \
+          (*(EventClockUnion *)&(clock)).half.high, \
+          (*(EventClockUnion *)&(clock)).half.low)
+
 #define EVENT_CLOCK_WRITE(stream, depth, clock)  \
   WriteF(stream, depth, "$W$W", \
          (*(EventClockUnion *)&(clock)).half.high, \
@@ -86,11 +91,17 @@ typedef union EventClockUnion {
 #define EVENT_CLOCK_PRINT(stream, clock) \
   fprintf(stream, "%016llX", (clock));
 
+#define EVENT_CLOCK_SPRINT(s, clock) \
+  sprintf(s, "%016llX", (clock))
+
 #else
 
 #define EVENT_CLOCK_PRINT(stream, clock) \
   fprintf(stream, "%016lX", (clock));
 
+#define EVENT_CLOCK_SPRINT(s, clock) \
+  sprintf(s, "%016lX", (clock))
+
 #endif
 
 #define EVENT_CLOCK_WRITE(stream, depth, clock) \
@@ -146,6 +157,11 @@ __extension__ typedef unsigned long long EventClock;
           (unsigned long)((clock) >> 32), \
           (unsigned long)((clock) & 0xffffffff))
 
+#define EVENT_CLOCK_SPRINT(s, clock) \
+  sprintf(s, "%08lX%08lX", \
+          (unsigned long)((clock) >> 32), \
+          (unsigned long)((clock) & 0xffffffff))
+
 #define EVENT_CLOCK_WRITE(stream, depth, clock) \
   WriteF(stream, depth, "$W$W", (WriteFW)((clock) >> 32), (WriteFW)clock, NULL)
 
@@ -167,6 +183,9 @@ typedef mps_clock_t EventClock;
 #define EVENT_CLOCK_PRINT(stream, clock) \
   fprintf(stream, "%lu", (unsigned long)clock)
 
+#define EVENT_CLOCK_SPRINT(s, clock) \
+  sprintf(s, "%lu", (unsigned long)clock)
+
 #define EVENT_CLOCK_WRITE(stream, depth, clock) \
   WriteF(stream, depth, "$W", (WriteFW)clock, NULL)
 
@@ -80,6 +80,33 @@
 #endif /* CONFIG_VAR_* */
 
 
+/* CONFIG_ASSERT_SAMPLED -- sampled consistency checking
+ *
+ * This symbol, used with the hot variety, causes the MPS to be built
+ * so that a sampled fraction of AVERT and AVERC assertions call their
+ * check methods at CHECKLEVEL_SAMPLED, while the others check no more
+ * than in the hot variety.  It is intended for canary deployments
+ * that need to find heap corruption under production load.  The
+ * interval between samples can be changed at run time by calling
+ * mps_check_sample_set().  See <design/check/#sampled>.
+ */
+
+#if defined(CONFIG_ASSERT_SAMPLED)
+#if !defined(CONFIG_ASSERT) || defined(CONFIG_ASSERT_ALL)
+#error "CONFIG_ASSERT_SAMPLED requires the hot variety"
+#endif
+#if !defined(CHECKLEVEL_DYNAMIC)
+#define CHECKLEVEL_DYNAMIC      CheckLevelMINIMAL
+#endif
+#if !defined(CHECKLEVEL_SAMPLED)
+#define CHECKLEVEL_SAMPLED      CheckLevelSHALLOW
+#endif
+#if !defined(CHECK_SAMPLE_INTERVAL)
+#define CHECK_SAMPLE_INTERVAL   ((size_t)1000)
+#endif
+#endif /* CONFIG_ASSERT_SAMPLED */
+
+
 /* Build Features */
 
 
@@ -90,6 +117,9 @@
 #if defined(CONFIG_ASSERT_ALL)
 #define AVER_AND_CHECK_ALL
 #define MPS_ASSERT_STRING "assertastic"
+#elif defined(CONFIG_ASSERT_SAMPLED)
+#define AVER_AND_CHECK_SAMPLED
+#define MPS_ASSERT_STRING "sampled"
 #else /* CONFIG_ASSERT_ALL, not */
 #define MPS_ASSERT_STRING "asserted"
 #endif /* CONFIG_ASSERT_ALL */
@@ -114,6 +144,21 @@
 #endif
 
 
+/* CONFIG_STATS_LOCK -- arena lock statistics
+ *
+ * This symbol causes ArenaEnter and ArenaLeave to count claims of the
+ * arena lock and to time how long threads wait for it and hold it, for
+ * mps_arena_stats.  This costs three reads of the event clock on each
+ * non-recursive entry, so it is only on by default in varieties with
+ * statistics, but it can be defined when building the hot variety to
+ * measure lock contention in production.  See <design/arena/#lock.stats>.
+ */
+
+#if defined(CONFIG_STATS) || defined(CONFIG_STATS_LOCK)
+#define LOCK_STATS
+#endif
+
+
 #if defined(CONFIG_LOG)
 /* TELEMETRY = LOG = EVENTs */
 #define EVENT
@@ -130,6 +175,44 @@
 #endif /* CONFIG_LOG */
 
 
+/* CONFIG_LOG_ALLOC -- log mps_alloc and mps_free in the hot variety
+ *
+ * The PoolAlloc and PoolFree events are on the critical path of
+ * mps_alloc and mps_free, so like other such events they are only
+ * logged in varieties with CONFIG_LOG_ALL.  Defining this symbol logs
+ * them in the hot variety too, so that a stream for mpsreplay can be
+ * captured from a production build.  This costs a test of the Object
+ * event kind on every allocation and free, even when the kind is
+ * disabled.  See <design/telemetry/#replay.capture>.
+ */
+
+#if defined(CONFIG_LOG_ALLOC)
+#define EVENT_ALLOC TRUE
+#else
+#define EVENT_ALLOC FALSE
+#endif
+
+
+/* CONFIG_PROBE_SDT -- static probes for external tracing tools
+ *
+ * This symbol causes the MPS to be built with statically defined
+ * tracing probes at the boundaries of collection phases and other
+ * places where the MPS may take a long time, so that tools such as
+ * perf, bpftrace and SystemTap can measure the collector without the
+ * telemetry stream.  It needs <sys/sdt.h>, which is supplied by
+ * SystemTap on Linux.  Each probe compiles to a single no-op
+ * instruction.  See <code/probe.h>.  e.g.
+ *
+ *     cc -O2 -c -DCONFIG_PROBE_SDT mps.c
+ */
+
+#if defined(CONFIG_PROBE_SDT)
+#define PROBE_SDT
+#else
+#define PROBE_NONE
+#endif
+
+
 /* CONFIG_PLINTH_NONE -- exclude the ANSI plinth
  *
  * Some MPS deployment environments want to avoid dependencies on the
@@ -331,6 +414,35 @@
 #endif
 
 
+/* THREAD_LOCAL -- thread-local storage class
+ *
+ * Expands to a storage class specifier giving a variable one instance
+ * per thread, where the compiler supports this.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/Thread-Local.html>.  Code using
+ * it must provide an alternative for when it is not defined.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define THREAD_LOCAL __thread
+#endif
+
+
+/* STORE_RELEASE, LOAD_ACQUIRE -- ordered memory accesses
+ *
+ * STORE_RELEASE(lvalue, value) assigns value to lvalue such that a
+ * thread that reads the new value using LOAD_ACQUIRE(lvalue) also sees
+ * all memory writes made by the storing thread before the store.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html>.
+ * These are defined wherever THREAD_LOCAL is.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define STORE_RELEASE(lvalue, value) \
+  __atomic_store_n(&(lvalue), (value), __ATOMIC_RELEASE)
+#define LOAD_ACQUIRE(lvalue) __atomic_load_n(&(lvalue), __ATOMIC_ACQUIRE)
+#endif
+
+
 /* Buffer Configuration -- see <code/buffer.c> */
 
 #define BUFFER_RANK_DEFAULT (mps_rank_exact())
@@ -635,12 +747,39 @@
 #define RememberedSummaryBLOCK 15
 
 
+/* Allocation Profiler Configuration -- see <code/profile.c>
+ *
+ * ProfileDEPTH is the maximum number of stack frames recorded with
+ * each sampled object.
+ */
+
+#define ProfileDEPTH 32
+
+
 /* Events
  *
  * EventBufferSIZE is the number of words in the global event buffer.
+ *
+ * EventThreadBufferSIZE is the size in bytes of each per-thread event
+ * buffer, and EventThreadBufferCOUNT is the number of per-thread
+ * buffers.  Threads that can't claim a buffer of their own log into
+ * the global event buffers.  See <design/telemetry/#thread>.
  */
 
 #define EventBufferSIZE ((size_t)4096)
+#define EventThreadBufferSIZE ((size_t)8192)
+#define EventThreadBufferCOUNT ((Count)64)
+
+/* EventOutputBlockSIZE is the size in bytes of each block of the
+ * telemetry output queue, and EventOutputBlockCOUNT is the number of
+ * blocks.  See <design/telemetry/#async>. */
+
+#define EventOutputBlockSIZE ((size_t)65536)
+#define EventOutputBlockCOUNT ((Count)8)
+
+#if defined(EVENT) && defined(LOCK) && defined(THREAD_LOCAL)
+#define EVENT_THREAD_BUFFER
+#endif
 #define EventStringLengthMAX ((size_t)255) /* Not including NUL */
 
 
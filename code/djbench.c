@@ -55,6 +55,9 @@ static unsigned rmax = 10;        /* maximum recursion depth */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
 static size_t arena_grain_size = 1; /* arena grain size */
+static mps_bool_t json = FALSE;   /* print results as JSON */
+static size_t committed_max;      /* peak committed memory, sampled */
+
 
 #define DJRUN(fname, alloc, free) \
   static unsigned fname##_inner(mps_ap_t ap, unsigned depth, unsigned r) { \
@@ -82,6 +85,8 @@ static size_t arena_grain_size = 1; /* arena grain size */
           } \
         } \
       } \
+      if (pool != NULL) \
+        sample_committed(&committed_max, arena); \
       if (rinter > 0 && depth > 0 && ++r % rinter == 0) { \
         /* putchar('>'); fflush(stdout); */ \
         r = fname##_inner(ap, depth - 1, r); \
@@ -158,15 +163,28 @@ static void weave(dj_t dj)
 static void watch(dj_t dj, const char *name)
 {
   clock_t start, finish;
+  double time;
   
+  committed_max = 0;
   start = clock();
   if (nthreads == 1)
     dj(NULL);
   else
     weave(dj);
   finish = clock();
+  time = (double)(finish - start) / CLOCKS_PER_SEC;
   
-  printf("%s: %g\n", name, (double)(finish - start) / CLOCKS_PER_SEC);
+  if (json)
+    /* Machine-readable output for tool/benchmark.  Manual pools don't
+       collect, so there are no collections or pauses to report. */
+    printf("{\"benchmark\": \"djbench\", \"test\": \"%s\", "
+           "\"seed\": %lu, \"threads\": %u, \"time\": %g, "
+           "\"committed_max\": %lu, \"collections\": 0, "
+           "\"condemned\": 0, \"pauses\": []}\n",
+           name, (unsigned long)seed, nthreads, time,
+           (unsigned long)committed_max);
+  else
+    printf("%s: %g\n", name, time);
 }
 
 
@@ -213,6 +231,7 @@ static struct option longopts[] = {
   {"arena-size",       required_argument, NULL, 'm'},
   {"arena-grain-size", required_argument, NULL, 'a'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"json",             no_argument,       NULL, 'j'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -247,7 +266,7 @@ int main(int argc, char *argv[])
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:z", longopts, NULL)) != -1)
+  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:zj", longopts, NULL)) != -1)
     switch (ch) {
     case 't':
       nthreads = (unsigned)strtoul(optarg, NULL, 10);
@@ -280,6 +299,9 @@ int main(int argc, char *argv[])
     case 'z':
       zoned = FALSE;
       break;
+    case 'j':
+      json = TRUE;
+      break;
     case 'm': {
         char *p;
         arena_size = (unsigned)strtoul(optarg, &p, 10);
@@ -346,21 +368,24 @@ int main(int argc, char *argv[])
               "    Random number seed (default from entropy).\n"
               "  -z, --arena-unzoned\n"
               "    Disabled zoned allocation in the arena\n"
+              "  -j, --json\n"
+              "    Print results as JSON, one line per test.\n",
+              pact,
+              rinter,
+              rmax);
+      fprintf(stderr,
               "Tests:\n"
               "  mvt   pool class MVT\n"
               "  mvff  pool class MVFF\n"
               "  mv    pool class MV\n"
               "  mvb   pool class MV with buffers\n"
-              "  an    malloc\n",
-              pact,
-              rinter,
-              rmax);
+              "  an    malloc\n");
       return EXIT_FAILURE;
     }
   argc -= optind;
   argv += optind;
   
-  if (!seed_specified) {
+  if (!seed_specified && !json) {
     printf("seed: %lu\n", seed);
     (void)fflush(stdout);
   }
@@ -12,6 +12,13 @@
  * is specific to the logging variety and actually does logging (maybe).
  * Unfortunately, the build system doesn't really cope, and so this file
  * consists of two versions which are conditional on the EVENT symbol.
+ *
+ * .thread.posix: Per-thread event buffers and the asynchronous output
+ * modes are only used where the compiler provides thread-local storage
+ * and ordered memory accesses (see THREAD_LOCAL and STORE_RELEASE in
+ * config.h), which is only on POSIX platforms, so POSIX threads are
+ * available to release a thread's buffer when it exits, and to wait
+ * for the telemetry writer.
  */
 
 #include "mpm.h"
@@ -19,6 +26,10 @@
 #include "mpsio.h"
 #include "lock.h"
 
+#if defined(EVENT_THREAD_BUFFER) || defined(STORE_RELEASE)
+#include <pthread.h> /* see .thread.posix */
+#endif
+
 SRCID(event, "$Id$");
 
 
@@ -45,12 +56,301 @@ EventControlSet EventKindControl;       /* Bit set used to control output. */
 /* A single event structure output once per buffer flush. */
 static EventEventClockSyncStruct eventClockSyncStruct;
 
+/* Header for a flight recorder dump.  See <design/telemetry/#ring>. */
+static EventEventInitStruct eventRingInitStruct;
 
-/* eventClockSync -- Populate and write the clock sync event. */
 
-static Res eventClockSync(void)
+#ifdef EVENT_THREAD_BUFFER
+
+/* Per-thread event buffers.  See <design/telemetry/#thread>. */
+static EventThreadBufferStruct eventThreadBuffers[EventThreadBufferCOUNT];
+
+/* The calling thread's event buffer, or NULL if it hasn't claimed one. */
+THREAD_LOCAL EventThreadBuffer EventThreadBufferCurrent = NULL;
+
+/* Thread-specific data key whose destructor releases the thread's
+   event buffer when it exits.  See <design/telemetry/#thread.release>. */
+static pthread_key_t eventThreadBufferKey;
+static Bool eventThreadBufferKeyCreated = FALSE;
+
+/* Set as the thread's event buffer once claiming has failed, so that
+   EVENT_THREAD_RESERVE always goes to EventThreadBufferReserve, which
+   returns NULL without trying to claim again. */
+static EventThreadBufferStruct eventThreadBufferNone = {
+  TRUE, eventThreadBufferNone.buffer + EventThreadBufferSIZE,
+  eventThreadBufferNone.buffer + EventThreadBufferSIZE, {0}
+};
+
+#endif /* EVENT_THREAD_BUFFER */
+
+
+/* Telemetry output queue.  See <design/telemetry/#async>.
+ *
+ * In the asynchronous output modes, events are copied into the block
+ * at index (eventBlockHead + eventBlockQueued) % EventOutputBlockCOUNT
+ * instead of being written to the telemetry stream.  When that block
+ * is full it is queued, and the queued blocks are written to the
+ * stream, oldest first, by EventOutputWrite, which the client calls
+ * from a thread of its choosing.  All these variables are protected
+ * by the leaf global lock, except that the writer sets
+ * eventBlockWritten and eventBlockWrites without it, under
+ * eventWaitLock, and eventBlockWaiting is changed under both locks.
+ *
+ * In the ring mode the queue is the flight recorder: nobody writes the
+ * queued blocks until the queue is drained, and when it is full the
+ * oldest block is discarded to make room.
+ */
+
+static EventOutputMode eventOutputMode = EventOutputModeSYNC;
+static char eventBlock[EventOutputBlockCOUNT][EventOutputBlockSIZE];
+static size_t eventBlockSize[EventOutputBlockCOUNT]; /* bytes used */
+static Count eventBlockHead;    /* index of oldest queued block */
+static Count eventBlockQueued;  /* number of queued blocks */
+static Bool eventBlockWriting;  /* is writer writing the head block? */
+static Bool eventBlockWritten;  /* has writer finished with it? */
+static Count eventDropped;      /* number of events dropped */
+static Bool eventBlockWaiting;  /* has a thread released the lock to wait? */
+static Count eventBlockWrites;  /* number of blocks the writer has written */
+static Bool eventDumping;       /* is an assertion dumping the queue? */
+
+/* The asynchronous output modes need ordered memory accesses between
+   threads (see config.h).  Where these are not available, only the
+   synchronous mode is, so there is never a writer thread to
+   synchronize with. */
+
+#if defined(STORE_RELEASE)
+#define EVENT_OUTPUT_ASYNC
+
+/* Threads that must wait for the writer, or for a thread in
+   eventBlockWait, sleep on eventWaitCond.  See
+   <design/telemetry/#async.wait>. */
+static pthread_mutex_t eventWaitLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t eventWaitCond = PTHREAD_COND_INITIALIZER;
+
+#else
+#define STORE_RELEASE(lvalue, value) ((lvalue) = (value))
+#define LOAD_ACQUIRE(lvalue) (lvalue)
+#endif
+
+
+/* eventBlockFill -- index of the block being filled */
+
+static Count eventBlockFill(void)
+{
+  return (eventBlockHead + eventBlockQueued) % EventOutputBlockCOUNT;
+}
+
+
+/* eventIOEnsure -- open the telemetry stream if necessary
+ *
+ * We do this late so that no stream is created if no events are
+ * enabled by telemetry control.
+ */
+
+static Res eventIOEnsure(void)
+{
+  if (!eventIOInited) {
+    Res res = (Res)mps_io_create(&eventIO);
+    if (res != ResOK)
+      return res;
+    eventIOInited = TRUE;
+  }
+  return ResOK;
+}
+
+
+/* eventIOWrite -- write to the telemetry stream */
+
+static Res eventIOWrite(void *buf, size_t size)
+{
+  Res res = eventIOEnsure();
+  if (res != ResOK)
+    return res;
+  return (Res)mps_io_write(eventIO, buf, size);
+}
+
+
+/* eventBlockPop -- discard the head block of the output queue */
+
+static void eventBlockPop(void)
+{
+  AVER(eventBlockQueued > 0);
+  eventBlockSize[eventBlockHead] = 0;
+  eventBlockHead = (eventBlockHead + 1) % EventOutputBlockCOUNT;
+  --eventBlockQueued;
+}
+
+
+/* eventBlockReap -- discard the head block if the writer has written it */
+
+static void eventBlockReap(void)
+{
+  if (eventBlockWriting && LOAD_ACQUIRE(eventBlockWritten)) {
+    eventBlockWriting = FALSE;
+    eventBlockWritten = FALSE;
+    eventBlockPop();
+  }
+}
+
+
+/* eventBlockWait -- let the writer make progress
+ *
+ * Called with the leaf lock held, when the writer is writing the head
+ * block.  The writer doesn't need the leaf lock to finish, but other
+ * threads need it to log events once their per-thread buffers are
+ * full, so we release it while we wait, rather than stalling every
+ * thread behind a slow mps_io_write.  The caller may be part way
+ * through synchronizing, so eventBlockWaiting keeps out everyone but
+ * the writer until we have the lock again: see eventClaim.  We sleep
+ * until the writer has finished a block, which it signals.
+ */
+
+static void eventBlockWait(void)
+{
+#if defined(EVENT_OUTPUT_ASYNC)
+  AVER(eventBlockWriting);
+  AVER(!eventBlockWaiting);
+  (void)pthread_mutex_lock(&eventWaitLock);
+  if (!eventBlockWritten) {
+    Count writes = eventBlockWrites;
+    eventBlockWaiting = TRUE;
+    LockReleaseGlobalLeaf();
+    while (eventBlockWrites == writes)
+      (void)pthread_cond_wait(&eventWaitCond, &eventWaitLock);
+    (void)pthread_mutex_unlock(&eventWaitLock);
+    LockClaimGlobalLeaf();
+    (void)pthread_mutex_lock(&eventWaitLock);
+    eventBlockWaiting = FALSE;
+    (void)pthread_cond_broadcast(&eventWaitCond);
+  }
+  (void)pthread_mutex_unlock(&eventWaitLock);
+  eventBlockReap();
+#else
+  NOTREACHED; /* Only the asynchronous modes have a writer. */
+#endif
+}
+
+
+/* eventClaim -- claim the leaf lock to synchronize or change mode
+ *
+ * Waits until no thread is in eventBlockWait, since that thread has
+ * released the lock in the middle of synchronizing.  Only the writer
+ * (EventOutputWrite) claims the leaf lock without this.
+ */
+
+static void eventClaimWait(void)
+{
+#if defined(EVENT_OUTPUT_ASYNC)
+  while (eventBlockWaiting) {
+    (void)pthread_mutex_lock(&eventWaitLock);
+    LockReleaseGlobalLeaf();
+    while (eventBlockWaiting)
+      (void)pthread_cond_wait(&eventWaitCond, &eventWaitLock);
+    (void)pthread_mutex_unlock(&eventWaitLock);
+    LockClaimGlobalLeaf();
+  }
+#else
+  AVER(!eventBlockWaiting);
+#endif
+}
+
+static void eventClaim(void)
+{
+  LockClaimGlobalLeaf();
+  eventClaimWait();
+}
+
+
+/* eventBlockWriteHead -- write the head block from this thread */
+
+static void eventBlockWriteHead(void)
+{
+  AVER(eventBlockQueued > 0);
+  AVER(!eventBlockWriting);
+  /* TODO: Consider taking some other action if a write fails. */
+  (void)eventIOWrite(eventBlock[eventBlockHead],
+                     eventBlockSize[eventBlockHead]);
+  eventBlockPop();
+}
+
+
+/* eventBlockQueue -- queue the block being filled
+ *
+ * Returns FALSE if the queue is full and events are being dropped.
+ * Otherwise, if the queue is full, discards the oldest block (in the
+ * ring mode), or waits for the writer or writes the oldest block from
+ * this thread, so that the mutator pays for the output, as in the
+ * synchronous mode.
+ */
+
+static Bool eventBlockQueue(void)
+{
+  eventBlockReap();
+  if (eventBlockQueued == EventOutputBlockCOUNT - 1) {
+    switch (eventOutputMode) {
+    case EventOutputModeDROP:
+      return FALSE;
+    case EventOutputModeRING:
+      AVER(!eventBlockWriting);
+      eventBlockPop();
+      break;
+    default:
+      AVER(eventOutputMode == EventOutputModeBLOCK);
+      while (eventBlockWriting
+             && eventBlockQueued == EventOutputBlockCOUNT - 1)
+        eventBlockWait();
+      if (eventBlockQueued == EventOutputBlockCOUNT - 1)
+        eventBlockWriteHead();
+      break;
+    }
+  }
+  AVER(eventBlockQueued < EventOutputBlockCOUNT - 1);
+  ++eventBlockQueued;
+  AVER(eventBlockSize[eventBlockFill()] == 0);
+  return TRUE;
+}
+
+
+/* eventOutput -- output events
+ *
+ * The buffer must contain a whole number of events.  In the
+ * synchronous output mode, they are written to the telemetry stream.
+ * Otherwise they are copied into the output queue, one at a time so
+ * that an event is never split between blocks, or dropped in part.
+ */
+
+static Res eventOutput(void *buf, size_t size)
+{
+  char *p = buf, *limit = p + size;
+
+  if (eventOutputMode == EventOutputModeSYNC)
+    return eventIOWrite(buf, size);
+
+  while (p < limit) {
+    size_t eventSize = ((Event)p)->any.size;
+    Count fill = eventBlockFill();
+    AVER(eventSize <= EventOutputBlockSIZE);
+    if (eventSize > EventOutputBlockSIZE - eventBlockSize[fill]
+        && eventBlockQueue())
+      fill = eventBlockFill();
+    if (eventSize <= EventOutputBlockSIZE - eventBlockSize[fill]) {
+      (void)mps_lib_memcpy(&eventBlock[fill][eventBlockSize[fill]],
+                           p, eventSize);
+      eventBlockSize[fill] += eventSize;
+    } else {
+      ++eventDropped;
+    }
+    p += eventSize;
+  }
+  AVER(p == limit);
+  return ResOK;
+}
+
+
+/* eventClockSyncFill -- Populate the clock sync event; return its size */
+
+static size_t eventClockSyncFill(void)
 {
-  Res res;
   size_t size;
 
   size= size_tAlignUp(sizeof(eventClockSyncStruct), MPS_PF_ALIGN);
@@ -58,7 +358,106 @@ static Res eventClockSync(void)
   eventClockSyncStruct.size = (EventSize)size;
   EVENT_CLOCK(eventClockSyncStruct.clock);
   eventClockSyncStruct.f0 = (Word)mps_clock();
-  res = (Res)mps_io_write(eventIO, (void *)&eventClockSyncStruct, size);
+  return size;
+}
+
+
+/* eventRingHeader -- write the header of a flight recorder dump
+ *
+ * The EventInit event at the start of the telemetry stream has
+ * usually been discarded from the ring by the time it is dumped, so
+ * the dump starts with a copy, followed by a clock sync event, so that
+ * it can be decoded on its own.
+ */
+
+static void eventRingHeader(void)
+{
+  size_t size;
+
+  size = size_tAlignUp(sizeof(eventRingInitStruct), MPS_PF_ALIGN);
+  eventRingInitStruct.code = EventEventInitCode;
+  eventRingInitStruct.size = (EventSize)size;
+  EVENT_CLOCK(eventRingInitStruct.clock);
+  eventRingInitStruct.f0 = EVENT_VERSION_MAJOR;
+  eventRingInitStruct.f1 = EVENT_VERSION_MEDIAN;
+  eventRingInitStruct.f2 = EVENT_VERSION_MINOR;
+  eventRingInitStruct.f3 = EventCodeMAX;
+  eventRingInitStruct.f4 = EventNameMAX;
+  eventRingInitStruct.f5 = MPS_WORD_WIDTH;
+  eventRingInitStruct.f6 = mps_clocks_per_sec();
+  (void)eventIOWrite(&eventRingInitStruct, size);
+
+  size = eventClockSyncFill();
+  (void)eventIOWrite(&eventClockSyncStruct, size);
+}
+
+
+/* eventDrain -- write all queued output to the telemetry stream
+ *
+ * The caller must hold the leaf global lock.
+ */
+
+static void eventDrain(void)
+{
+  if (eventOutputMode != EventOutputModeSYNC) {
+    Count fill;
+    eventBlockReap();
+    while (eventBlockWriting)
+      eventBlockWait();
+    if (eventOutputMode == EventOutputModeRING
+        && (eventBlockQueued > 0 || eventBlockSize[eventBlockFill()] > 0))
+      eventRingHeader();
+    while (eventBlockQueued > 0)
+      eventBlockWriteHead();
+    fill = eventBlockFill();
+    if (eventBlockSize[fill] > 0) {
+      (void)eventIOWrite(eventBlock[fill], eventBlockSize[fill]);
+      eventBlockSize[fill] = 0;
+    }
+  }
+  if (eventIOInited)
+    (void)mps_io_flush(eventIO);
+}
+
+
+/* eventDump -- write the output queue without synchronizing
+ *
+ * Called by EventDrain when the calling thread already holds the leaf
+ * lock, which means that an assertion has failed in the telemetry
+ * system and the assertion handler is dumping telemetry.  The buffers
+ * and the queue may be inconsistent, so this writes every block that
+ * the writer isn't writing, without changing the queue, and without
+ * any assertions that might re-enter the handler.  See
+ * <design/telemetry/#ring.assert>.
+ */
+
+static void eventDump(void)
+{
+  Count i, block;
+
+  if (eventOutputMode == EventOutputModeSYNC)
+    return;
+  if (eventOutputMode == EventOutputModeRING)
+    eventRingHeader();
+  for (i = eventBlockWriting ? 1 : 0; i <= eventBlockQueued; ++i) {
+    block = (eventBlockHead + i) % EventOutputBlockCOUNT;
+    if (eventBlockSize[block] > 0)
+      (void)eventIOWrite(eventBlock[block], eventBlockSize[block]);
+  }
+  if (eventIOInited)
+    (void)mps_io_flush(eventIO);
+}
+
+
+/* eventClockSync -- Populate and write the clock sync event. */
+
+static Res eventClockSync(void)
+{
+  Res res;
+  size_t size;
+
+  size = eventClockSyncFill();
+  res = eventOutput((void *)&eventClockSyncStruct, size);
   if (res != ResOK)
     goto failWrite;
   
@@ -89,9 +488,119 @@ void EventFlush(EventKind kind)
 }
 
 
-/* EventSync -- synchronize the event stream with the buffers */
+/* eventCodeKind -- the kind of an event, given its code */
 
-void EventSync(void)
+#ifdef EVENT_THREAD_BUFFER
+
+static EventKind eventCodeKind(EventCode code)
+{
+  switch (code) {
+#define EVENT_CODE_KIND(X, name, code, always, kind) \
+  case code: return Event##name##Kind;
+  EVENT_LIST(EVENT_CODE_KIND, X)
+  default: return EventKindLIMIT;
+  }
+}
+
+
+/* eventSyncThreadBuffers -- write out the per-thread event buffers
+ *
+ * The pending events from all the per-thread buffers are merged by
+ * timestamp, so that they appear in the event stream in the order they
+ * were logged (within the accuracy of the clock).  Events are written
+ * up to the limit published by each owning thread when we start: a
+ * thread may log more while we run, but it won't overwrite anything
+ * below the limit until it claims the leaf lock.
+ */
+
+static Bool eventSyncThreadBuffers(void)
+{
+  char *next[EventThreadBufferCOUNT], *limit[EventThreadBufferCOUNT];
+  EventThreadBuffer tbs[EventThreadBufferCOUNT];
+  Count i, n = 0;
+  Bool wrote = FALSE;
+
+  for (i = 0; i < EventThreadBufferCOUNT; ++i) {
+    EventThreadBuffer tb = &eventThreadBuffers[i];
+    if (tb->claimed) {
+      char *tbLimit = LOAD_ACQUIRE(tb->limit);
+      AVER(tb->buffer <= tb->written);
+      AVER(tb->written <= tbLimit);
+      AVER(tbLimit <= tb->buffer + EventThreadBufferSIZE);
+      if (tb->written < tbLimit) {
+        tbs[n] = tb;
+        next[n] = tb->written;
+        limit[n] = tbLimit;
+        ++n;
+      }
+    }
+  }
+
+  /* If no events are wanted, there's no need to merge. */
+  if (EventKindControl == BS_EMPTY(EventControlSet)) {
+    for (i = 0; i < n; ++i)
+      tbs[i]->written = limit[i];
+    return FALSE;
+  }
+
+  while (n > 0) {
+    Count min = 0;
+    Event event;
+
+    for (i = 1; i < n; ++i)
+      if (((Event)next[i])->any.clock < ((Event)next[min])->any.clock)
+        min = i;
+
+    event = (Event)next[min];
+    if (BS_IS_MEMBER(EventKindControl, eventCodeKind(event->any.code))) {
+      /* TODO: Consider taking some other action if a write fails. */
+      if (eventOutput(event, event->any.size) == ResOK)
+        wrote = TRUE;
+    }
+    next[min] += event->any.size;
+    AVER(next[min] <= limit[min]);
+
+    if (next[min] == limit[min]) {
+      tbs[min]->written = limit[min];
+      --n;
+      tbs[min] = tbs[n];
+      next[min] = next[n];
+      limit[min] = limit[n];
+    }
+  }
+
+  return wrote;
+}
+
+#endif /* EVENT_THREAD_BUFFER */
+
+
+/* eventSyncDone -- finish synchronizing
+ *
+ * If we wrote out events, send an EventClockSync event and flush the
+ * telemetry stream.  In the asynchronous modes the writer flushes the
+ * stream after writing each block.
+ */
+
+static void eventSyncDone(Bool wrote)
+{
+  if (wrote) {
+    (void)eventClockSync();
+    if (eventOutputMode == EventOutputModeSYNC)
+      (void)mps_io_flush(eventIO);
+  }
+}
+
+
+/* eventSync -- synchronize the event stream with the buffers
+ *
+ * The caller must hold the leaf global lock.  The global per-kind
+ * buffers are written under the arena lock, so this should only be
+ * called by a thread that holds the arena lock, or by the client via
+ * mps_telemetry_flush (see <design/telemetry/#thread.full>).
+ */
+
+static void eventSync(void)
 {
   EventKind kind;
   Bool wrote = FALSE;
@@ -111,22 +620,11 @@ void EventSync(void)
       size = (size_t)(EventWritten[kind] - EventLast[kind]);
       if (size > 0) {
 
-        /* Ensure the IO stream is open.  We do this late so that no stream is
-           created if no events are enabled by telemetry control. */
-        if (!eventIOInited) {
-          res = (Res)mps_io_create(&eventIO);
-          if(res != ResOK) {
-            /* TODO: Consider taking some other action if open fails. */
-            return;
-          }
-          eventIOInited = TRUE;
-        }
-
         /* Writing might be faster if the size is aligned to a multiple of the
            C library or kernel's buffer size.  We could pad out the buffer with
            a marker for this purpose. */
       
-        res = (Res)mps_io_write(eventIO, (void *)EventLast[kind], size);
+        res = eventOutput((void *)EventLast[kind], size);
         if (res == ResOK) {
           /* TODO: Consider taking some other action if a write fails. */
           EventWritten[kind] = EventLast[kind];
@@ -136,12 +634,247 @@ void EventSync(void)
     }
   }
 
-  /* If we wrote out events, send an EventClockSync event and flush
-     the telemetry stream. */
-  if (wrote) {
-    (void)eventClockSync();
-    (void)mps_io_flush(eventIO);
+#ifdef EVENT_THREAD_BUFFER
+  if (eventSyncThreadBuffers())
+    wrote = TRUE;
+#endif
+
+  eventSyncDone(wrote);
+}
+
+
+/* EventSync -- synchronize the event stream with the buffers */
+
+void EventSync(void)
+{
+  eventClaim();
+  eventSync();
+  LockReleaseGlobalLeaf();
+}
+
+
+/* EventDrain -- synchronize the event stream and write all output
+ *
+ * Unlike EventSync, this waits for all events to be written to the
+ * telemetry stream, whatever the output mode.  In the ring mode, this
+ * dumps the flight recorder.
+ *
+ * This is called by the assertion handler (via mps_telemetry_flush),
+ * so it must not claim the leaf lock if the calling thread already
+ * owns it, which it does if an assertion failed in the telemetry
+ * system.  In that case, it dumps what it can with eventDump, once.
+ */
+
+void EventDrain(void)
+{
+  if (!LockClaimGlobalLeafUnlessOwned()) {
+    if (!eventDumping) {
+      eventDumping = TRUE;
+      eventDump();
+      eventDumping = FALSE;
+    }
+    return;
+  }
+  eventClaimWait();
+  eventSync();
+  eventDrain();
+  LockReleaseGlobalLeaf();
+}
+
+
+/* EventOutputSet -- set the telemetry output mode
+ *
+ * All output queued in the old mode is written before changing mode.
+ * The asynchronous modes need ordered memory accesses between threads
+ * (see config.h).
+ */
+
+Res EventOutputSet(EventOutputMode mode)
+{
+  if (mode != EventOutputModeSYNC
+      && mode != EventOutputModeBLOCK
+      && mode != EventOutputModeDROP
+      && mode != EventOutputModeRING)
+    return ResPARAM;
+#if !defined(EVENT_OUTPUT_ASYNC)
+  if (mode != EventOutputModeSYNC)
+    return ResUNIMPL;
+#endif
+
+  eventClaim();
+  eventSync();
+  eventDrain();
+  eventOutputMode = mode;
+  LockReleaseGlobalLeaf();
+  return ResOK;
+}
+
+
+/* EventOutputWrite -- write the oldest queued block of output
+ *
+ * Intended to be called repeatedly by a client thread dedicated to
+ * writing telemetry, so that the threads running the MPS don't wait
+ * for the telemetry stream.  Returns TRUE if it wrote a block, FALSE
+ * if there was nothing to write.  The write itself happens without
+ * holding any lock.
+ */
+
+Bool EventOutputWrite(void)
+{
+  Count head;
+
+  LockClaimGlobalLeaf();
+  eventBlockReap();
+  if (eventOutputMode == EventOutputModeSYNC
+      || eventOutputMode == EventOutputModeRING
+      || eventBlockWriting
+      || eventBlockQueued == 0
+      || eventIOEnsure() != ResOK) {
+    LockReleaseGlobalLeaf();
+    return FALSE;
+  }
+  head = eventBlockHead;
+  eventBlockWriting = TRUE;
+  LockReleaseGlobalLeaf();
+
+  /* TODO: Consider taking some other action if a write fails. */
+  (void)mps_io_write(eventIO, eventBlock[head], eventBlockSize[head]);
+  (void)mps_io_flush(eventIO);
+#if defined(EVENT_OUTPUT_ASYNC)
+  (void)pthread_mutex_lock(&eventWaitLock);
+  STORE_RELEASE(eventBlockWritten, TRUE);
+  ++eventBlockWrites;
+  (void)pthread_cond_broadcast(&eventWaitCond);
+  (void)pthread_mutex_unlock(&eventWaitLock);
+#else
+  NOTREACHED; /* Only the asynchronous modes have a writer. */
+#endif
+  return TRUE;
+}
+
+
+/* EventDropped -- number of events dropped from the output queue */
+
+Count EventDropped(void)
+{
+  return eventDropped;
+}
+
+
+#ifdef EVENT_THREAD_BUFFER
+
+/* EventThreadBufferReserve -- make room in the thread's event buffer
+ *
+ * Called by EVENT_THREAD_RESERVE when the calling thread has no event
+ * buffer, or not enough room in it for an event of the given size.
+ * Returns the thread's buffer with room for the event, or NULL if the
+ * thread can't claim a buffer.
+ */
+
+EventThreadBuffer EventThreadBufferReserve(size_t size)
+{
+  EventThreadBuffer tb = EventThreadBufferCurrent;
+  Count i;
+
+  AVER(eventInited);
+  AVER(size <= EventThreadBufferSIZE);
+
+  if (tb == &eventThreadBufferNone)
+    return NULL;
+
+  eventClaim();
+  if (tb == NULL) {
+    for (i = 0; eventThreadBufferKeyCreated && i < EventThreadBufferCOUNT;
+         ++i) {
+      if (!eventThreadBuffers[i].claimed) {
+        /* <design/telemetry/#thread.release> */
+        if (pthread_setspecific(eventThreadBufferKey,
+                                &eventThreadBuffers[i]) == 0) {
+          tb = &eventThreadBuffers[i];
+          tb->claimed = TRUE;
+          tb->written = tb->limit = tb->buffer;
+        }
+        break;
+      }
+    }
+    if (tb == NULL)
+      tb = &eventThreadBufferNone;
+    EventThreadBufferCurrent = tb;
+  } else {
+    /* Send all pending events in the per-thread buffers to the event
+       stream, and then empty the buffer whether or not we sent them,
+       as EventFlush does.  The calling thread need not hold the arena
+       lock, so it mustn't touch the global buffers. */
+    eventSyncDone(eventSyncThreadBuffers());
+    AVER(tb->written == tb->limit);
+    tb->written = tb->buffer;
+    STORE_RELEASE(tb->limit, tb->buffer);
   }
+  LockReleaseGlobalLeaf();
+
+  if (tb == &eventThreadBufferNone)
+    return NULL;
+  return tb;
+}
+
+#endif /* EVENT_THREAD_BUFFER */
+
+
+/* eventThreadBufferRelease -- release an event buffer
+ *
+ * Sends any pending events in the buffer to the event stream and makes
+ * it available to other threads.
+ */
+
+#ifdef EVENT_THREAD_BUFFER
+
+static void eventThreadBufferRelease(EventThreadBuffer tb)
+{
+  eventClaim();
+  eventSyncDone(eventSyncThreadBuffers());
+  AVER(tb->written == tb->limit);
+  tb->claimed = FALSE;
+  LockReleaseGlobalLeaf();
+}
+
+
+/* eventThreadBufferExit -- release a thread's event buffer at exit
+ *
+ * The destructor for eventThreadBufferKey, called by the thread
+ * library when a thread that claimed a buffer exits, whether or not
+ * the thread was registered. See <design/telemetry/#thread.release>.
+ */
+
+static void eventThreadBufferExit(void *value)
+{
+  /* Destructors for other keys may log events after this one. */
+  EventThreadBufferCurrent = &eventThreadBufferNone;
+  eventThreadBufferRelease(value);
+}
+
+#endif /* EVENT_THREAD_BUFFER */
+
+
+/* EventThreadBufferRelease -- release the thread's event buffer
+ *
+ * Releases the calling thread's event buffer. The thread claims a
+ * buffer again if it logs more events.
+ */
+
+void EventThreadBufferRelease(void)
+{
+#ifdef EVENT_THREAD_BUFFER
+  EventThreadBuffer tb = EventThreadBufferCurrent;
+
+  if (tb == NULL)
+    return;
+
+  EventThreadBufferCurrent = NULL;
+  if (tb != &eventThreadBufferNone) {
+    (void)pthread_setspecific(eventThreadBufferKey, NULL);
+    eventThreadBufferRelease(tb);
+  }
+#endif
 }
 
 
@@ -198,6 +931,7 @@ void EventInit(void)
   
   /* Ensure that no event can be larger than the maximum event size. */
   AVER(EventBufferSIZE <= EventSizeMAX);
+  AVER(EventBufferSIZE <= EventOutputBlockSIZE);
 
   /* Only if this is the first call. */
   if (!eventInited) { /* See .trans.log */
@@ -209,6 +943,13 @@ void EventInit(void)
         AVER(EventWritten[kind] == NULL);
         EventLast[kind] = EventWritten[kind] = EventBuffer[kind] + EventBufferSIZE;
       }
+#ifdef EVENT_THREAD_BUFFER
+      /* If the key can't be created, all events are logged to the
+         global buffers. */
+      eventThreadBufferKeyCreated =
+        pthread_key_create(&eventThreadBufferKey,
+                           eventThreadBufferExit) == 0;
+#endif
       eventInited = TRUE;
       EventKindControl = (Word)mps_lib_telemetry_control();
       EventInternSerial = (Serial)1; /* 0 is reserved */
@@ -230,7 +971,12 @@ void EventFinish(void)
 {
   AVER(eventInited);
 
-  EventSync();
+  /* In the ring mode, keep the events for a later dump. */
+  eventClaim();
+  eventSync();
+  if (eventOutputMode != EventOutputModeRING)
+    eventDrain();
+  LockReleaseGlobalLeaf();
 }
 
 
@@ -432,6 +1178,23 @@ void EventDump(mps_lib_FILE *stream)
       (void)WriteF(stream, 0, "\n", NULL);
     }
   }
+
+#ifdef EVENT_THREAD_BUFFER
+  {
+    Count i;
+    for (i = 0; i < EventThreadBufferCOUNT; ++i) {
+      EventThreadBuffer tb = &eventThreadBuffers[i];
+      if (tb->claimed) {
+        for (event = (Event)tb->buffer;
+             (char *)event < tb->limit;
+             event = (Event)((char *)event + event->any.size)) {
+          (void)EventWrite(event, stream);
+          (void)WriteF(stream, 0, "\n", NULL);
+        }
+      }
+    }
+  }
+#endif
 }
 
 
@@ -515,6 +1278,37 @@ void EventDump(mps_lib_FILE *stream)
 }
 
 
+void EventThreadBufferRelease(void)
+{
+  NOOP;
+}
+
+
+void EventDrain(void)
+{
+  NOOP;
+}
+
+
+Res EventOutputSet(EventOutputMode mode)
+{
+  UNUSED(mode);
+  return ResUNIMPL;
+}
+
+
+Bool EventOutputWrite(void)
+{
+  return FALSE;
+}
+
+
+Count EventDropped(void)
+{
+  return 0;
+}
+
+
 #endif /* EVENT */
 
 
@@ -23,6 +23,14 @@
 
 typedef Word EventStringId;
 typedef Word EventControlSet;
+typedef unsigned EventOutputMode;
+
+/* Telemetry output modes: see <design/telemetry/#async>.  Keep in
+   sync with MPS_TELEMETRY_OUTPUT_* in mps.h. */
+#define EventOutputModeSYNC  ((EventOutputMode)0)
+#define EventOutputModeBLOCK ((EventOutputMode)1)
+#define EventOutputModeDROP  ((EventOutputMode)2)
+#define EventOutputModeRING  ((EventOutputMode)3)
 
 extern void EventSync(void);
 extern void EventInit(void);
@@ -36,6 +44,11 @@ extern void EventFlush(EventKind kind);
 extern Res EventDescribe(Event event, mps_lib_FILE *stream, Count depth);
 extern Res EventWrite(Event event, mps_lib_FILE *stream);
 extern void EventDump(mps_lib_FILE *stream);
+extern void EventThreadBufferRelease(void);
+extern void EventDrain(void);
+extern Res EventOutputSet(EventOutputMode mode);
+extern Bool EventOutputWrite(void);
+extern Count EventDropped(void);
 
 
 #ifdef EVENT
@@ -47,26 +60,104 @@ extern char *EventLast[EventKindLIMIT];
 extern Word EventKindControl;
 
 
-/* Events are written into the buffer from the top down, so that a backtrace
-   can find them all starting at EventLast. */
+/* EventThreadBufferStruct -- per-thread event buffer
+ *
+ * Events emitted by a thread that has claimed one of these are
+ * appended at the limit by the owning thread without locking, and
+ * published by a release store to the limit.  Events in
+ * [written, limit) are yet to be sent to the event stream.  See
+ * <design/telemetry/#thread>.
+ */
+
+typedef struct EventThreadBufferStruct *EventThreadBuffer;
+
+typedef struct EventThreadBufferStruct {
+  Bool claimed;                 /* owned by some thread? */
+  char *written;                /* end of events sent to the stream */
+  char *limit;                  /* end of events logged by owner */
+  char buffer[EventThreadBufferSIZE]; /* events, oldest first */
+} EventThreadBufferStruct;
+
+#ifdef EVENT_THREAD_BUFFER
+
+extern THREAD_LOCAL EventThreadBuffer EventThreadBufferCurrent;
+extern EventThreadBuffer EventThreadBufferReserve(size_t size);
+
+/* EVENT_THREAD_RESERVE -- find room in this thread's event buffer
+ *
+ * Sets tb to the calling thread's event buffer if it has room for an
+ * event of the given size, claiming or flushing the buffer if
+ * necessary, or to NULL if the thread has no buffer, in which case
+ * the event must be logged into the global buffer.
+ */
+
+#define EVENT_THREAD_RESERVE(tb, size) \
+  BEGIN \
+    (tb) = EventThreadBufferCurrent; \
+    if ((tb) == NULL \
+        || (size) > (size_t)((tb)->buffer + EventThreadBufferSIZE \
+                             - (tb)->limit)) \
+      (tb) = EventThreadBufferReserve(size); \
+  END
+
+#define EVENT_THREAD_COMMIT(tb, size) \
+  STORE_RELEASE((tb)->limit, (tb)->limit + (size))
+
+#else /* EVENT_THREAD_BUFFER, not */
+
+#define EVENT_THREAD_RESERVE(tb, size) \
+  BEGIN (tb) = NULL; UNUSED(size); END
+
+#define EVENT_THREAD_COMMIT(tb, size) \
+  BEGIN UNUSED(tb); UNUSED(size); NOTREACHED; END
+
+#endif /* EVENT_THREAD_BUFFER */
+
+
+/* EVENT_KIND_ENABLED -- is output of events of this kind enabled?
+ *
+ * Events are filtered by kind only when they are written to the
+ * telemetry stream, so code that emits very many events (for example,
+ * an event for every allocation) tests this first, to avoid the cost
+ * of logging events that will be thrown away.
+ */
+
+#define EVENT_KIND_ENABLED(kind) \
+  BS_IS_MEMBER(EventKindControl, EventKind##kind)
+
+
+/* Events are written into a per-thread buffer from the bottom up, if
+   the thread has one (see above), otherwise into the global buffer
+   for their kind from the top down, so that a backtrace can find them
+   all starting at EventLast.  Only the latter requires the caller to
+   hold a lock. */
 
 #define EVENT_BEGIN(name, structSize) \
   BEGIN \
     if(EVENT_ALL || Event##name##Always) { /* see config.h */ \
       Event##name##Struct *_event; \
+      EventThreadBuffer _tb; \
       size_t _size = size_tAlignUp(structSize, MPS_PF_ALIGN); \
-      if (_size > (size_t)(EventLast[Event##name##Kind] \
-                           - EventBuffer[Event##name##Kind])) \
-        EventFlush(Event##name##Kind); \
-      AVER(_size <= (size_t)(EventLast[Event##name##Kind] \
-                             - EventBuffer[Event##name##Kind])); \
-      _event = (void *)(EventLast[Event##name##Kind] - _size); \
+      EVENT_THREAD_RESERVE(_tb, _size); \
+      if (_tb != NULL) { \
+        _event = (void *)_tb->limit; \
+      } else { \
+        if (_size > (size_t)(EventLast[Event##name##Kind] \
+                             - EventBuffer[Event##name##Kind])) \
+          EventFlush(Event##name##Kind); \
+        AVER(_size <= (size_t)(EventLast[Event##name##Kind] \
+                               - EventBuffer[Event##name##Kind])); \
+        _event = (void *)(EventLast[Event##name##Kind] - _size); \
+      } \
       _event->code = Event##name##Code; \
       _event->size = (EventSize)_size; \
       EVENT_CLOCK(_event->clock);
 
 #define EVENT_END(name, size) \
-      EventLast[Event##name##Kind] -= _size; \
+      if (_tb != NULL) \
+        EVENT_THREAD_COMMIT(_tb, _size); \
+      else \
+        EventLast[Event##name##Kind] -= _size; \
     } \
   END
 
@@ -123,6 +214,8 @@ extern Word EventKindControl;
 #else /* EVENT not */
 
 
+#define EVENT_KIND_ENABLED(kind) FALSE
+
 #define EVENT0(name) NOOP
 /* The following lines were generated with
    python -c 'for i in range(1,22): print "#define EVENT%d(name, %s) BEGIN %s END" % (i, ", ".join(["p%d" % j for j in range(0, i)]), " ".join(["UNUSED(p%d);" % j for j in range(0, i)]))'
@@ -30,6 +30,12 @@
  * variable used to specify the telemetry file to the MPS library).
  * If the environment variable does not exist, the default filename of
  * "mpsio.log" is used.
+ *
+ * The log is read in windows of WINDOW_SIZE bytes.  Each window is
+ * split at event boundaries into as many chunks as there are jobs
+ * (set with the -j command-line argument), and the chunks are decoded
+ * in parallel into memory, then written in order, so the output is
+ * the same whatever the number of jobs.
  * 
  * $Id$
  */
@@ -38,6 +44,7 @@
 #include "eventdef.h"
 #include "eventcom.h"
 #include "testlib.h" /* for ulongest_t and associated print formats */
+#include "testthr.h"
 
 #include <stddef.h> /* for size_t */
 #include <stdio.h> /* for printf */
@@ -49,33 +56,45 @@
 #define DEFAULT_TELEMETRY_FILENAME "mpsio.log"
 #define TELEMETRY_FILENAME_ENVAR   "MPS_TELEMETRY_FILENAME"
 
-static EventClock eventTime; /* current event time */
+#define WINDOW_SIZE ((size_t)1 << 24) /* bytes of log decoded at once */
+#define JOBS_DEFAULT 4 /* number of chunks per window */
+#define JOBS_MAX 64
+#define FIELD_MAX 64 /* longest output of a non-string field */
+
 static const char *prog; /* program name */
+static unsigned nJobs = JOBS_DEFAULT; /* number of decoding threads */
 
 /* Errors and Warnings */
 
-/* fevwarn -- flush stdout, write message to stderr */
+/* fevwarn -- write message to stderr
+ *
+ * If time is not NULL, it is the printed time of the event that the
+ * message concerns.
+ */
 
-ATTRIBUTE_FORMAT((printf, 2, 0))
-static void fevwarn(const char *prefix, const char *format, va_list args)
+ATTRIBUTE_FORMAT((printf, 3, 0))
+static void fevwarn(const char *prefix, const char *time,
+                    const char *format, va_list args)
 {
-  (void)fflush(stdout); /* sync */
-  (void)fprintf(stderr, "%s: %s @", prog, prefix);
-  (void)EVENT_CLOCK_PRINT(stderr, eventTime);
+  (void)fprintf(stderr, "%s: %s", prog, prefix);
+  if (time != NULL)
+    (void)fprintf(stderr, " @%s", time);
   (void)fprintf(stderr, " ");
   (void)vfprintf(stderr, format, args);
   (void)fprintf(stderr, "\n");
 }
 
-/* evwarn -- flush stdout, warn to stderr */
+/* evwarn -- warn to stderr about the event at time clock */
 
-ATTRIBUTE_FORMAT((printf, 1, 2))
-static void evwarn(const char *format, ...)
+ATTRIBUTE_FORMAT((printf, 2, 3))
+static void evwarn(EventClock clock, const char *format, ...)
 {
+  char time[FIELD_MAX];
   va_list args;
 
+  (void)EVENT_CLOCK_SPRINT(time, clock);
   va_start(args, format);
-  fevwarn("Warning", format, args);
+  fevwarn("Warning", time, format, args);
   va_end(args);
 }
 
@@ -86,8 +105,9 @@ static void everror(const char *format, ...)
 {
   va_list args;
 
+  (void)fflush(stdout); /* sync */
   va_start(args, format);
-  fevwarn("Error", format, args);
+  fevwarn("Error", NULL, format, args);
   va_end(args);
   exit(EXIT_FAILURE);
 }
@@ -97,7 +117,7 @@ static void everror(const char *format, ...)
 
 static void usage(void)
 {
-  (void)fprintf(stderr, "Usage: %s [-f logfile] [-h]\n"
+  (void)fprintf(stderr, "Usage: %s [-f logfile] [-j jobs] [-h]\n"
                 "See \"Telemetry\" in the reference manual for instructions.\n",
                 prog);
 }
@@ -134,6 +154,17 @@ static char *parseArgs(int argc, char *argv[])
         else
           name = argv[i];
         break;
+      case 'j': /* number of jobs */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else {
+          long n = strtol(argv[i], NULL, 10);
+          if (n < 1 || n > JOBS_MAX)
+            everror("Number of jobs must be from 1 to %d", JOBS_MAX);
+          nJobs = (unsigned)n;
+        }
+        break;
       case '?': case 'h': /* help */
         usage();
         exit(EXIT_SUCCESS);
@@ -147,153 +178,260 @@ static char *parseArgs(int argc, char *argv[])
 }
 
 
+/* Output buffers
+ *
+ * Each chunk of the log is decoded into its own buffer in memory, so
+ * that chunks can be decoded in parallel and then written in order.
+ */
+
+typedef struct OutStruct {
+  char *base;           /* start of buffer */
+  size_t size;          /* bytes of output in buffer */
+  size_t capacity;      /* bytes allocated for buffer */
+} OutStruct, *Out;
+
+/* outEnsure -- ensure there's room for n more bytes of output */
+
+static void outEnsure(Out out, size_t n)
+{
+  if (out->capacity - out->size < n) {
+    size_t capacity = out->capacity == 0 ? WINDOW_SIZE : out->capacity;
+    char *base;
+    while (capacity - out->size < n)
+      capacity *= 2;
+    base = realloc(out->base, capacity);
+    if (base == NULL)
+      everror("Out of memory for output buffer");
+    out->base = base;
+    out->capacity = capacity;
+  }
+}
+
+/* outSprintf -- account for output written by sprintf */
+
+static void outSprintf(Out out, int n)
+{
+  assert(n >= 0 && (size_t)n < FIELD_MAX);
+  out->size += (size_t)n;
+}
+
+
 /* Printing routines */
 
-static void printHex(ulongest_t val)
+static void printHex(Out out, ulongest_t val)
 {
-  printf(" %"PRIXLONGEST, (ulongest_t)val);
+  outEnsure(out, FIELD_MAX);
+  outSprintf(out, sprintf(out->base + out->size, " %"PRIXLONGEST, val));
 }
         
-#define printParamP(p) printHex((ulongest_t)p)
-#define printParamA(a) printHex((ulongest_t)a)
-#define printParamU(u) printHex((ulongest_t)u)
-#define printParamW(w) printHex((ulongest_t)w)
-#define printParamB(b) printHex((ulongest_t)b)
+#define printParamP(out, p) printHex(out, (ulongest_t)p)
+#define printParamA(out, a) printHex(out, (ulongest_t)a)
+#define printParamU(out, u) printHex(out, (ulongest_t)u)
+#define printParamW(out, w) printHex(out, (ulongest_t)w)
+#define printParamB(out, b) printHex(out, (ulongest_t)b)
 
-static void printParamD(double d)
+static void printParamD(Out out, double d)
 {
-  printf(" %.10G", d);
+  outEnsure(out, FIELD_MAX);
+  outSprintf(out, sprintf(out->base + out->size, " %.10G", d));
 }
 
-static void printParamS(const char *str)
+static void printParamS(Out out, const char *str)
 {
   size_t i;
-  putchar(' ');
-  putchar('"');
+  /* Each character may be escaped; add a space and two quotes. */
+  outEnsure(out, 2 * sizeof(EventFS) + 3);
+  out->base[out->size++] = ' ';
+  out->base[out->size++] = '"';
   for (i = 0; str[i] != '\0'; ++i) {
     char c = str[i];
     if (c == '"' || c == '\\')
-      putchar('\\');
-    putchar(c);
+      out->base[out->size++] = '\\';
+    out->base[out->size++] = c;
   }
-  putchar('"');
+  out->base[out->size++] = '"';
 }
 
 
-/* EventRead -- read one event from the file */
+/* printEvent -- decode one event and append it to the output */
 
-static Res eventRead(Bool *eofOut, EventUnion *event, FILE *stream)
+static void printEvent(Out out, Event event)
 {
-  size_t n;
-  size_t rest;
-
-  /* Read the prefix common to all event structures, in order to decode the
-     event size. */
-  n = fread(&event->any, sizeof(event->any), 1, stream);
-  if (n < 1) {
-    if (feof(stream)) {
-      *eofOut = TRUE;
-      return ResOK;
-    }
-    return ResIO;
+  EventClock eventTime = event->any.clock;
+  EventCode code = event->any.code;
+
+  /* Special handling for some events, prior to text output */
+
+  switch(code) {
+  case EventEventInitCode:
+    if ((event->EventInit.f0 != EVENT_VERSION_MAJOR) ||
+        (event->EventInit.f1 != EVENT_VERSION_MEDIAN) ||
+        (event->EventInit.f2 != EVENT_VERSION_MINOR))
+      evwarn(eventTime,
+             "Event log version does not match: %d.%d.%d vs %d.%d.%d",
+             event->EventInit.f0,
+             event->EventInit.f1,
+             event->EventInit.f2,
+             EVENT_VERSION_MAJOR,
+             EVENT_VERSION_MEDIAN,
+             EVENT_VERSION_MINOR);
+
+    if (event->EventInit.f3 > EventCodeMAX)
+      evwarn(eventTime,
+             "Event log may contain unknown events with codes from %d to %d",
+             EventCodeMAX+1, event->EventInit.f3);
+
+    if (event->EventInit.f5 != MPS_WORD_WIDTH)
+      /* This probably can't happen; other things will break
+       * before we get here */
+      evwarn(eventTime,
+             "Event log has incompatible word width: %d instead of %d",
+             event->EventInit.f5,
+             MPS_WORD_WIDTH);
+    break;
+  default:
+    /* No special treatment needed. */
+    break;
   }
 
-  if (event->any.size < sizeof(event->any))
-    return ResFAIL; /* invalid size: too small */
-
-  if (event->any.size > sizeof(*event))
-    return ResFAIL; /* invalid size: too large */
-
-  /* Read the rest of the event. */
-  rest = event->any.size - sizeof(event->any);
-  if (rest > 0) {
-    n = fread((char *)event + sizeof(event->any), rest, 1, stream);
-    if (n < 1) {
-      if (feof(stream))
-        return ResFAIL; /* truncated event */
-      else
-        return ResIO;
-    }
+  outEnsure(out, FIELD_MAX);
+  outSprintf(out, EVENT_CLOCK_SPRINT(out->base + out->size, eventTime));
+  outEnsure(out, FIELD_MAX);
+  outSprintf(out, sprintf(out->base + out->size, " %4X", (unsigned)code));
+
+  switch (code) {
+#define EVENT_PARAM_PRINT(name, index, sort, ident)     \
+    printParam##sort(out, event->name.f##index);
+#define EVENT_PRINT(X, name, code, always, kind)        \
+    case code:                                          \
+      EVENT_##name##_PARAMS(EVENT_PARAM_PRINT, name)    \
+      break;
+    EVENT_LIST(EVENT_PRINT, X)
+  default:
+    evwarn(eventTime, "Unknown event code %d", code);
   }
 
-  *eofOut = FALSE;
-  return ResOK;
+  outEnsure(out, 1);
+  out->base[out->size++] = '\n';
 }
 
+
+/* Jobs
+ *
+ * A job decodes a chunk: a sequence of complete events in the current
+ * window of the log.
+ */
+
+typedef struct JobStruct {
+  const char *base;     /* first event in chunk */
+  const char *limit;    /* end of last event in chunk */
+  OutStruct outStruct;  /* decoded output */
+  testthr_t thread;     /* thread decoding the chunk */
+} JobStruct, *Job;
+
+/* decodeJob -- decode all the events in a job's chunk
+ *
+ * Events are copied out of the window before decoding, because the
+ * window is not necessarily aligned for every event structure.
+ */
+
+static void *decodeJob(void *closure)
+{
+  Job job = closure;
+  const char *p = job->base;
+
+  job->outStruct.size = 0;
+  while (p < job->limit) {
+    EventUnion eventUnion;
+    EventAnyStruct any;
+    (void)memcpy(&any, p, sizeof any);
+    (void)memcpy(&eventUnion, p, any.size);
+    printEvent(&job->outStruct, &eventUnion);
+    p += any.size;
+  }
+  return NULL;
+}
+
+
 /* readLog -- read and parse log */
 
 static void readLog(FILE *stream)
 {
-  for(;;) { /* loop for each event */
-    EventUnion eventUnion;
-    Event event = &eventUnion;
-    EventCode code;
-    Res res;
-    Bool eof = FALSE; /* suppress warnings about uninitialized use */
-
-    /* Read and parse event. */
-    res = eventRead(&eof, event, stream);
-    if (res == ResFAIL)
-      everror("Truncated log");
-    else if (res == ResIO)
-      everror("I/O error reading log");
-    else if (res != ResOK)
-      everror("Unknown error reading log");
-    if (eof)
-      break;
+  JobStruct job[JOBS_MAX];
+  char *window;
+  size_t carry = 0; /* bytes of incomplete event from last window */
+  unsigned i;
+
+  window = malloc(WINDOW_SIZE);
+  if (window == NULL)
+    everror("Out of memory for log window");
+  for (i = 0; i < nJobs; ++i) {
+    job[i].outStruct.base = NULL;
+    job[i].outStruct.size = 0;
+    job[i].outStruct.capacity = 0;
+  }
 
-    eventTime = event->any.clock;
-    code = event->any.code;
-    
-    /* Special handling for some events, prior to text output */
-
-    switch(code) {
-    case EventEventInitCode:
-      if ((event->EventInit.f0 != EVENT_VERSION_MAJOR) ||
-          (event->EventInit.f1 != EVENT_VERSION_MEDIAN) ||
-          (event->EventInit.f2 != EVENT_VERSION_MINOR))
-        evwarn("Event log version does not match: %d.%d.%d vs %d.%d.%d",
-               event->EventInit.f0,
-               event->EventInit.f1,
-               event->EventInit.f2,
-               EVENT_VERSION_MAJOR,
-               EVENT_VERSION_MEDIAN,
-               EVENT_VERSION_MINOR);
-
-      if (event->EventInit.f3 > EventCodeMAX)
-        evwarn("Event log may contain unknown events with codes from %d to %d",
-               EventCodeMAX+1, event->EventInit.f3);
-
-      if (event->EventInit.f5 != MPS_WORD_WIDTH)
-        /* This probably can't happen; other things will break
-         * before we get here */
-        evwarn("Event log has incompatible word width: %d instead of %d",
-               event->EventInit.f5,
-               MPS_WORD_WIDTH);
-      break;
-    default:
-      /* No special treatment needed. */
-      break;
-    }
+  for (;;) { /* loop for each window */
+    size_t n, avail, pos = 0, target;
+    unsigned nUsed = 0;
+    Bool eof = FALSE;
 
-    (void)EVENT_CLOCK_PRINT(stdout, eventTime);
-    printf(" %4X", (unsigned)code);
+    n = fread(window + carry, 1, WINDOW_SIZE - carry, stream);
+    if (n < WINDOW_SIZE - carry) {
+      if (ferror(stream))
+        everror("I/O error reading log");
+      eof = TRUE;
+    }
+    avail = carry + n;
+
+    /* Find the event boundaries, and split the complete events into
+       chunks of roughly equal size. */
+    target = avail / nJobs + 1;
+    job[0].base = window;
+    while (avail - pos >= sizeof(EventAnyStruct)) {
+      EventAnyStruct any;
+      (void)memcpy(&any, window + pos, sizeof any);
+      if (any.size < sizeof any || any.size > sizeof(EventUnion))
+        everror("Corrupt log: invalid event size %u", (unsigned)any.size);
+      if (avail - pos < any.size)
+        break; /* event continues in next window */
+      pos += any.size;
+      if (pos >= target * (nUsed + 1) && nUsed + 1 < nJobs) {
+        job[nUsed].limit = window + pos;
+        ++nUsed;
+        job[nUsed].base = window + pos;
+      }
+    }
+    job[nUsed].limit = window + pos;
+    ++nUsed;
+
+    /* Decode the chunks in parallel, using this thread for the first. */
+    for (i = 1; i < nUsed; ++i)
+      testthr_create(&job[i].thread, decodeJob, &job[i]);
+    (void)decodeJob(&job[0]);
+    for (i = 1; i < nUsed; ++i)
+      testthr_join(&job[i].thread, NULL);
+
+    for (i = 0; i < nUsed; ++i) {
+      Out out = &job[i].outStruct;
+      if (fwrite(out->base, 1, out->size, stdout) < out->size)
+        everror("I/O error writing output");
+    }
 
-    switch (code) {
-#define EVENT_PARAM_PRINT(name, index, sort, ident)     \
-      printParam##sort(event->name.f##index);
-#define EVENT_PRINT(X, name, code, always, kind)        \
-      case code:                                        \
-        EVENT_##name##_PARAMS(EVENT_PARAM_PRINT, name)  \
-        break;
-      EVENT_LIST(EVENT_PRINT, X)
-    default:
-      evwarn("Unknown event code %d", code);
+    carry = avail - pos;
+    if (eof) {
+      if (carry > 0)
+        everror("Truncated log");
+      break;
     }
+    (void)memmove(window, window + pos, carry);
+  }
 
-    putchar('\n');
-    (void)fflush(stdout);
-  } /* while(!feof(input)) */
+  if (fflush(stdout) != 0)
+    everror("I/O error writing output");
+  for (i = 0; i < nJobs; ++i)
+    free(job[i].outStruct.base);
+  free(window);
 }
 
 
@@ -37,7 +37,7 @@
 
 #define EVENT_VERSION_MAJOR  ((unsigned)1)
 #define EVENT_VERSION_MEDIAN ((unsigned)6)
-#define EVENT_VERSION_MINOR  ((unsigned)1)
+#define EVENT_VERSION_MINOR  ((unsigned)4)
 
 
 /* EVENT_LIST -- list of event types and general properties
@@ -45,7 +45,8 @@
  * These specify:
  *   - Type: The name of the event type, without the leading "Event";
  *   - Code: The unique 16-bit code associated with this event type;
- *   - Always: Whether this event type should appear in "hot" varieties,
+ *   - Always: Whether this event type should appear in "hot" varieties
+ *     (EVENT_ALLOC for the events on the allocation path: see config.h),
  *   - Kind: Category into which this event falls, without the
  *     leading "EventKind";
  *
@@ -67,7 +68,7 @@
  */
  
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x0088)
+#define EventCodeMAX ((EventCode)0x008D)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -93,8 +94,8 @@
   EVENT(X, SegFree            , 0x0014,  TRUE, Seg) \
   EVENT(X, PoolInit           , 0x0015,  TRUE, Pool) \
   EVENT(X, PoolFinish         , 0x0016,  TRUE, Pool) \
-  EVENT(X, PoolAlloc          , 0x0017, FALSE, Object) \
-  EVENT(X, PoolFree           , 0x0018, FALSE, Object) \
+  EVENT(X, PoolAlloc          , 0x0017, EVENT_ALLOC, Object) \
+  EVENT(X, PoolFree           , 0x0018, EVENT_ALLOC, Object) \
   EVENT(X, LandInit           , 0x0019,  TRUE, Pool) \
   EVENT(X, Intern             , 0x001a,  TRUE, User) \
   EVENT(X, Label              , 0x001b,  TRUE, User) \
@@ -194,7 +195,12 @@
   EVENT(X, ArenaUseFreeZone   , 0x0085,  TRUE, Arena) \
   /* EVENT(X, ArenaBlacklistZone , 0x0086,  TRUE, Arena) */ \
   EVENT(X, PauseTimeSet       , 0x0087,  TRUE, Arena) \
-  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace)
+  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace) \
+  EVENT(X, PoolCreateClient   , 0x0089,  TRUE, Pool) \
+  EVENT(X, GenInit            , 0x008A,  TRUE, Arena) \
+  EVENT(X, PoolGenInit        , 0x008B,  TRUE, Pool) \
+  EVENT(X, PoolFreeStats      , 0x008C,  TRUE, Pool) \
+  EVENT(X, PoolFreeBucket     , 0x008D,  TRUE, Pool)
 
 
 /* Remember to update EventNameMAX and EventCodeMAX above! 
@@ -711,6 +717,37 @@
   PARAM(X,  4, W, preservedInPlace) /* bytes preserved in generation */ \
   PARAM(X,  5, D, mortality)    /* updated mortality */
 
+#define EVENT_PoolCreateClient_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, pool)         /* the pool */ \
+  PARAM(X,  1, P, arena)        /* the arena */ \
+  PARAM(X,  2, P, poolClass)    /* the class of the pool */
+
+#define EVENT_GenInit_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, chain)        /* the chain */ \
+  PARAM(X,  1, P, gen)          /* the generation */ \
+  PARAM(X,  2, W, serial)       /* index of generation in chain */ \
+  PARAM(X,  3, W, capacity)     /* capacity of generation, in bytes */ \
+  PARAM(X,  4, D, mortality)    /* initial mortality of generation */
+
+#define EVENT_PoolGenInit_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, pool)         /* the pool */ \
+  PARAM(X,  1, P, gen)          /* the generation */
+
+#define EVENT_PoolFreeStats_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, pool)         /* the pool */ \
+  PARAM(X,  1, W, size)         /* size of request that grew pool, or 0 */ \
+  PARAM(X,  2, W, totalSize)    /* total memory allocated from arena */ \
+  PARAM(X,  3, W, freeSize)     /* free memory (PoolFreeSize) */ \
+  PARAM(X,  4, W, blocks)       /* number of free blocks walked */ \
+  PARAM(X,  5, W, blockSize)    /* total size of free blocks walked */ \
+  PARAM(X,  6, W, largest)      /* size of largest free block */
+
+#define EVENT_PoolFreeBucket_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, pool)         /* the pool */ \
+  PARAM(X,  1, W, shift)        /* blocks of size [2^shift, 2^(shift+1)) */ \
+  PARAM(X,  2, W, count)        /* number of free blocks in bucket */ \
+  PARAM(X,  3, W, size)         /* total size of free blocks in bucket */
+
 
 #endif /* eventdef_h */
 
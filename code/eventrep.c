@@ -1,100 +1,97 @@
 /* eventrep.c: Allocation replayer routines
- * Copyright (c) 2001-2014 Ravenbrook Limited.  See end of file for license.
+ * Copyright (c) 2001-2026 Ravenbrook Limited.  See end of file for license.
  *
  * $Id$
+ *
+ * .design: <design/telemetry/#replay>.
+ *
+ * .scope: Only allocation in pools of the manual classes MVFF and MVT
+ * is replayed.  See <design/telemetry/#replay.class>.
  */
 
 #include "config.h"
-/* override variety setting for EVENT */
-#define EVENT
-
+#include "eventdef.h"
 #include "eventcom.h"
 #include "eventrep.h"
-#include "eventpro.h"
-#include "mpmtypes.h"
+#include "table.h"
+#include "testlib.h" /* for ulongest_t and associated print formats */
 
 #include "mps.h"
 #include "mpsavm.h"
-#include "mpsacl.h"
-#include "mpscmv.h"
 #include "mpscmvff.h"
-#include "mpscepvm.h"
-#include "fmtpstst.h"
-#include "mpscepdl.h"
-
-#include "table.h"
+#include "mpscmvt.h"
 
-#include <stddef.h> /* for size_t */
 #include <stdarg.h> /* for va_list */
-#include <stdlib.h> /* for EXIT_FAILURE */
 #include <stdio.h> /* for printf */
+#include <stdlib.h> /* for EXIT_FAILURE */
 #include "mpstd.h"
 
 
-#if defined(MPS_OS_W3) && defined(MPS_ARCH_I6)
-#define PRIuLONGEST "llu"
-#define PRIXPTR     "016llX"
-typedef unsigned long long ulongest_t;
-#else
-#define PRIuLONGEST "lu"
-#define PRIXPTR     "08lX"
-typedef unsigned long ulongest_t;
-#endif
-
+/* Options */
 
-typedef unsigned long ulong;
+static EventRepClass replayClass;
+static size_t replayArenaSize; /* 0 means use the logged size */
+static size_t replayCommitLimit; /* 0 means use the logged limits */
+static size_t replayExtendBy; /* 0 means use the logged extendBy */
+static size_t replaySpareCommitLimit; /* 0 means use the logged limits */
 
 
-/* Globals */
+/* Statistics */
 
-static ulong totalEvents; /* count of events */
-static ulong discardedEvents; /* count of ignored events */
-static ulong unknownEvents; /* count of unknown events */
+static EventClock eventTime; /* time of current event */
+static unsigned long totalEvents; /* count of events */
+static unsigned long discardedEvents; /* count of ignored events */
+static unsigned long poolCount; /* count of pools replayed */
+static unsigned long allocCount; /* count of objects allocated */
+static unsigned long freeCount; /* count of objects freed */
+static unsigned long unknownFreeCount; /* frees of unlogged objects */
+static size_t allocSize; /* total size allocated */
+static size_t liveSize; /* size of objects allocated but not freed */
+static size_t peakLiveSize; /* maximum of liveSize */
+static size_t peakCommitted; /* maximum memory committed by an arena */
 
-static Word eventTime;
 
 /* Dictionaries for translating from log to replay values */
+
 static Table arenaTable; /* dictionary of arenas */
+static Table paramsTable; /* dictionary of poolParams */
 static Table poolTable; /* dictionary of poolReps */
 static Table apTable; /* dictionary of apReps */
 
 
-/* poolSupport -- describes pool support for explicit deallocation */
-
-enum {supportTruncate = 1, supportFree, supportNothing};
-typedef int poolSupport;
-
-
-/* objectTable -- object address mapping structure
+/* poolParams -- pool parameters
  *
- * .obj-mapping.truncate: Pools that support truncate need to keep track
- * of object end points as well.  .obj-mapping.partial-free: Arbitrary
- * partial free is not supported.
+ * The class-specific PoolInit event comes before the PoolCreateClient
+ * event that tells us the pool is to be replayed, so its parameters
+ * are remembered until then.  See <design/telemetry/#replay.client>.
  */
 
-typedef struct objectTableStruct {
-  Table startTable;
-  Table endTable;
-} objectTableStruct;
-typedef struct objectTableStruct *objectTable;
+typedef struct poolParamsStruct {
+  EventRepClass klass;
+  size_t extendBy, avgSize, align;  /* MVFF */
+  mps_bool_t slotHigh, arenaHigh, firstFit;  /* MVFF */
+  size_t minSize, meanSize, maxSize;  /* MVT */
+  size_t reserveDepth;  /* MVT */
+  double fragLimit;  /* MVT */
+} poolParamsStruct;
+typedef struct poolParamsStruct *poolParams;
 
 
 /* poolRep -- pool tracking structure
  *
- * .pool.object-addr: Pools that support explicit free (or truncate)
- * need to maintain a mapping from the addresses in the log to those in
- * the replay.
+ * .pool.object-addr: Maintain a mapping from the addresses of objects
+ * in the log to those in the replay, so that frees can be replayed.
  *
- * .bufclass: In order to create APs with the correct arguments, the
- * replayer has to pick the right BufferInit event to use, as there's
- * one for each superclass.  The pool determines the buffer class, so
- * we store its subclass level in the pool representation.
+ * .pool.ap: MVT doesn't support mps_alloc, so PoolAlloc events are
+ * replayed by allocating on an allocation point instead.
  */
 
 typedef struct poolRepStruct {
   mps_pool_t pool; /* the replay pool */
-  objectTable objects;
-  int bufferClassLevel; /* subclass level of the buffer class */
+  mps_arena_t arena; /* the replay arena */
+  size_t align; /* alignment of the replay pool */
+  mps_ap_t ap; /* ap for replaying PoolAlloc, or NULL; see .pool.ap */
+  Table objects; /* dictionary of replay objects */
 } poolRepStruct;
 typedef struct poolRepStruct *poolRep;
 
@@ -103,26 +100,24 @@ typedef struct poolRepStruct *poolRep;
 
 typedef struct apRepStruct {
   mps_ap_t ap; /* the replay ap */
-  objectTable objects; /* object mapping for the pool of this ap */
+  poolRep pool; /* the pool of this ap */
+  mps_addr_t init; /* address reserved in the replay */
+  size_t size; /* size reserved in the replay */
 } apRepStruct;
 typedef struct apRepStruct *apRep;
 
 
-/* PointerAdd -- add offset to pointer */
-
-#define PointerAdd(p, s) ((void *)((char *)(p) + (s)))
-#define PointerSub(p, s) ((void *)((char *)(p) - (s)))
-
-
-/* error -- error signalling */
+/* everror -- report an error and exit */
 
 ATTRIBUTE_FORMAT((printf, 1, 2))
-static void error(const char *format, ...)
+static void everror(const char *format, ...)
 {
   va_list args;
 
   fflush(stdout); /* sync */
-  fprintf(stderr, "Failed @%"PRIuLONGEST" ", (ulongest_t)eventTime);
+  fprintf(stderr, "Failed @");
+  EVENT_CLOCK_PRINT(stderr, eventTime);
+  fprintf(stderr, " ");
   va_start(args, format);
   vfprintf(stderr, format, args);
   fprintf(stderr, "\n");
@@ -137,183 +132,230 @@ static void error(const char *format, ...)
  */
 
 #define verifyMPS(res) \
-  MPS_BEGIN if ((res) != MPS_RES_OK) error("line %d MPS", __LINE__); MPS_END
+  MPS_BEGIN \
+    mps_res_t _res = (res); \
+    if (_res != MPS_RES_OK) \
+      everror("line %d MPS result %d", __LINE__, (int)_res); \
+  MPS_END
 
 #define verify(cond) \
-  MPS_BEGIN if (!(cond)) error("line %d " #cond, __LINE__); MPS_END
+  MPS_BEGIN if (!(cond)) everror("line %d " #cond, __LINE__); MPS_END
 
 
-/* objectTableCreate -- create an objectTable */
+/* table methods, using malloc so as not to disturb the replay arenas;
+ * see <design/telemetry/#replay.measure>. */
 
-static objectTable objectTableCreate(poolSupport support)
+static void *tableAlloc(void *closure, size_t size)
 {
-  if (support != supportNothing) {
-    Res ires;
-    objectTable table;
+  void *p;
+  testlib_unused(closure);
+  p = malloc(size);
+  verify(p != NULL);
+  return p;
+}
 
-    table = malloc(sizeof(objectTableStruct));
-    verify(table != NULL);
-    ires = TableCreate(&table->startTable, (size_t)1<<12);
-    verify(ires == ResOK);
-    if (support == supportTruncate) {
-      ires = TableCreate(&table->endTable, (size_t)1<<12);
-      verify(ires == ResOK);
-    } else {
-      table->endTable = NULL;
-    }
-    return table;
-  } else {
-    return NULL;
-  }
+static void tableFree(void *closure, void *p, size_t size)
+{
+  testlib_unused(closure);
+  testlib_unused(size);
+  free(p);
+}
+
+static Table tableCreate(Count length)
+{
+  Table table;
+  Res res;
+
+  res = TableCreate(&table, length, tableAlloc, tableFree, NULL,
+                    (TableKey)-1, (TableKey)-2);
+  verify(res == ResOK);
+  return table;
 }
 
 
-/* objectTableDestroy -- destroy an objectTable */
+/* sizeAlignUp -- round size up to a power-of-two alignment */
 
-static void objectTableDestroy(objectTable table)
+static size_t sizeAlignUp(size_t size, size_t align)
 {
-  if (table != NULL) {
-    TableDestroy(table->startTable);
-    if (table->endTable != NULL)
-      TableDestroy(table->endTable);
-    free(table);
-  }
+  return (size + align - 1) & ~(align - 1);
 }
 
 
-/* objDefine -- add a new mapping to an objectTable */
+/* arenaRecreate -- create and record an arena */
 
-static void objDefine(objectTable table,
-                      void *logObj, void *obj, size_t size)
+static mps_arena_t arenaRecreate(void *logArena, size_t logSize)
 {
-  if (table != NULL) {
-    Res ires;
+  mps_arena_t arena;
+  mps_res_t eres;
+  Res ires;
 
-    ires = TableDefine(table->startTable, (TableKey)logObj, obj);
-    verify(ires == ResOK);
-    if (table->endTable != NULL) {
-      ires = TableDefine(table->endTable,
-                         (TableKey)PointerAdd(logObj, size),
-                         PointerAdd(obj, size));
-      verify(ires == ResOK);
-    }
-  }
+  MPS_ARGS_BEGIN(args) {
+    if (replayArenaSize != 0)
+      MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, replayArenaSize);
+    else if (logSize != 0)
+      MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, logSize);
+    if (replayCommitLimit != 0)
+      MPS_ARGS_ADD(args, MPS_KEY_COMMIT_LIMIT, replayCommitLimit);
+    if (replaySpareCommitLimit != 0)
+      MPS_ARGS_ADD(args, MPS_KEY_SPARE_COMMIT_LIMIT, replaySpareCommitLimit);
+    eres = mps_arena_create_k(&arena, mps_arena_class_vm(), args);
+  } MPS_ARGS_END(args);
+  verifyMPS(eres);
+  ires = TableDefine(arenaTable, (TableKey)logArena, (void *)arena);
+  verify(ires == ResOK);
+  return arena;
+}
+
+
+/* arenaLookup -- find the replay arena for a logged arena
+ *
+ * If the arena's creation wasn't logged (for example, because Arena
+ * events weren't enabled) then create it now.
+ */
+
+static mps_arena_t arenaLookup(void *logArena)
+{
+  void *entry;
+
+  if (TableLookup(&entry, arenaTable, (TableKey)logArena))
+    return (mps_arena_t)entry;
+  return arenaRecreate(logArena, 0);
 }
 
 
-/* objRemove -- look up and remove a mapping in an objectTable */
+/* paramsLookup -- find or create the parameters for a logged pool */
 
-static void objRemove(void **objReturn, objectTable table,
-                      void *logObj, size_t size)
+static poolParams paramsLookup(void *logPool)
 {
-  Bool found;
+  void *entry;
+  poolParams params;
   Res ires;
-  void *obj;
-  void *end;
-  void *logEnd;
 
-  found = TableLookup(&obj, table->startTable, (TableKey)logObj);
-  if (found) {
-    ires = TableRemove(table->startTable, (TableKey)logObj);
+  if (TableLookup(&entry, paramsTable, (TableKey)logPool))
+    return (poolParams)entry;
+  params = malloc(sizeof(poolParamsStruct));
+  verify(params != NULL);
+  ires = TableDefine(paramsTable, (TableKey)logPool, (void *)params);
+  verify(ires == ResOK);
+  return params;
+}
+
+
+/* paramsRemove -- forget the parameters for a logged pool */
+
+static void paramsRemove(void *logPool)
+{
+  void *entry;
+  Res ires;
+
+  if (TableLookup(&entry, paramsTable, (TableKey)logPool)) {
+    ires = TableRemove(paramsTable, (TableKey)logPool);
     verify(ires == ResOK);
-    if (table->endTable != NULL) {
-      ires = TableRemove(table->endTable,
-                         (TableKey)PointerAdd(logObj, size));
-      verify(ires == ResOK);
-    }
-    *objReturn = obj;
-    return;
+    free(entry);
   }
-  /* Must be a truncation. */
-  verify(table->endTable != NULL);
-  logEnd = PointerAdd(logObj, size);
-  found = TableLookup(&end, table->endTable, (TableKey)logEnd);
-  verify(found);
-  obj = PointerSub(end, size);
-  /* Remove the old end and insert the new one. */
-  ires = TableRemove(table->endTable, (TableKey)logEnd);
-  verify(ires == ResOK);
-  ires = TableDefine(table->endTable, (TableKey)logObj, obj);
-  verify(ires == ResOK);
-  *objReturn = obj;
-  return;
 }
 
 
-/* poolRecreate -- create and record a pool */
+/* poolRecreate -- create and record a pool
+ *
+ * If the pool is replayed in its logged class, it gets its logged
+ * parameters; otherwise, the defaults for the replay class. In either
+ * case, an MVFF pool's extendBy may be overridden.
+ */
 
-static void poolRecreate(void *logPool, void *logArena,
-                         mps_pool_class_t pool_class,
-                         poolSupport support, int bufferClassLevel, ...)
+static void poolRecreate(void *logPool, void *logArena, poolParams params)
 {
-  va_list args;
+  mps_arena_t arena;
   mps_pool_t pool;
   mps_res_t eres;
+  EventRepClass klass;
+  size_t align = MPS_PF_ALIGN;
   poolRep rep;
   Res ires;
-  void *entry;
-  Bool found;
 
-  found = TableLookup(&entry, arenaTable, (TableKey)logArena);
-  verify(found);
-  va_start(args, bufferClassLevel);
-  eres = mps_pool_create_v(&pool, (mps_arena_t)entry, klass, args);
+  arena = arenaLookup(logArena);
+  klass = replayClass == EventRepClassLOG ? params->klass : replayClass;
+  MPS_ARGS_BEGIN(args) {
+    switch (klass) {
+    case EventRepClassMVFF:
+      if (params->klass == EventRepClassMVFF) {
+        MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, params->extendBy);
+        MPS_ARGS_ADD(args, MPS_KEY_MEAN_SIZE, params->avgSize);
+        MPS_ARGS_ADD(args, MPS_KEY_ALIGN, params->align);
+        MPS_ARGS_ADD(args, MPS_KEY_MVFF_SLOT_HIGH, params->slotHigh);
+        MPS_ARGS_ADD(args, MPS_KEY_MVFF_ARENA_HIGH, params->arenaHigh);
+        MPS_ARGS_ADD(args, MPS_KEY_MVFF_FIRST_FIT, params->firstFit);
+        align = params->align;
+      }
+      if (replayExtendBy != 0)
+        MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, replayExtendBy);
+      eres = mps_pool_create_k(&pool, arena, mps_class_mvff(), args);
+      break;
+    case EventRepClassMVT:
+      if (params->klass == EventRepClassMVT) {
+        MPS_ARGS_ADD(args, MPS_KEY_MIN_SIZE, params->minSize);
+        MPS_ARGS_ADD(args, MPS_KEY_MEAN_SIZE, params->meanSize);
+        MPS_ARGS_ADD(args, MPS_KEY_MAX_SIZE, params->maxSize);
+        MPS_ARGS_ADD(args, MPS_KEY_MVT_RESERVE_DEPTH, params->reserveDepth);
+        MPS_ARGS_ADD(args, MPS_KEY_MVT_FRAG_LIMIT, params->fragLimit);
+      }
+      eres = mps_pool_create_k(&pool, arena, mps_class_mvt(), args);
+      break;
+    default:
+      everror("line %d unknown replay class %d", __LINE__, klass);
+      return;
+    }
+  } MPS_ARGS_END(args);
   verifyMPS(eres);
-  va_end(args);
+
   rep = malloc(sizeof(poolRepStruct));
   verify(rep != NULL);
   rep->pool = pool;
-  rep->objects = objectTableCreate(support);
-  rep->bufferClassLevel = bufferClassLevel;
+  rep->arena = arena;
+  rep->align = align;
+  rep->ap = NULL;
+  if (klass == EventRepClassMVT) {
+    eres = mps_ap_create_k(&rep->ap, pool, mps_args_none);
+    verifyMPS(eres);
+  }
+  rep->objects = tableCreate((Count)1 << 10);
   ires = TableDefine(poolTable, (TableKey)logPool, (void *)rep);
   verify(ires == ResOK);
+  ++poolCount;
 }
 
 
 /* poolRedestroy -- destroy and derecord a pool */
 
-static void poolRedestroy(void *logPool)
+static void poolRedestroy(void *logPool, poolRep rep)
 {
   Res ires;
-  void *entry;
-  Bool found;
-  poolRep rep;
 
-  found = TableLookup(&entry, poolTable, (TableKey)logPool);
-  verify(found);
-  rep = (poolRep)entry;
+  if (rep->ap != NULL)
+    mps_ap_destroy(rep->ap);
   mps_pool_destroy(rep->pool);
   ires = TableRemove(poolTable, (TableKey)logPool);
   verify(ires == ResOK);
-  objectTableDestroy(rep->objects);
+  TableDestroy(rep->objects);
   free(rep);
 }
 
 
 /* apRecreate -- create and record an ap */
 
-static void apRecreate(void *logAp, void *logPool, ...)
+static void apRecreate(void *logAp, poolRep pRep)
 {
-  va_list args;
-  mps_ap_t ap;
-  poolRep pRep;
   apRep aRep;
   mps_res_t eres;
   Res ires;
-  void *entry;
-  Bool found;
 
-  found = TableLookup(&entry, poolTable, (TableKey)logPool);
-  verify(found);
-  pRep = (poolRep)entry;
-  va_start(args, logPool);
-  eres = mps_ap_create_v(&ap, pRep->pool, args);
-  verifyMPS(eres);
-  va_end(args);
   aRep = malloc(sizeof(apRepStruct));
   verify(aRep != NULL);
-  aRep->ap = ap;
-  aRep->objects = pRep->objects;
+  eres = mps_ap_create_k(&aRep->ap, pRep->pool, mps_args_none);
+  verifyMPS(eres);
+  aRep->pool = pRep;
+  aRep->init = NULL;
+  aRep->size = 0;
   ires = TableDefine(apTable, (TableKey)logAp, (void *)aRep);
   verify(ires == ResOK);
 }
@@ -321,16 +363,10 @@ static void apRecreate(void *logAp, void *logPool, ...)
 
 /* apRedestroy -- destroy and derecord an ap */
 
-static void apRedestroy(void *logAp)
+static void apRedestroy(void *logAp, apRep rep)
 {
   Res ires;
-  void *entry;
-  Bool found;
-  apRep rep;
 
-  found = TableLookup(&entry, apTable, (TableKey)logAp);
-  verify(found);
-  rep = (apRep)entry;
   mps_ap_destroy(rep->ap);
   ires = TableRemove(apTable, (TableKey)logAp);
   verify(ires == ResOK);
@@ -338,245 +374,231 @@ static void apRedestroy(void *logAp)
 }
 
 
-/* EventReplay -- replay event */
+/* objAllocated -- record the allocation of an object */
 
-static arenaJustCreated = FALSE;
+static void objAllocated(poolRep rep, void *logObj, void *obj, size_t size)
+{
+  size_t committed;
+  Res ires;
+
+  ires = TableDefine(rep->objects, (TableKey)logObj, obj);
+  verify(ires == ResOK);
+  ++allocCount;
+  allocSize += size;
+  liveSize += size;
+  if (liveSize > peakLiveSize)
+    peakLiveSize = liveSize;
+  committed = mps_arena_committed(rep->arena);
+  if (committed > peakCommitted)
+    peakCommitted = committed;
+}
+
+
+/* objFree -- replay the free of an object */
 
-void EventReplay(Event event, Word etime)
+static void objFree(poolRep rep, void *logObj, size_t logSize)
 {
-  mps_res_t eres;
+  void *obj;
+  size_t size;
   Res ires;
-  Bool found;
+
+  if (!TableLookup(&obj, rep->objects, (TableKey)logObj)) {
+    /* Allocated before capture started; see .replay.objects. */
+    ++unknownFreeCount;
+    return;
+  }
+  ires = TableRemove(rep->objects, (TableKey)logObj);
+  verify(ires == ResOK);
+  size = sizeAlignUp(logSize, rep->align);
+  mps_free(rep->pool, obj, size);
+  ++freeCount;
+  liveSize -= size;
+}
+
+
+/* poolFind, apFind -- find the replay pool or ap for a logged one */
+
+static poolRep poolFind(void *logPool)
+{
   void *entry;
+  if (TableLookup(&entry, poolTable, (TableKey)logPool))
+    return (poolRep)entry;
+  return NULL;
+}
 
-  ++totalEvents;
-  eventTime = etime;
-  switch(event->any.code) {
-  case EventArenaCreateVM: { /* arena, userSize, chunkSize */
-    mps_arena_t arena;
+static apRep apFind(void *logAp)
+{
+  void *entry;
+  if (TableLookup(&entry, apTable, (TableKey)logAp))
+    return (apRep)entry;
+  return NULL;
+}
 
-    eres = mps_arena_create(&arena, mps_arena_class_vm(),
-                            event->pww.w1);
-    verifyMPS(eres);
-    ires = TableDefine(arenaTable, (TableKey)event->pww.p0, (void *)arena);
-    verify(ires == ResOK);
-    arenaJustCreated = TRUE;
-  } break;
-  case EventArenaCreateVMNZ: { /* arena, userSize, chunkSize */
-    mps_arena_t arena;
 
-    eres = mps_arena_create(&arena, mps_arena_class_vmnz(),
-                            event->pww.w1);
-    verifyMPS(eres);
-    ires = TableDefine(arenaTable, (TableKey)event->pww.p0, (void *)arena);
-    verify(ires == ResOK);
-    arenaJustCreated = TRUE;
-  } break;
-  case EventArenaCreateCL: { /* arena, size, base */
-    mps_arena_t arena;
-    void *base;
-
-    base = malloc((size_t)event->pwa.w1);
-    verify(base != NULL);
-    eres = mps_arena_create(&arena, mps_arena_class_cl(),
-                            (Size)event->pwa.w1, base);
-    verifyMPS(eres);
-    ires = TableDefine(arenaTable, (TableKey)event->pw.p0, (void *)arena);
-    verify(ires == ResOK);
-    arenaJustCreated = TRUE;
-  } break;
-  case EventArenaDestroy: { /* arena */
-    found = TableLookup(&entry, arenaTable, (TableKey)event->p.p0);
-    verify(found);
-    mps_arena_destroy((mps_arena_t)entry);
-    ires = TableRemove(arenaTable, (TableKey)event->pw.p0);
-    verify(ires == ResOK);
-  } break;
-  case EventPoolInitMVFF: {
-    /* pool, arena, extendBy, avgSize, align, slotHigh, arenaHigh, firstFit */
-    poolRecreate(event->ppwwwuuu.p0, event->ppwwwuuu.p1,
-                 mps_class_mvff(), supportFree, 0,
-                 (size_t)event->ppwwwuuu.w2,
-                 (size_t)event->ppwwwuuu.w3,
-                 (size_t)event->ppwwwuuu.w4,
-                 (mps_bool_t)event->ppwwwuuu.u5,
-                 (mps_bool_t)event->ppwwwuuu.u6,
-                 (mps_bool_t)event->ppwwwuuu.u7);
-  } break;
-  case EventPoolInitMV: { /* pool, arena, extendBy, avgSize, maxSize */
-    /* .pool.control: The control pool will get created just after */
-    /* its arena; ignore it. */
-    if (!arenaJustCreated) {
-      poolRecreate(event->ppwww.p0, event->ppwww.p1,
-                   mps_class_mv(), supportFree, 0, (size_t)event->ppwww.w2,
-                   (size_t)event->ppwww.w3, (size_t)event->ppwww.w4);
-    } else {
-      arenaJustCreated = FALSE;
-    }
-  } break;
-  case EventPoolInitMFS: { /* pool, arena, extendBy, unitSize */
-    /* internal only */
-    ++discardedEvents;
-  } break;
-  case EventPoolInit: { /* pool, arena, class */
-    /* all internal only */
-    ++discardedEvents;
-  } break;
-  case EventPoolFinish: { /* pool */
-    found = TableLookup(&entry, poolTable, (TableKey)event->p.p0);
-    if (found) {
-      poolRedestroy(event->p.p0);
+/* EventReplay -- replay event */
+
+void EventReplay(Event event)
+{
+  mps_res_t eres;
+  poolParams params;
+  poolRep pRep;
+  apRep aRep;
+  void *entry;
+  Res ires;
+
+  ++totalEvents;
+  eventTime = event->any.clock;
+  switch (event->any.code) {
+  case EventArenaCreateVMCode: /* arena, userSize, chunkSize */
+    (void)arenaRecreate(event->ArenaCreateVM.f0,
+                        (size_t)event->ArenaCreateVM.f1);
+    break;
+  case EventArenaCreateVMNZCode: /* arena, userSize, chunkSize */
+    (void)arenaRecreate(event->ArenaCreateVMNZ.f0,
+                        (size_t)event->ArenaCreateVMNZ.f1);
+    break;
+  case EventArenaCreateCLCode: /* arena, size, base */
+    /* The replay arena is always a VM arena of the same size. */
+    (void)arenaRecreate(event->ArenaCreateCL.f0,
+                        (size_t)event->ArenaCreateCL.f1);
+    break;
+  case EventArenaDestroyCode: /* arena */
+    if (TableLookup(&entry, arenaTable, (TableKey)event->ArenaDestroy.f0)) {
+      mps_arena_destroy((mps_arena_t)entry);
+      ires = TableRemove(arenaTable, (TableKey)event->ArenaDestroy.f0);
+      verify(ires == ResOK);
     } else {
       ++discardedEvents;
     }
-  } break;
-  case EventBufferInit: { /* buffer, pool, isMutator */
-    if ((Bool)event->ppu.u2) {
-      found = TableLookup(&entry, poolTable, (TableKey)event->ppu.p1);
-      if (found) {
-        poolRep rep = (poolRep)entry;
-
-        if(rep->bufferClassLevel == 0) { /* see .bufclass */
-          apRecreate(event->ppu.p0, event->ppu.p1);
-        } else {
-          ++discardedEvents;
-        }
-      } else {
-        ++discardedEvents;
-      }
-    } else {
+    break;
+  case EventCommitLimitSetCode: /* arena, limit, OK */
+    if (replayCommitLimit == 0
+        && TableLookup(&entry, arenaTable,
+                       (TableKey)event->CommitLimitSet.f0))
+      (void)mps_arena_commit_limit_set((mps_arena_t)entry,
+                                       (size_t)event->CommitLimitSet.f1);
+    else
       ++discardedEvents;
-    }
-  } break;
-  case EventBufferInitSeg: { /* buffer, pool, isMutator */
-    if ((Bool)event->ppu.u2) {
-      found = TableLookup(&entry, poolTable, (TableKey)event->ppu.p1);
-      if (found) {
-        poolRep rep = (poolRep)entry;
-
-        if(rep->bufferClassLevel == 1) { /* see .bufclass */
-          apRecreate(event->ppu.p0, event->ppu.p1);
-        } else {
-          ++discardedEvents;
-        }
-      } else {
-        ++discardedEvents;
-      }
-    } else {
+    break;
+  case EventSpareCommitLimitSetCode: /* arena, limit */
+    if (replaySpareCommitLimit == 0
+        && TableLookup(&entry, arenaTable,
+                    (TableKey)event->SpareCommitLimitSet.f0))
+      mps_arena_spare_commit_limit_set((mps_arena_t)entry,
+                                       (size_t)event->SpareCommitLimitSet.f1);
+    else
       ++discardedEvents;
-    }
-  } break;
-  case EventBufferInitRank: { /* buffer, pool, isMutator, rank */
-    if ((Bool)event->ppuu.u2) {
-      found = TableLookup(&entry, poolTable, (TableKey)event->ppuu.p1);
-      if (found) {
-        poolRep rep = (poolRep)entry;
-
-        if(rep->bufferClassLevel == 2) { /* see .bufclass */
-          apRecreate(event->ppuu.p0, event->ppuu.p1, event->ppuu.u3);
-        } else {
-          ++discardedEvents;
-        }
-      } else {
-        ++discardedEvents;
-      }
+    break;
+  case EventPoolInitMVFFCode:
+    /* pool, arena, extendBy, avgSize, align, slotHigh, arenaHigh, firstFit */
+    params = paramsLookup(event->PoolInitMVFF.f0);
+    params->klass = EventRepClassMVFF;
+    params->extendBy = (size_t)event->PoolInitMVFF.f2;
+    params->avgSize = (size_t)event->PoolInitMVFF.f3;
+    params->align = (size_t)event->PoolInitMVFF.f4;
+    params->slotHigh = (mps_bool_t)event->PoolInitMVFF.f5;
+    params->arenaHigh = (mps_bool_t)event->PoolInitMVFF.f6;
+    params->firstFit = (mps_bool_t)event->PoolInitMVFF.f7;
+    break;
+  case EventPoolInitMVTCode:
+    /* pool, minSize, meanSize, maxSize, reserveDepth, fragLimit */
+    params = paramsLookup(event->PoolInitMVT.f0);
+    params->klass = EventRepClassMVT;
+    params->minSize = (size_t)event->PoolInitMVT.f1;
+    params->meanSize = (size_t)event->PoolInitMVT.f2;
+    params->maxSize = (size_t)event->PoolInitMVT.f3;
+    params->reserveDepth = (size_t)event->PoolInitMVT.f4;
+    params->fragLimit = (double)event->PoolInitMVT.f5 / 100.0;
+    break;
+  case EventPoolCreateClientCode: /* pool, arena, poolClass */
+    if (TableLookup(&entry, paramsTable,
+                    (TableKey)event->PoolCreateClient.f0)) {
+      poolRecreate(event->PoolCreateClient.f0, event->PoolCreateClient.f1,
+                   (poolParams)entry);
+      paramsRemove(event->PoolCreateClient.f0);
     } else {
-      ++discardedEvents;
+      ++discardedEvents; /* not a manual pool; see .scope */
     }
-  } break;
-  case EventBufferFinish: { /* buffer */
-    found = TableLookup(&entry, apTable, (TableKey)event->p.p0);
-    if (found) {
-      apRedestroy(event->p.p0);
-    } else {
+    break;
+  case EventPoolFinishCode: /* pool */
+    paramsRemove(event->PoolFinish.f0);
+    pRep = poolFind(event->PoolFinish.f0);
+    if (pRep != NULL)
+      poolRedestroy(event->PoolFinish.f0, pRep);
+    else
       ++discardedEvents;
-    }
-  } break;
-  case EventBufferReserve: { /* buffer, init, size */
-    found = TableLookup(&entry, apTable, (TableKey)event->paw.p0);
-    if (found) {
-      apRep rep = (apRep)entry;
-      mps_addr_t p;
-
-      eres = mps_reserve(&p, rep->ap, (size_t)event->paw.w2);
+    break;
+  case EventBufferInitCode: /* buffer, pool, isMutator */
+    pRep = poolFind(event->BufferInit.f1);
+    if (event->BufferInit.f2 && pRep != NULL)
+      apRecreate(event->BufferInit.f0, pRep);
+    else
+      ++discardedEvents;
+    break;
+  case EventBufferFinishCode: /* buffer */
+    aRep = apFind(event->BufferFinish.f0);
+    if (aRep != NULL)
+      apRedestroy(event->BufferFinish.f0, aRep);
+    else
+      ++discardedEvents;
+    break;
+  case EventBufferReserveCode: /* buffer, init, size */
+    aRep = apFind(event->BufferReserve.f0);
+    if (aRep != NULL) {
+      size_t size = sizeAlignUp((size_t)event->BufferReserve.f2,
+                                aRep->pool->align);
+      eres = mps_reserve(&aRep->init, aRep->ap, size);
       verifyMPS(eres);
+      aRep->size = size;
     } else {
       ++discardedEvents;
     }
-  } break;
-  case EventBufferCommit: { /* buffer, p, size, clientClass */
-    found = TableLookup(&entry, apTable, (TableKey)event->pawa.p0);
-    if (found) {
-      apRep rep = (apRep)entry;
-      mps_addr_t obj = rep->ap->init;
+    break;
+  case EventBufferCommitCode: /* buffer, p, size, clientClass */
+    aRep = apFind(event->BufferCommit.f0);
+    if (aRep != NULL) {
       mps_bool_t committed;
-      size_t size = (size_t)event->pawa.w2;
-
-      committed = mps_commit(rep->ap, obj, size);
-      verifyMPS(committed ? MPS_RES_OK : MPS_RES_FAIL);
-      objDefine(rep->objects, event->pawa.a1, obj, size);
+      verify(aRep->size != 0);
+      /* Manual pools never flip, so commit always succeeds. */
+      committed = mps_commit(aRep->ap, aRep->init, aRep->size);
+      verify(committed);
+      objAllocated(aRep->pool, event->BufferCommit.f1, aRep->init,
+                   aRep->size);
+      aRep->size = 0;
     } else {
       ++discardedEvents;
     }
-  } break;
-  case EventPoolAlloc: { /* pool, obj, size */
-    found = TableLookup(&entry, poolTable, (TableKey)event->paw.p0);
-    if (found) {
-      poolRep rep = (poolRep)entry;
+    break;
+  case EventPoolAllocCode: /* pool, pReturn, size */
+    pRep = poolFind(event->PoolAlloc.f0);
+    if (pRep != NULL) {
       void *obj;
-      size_t size = (size_t)event->paw.w2;
+      size_t size = sizeAlignUp((size_t)event->PoolAlloc.f2, pRep->align);
 
-      eres = mps_alloc(&obj, rep->pool, size);
-      verifyMPS(eres);
-      objDefine(rep->objects, event->paw.a1, obj, size);
+      if (pRep->ap != NULL) { /* see .pool.ap */
+        do {
+          eres = mps_reserve(&obj, pRep->ap, size);
+          verifyMPS(eres);
+        } while (!mps_commit(pRep->ap, obj, size));
+      } else {
+        eres = mps_alloc(&obj, pRep->pool, size);
+        verifyMPS(eres);
+      }
+      objAllocated(pRep, event->PoolAlloc.f1, obj, size);
     } else {
       ++discardedEvents;
     }
-  } break;
-  case EventPoolFree: { /* pool, obj, size */
-    found = TableLookup(&entry, poolTable, (TableKey)event->paw.p0);
-    if (found) {
-      poolRep rep = (poolRep)entry;
-      void *obj;
-      size_t size = (size_t)event->paw.w2;
-
-      objRemove(&obj, rep->objects, event->paw.a1, size);
-      mps_free(rep->pool, obj, size);
-    } else {
+    break;
+  case EventPoolFreeCode: /* pool, old, size */
+    pRep = poolFind(event->PoolFree.f0);
+    if (pRep != NULL)
+      objFree(pRep, event->PoolFree.f1, (size_t)event->PoolFree.f2);
+    else
       ++discardedEvents;
-    }
-  } break;
-  case EventCommitLimitSet: { /* arena, limit, succeeded */
-    found = TableLookup(&entry, arenaTable, (TableKey)event->pwu.p0);
-    verify(found);
-    eres = mps_arena_commit_limit_set((mps_arena_t)entry,
-                                      (size_t)event->pwu.w1);
-    verifyMPS(((Bool)event->pwu.u2 == (eres == MPS_RES_OK))
-                ? MPS_RES_OK : MPS_RES_FAIL);
-  } break;
-  case EventSpareCommitLimitSet: { /* arena, limit */
-    found = TableLookup(&entry, arenaTable, (TableKey)event->pw.p0);
-    verify(found);
-    (void)mps_arena_spare_commit_limit_set((mps_arena_t)entry,
-                                           (size_t)event->pw.w1);
-  } break;
-  case EventVMMap: case EventVMUnmap:
-  case EventVMInit: case EventVMFinish:
-  case EventArenaWriteFaults:
-  case EventArenaAlloc: case EventArenaAllocFail: case EventArenaFree:
-  case EventSegAlloc: case EventSegAllocFail: case EventSegFree:
-  case EventSegMerge: case EventSegSplit:
-  case EventBufferFill: case EventBufferEmpty:
-  case EventCBSInit: case EventMeterInit: case EventMeterValues:
-  case EventIntern: case EventLabel: {
+    break;
+  default:
     ++discardedEvents;
-  } break;
-  default: {
-    ++unknownEvents;
-    if (unknownEvents < 12) /* don't output too much */
-      printf("Unknown event @%ld: %s.\n", etime,
-             EventCode2Name(EventGetCode(event)));
-  } break;
+    break;
   }
 }
 
@@ -599,57 +621,127 @@ void EventReplay(Event event, Word etime)
 
 /* EventRepInit -- initialize the module */
 
-Res EventRepInit(void)
+Res EventRepInit(EventRepClass klass, size_t arenaSize, size_t commitLimit,
+                 size_t extendBy, size_t spareCommitLimit)
 {
-  Res res;
-
   /* Check using pointers as keys in the tables. */
   verify(CHECKCONV(Word, void *));
   /* Check storage of MPS opaque handles in the tables. */
   verify(COMPATTYPE(mps_arena_t, void *));
-  verify(COMPATTYPE(mps_ap_t, void *));
   /* .event-conv: Conversion of event fields into the types required */
   /* by the MPS functions is justified by the reverse conversion */
   /* being acceptable (which is upto the event log generator). */
 
-  totalEvents = 0; discardedEvents = 0; unknownEvents = 0;
+  replayClass = klass;
+  replayArenaSize = arenaSize;
+  replayCommitLimit = commitLimit;
+  replayExtendBy = extendBy;
+  replaySpareCommitLimit = spareCommitLimit;
 
-  res = TableCreate(&arenaTable, (size_t)1);
-  if (res != ResOK)
-    goto failArena;
-  res = TableCreate(&poolTable, (size_t)1<<4);
-  if (res != ResOK)
-    goto failPool;
-  res = TableCreate(&apTable, (size_t)1<<6);
-  if (res != ResOK)
-    goto failAp;
+  totalEvents = 0; discardedEvents = 0; poolCount = 0;
+  allocCount = 0; freeCount = 0; unknownFreeCount = 0;
+  allocSize = 0; liveSize = 0; peakLiveSize = 0; peakCommitted = 0;
+
+  arenaTable = tableCreate((Count)1);
+  paramsTable = tableCreate((Count)1 << 4);
+  poolTable = tableCreate((Count)1 << 4);
+  apTable = tableCreate((Count)1 << 6);
 
   return ResOK;
+}
 
-failAp:
-  TableDestroy(poolTable);
-failPool:
-  TableDestroy(arenaTable);
-failArena:
-  return res;
+
+/* EventRepReport -- report the results of the replay */
+
+void EventRepReport(void)
+{
+  printf("Replayed %lu and discarded %lu events.\n",
+         totalEvents - discardedEvents, discardedEvents);
+  printf("Pools replayed: %lu\n", poolCount);
+  printf("Objects allocated: %lu (%"PRIuLONGEST" bytes)\n",
+         allocCount, (ulongest_t)allocSize);
+  printf("Objects freed: %lu (%lu not allocated in log)\n",
+         freeCount, unknownFreeCount);
+  printf("Peak live size: %"PRIuLONGEST" bytes\n", (ulongest_t)peakLiveSize);
+  printf("Peak committed: %"PRIuLONGEST" bytes\n",
+         (ulongest_t)peakCommitted);
+  if (peakLiveSize > 0)
+    printf("Peak committed / peak live: %.3f\n",
+           (double)peakCommitted / (double)peakLiveSize);
 }
 
 
-/* EventRepFinish -- finish the module */
+/* EventRepPeakCommitted, EventRepPools -- results of the replay */
+
+size_t EventRepPeakCommitted(void)
+{
+  return peakCommitted;
+}
+
+unsigned long EventRepPools(void)
+{
+  return poolCount;
+}
+
+
+/* EventRepFinish -- finish the module
+ *
+ * Destroys whatever the replay left behind, so that the module can be
+ * initialized again for another replay. See
+ * <design/telemetry/#tune.replay>.
+ */
+
+static void apCleanup(void *closure, TableKey key, TableValue value)
+{
+  apRep rep = value;
+  testlib_unused(closure);
+  testlib_unused(key);
+  mps_ap_destroy(rep->ap);
+  free(rep);
+}
+
+static void poolCleanup(void *closure, TableKey key, TableValue value)
+{
+  poolRep rep = value;
+  testlib_unused(closure);
+  testlib_unused(key);
+  if (rep->ap != NULL)
+    mps_ap_destroy(rep->ap);
+  mps_pool_destroy(rep->pool);
+  TableDestroy(rep->objects);
+  free(rep);
+}
+
+static void arenaCleanup(void *closure, TableKey key, TableValue value)
+{
+  testlib_unused(closure);
+  testlib_unused(key);
+  mps_arena_destroy((mps_arena_t)value);
+}
+
+static void paramsCleanup(void *closure, TableKey key, TableValue value)
+{
+  testlib_unused(closure);
+  testlib_unused(key);
+  free(value);
+}
 
 void EventRepFinish(void)
 {
-  /* @@@@ add listing of remaining objects? */
-  /* No point in cleaning up the tables, since we're quitting. */
-  printf("Replayed %lu and discarded %lu events (%lu unknown).\n",
-         totalEvents - discardedEvents - unknownEvents,
-         discardedEvents + unknownEvents, unknownEvents);
+  TableMap(apTable, apCleanup, NULL);
+  TableMap(poolTable, poolCleanup, NULL);
+  TableMap(arenaTable, arenaCleanup, NULL);
+  TableMap(paramsTable, paramsCleanup, NULL);
+  TableDestroy(apTable);
+  TableDestroy(poolTable);
+  TableDestroy(arenaTable);
+  TableDestroy(paramsTable);
 }
 
 
 /* C. COPYRIGHT AND LICENSE
  *
- * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * Copyright (C) 2001-2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
  * All rights reserved.  This is an open source license.  Contact
  * Ravenbrook for commercial licensing options.
  * 
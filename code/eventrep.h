@@ -1,24 +1,49 @@
 /* eventrep.h: Allocation replayer interface
- * Copyright (c) 2001 Ravenbrook Limited.  See end of file for license.
+ * Copyright (c) 2001-2026 Ravenbrook Limited.  See end of file for license.
  *
  * $Id$
+ *
+ * .design: <design/telemetry/#replay>.
  */
 
 #ifndef eventrep_h
 #define eventrep_h
 
 #include "config.h"
-/* override variety setting for EVENT */
-#define EVENT
-
 #include "eventcom.h"
 #include "mpmtypes.h"
 
+#include <stddef.h> /* for size_t */
+
+
+/* EventRepClass -- pool class to replay into
+ *
+ * EventRepClassLOG means the class each pool had in the log.
+ */
+
+enum {
+  EventRepClassLOG = 1,
+  EventRepClassMVFF,
+  EventRepClassMVT
+};
+typedef int EventRepClass;
+
+
+/* EventRepInit -- initialize the replay
+ *
+ * A size of 0 for any of the arena size, commit limit, MVFF extendBy
+ * or spare commit limit means use the value in the log.
+ */
 
-extern Res EventRepInit(Bool partial);
+extern Res EventRepInit(EventRepClass klass, size_t arenaSize,
+                        size_t commitLimit, size_t extendBy,
+                        size_t spareCommitLimit);
 extern void EventRepFinish(void);
+extern void EventRepReport(void);
+extern size_t EventRepPeakCommitted(void);
+extern unsigned long EventRepPools(void);
 
-extern void EventReplay(Event event, Word etime);
+extern void EventReplay(Event event);
 
 
 #endif /* eventrep_h */
@@ -26,7 +51,7 @@ extern void EventReplay(Event event, Word etime);
 
 /* C. COPYRIGHT AND LICENSE
  *
- * Copyright (C) 2001-2002 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * Copyright (C) 2001-2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
  * All rights reserved.  This is an open source license.  Contact
  * Ravenbrook for commercial licensing options.
  * 
@@ -56,6 +56,8 @@ enum {
 #define rootCOUNT 20
 #define maxtreeDEPTH 9
 #define collectionCOUNT 10
+#define maxtreeNODES ((size_t)1 << maxtreeDEPTH)
+#define drainCOUNT 64
 
 
 /* global object counter */
@@ -99,6 +101,36 @@ static void register_numbered_tree(mps_word_t tree, mps_arena_t arena)
     }
 }
 
+static mps_addr_t batch[maxtreeNODES];
+static size_t batch_count;
+
+static void collect_numbered_tree(mps_word_t tree)
+{
+    /* don't finalize ints */
+    if ((tree & 1) == 0) {
+        Insist(batch_count < maxtreeNODES);
+        batch[batch_count++] = (mps_addr_t)tree;
+        collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 0));
+        collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 1));
+    }
+}
+
+/* register_batched_tree -- register a tree using the batch interface
+ *
+ * Each object is registered twice and then deregistered once, so that
+ * the MRG pool's index holds more than one guardian for each object.
+ */
+
+static void register_batched_tree(mps_word_t tree, mps_arena_t arena)
+{
+    batch_count = 0;
+    collect_numbered_tree(tree);
+    die(mps_finalize_many(arena, batch, batch_count), "mps_finalize_many");
+    die(mps_finalize_many(arena, batch, batch_count), "mps_finalize_many");
+    die(mps_definalize_many(arena, batch, batch_count),
+        "mps_definalize_many");
+}
+
 static mps_word_t make_indirect_cons(mps_word_t car, mps_word_t cdr,
                                      mps_ap_t ap)
 {
@@ -199,6 +231,14 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
       Insist(free_size <= total_size);
       Insist(free_size + live_size <= total_size);
     }
+    {
+      mps_addr_t refs[drainCOUNT];
+      size_t drained;
+      do {
+        drained = mps_message_finalization_drain(refs, drainCOUNT, arena);
+        final_this_time += drained;
+      } while (drained == drainCOUNT);
+    }
     while (mps_message_queue_type(&type, arena)) {
       mps_message_t message;
       cdie(mps_message_get(&message, arena, type), "message_get");
@@ -231,6 +271,91 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
           (unsigned long)collectionCOUNT, (unsigned long)collections);
 }
 
+/* test_moved -- deregister objects after they have moved
+ *
+ * Each object is registered twice. The first deregistration follows
+ * a collection, so that objects in a moving pool have moved, and the
+ * second happens while a trace is flipped, so that some guardians have
+ * not yet been scanned. After both, collecting the objects must not
+ * finalize anything. The objects are only reachable from the roots,
+ * so that this works for leaf pools too.
+ */
+
+static void test_moved(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_message_t message;
+  size_t finals = 0;
+  size_t i;
+
+  mps_arena_park(arena);
+  for (i = 0; i < rootCOUNT; ++i)
+    root[i] = (void *)make_numbered_cons(DYLAN_INT(0), DYLAN_INT(0), ap);
+  die(mps_finalize_many(arena, root, rootCOUNT), "mps_finalize_many");
+  die(mps_finalize_many(arena, root, rootCOUNT), "mps_finalize_many");
+
+  die(mps_arena_collect(arena), "collect");
+  die(mps_definalize_many(arena, root, rootCOUNT),
+      "mps_definalize_many after collect");
+
+  die(mps_arena_start_collect(arena), "start_collect");
+  die(mps_definalize_many(arena, root, rootCOUNT),
+      "mps_definalize_many during collect");
+  mps_arena_park(arena);
+
+  for (i = 0; i < rootCOUNT; ++i)
+    root[i] = 0;
+  die(mps_arena_collect(arena), "collect");
+  while (mps_message_get(&message, arena, mps_message_type_finalization())) {
+    ++ finals;
+    mps_message_discard(arena, message);
+  }
+  if (finals != 0)
+    error("%lu deregistered objects were finalized.", (unsigned long)finals);
+}
+
+/* test_definalize_flipped -- definalize while a trace is flipped
+ *
+ * One object is kept alive and deregistered while a trace is flipped.
+ * The others are only reachable from their guardians, and the same
+ * trace must still finalize all of them.
+ */
+
+static void test_definalize_flipped(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_message_t message;
+  mps_word_t first;
+  size_t finals = 0;
+  size_t i;
+
+  mps_arena_park(arena);
+  first = object_count;
+  for (i = 0; i < rootCOUNT; ++i)
+    root[i] = (void *)make_numbered_cons(DYLAN_INT(0), DYLAN_INT(0), ap);
+  die(mps_finalize_many(arena, root, rootCOUNT), "mps_finalize_many");
+  for (i = 1; i < rootCOUNT; ++i)
+    root[i] = 0;
+
+  die(mps_arena_start_collect(arena), "start_collect");
+  die(mps_definalize(arena, &root[0]), "mps_definalize during collect");
+  mps_arena_park(arena);
+
+  while (mps_message_get(&message, arena, mps_message_type_finalization())) {
+    mps_addr_t obj;
+    mps_word_t n;
+    mps_message_finalization_ref(&obj, arena, message);
+    n = DYLAN_INT_INT(DYLAN_VECTOR_SLOT((mps_word_t)obj, 2));
+    if (n == first)
+      error("Deregistered object was finalized.");
+    if (first < n && n < first + rootCOUNT)
+      ++ finals;
+    mps_message_discard(arena, message);
+  }
+  if (finals != rootCOUNT - 1)
+    error("Expected %lu finalizations during collect but got %lu.",
+          (unsigned long)rootCOUNT - 1, (unsigned long)finals);
+  root[0] = 0;
+}
+
 static void test_pool(int mode, mps_arena_t arena, mps_chain_t chain,
                       mps_pool_class_t pool_class)
 {
@@ -258,6 +383,10 @@ static void test_pool(int mode, mps_arena_t arena, mps_chain_t chain,
              register_numbered_tree);
   test_trees(mode, "indirect", arena, pool, ap, make_indirect_tree,
              register_indirect_tree);
+  test_trees(mode, "batched", arena, pool, ap, make_numbered_tree,
+             register_batched_tree);
+  test_moved(arena, ap);
+  test_definalize_flipped(arena, ap);
 
   mps_ap_destroy(ap);
   mps_root_destroy(mps_root);
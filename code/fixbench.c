@@ -0,0 +1,734 @@
+/* fixbench.c -- fix and scan microbenchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark measures the cost per reference of the critical path
+ * of the MPS: MPS_FIX1 and _mps_fix2, the area scanners, and the Dylan
+ * format scanner.  It builds a heap with a chosen number of chunks,
+ * makes arrays of references of each kind that _mps_fix2 distinguishes
+ * (outside the arena, into free tracts, into segments that are not
+ * white, and into white segments) and a mixture of them in chosen
+ * proportions, and then times scanning these arrays from inside a root
+ * scanning function during a real collection.  See
+ * <design/tests/#test.fix>.
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "mpm.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, sscanf, stderr */
+#include <stdlib.h> /* exit, EXIT_FAILURE, EXIT_SUCCESS, malloc, strtoul */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+#define RESMUST(expr) \
+  do { \
+    mps_res_t res = (expr); \
+    if (res != MPS_RES_OK) { \
+      fprintf(stderr, #expr " returned %d\n", res); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+static mps_arena_t arena;
+
+#define countsLIMIT 32
+#define OUTSIDE_SIZE ((size_t)1024 * 1024) /* size of memory outside arena */
+#define SAMPLE_TRIES 1000000  /* attempts to find a free page */
+
+static rnd_state_t seed = 0;      /* random number seed */
+static size_t nchunks[countsLIMIT] = {1, 16}; /* chunk counts */
+static size_t nchunk_counts = 2;
+static size_t heap_sizes[countsLIMIT] = {4ul << 20, 32ul << 20};
+static size_t nheap_sizes = 2;
+static size_t nrefs = 65536;      /* references of each kind */
+static unsigned long reps = 64;   /* repetitions of each measurement */
+static double proportion[4] = {0.25, 0.25, 0.25, 0.25}; /* of mixture */
+static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
+static mps_bool_t json = FALSE;   /* print results as JSON */
+
+static double ticks_per_sec;      /* EVENT_CLOCK ticks per second */
+
+
+/* The kinds of reference, in the order of the tests in _mps_fix2. */
+
+enum {
+  KIND_OUTSIDE,                   /* outside the arena */
+  KIND_FREE,                      /* into a free tract */
+  KIND_NONWHITE,                  /* into a segment that is not white */
+  KIND_WHITE,                     /* into a white segment */
+  KIND_MIX,                       /* mixture in chosen proportions */
+  KIND_LIMIT
+};
+
+static const char *kind_name[KIND_LIMIT] = {
+  "outside", "free", "nonwhite", "white", "mix"
+};
+
+static mps_addr_t *refs[KIND_LIMIT]; /* references of each kind */
+static mps_word_t *block, *block_limit; /* formatted objects to scan */
+static size_t block_refs;         /* references in formatted objects */
+
+
+/* Results of one configuration, in nanoseconds per reference, except
+ * for fix1_pass, which is the fraction of references that pass the
+ * zone test in MPS_FIX1. */
+
+static struct {
+  mps_bool_t measured;
+  size_t chunks;
+  double fix12[KIND_LIMIT];
+  double fix2[KIND_LIMIT];
+  double fix1_pass[KIND_LIMIT];
+  double scan_area;
+  double scan_area_tagged;
+  double scan_area_tagged_or_zero;
+  double fmt_scan;
+  double time;                    /* total time measured, in seconds */
+} result;
+
+
+/* calibrate -- measure the rate of EVENT_CLOCK against clock()
+ *
+ * The benchmark is single-threaded and busy throughout, so processor
+ * time is a fair proxy for elapsed time.
+ */
+
+static void calibrate(void)
+{
+  clock_t start, begin, end;
+  EventClock ticks_begin, ticks_end;
+
+  start = clock();
+  while ((begin = clock()) == start)
+    NOOP; /* wait for the clock to tick */
+  EVENT_CLOCK(ticks_begin);
+  while ((end = clock()) - begin < CLOCKS_PER_SEC / 10)
+    NOOP;
+  EVENT_CLOCK(ticks_end);
+  ticks_per_sec = (double)(ticks_end - ticks_begin) * CLOCKS_PER_SEC
+    / (double)(end - begin);
+}
+
+
+/* ns_per_ref -- convert a measurement to nanoseconds per reference */
+
+static double ns_per_ref(EventClock begin, EventClock end, size_t n)
+{
+  double seconds = (double)(end - begin) / ticks_per_sec;
+  result.time += seconds;
+  if (n == 0)
+    return 0.0;
+  return seconds * 1e9 / ((double)n * (double)reps);
+}
+
+
+/* time_fix12 -- time MPS_FIX12 on an array of references */
+
+static mps_res_t time_fix12(double *ns_o, mps_ss_t ss,
+                            mps_addr_t *array, size_t n)
+{
+  EventClock begin, end;
+  unsigned long r;
+  size_t i;
+
+  EVENT_CLOCK(begin);
+  for (r = 0; r < reps; ++r) {
+    MPS_SCAN_BEGIN(ss) {
+      for (i = 0; i < n; ++i) {
+        mps_res_t res = MPS_FIX12(ss, &array[i]);
+        if (res != MPS_RES_OK)
+          return res;
+      }
+    } MPS_SCAN_END(ss);
+  }
+  EVENT_CLOCK(end);
+  *ns_o = ns_per_ref(begin, end, n);
+  return MPS_RES_OK;
+}
+
+
+/* widen_white, restore_white -- widen the white zone set to all zones
+ *
+ * The scan state caches the union of the white zone sets of its
+ * traces, and checks that they agree, so both must be changed.
+ */
+
+static void widen_white(ScanState ss, ZoneSet saved[TraceLIMIT])
+{
+  TraceId ti;
+  Trace trace;
+  TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
+    saved[ti] = trace->white;
+    trace->white = ZoneSetUNIV;
+  TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
+  ScanStateSetWhite(ss, ZoneSetUNIV);
+}
+
+static void restore_white(ScanState ss, ZoneSet saved[TraceLIMIT])
+{
+  ZoneSet white = ZoneSetEMPTY;
+  TraceId ti;
+  Trace trace;
+  TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
+    trace->white = saved[ti];
+    white = ZoneSetUnion(white, saved[ti]);
+  TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
+  ScanStateSetWhite(ss, white);
+}
+
+
+/* time_fix2 -- time _mps_fix2 alone on an array of references
+ *
+ * _mps_fix2 may only be called on references that pass the zone test
+ * in MPS_FIX1, so to measure the tract lookup on all the references,
+ * the white zone set is widened to all zones for the duration.  The
+ * fraction of references that pass the real zone test is measured
+ * first.
+ */
+
+static mps_res_t time_fix2(double *ns_o, double *pass_o, mps_ss_t ss,
+                           mps_addr_t *array, size_t n)
+{
+  ScanState scanState = PARENT(ScanStateStruct, ss_s, ss);
+  ZoneSet saved[TraceLIMIT];
+  EventClock begin, end;
+  mps_res_t res = MPS_RES_OK;
+  unsigned long r;
+  size_t i, npassed = 0;
+
+  MPS_SCAN_BEGIN(ss) {
+    for (i = 0; i < n; ++i)
+      if (MPS_FIX1(ss, array[i]))
+        ++npassed;
+  } MPS_SCAN_END(ss);
+  *pass_o = n == 0 ? 0.0 : (double)npassed / (double)n;
+
+  widen_white(scanState, saved);
+  EVENT_CLOCK(begin);
+  for (r = 0; r < reps && res == MPS_RES_OK; ++r)
+    for (i = 0; i < n && res == MPS_RES_OK; ++i)
+      res = MPS_FIX2(ss, &array[i]);
+  EVENT_CLOCK(end);
+  restore_white(scanState, saved);
+  *ns_o = ns_per_ref(begin, end, n);
+  return res;
+}
+
+
+/* time_area -- time an area scanner on the mixture of references */
+
+static mps_res_t time_area(double *ns_o, mps_ss_t ss,
+                           mps_area_scan_t scan_area, void *closure)
+{
+  EventClock begin, end;
+  unsigned long r;
+
+  EVENT_CLOCK(begin);
+  for (r = 0; r < reps; ++r) {
+    mps_res_t res = scan_area(ss, refs[KIND_MIX], refs[KIND_MIX] + nrefs,
+                              closure);
+    if (res != MPS_RES_OK)
+      return res;
+  }
+  EVENT_CLOCK(end);
+  *ns_o = ns_per_ref(begin, end, nrefs);
+  return MPS_RES_OK;
+}
+
+
+/* measure -- root scanning function that runs the measurements
+ *
+ * The root is ambiguous, because exact references must not point into
+ * free tracts (see <design/trace/#exact.legal>).  The first pass over
+ * the white references preserves their referents, so it is not timed:
+ * the measurements are of the steady state in which each reference
+ * has been fixed before.
+ */
+
+static mps_res_t measure(mps_ss_t ss, void *p, size_t s)
+{
+  mps_fmt_A_s *fmt = dylan_fmt_A();
+  mps_scan_tag_s tag;
+  EventClock begin, end;
+  unsigned long r;
+  mps_res_t res;
+  size_t i;
+
+  testlib_unused(p);
+  testlib_unused(s);
+  if (result.measured)
+    return MPS_RES_OK;
+  result.measured = TRUE;
+  result.chunks = RingLength(ArenaChunkRing((Arena)arena));
+
+  MPS_SCAN_BEGIN(ss) {
+    for (i = 0; i < nrefs; ++i) {
+      res = MPS_FIX12(ss, &refs[KIND_WHITE][i]);
+      if (res != MPS_RES_OK)
+        return res;
+    }
+  } MPS_SCAN_END(ss);
+
+  for (i = 0; i < KIND_LIMIT; ++i) {
+    res = time_fix12(&result.fix12[i], ss, refs[i], nrefs);
+    if (res != MPS_RES_OK)
+      return res;
+    res = time_fix2(&result.fix2[i], &result.fix1_pass[i], ss,
+                    refs[i], nrefs);
+    if (res != MPS_RES_OK)
+      return res;
+  }
+
+  res = time_area(&result.scan_area, ss, mps_scan_area, NULL);
+  if (res != MPS_RES_OK)
+    return res;
+  tag.mask = sizeof(mps_word_t) - 1;
+  tag.pattern = 0;
+  res = time_area(&result.scan_area_tagged, ss, mps_scan_area_tagged, &tag);
+  if (res != MPS_RES_OK)
+    return res;
+  res = time_area(&result.scan_area_tagged_or_zero, ss,
+                  mps_scan_area_tagged_or_zero, &tag);
+  if (res != MPS_RES_OK)
+    return res;
+
+  EVENT_CLOCK(begin);
+  for (r = 0; r < reps; ++r) {
+    res = fmt->scan(ss, block, block_limit);
+    if (res != MPS_RES_OK)
+      return res;
+  }
+  EVENT_CLOCK(end);
+  result.fmt_scan = ns_per_ref(begin, end, block_refs);
+
+  return MPS_RES_OK;
+}
+
+
+/* sample_free -- return an address in a free page of some chunk */
+
+static mps_addr_t sample_free(Chunk *chunks, size_t count)
+{
+  unsigned long tries;
+  for (tries = 0; tries < SAMPLE_TRIES; ++tries) {
+    Chunk chunk = chunks[rnd() % count];
+    Index i = chunk->allocBase + rnd() % (chunk->pages - chunk->allocBase);
+    if (!BTGet(chunk->allocTable, i)) {
+      Size offset = (rnd() % (ChunkPageSize(chunk) / sizeof(mps_word_t)))
+        * sizeof(mps_word_t);
+      return (mps_addr_t)AddrAdd(PageIndexBase(chunk, i), offset);
+    }
+  }
+  fprintf(stderr, "no free pages in arena\n");
+  exit(EXIT_FAILURE);
+}
+
+
+/* run -- measure one configuration */
+
+static void run(mps_pool_class_t pool_class, const char *name,
+                size_t chunks, size_t heap_size)
+{
+  mps_pool_t pool, mvff;
+  mps_fmt_t format;
+  mps_ap_t ap;
+  mps_root_t root;
+  mps_addr_t *white, *nonwhite;
+  mps_word_t *outside;
+  Chunk *chunk_array;
+  size_t chunk_size, nwhite = 0, nnonwhite = 0, max_objects, size, i;
+  size_t allocated, nchunk_array;
+  Ring node, next;
+  mps_addr_t base;
+
+  /* Make an arena of the requested number of chunks, together large
+     enough for twice the heap, so that there are free pages. */
+  chunk_size = 2 * heap_size / chunks;
+  if (chunk_size < (size_t)1 << 20)
+    chunk_size = (size_t)1 << 20;
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, chunk_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
+  } MPS_ARGS_END(args);
+  RESMUST(mps_arena_vm_growth(arena, chunk_size, chunk_size));
+  for (i = 1; i < chunks; ++i) {
+    Res grown;
+    ArenaEnter((Arena)arena);
+    grown = Method(Arena, (Arena)arena, grow)((Arena)arena,
+                                             LocusPrefDefault(), chunk_size);
+    ArenaLeave((Arena)arena);
+    RESMUST(grown);
+  }
+  mps_arena_park(arena);
+
+  RESMUST(dylan_fmt(&format, arena));
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    RESMUST(mps_pool_create_k(&pool, arena, pool_class, args));
+  } MPS_ARGS_END(args);
+  RESMUST(mps_pool_create_k(&mvff, arena, mps_class_mvff(), mps_args_none));
+
+  /* Half the heap is in the white pool, half in the manual pool. */
+  max_objects = heap_size / 2 / (3 * sizeof(mps_word_t)) + 1;
+  white = malloc(max_objects * sizeof white[0]);
+  nonwhite = malloc(max_objects * sizeof nonwhite[0]);
+  outside = malloc(OUTSIDE_SIZE);
+  if (white == NULL || nonwhite == NULL || outside == NULL) {
+    fprintf(stderr, "out of memory allocating heap tables\n");
+    exit(EXIT_FAILURE);
+  }
+  RESMUST(mps_ap_create_k(&ap, pool, mps_args_none));
+  for (allocated = 0; allocated < heap_size / 2; allocated += size) {
+    mps_word_t v;
+    size_t slots = 1 + rnd() % 7;
+    size = (slots + 2) * sizeof(mps_word_t);
+    RESMUST(make_dylan_vector(&v, ap, slots));
+    white[nwhite++] = (mps_addr_t)v;
+  }
+  mps_ap_destroy(ap);
+  for (allocated = 0; allocated < heap_size / 2; allocated += size) {
+    size = (2 + rnd() % 8) * sizeof(mps_word_t);
+    RESMUST(mps_alloc(&nonwhite[nnonwhite++], mvff, size));
+  }
+
+  /* The chunks are collected after allocation, so that the free pages
+     are those that remain free. */
+  nchunk_array = RingLength(ArenaChunkRing((Arena)arena));
+  chunk_array = malloc(nchunk_array * sizeof chunk_array[0]);
+  if (chunk_array == NULL) {
+    fprintf(stderr, "out of memory allocating chunk table\n");
+    exit(EXIT_FAILURE);
+  }
+  i = 0;
+  RING_FOR(node, ArenaChunkRing((Arena)arena), next)
+    chunk_array[i++] = RING_ELT(Chunk, arenaRing, node);
+
+  for (i = 0; i < KIND_LIMIT; ++i) {
+    refs[i] = malloc(nrefs * sizeof refs[i][0]);
+    if (refs[i] == NULL) {
+      fprintf(stderr, "out of memory allocating references\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (i = 0; i < nrefs; ++i) {
+    double p = rnd_double();
+    size_t kind;
+    refs[KIND_OUTSIDE][i]
+      = &outside[rnd() % (OUTSIDE_SIZE / sizeof(mps_word_t))];
+    refs[KIND_FREE][i] = sample_free(chunk_array, nchunk_array);
+    refs[KIND_NONWHITE][i] = nonwhite[rnd() % nnonwhite];
+    refs[KIND_WHITE][i] = white[rnd() % nwhite];
+    for (kind = 0; kind < KIND_MIX - 1; ++kind) {
+      if (p < proportion[kind])
+        break;
+      p -= proportion[kind];
+    }
+    refs[KIND_MIX][i] = refs[kind][i];
+  }
+
+  /* Formatted objects for the format scanner: vectors in the manual
+     pool whose slots hold the mixture of references. */
+  size = nrefs / 8 * 10 * sizeof(mps_word_t);
+  RESMUST(mps_alloc(&base, mvff, size));
+  block = base;
+  block_limit = block + size / sizeof(mps_word_t);
+  block_refs = 0;
+  for (i = 0; i + 10 <= size / sizeof(mps_word_t); i += 10) {
+    size_t j;
+    RESMUST(dylan_init(&block[i], 10 * sizeof(mps_word_t), NULL, 0));
+    for (j = 0; j < 8; ++j)
+      DYLAN_VECTOR_SLOT(&block[i], j)
+        = (mps_word_t)refs[KIND_MIX][block_refs++];
+  }
+
+  result.measured = FALSE;
+  result.time = 0.0;
+  RESMUST(mps_root_create(&root, arena, mps_rank_ambig(), (mps_rm_t)0,
+                          measure, NULL, 0));
+  mps_arena_collect(arena);
+  if (!result.measured) {
+    fprintf(stderr, "root was not scanned\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (json) {
+    printf("{\"benchmark\": \"fixbench\", \"test\": \"%s\", \"seed\": %lu, "
+           "\"chunks\": %lu, \"heap\": %lu, \"refs\": %lu, \"time\": %g, "
+           "\"committed_max\": %lu, \"collections\": 1, \"pauses\": [], ",
+           name, (unsigned long)seed, (unsigned long)result.chunks,
+           (unsigned long)heap_size, (unsigned long)nrefs, result.time,
+           (unsigned long)mps_arena_committed(arena));
+    for (i = 0; i < KIND_LIMIT; ++i)
+      printf("\"fix12_%s\": %g, \"fix2_%s\": %g, \"fix1_pass_%s\": %g, ",
+             kind_name[i], result.fix12[i], kind_name[i], result.fix2[i],
+             kind_name[i], result.fix1_pass[i]);
+    printf("\"scan_area\": %g, \"scan_area_tagged\": %g, "
+           "\"scan_area_tagged_or_zero\": %g, \"fmt_scan\": %g}\n",
+           result.scan_area, result.scan_area_tagged,
+           result.scan_area_tagged_or_zero, result.fmt_scan);
+  } else {
+    printf("%s, %lu chunks, heap %lu: ns/ref\n", name,
+           (unsigned long)result.chunks, (unsigned long)heap_size);
+    for (i = 0; i < KIND_LIMIT; ++i)
+      printf("  %-8s  fix12 %6.2f  fix2 %6.2f  (%3.0f%% pass fix1)\n",
+             kind_name[i], result.fix12[i], result.fix2[i],
+             100.0 * result.fix1_pass[i]);
+    printf("  scan_area %.2f  tagged %.2f  tagged_or_zero %.2f  "
+           "dylan_scan %.2f\n",
+           result.scan_area, result.scan_area_tagged,
+           result.scan_area_tagged_or_zero, result.fmt_scan);
+  }
+
+  mps_root_destroy(root);
+  for (i = 0; i < KIND_LIMIT; ++i)
+    free(refs[i]);
+  free(chunk_array);
+  free(outside);
+  free(nonwhite);
+  free(white);
+  mps_pool_destroy(mvff);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(arena);
+}
+
+
+/* parse_size -- parse a size with an optional K, M or G suffix */
+
+static size_t parse_size(const char *s, char **end_o)
+{
+  char *p;
+  size_t size = (size_t)strtoul(s, &p, 10);
+  switch (toupper(*p)) {
+  case 'G': size <<= 30; ++p; break;
+  case 'M': size <<= 20; ++p; break;
+  case 'K': size <<= 10; ++p; break;
+  default: break;
+  }
+  if (end_o != NULL)
+    *end_o = p;
+  else if (*p != '\0') {
+    fprintf(stderr, "Bad size %s\n", s);
+    exit(EXIT_FAILURE);
+  }
+  return size;
+}
+
+
+/* parse_list -- parse a comma-separated list of sizes */
+
+static size_t parse_list(size_t *list, char *s)
+{
+  char *p = s;
+  size_t n = 0;
+  do {
+    if (n >= countsLIMIT) {
+      fprintf(stderr, "exceeded countsLIMIT\n");
+      exit(EXIT_FAILURE);
+    }
+    list[n] = parse_size(p, &p);
+    if (list[n] == 0 || (*p != ',' && *p != '\0')) {
+      fprintf(stderr, "Bad list %s\n", s);
+      exit(EXIT_FAILURE);
+    }
+    ++n;
+  } while (*p++ == ',');
+  return n;
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"chunks",           required_argument, NULL, 'c'},
+  {"heap-size",        required_argument, NULL, 'H'},
+  {"refs",             required_argument, NULL, 'n'},
+  {"repeat",           required_argument, NULL, 'r'},
+  {"proportions",      required_argument, NULL, 'p'},
+  {"seed",             required_argument, NULL, 'x'},
+  {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"json",             no_argument,       NULL, 'j'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_pool_class_t (*pool_class)(void);
+} pools[] = {
+  {"amc", mps_class_amc},
+  {"ams", mps_class_ams},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+  size_t c, h;
+  mps_bool_t seed_specified = FALSE;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "hc:H:n:r:p:x:zj",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 'c':
+      nchunk_counts = parse_list(nchunks, optarg);
+      break;
+    case 'H':
+      nheap_sizes = parse_list(heap_sizes, optarg);
+      break;
+    case 'n':
+      nrefs = parse_size(optarg, NULL);
+      if (nrefs < 8)
+        nrefs = 8;
+      break;
+    case 'r':
+      reps = strtoul(optarg, NULL, 10);
+      if (reps < 1)
+        reps = 1;
+      break;
+    case 'p': {
+        double sum;
+        if (sscanf(optarg, "%lf,%lf,%lf,%lf", &proportion[0],
+                   &proportion[1], &proportion[2], &proportion[3]) != 4
+            || (sum = proportion[0] + proportion[1] + proportion[2]
+                + proportion[3]) <= 0.0) {
+          fprintf(stderr, "Bad proportions %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+        for (i = 0; i < 4; ++i)
+          proportion[i] /= sum;
+      }
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    case 'z':
+      zoned = FALSE;
+      break;
+    case 'j':
+      json = TRUE;
+      break;
+    default:
+      /* This is printed in parts to keep within the 509 character
+         limit for string literals in portable standard C. */
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -c n,..., --chunks=n,...\n"
+              "    Numbers of arena chunks (default 1,16).\n"
+              "  -H n,..., --heap-size=n[KMG],...\n"
+              "    Heap sizes (default 4M,32M).\n"
+              "  -n n, --refs=n[KMG]\n"
+              "    References of each kind (default %lu).\n"
+              "  -r n, --repeat=n\n"
+              "    Repetitions of each measurement (default %lu).\n",
+              argv[0],
+              (unsigned long)nrefs,
+              reps);
+      fprintf(stderr,
+              "  -p o,f,n,w, --proportions=o,f,n,w\n"
+              "    Proportions of references outside the arena, into\n"
+              "    free tracts, into non-white segments and into white\n"
+              "    segments in the mixture (default 1,1,1,1).\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n"
+              "  -z, --arena-unzoned\n"
+              "    Disable zoned allocation in the arena.\n"
+              "  -j, --json\n"
+              "    Print results as JSON, one line per configuration.\n");
+      fprintf(stderr,
+              "Tests:\n"
+              "  amc   white objects in pool class AMC\n"
+              "  ams   white objects in pool class AMS\n");
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (!seed_specified && !json) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+
+  calibrate();
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(pools); ++i)
+      if (strcmp(argv[0], pools[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown pool test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    for (c = 0; c < nchunk_counts; ++c)
+      for (h = 0; h < nheap_sizes; ++h) {
+        rnd_state_set(seed);
+        run(pools[i].pool_class(), pools[i].name, nchunks[c],
+            heap_sizes[h]);
+      }
+    --argc;
+    ++argv;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
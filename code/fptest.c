@@ -0,0 +1,140 @@
+/* fptest.c: FRAME POINTER REGISTER SCANNING TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .overview: This test case is a regression test for
+ * design.mps.stack-scan.sol.setjmp.mangle. It puts a value in the
+ * frame pointer register, saves the context with STACK_CONTEXT_SAVE
+ * and captures a hot stack pointer with StackHot, as
+ * STACK_CONTEXT_BEGIN does, and checks that the value can be found in
+ * the part of the stack that StackScan would scan.
+ *
+ * .platform: The value is placed in the register by a function
+ * written in assembly language, and STACK_CONTEXT_SAVE only works
+ * around the mangling on Linux (see <code/ss.h>), so the test is only
+ * effective on x86-64 Linux with GCC or Clang. On other platforms it
+ * passes trivially.
+ *
+ * .key: The value is the complement of fptest_key, and is only
+ * computed in the frame pointer register, so that no other copy of it
+ * can be found on the stack.
+ */
+
+#include "mpm.h"
+#include "ss.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+
+
+#if defined(MPS_ARCH_I6) && defined(MPS_OS_LI) \
+  && (defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL))
+
+volatile Word fptest_key = (Word)0x2F1D3C4B5A697887;
+
+/* call_with_fp -- call f(cold) with ~fptest_key in %rbp */
+
+extern Bool call_with_fp(Bool (*f)(void *cold), void *cold);
+
+__asm__(
+  ".text\n"
+  ".globl call_with_fp\n"
+  ".type call_with_fp, @function\n"
+  "call_with_fp:\n"
+  "  pushq %rbp\n"
+  "  movq fptest_key(%rip), %rbp\n"
+  "  notq %rbp\n"
+  "  movq %rdi, %rax\n"
+  "  movq %rsi, %rdi\n"
+  "  call *%rax\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size call_with_fp, .-call_with_fp\n"
+);
+
+/* look -- save the context and search the stack for the value */
+
+static Bool look(void *cold)
+{
+  StackContextStruct sc;
+  void *hot;
+  Word *p;
+
+  STACK_CONTEXT_SAVE(&sc);
+  StackHot(&hot);
+  for (p = hot; p < (Word *)cold; ++p)
+    if (~*p == fptest_key)
+      return TRUE;
+  return FALSE;
+}
+
+static void test(void *cold)
+{
+  cdie(call_with_fp(look, cold),
+       "value in frame pointer register not found on stack");
+}
+
+#else /* not x86-64 Linux with GCC or Clang */
+
+static void test(void *cold)
+{
+  testlib_unused(cold);
+}
+
+#endif
+
+
+int main(int argc, char *argv[])
+{
+  void *marker = &marker;
+
+  testlib_init(argc, argv);
+
+  test(marker);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,728 @@
+/* frag.c: Free space fragmentation analyser
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * $Id$
+ *
+ * Reads a telemetry stream and reports how the free space in each
+ * manual pool was shaped each time the pool grew, so that growth
+ * caused by fragmentation can be told apart from growth caused by
+ * live data.  See <design/pool/#free-stats> and "Analysing
+ * fragmentation" in the Telemetry chapter of the reference manual.
+ */
+
+#include "config.h"
+#include "eventdef.h"
+#include "eventcom.h"
+#include "table.h"
+#include "testlib.h" /* for ulongest_t and associated print formats */
+
+#include <stddef.h> /* for size_t */
+#include <stdio.h> /* for printf */
+#include <stdarg.h> /* for va_list */
+#include <stdlib.h> /* for EXIT_FAILURE */
+#include <string.h> /* for strcmp */
+#include "mpstd.h"
+
+#define DEFAULT_TELEMETRY_FILENAME "mpsio.log"
+#define TELEMETRY_FILENAME_ENVAR   "MPS_TELEMETRY_FILENAME"
+
+#define ROWS_DEFAULT 20         /* snapshots printed per pool */
+#define WASTE_ALIGN  0.05       /* alignment waste worth reporting */
+
+
+/* command-line arguments */
+
+static const char *prog; /* program name */
+static Bool printAll = FALSE; /* print every snapshot */
+static Bool allPools = FALSE; /* include pools created by the MPS */
+
+
+/* everror -- flush stdout, message to stderr, exit */
+
+ATTRIBUTE_FORMAT((printf, 1, 2))
+static void everror(const char *format, ...)
+{
+  va_list args;
+
+  fflush(stdout); /* sync */
+  fprintf(stderr, "%s: ", prog);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+  exit(EXIT_FAILURE);
+}
+
+
+/* usage -- usage message */
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "Usage: %s [-f logfile] [-a] [-i] [-h]\n"
+          "See \"Telemetry\" in the reference manual for instructions.\n",
+          prog);
+}
+
+
+/* usageError -- explain usage and error */
+
+static void usageError(void)
+{
+  usage();
+  everror("Bad usage");
+}
+
+
+/* parseArgs -- parse command line arguments, return log file name */
+
+static char *parseArgs(int argc, char *argv[])
+{
+  char *name = NULL;
+  int i = 1;
+
+  if (argc >= 1)
+    prog = argv[0];
+  else
+    prog = "unknown";
+
+  while (i < argc) { /* consider argument i */
+    if (argv[i][0] == '-') { /* it's an option argument */
+      switch (argv[i][1]) {
+      case 'f': /* file name */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          name = argv[i];
+        break;
+      case 'a': /* all snapshots */
+        printAll = TRUE;
+        break;
+      case 'i': /* internal pools too */
+        allPools = TRUE;
+        break;
+      case '?': case 'h': /* help */
+        usage();
+        exit(EXIT_SUCCESS);
+      default:
+        usageError();
+      }
+    } /* if option */
+    ++ i;
+  }
+  return name;
+}
+
+
+/* readLog -- read the whole log into memory */
+
+static char *readLog(size_t *sizeReturn, FILE *stream)
+{
+  char *log = NULL;
+  size_t size = 0, capacity = 0;
+
+  for (;;) {
+    size_t n;
+    if (size == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 20 : capacity * 2;
+      log = realloc(log, capacity);
+      if (log == NULL)
+        everror("Out of memory for log");
+    }
+    n = fread(log + size, 1, capacity - size, stream);
+    size += n;
+    if (size < capacity) {
+      if (ferror(stream))
+        everror("I/O error reading log");
+      break;
+    }
+  }
+  *sizeReturn = size;
+  return log;
+}
+
+
+/* Event index
+ *
+ * Events are analysed in timestamp order, as in the replayer.  See
+ * <design/telemetry/#replay.order>.
+ */
+
+typedef struct EventIndexStruct {
+  EventClock clock;     /* timestamp of event */
+  size_t offset;        /* position of event in log */
+} EventIndexStruct, *EventIndex;
+
+static int indexCompare(const void *a, const void *b)
+{
+  const EventIndexStruct *ia = a, *ib = b;
+  if (ia->clock != ib->clock)
+    return ia->clock < ib->clock ? -1 : 1;
+  if (ia->offset != ib->offset)
+    return ia->offset < ib->offset ? -1 : 1;
+  return 0;
+}
+
+static EventIndex indexLog(size_t *countReturn, const char *log, size_t size)
+{
+  EventIndex index = NULL;
+  size_t count = 0, capacity = 0, pos = 0;
+
+  while (size - pos >= sizeof(EventAnyStruct)) {
+    EventAnyStruct any;
+    (void)memcpy(&any, log + pos, sizeof any);
+    if (any.size < sizeof any || any.size > sizeof(EventUnion))
+      everror("Corrupt log: invalid event size %u", (unsigned)any.size);
+    if (size - pos < any.size)
+      break;
+    if (count == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 16 : capacity * 2;
+      index = realloc(index, capacity * sizeof *index);
+      if (index == NULL)
+        everror("Out of memory for event index");
+    }
+    index[count].clock = any.clock;
+    index[count].offset = pos;
+    ++count;
+    pos += any.size;
+  }
+  if (pos != size)
+    everror("Truncated log");
+  qsort(index, count, sizeof *index, indexCompare);
+  *countReturn = count;
+  return index;
+}
+
+static void indexEvent(EventUnion *eventReturn, const char *log,
+                       EventIndex index, size_t i)
+{
+  EventAnyStruct any;
+  const char *p = log + index[i].offset;
+  (void)memcpy(&any, p, sizeof any);
+  (void)memcpy(eventReturn, p, any.size);
+}
+
+
+/* Pool records
+ *
+ * A record is created for each pool when its first init event is
+ * seen, and removed from the table of live pools when its PoolFinish
+ * event is seen, so that a pool whose address is reused gets a new
+ * record.
+ */
+
+typedef struct SnapStruct {
+  EventClock clock;     /* time of snapshot */
+  Word size;            /* request that grew the pool, or 0 */
+  Word totalSize;       /* total memory allocated from arena */
+  Word freeSize;        /* free memory */
+  Word blocks;          /* free blocks */
+  Word blockSize;       /* total size of free blocks */
+  Word largest;         /* largest free block */
+} SnapStruct, *Snap;
+
+typedef struct HistStruct {
+  Word count[MPS_WORD_WIDTH];   /* free blocks of size [2^i, 2^(i+1)) */
+  Word size[MPS_WORD_WIDTH];    /* total size of those blocks */
+} HistStruct, *Hist;
+
+typedef struct PoolRecStruct *PoolRec;
+
+typedef struct PoolRecStruct {
+  PoolRec next;         /* next record, in order of creation */
+  void *logPool;        /* pool in the log */
+  unsigned long serial; /* order of creation */
+  const char *className; /* name of pool class, if known */
+  Bool client;          /* created by the client program */
+  Word extendBy;        /* logged MVFF extendBy, or 0 */
+  Word meanSize;        /* logged mean size, or 0 */
+  Word align;           /* logged alignment, or 0 */
+  size_t snapCount, snapCapacity;
+  Snap snap;            /* snapshots, in time order */
+  HistStruct hist;      /* histogram of the latest snapshot */
+  HistStruct peakHist;  /* histogram at the peak total size */
+  Word peakTotal;       /* peak total size */
+  Bool histIsPeak;      /* latest snapshot is at the peak */
+  double allocCount;    /* blocks allocated */
+  double allocSize;     /* bytes requested */
+  double alignWaste;    /* bytes lost to rounding up to alignment */
+} PoolRecStruct;
+
+static Table poolTable;         /* logged pool -> PoolRec */
+static Table bufferTable;       /* logged mutator buffer -> PoolRec */
+static PoolRec poolFirst = NULL, *poolLast = &poolFirst;
+static unsigned long poolSerial = 0;
+
+static Word clocksPerSec = 0;   /* mps_clock() ticks per second */
+static Bool haveSync = FALSE;   /* syncFirst and syncLast are valid */
+static EventClock syncFirstEvent, syncLastEvent; /* event clock ... */
+static Word syncFirstMPS, syncLastMPS; /* ... and mps_clock() at same time */
+static EventClock firstClock;   /* start of the stream */
+
+
+/* table support, as in eventrep.c */
+
+static void *tableAlloc(void *closure, size_t size)
+{
+  void *p;
+  testlib_unused(closure);
+  p = malloc(size);
+  if (p == NULL)
+    everror("Out of memory for table");
+  return p;
+}
+
+static void tableFree(void *closure, void *p, size_t size)
+{
+  testlib_unused(closure);
+  testlib_unused(size);
+  free(p);
+}
+
+static Table tableCreate(Count length)
+{
+  Table table;
+  Res res;
+
+  res = TableCreate(&table, length, tableAlloc, tableFree, NULL,
+                    (TableKey)-1, (TableKey)-2);
+  if (res != ResOK)
+    everror("Can't create table: error %d.", res);
+  return table;
+}
+
+
+/* poolLookup -- find the record of a live pool, or NULL */
+
+static PoolRec poolLookup(void *logPool)
+{
+  void *entry;
+  if (TableLookup(&entry, poolTable, (TableKey)logPool))
+    return entry;
+  return NULL;
+}
+
+
+/* poolCreate -- find or create the record of a live pool
+ *
+ * The pool class's init event (for example, PoolInitMVFF) comes
+ * before PoolInit, so either may create the record.
+ */
+
+static PoolRec poolCreate(void *logPool)
+{
+  PoolRec pool;
+  Res res;
+
+  pool = poolLookup(logPool);
+  if (pool != NULL)
+    return pool;
+  pool = calloc(1, sizeof *pool);
+  if (pool == NULL)
+    everror("Out of memory for pool");
+  pool->logPool = logPool;
+  pool->serial = poolSerial;
+  ++ poolSerial;
+  pool->className = NULL;
+  pool->snap = NULL;
+  pool->next = NULL;
+  *poolLast = pool;
+  poolLast = &pool->next;
+  res = TableDefine(poolTable, (TableKey)logPool, pool);
+  if (res != ResOK)
+    everror("Can't define pool: error %d.", res);
+  return pool;
+}
+
+
+/* poolSnapshot -- add a snapshot to a pool's record
+ *
+ * The histogram of the snapshot follows in PoolFreeBucket events, so
+ * the histogram of the previous snapshot is complete when the next
+ * one starts.
+ */
+
+static void poolSnapshot(PoolRec pool, Snap snap)
+{
+  if (pool->histIsPeak)
+    pool->peakHist = pool->hist;
+  if (pool->snapCount == pool->snapCapacity) {
+    pool->snapCapacity = pool->snapCapacity == 0 ? 64
+      : pool->snapCapacity * 2;
+    pool->snap = realloc(pool->snap, pool->snapCapacity * sizeof *snap);
+    if (pool->snap == NULL)
+      everror("Out of memory for snapshots");
+  }
+  pool->snap[pool->snapCount] = *snap;
+  ++ pool->snapCount;
+  (void)memset(&pool->hist, 0, sizeof pool->hist);
+  pool->histIsPeak = snap->totalSize >= pool->peakTotal;
+  if (pool->histIsPeak)
+    pool->peakTotal = snap->totalSize;
+}
+
+
+/* poolAllocated -- note the allocation of a block of the given size */
+
+static void poolAllocated(PoolRec pool, Word size)
+{
+  pool->allocCount += 1.0;
+  pool->allocSize += (double)size;
+  if (pool->align > 0 && size % pool->align != 0)
+    pool->alignWaste += (double)(pool->align - size % pool->align);
+}
+
+
+/* syncClocks -- note a pair of simultaneous event and mps_clock times */
+
+static void syncClocks(EventClock eventClock, Word mpsClock)
+{
+  if (!haveSync) {
+    syncFirstEvent = eventClock;
+    syncFirstMPS = mpsClock;
+    haveSync = TRUE;
+  }
+  syncLastEvent = eventClock;
+  syncLastMPS = mpsClock;
+}
+
+
+/* analyse -- add an event to the pool records */
+
+static void analyse(Event event)
+{
+  PoolRec pool;
+  void *entry;
+  Res res;
+
+  switch (event->any.code) {
+  case EventEventInitCode:
+    clocksPerSec = event->EventInit.f6;
+    break;
+  case EventEventClockSyncCode:
+    syncClocks(event->any.clock, event->EventClockSync.f0);
+    break;
+  case EventPoolInitCode: /* pool, arena, poolClass */
+    (void)poolCreate(event->PoolInit.f0);
+    break;
+  case EventPoolInitMVFFCode:
+    /* pool, arena, extendBy, avgSize, align, slotHigh, arenaHigh, firstFit */
+    pool = poolCreate(event->PoolInitMVFF.f0);
+    pool->className = "MVFF";
+    pool->extendBy = event->PoolInitMVFF.f2;
+    pool->meanSize = event->PoolInitMVFF.f3;
+    pool->align = event->PoolInitMVFF.f4;
+    break;
+  case EventPoolInitMVTCode:
+    /* pool, minSize, meanSize, maxSize, reserveDepth, fragLimit */
+    pool = poolCreate(event->PoolInitMVT.f0);
+    pool->className = "MVT";
+    pool->meanSize = event->PoolInitMVT.f2;
+    break;
+  case EventPoolCreateClientCode: /* pool, arena, poolClass */
+    pool = poolLookup(event->PoolCreateClient.f0);
+    if (pool != NULL)
+      pool->client = TRUE;
+    break;
+  case EventPoolFinishCode: /* pool */
+    if (poolLookup(event->PoolFinish.f0) != NULL) {
+      res = TableRemove(poolTable, (TableKey)event->PoolFinish.f0);
+      if (res != ResOK)
+        everror("Can't remove pool: error %d.", res);
+    }
+    break;
+  case EventPoolFreeStatsCode:
+    /* pool, size, totalSize, freeSize, blocks, blockSize, largest */
+    pool = poolLookup(event->PoolFreeStats.f0);
+    if (pool != NULL) {
+      SnapStruct snap;
+      snap.clock = event->any.clock;
+      snap.size = event->PoolFreeStats.f1;
+      snap.totalSize = event->PoolFreeStats.f2;
+      snap.freeSize = event->PoolFreeStats.f3;
+      snap.blocks = event->PoolFreeStats.f4;
+      snap.blockSize = event->PoolFreeStats.f5;
+      snap.largest = event->PoolFreeStats.f6;
+      poolSnapshot(pool, &snap);
+    }
+    break;
+  case EventPoolFreeBucketCode: /* pool, shift, count, size */
+    pool = poolLookup(event->PoolFreeBucket.f0);
+    if (pool != NULL && pool->snapCount > 0
+        && event->PoolFreeBucket.f1 < MPS_WORD_WIDTH) {
+      pool->hist.count[event->PoolFreeBucket.f1] += event->PoolFreeBucket.f2;
+      pool->hist.size[event->PoolFreeBucket.f1] += event->PoolFreeBucket.f3;
+    }
+    break;
+  case EventPoolAllocCode: /* pool, pReturn, size */
+    pool = poolLookup(event->PoolAlloc.f0);
+    if (pool != NULL)
+      poolAllocated(pool, event->PoolAlloc.f2);
+    break;
+  case EventBufferInitCode: /* buffer, pool, isMutator */
+    pool = poolLookup(event->BufferInit.f1);
+    if (pool != NULL && event->BufferInit.f2) {
+      if (TableLookup(&entry, bufferTable, (TableKey)event->BufferInit.f0))
+        res = TableRedefine(bufferTable, (TableKey)event->BufferInit.f0,
+                            pool);
+      else
+        res = TableDefine(bufferTable, (TableKey)event->BufferInit.f0,
+                          pool);
+      if (res != ResOK)
+        everror("Can't define buffer: error %d.", res);
+    }
+    break;
+  case EventBufferFinishCode: /* buffer */
+    if (TableLookup(&entry, bufferTable, (TableKey)event->BufferFinish.f0)) {
+      res = TableRemove(bufferTable, (TableKey)event->BufferFinish.f0);
+      if (res != ResOK)
+        everror("Can't remove buffer: error %d.", res);
+    }
+    break;
+  case EventBufferCommitCode: /* buffer, p, size, clientClass */
+    if (TableLookup(&entry, bufferTable, (TableKey)event->BufferCommit.f0))
+      poolAllocated(entry, event->BufferCommit.f2);
+    break;
+  default:
+    break;
+  }
+}
+
+
+/* Reporting */
+
+static double ticksPerSec = 0.0; /* event clock ticks per second */
+
+static void calibrate(void)
+{
+  ticksPerSec = (double)clocksPerSec;
+  if (haveSync && syncLastMPS > syncFirstMPS && clocksPerSec > 0)
+    ticksPerSec = (double)(syncLastEvent - syncFirstEvent)
+      / ((double)(syncLastMPS - syncFirstMPS) / (double)clocksPerSec);
+}
+
+static void printSnap(Snap snap)
+{
+  double frag = snap->blockSize == 0 ? 0.0
+    : 100.0 * (1.0 - (double)snap->largest / (double)snap->blockSize);
+  if (ticksPerSec > 0.0)
+    printf("  %10.3f", (double)(snap->clock - firstClock) / ticksPerSec);
+  else
+    printf("  %10.0f", (double)(snap->clock - firstClock));
+  printf(" %10"PRIuLONGEST" %12"PRIuLONGEST" %12"PRIuLONGEST
+         " %8"PRIuLONGEST" %10"PRIuLONGEST" %6.1f%%%s\n",
+         (ulongest_t)snap->size, (ulongest_t)snap->totalSize,
+         (ulongest_t)snap->freeSize, (ulongest_t)snap->blocks,
+         (ulongest_t)snap->largest, frag,
+         snap->size > 0 && snap->blockSize >= snap->size ? "  *" : "");
+}
+
+static void printHist(const char *title, Hist hist)
+{
+  Word total = 0;
+  size_t i;
+
+  for (i = 0; i < MPS_WORD_WIDTH; ++i)
+    total += hist->size[i];
+  if (total == 0)
+    return;
+  printf("\n  %s:\n"
+         "  %22s %10s %12s %7s\n",
+         title, "block size", "blocks", "bytes", "%");
+  for (i = 0; i < MPS_WORD_WIDTH; ++i)
+    if (hist->count[i] > 0) {
+      Word lo = (Word)1 << i;
+      Word hi = i + 1 < MPS_WORD_WIDTH ? ((Word)1 << (i + 1)) - 1
+        : ~(Word)0;
+      printf("  %10"PRIuLONGEST"..%-10"PRIuLONGEST" %10"PRIuLONGEST
+             " %12"PRIuLONGEST" %6.1f%%\n",
+             (ulongest_t)lo, (ulongest_t)hi,
+             (ulongest_t)hist->count[i], (ulongest_t)hist->size[i],
+             100.0 * (double)hist->size[i] / (double)total);
+    }
+}
+
+static void reportPool(PoolRec pool)
+{
+  size_t i, growths = 0, fragGrowths = 0, rows, step;
+  double meanSize = 0.0;
+
+  if (pool->histIsPeak)
+    pool->peakHist = pool->hist;
+
+  printf("\nPool %lu (%s%s)", pool->serial,
+         pool->className ? pool->className : "unknown class",
+         pool->client ? "" : ", internal");
+  if (pool->extendBy > 0)
+    printf(", extendBy %"PRIuLONGEST, (ulongest_t)pool->extendBy);
+  if (pool->meanSize > 0)
+    printf(", mean size %"PRIuLONGEST, (ulongest_t)pool->meanSize);
+  if (pool->align > 0)
+    printf(", alignment %"PRIuLONGEST, (ulongest_t)pool->align);
+  printf("\n");
+
+  for (i = 0; i < pool->snapCount; ++i)
+    if (pool->snap[i].size > 0) {
+      ++ growths;
+      if (pool->snap[i].blockSize >= pool->snap[i].size)
+        ++ fragGrowths;
+    }
+  printf("  Grew %lu times (of %lu snapshots); %lu (%.0f%%) with enough "
+         "free memory\n  in total for the request (marked *)\n",
+         (unsigned long)growths, (unsigned long)pool->snapCount,
+         (unsigned long)fragGrowths,
+         growths == 0 ? 0.0 : 100.0 * (double)fragGrowths / (double)growths);
+
+  printf("\n  %10s %10s %12s %12s %8s %10s %7s\n",
+         ticksPerSec > 0.0 ? "time/s" : "clock", "request", "total",
+         "free", "blocks", "largest", "frag");
+  rows = printAll ? pool->snapCount : ROWS_DEFAULT;
+  step = pool->snapCount <= rows ? 1
+    : (pool->snapCount + rows - 1) / rows;
+  for (i = 0; i < pool->snapCount; i += step)
+    printSnap(&pool->snap[i]);
+  if ((pool->snapCount - 1) % step != 0)
+    printSnap(&pool->snap[pool->snapCount - 1]);
+
+  printHist("Free blocks at peak total size", &pool->peakHist);
+  printHist("Free blocks at last snapshot", &pool->hist);
+
+  if (pool->allocCount > 0.0) {
+    meanSize = pool->allocSize / pool->allocCount;
+    printf("\n  %.0f blocks allocated, mean size %.1f bytes",
+           pool->allocCount, meanSize);
+    if (pool->align > 0)
+      printf(", %.1f%% lost to alignment",
+             100.0 * pool->alignWaste / pool->allocSize);
+    printf("\n");
+  }
+
+  /* Advice */
+  if (growths > 0 && 2 * fragGrowths > growths)
+    printf("\n  Most growth was caused by fragmentation: the free blocks "
+           "were large\n  enough in total, but none was large enough "
+           "for the request.\n");
+  else if (growths > 0)
+    printf("\n  Most growth was caused by live data: there was not enough "
+           "free\n  memory in total for the request.\n");
+  if (meanSize > 0.0 && pool->meanSize > 0
+      && (meanSize > 2.0 * (double)pool->meanSize
+          || 2.0 * meanSize < (double)pool->meanSize)) {
+    Word suggest = (Word)(meanSize + 0.5);
+    if (pool->align > 0)
+      suggest = (suggest + pool->align - 1) / pool->align * pool->align;
+    printf("  Consider MPS_KEY_MEAN_SIZE = %"PRIuLONGEST
+           " (the observed mean).\n", (ulongest_t)suggest);
+  }
+  if (pool->allocSize > 0.0 && pool->align > MPS_PF_ALIGN
+      && pool->alignWaste > WASTE_ALIGN * pool->allocSize)
+    printf("  Consider MPS_KEY_ALIGN = %u (the platform's natural "
+           "alignment).\n", (unsigned)MPS_PF_ALIGN);
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *filename;
+  FILE *input;
+  char *log;
+  size_t size, count, i;
+  EventIndex index;
+  PoolRec pool;
+  Bool any = FALSE;
+
+  filename = parseArgs(argc, argv);
+  if (!filename) {
+    filename = getenv(TELEMETRY_FILENAME_ENVAR);
+    if (!filename)
+      filename = DEFAULT_TELEMETRY_FILENAME;
+  }
+
+  if (strcmp(filename, "-") == 0)
+    input = stdin;
+  else {
+    input = fopen(filename, "rb");
+    if (input == NULL)
+      everror("unable to open \"%s\"", filename);
+  }
+  log = readLog(&size, input);
+  if (input != stdin)
+    (void)fclose(input);
+  index = indexLog(&count, log, size);
+  if (count == 0)
+    everror("Empty log");
+
+  poolTable = tableCreate((Count)1 << 4);
+  bufferTable = tableCreate((Count)1 << 6);
+  firstClock = index[0].clock;
+  for (i = 0; i < count; ++i) {
+    EventUnion eventUnion;
+    indexEvent(&eventUnion, log, index, i);
+    analyse(&eventUnion);
+  }
+  calibrate();
+
+  for (pool = poolFirst; pool != NULL; pool = pool->next)
+    if (pool->snapCount > 0 && (pool->client || allPools)) {
+      reportPool(pool);
+      any = TRUE;
+    }
+  if (!any)
+    printf("No snapshots of free memory in log: enable Pool events "
+           "(see \"Telemetry\" in\nthe reference manual).\n");
+
+  for (pool = poolFirst; pool != NULL; ) {
+    PoolRec next = pool->next;
+    free(pool->snap);
+    free(pool);
+    pool = next;
+  }
+  TableDestroy(poolTable);
+  TableDestroy(bufferTable);
+  free(index);
+  free(log);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -56,6 +56,8 @@ static size_t arena_grain_size = 1; /* arena grain size */
 static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static mps_bool_t json = FALSE;   /* print results as JSON */
+static size_t committed_max;      /* peak committed memory, sampled */
 
 typedef struct gcthread_s *gcthread_t;
 
@@ -175,6 +177,7 @@ static void *gc_tree(gcthread_t thread)
         tree = new_tree(ap, tree, depth);
       if (pupdate > 0.0)
         tree = update_tree(ap, tree, depth);
+      sample_committed(&committed_max, arena);
     }
   }
   return NULL;
@@ -220,18 +223,56 @@ static void weave1(gcthread_fn_t fn)
 }
 
 
+/* report -- print the results of a test as a line of JSON
+ *
+ * This is the machine-readable output consumed by tool/benchmark.  The
+ * arena must be parked, so that the messages for all collections have
+ * been posted.
+ */
+static void report(const char *name, double time)
+{
+  mps_arena_stats_s stats;
+  mps_message_t message;
+  const char *sep = "";
+
+  mps_arena_stats(arena, &stats);
+  printf("{\"benchmark\": \"gcbench\", \"test\": \"%s\", "
+         "\"seed\": %lu, \"threads\": %u, \"time\": %g, "
+         "\"committed_max\": %lu, \"collections\": %lu, "
+         "\"condemned\": %lu, \"pauses\": [",
+         name, (unsigned long)seed, nthreads, time,
+         (unsigned long)committed_max, (unsigned long)stats.traces,
+         (unsigned long)stats.condemned_size);
+  while (mps_message_get(&message, arena, mps_message_type_gc())) {
+    printf("%s%g", sep, mps_message_gc_max_pause(arena, message));
+    sep = ", ";
+    mps_message_discard(arena, message);
+  }
+  printf("]}\n");
+}
+
 static void watch(gcthread_fn_t fn, const char *name)
 {
   clock_t begin, end;
+  double time;
   
+  committed_max = 0;
+  if (json)
+    mps_message_type_enable(arena, mps_message_type_gc());
   begin = clock();
   if (nthreads == 1)
     weave1(fn);
   else
     weave(fn);
   end = clock();
+  time = (double)(end - begin) / CLOCKS_PER_SEC;
   
-  printf("%s: %g\n", name, (double)(end - begin) / CLOCKS_PER_SEC);
+  if (json) {
+    mps_arena_park(arena);
+    report(name, time);
+  } else {
+    printf("%s: %g\n", name, time);
+  }
 }
 
 
@@ -288,6 +329,7 @@ static struct option longopts[] = {
   {"seed",             required_argument, NULL, 'x'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
   {"pause-time",       required_argument, NULL, 'P'},
+  {"json",             no_argument,       NULL, 'j'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -313,7 +355,7 @@ int main(int argc, char *argv[])
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:j",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -407,6 +449,9 @@ int main(int argc, char *argv[])
     case 'P':
       pause_time = strtod(optarg, NULL);
       break;
+    case 'j':
+      json = TRUE;
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -454,6 +499,8 @@ int main(int argc, char *argv[])
               "    Disable zoned allocation in the arena\n"
               "  -P t, --pause-time\n"
               "    Maximum pause time in seconds (default %f) \n"
+              "  -j, --json\n"
+              "    Print results as JSON, one line per test\n"
               "Tests:\n"
               "  amc   pool class AMC\n"
               "  ams   pool class AMS\n",
@@ -463,7 +510,7 @@ int main(int argc, char *argv[])
   argc -= optind;
   argv += optind;
 
-  if (!seed_specified) {
+  if (!seed_specified && !json) {
     printf("seed: %lu\n", seed);
     (void)fflush(stdout);
   }
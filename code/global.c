@@ -61,6 +61,7 @@ void GlobalsClaimAll(void)
   LockClaimGlobalRecursive();
   arenaClaimRingLock();
   GlobalsArenaMap(ArenaEnter);
+  LockClaimGlobalLeaf();
 }
 
 /* GlobalsReleaseAll -- release all MPS locks. GlobalsClaimAll must
@@ -68,6 +69,7 @@ void GlobalsClaimAll(void)
 
 void GlobalsReleaseAll(void)
 {
+  LockReleaseGlobalLeaf();
   GlobalsArenaMap(ArenaLeave);
   arenaReleaseRingLock();
   LockReleaseGlobalRecursive();
@@ -236,6 +238,9 @@ Bool GlobalsCheck(Globals arenaGlobals)
   /* can't write a check for arena->epoch */
   CHECKD(History, ArenaHistory(arena));
 
+  if (arena->profile != NULL)
+    CHECKD(Profile, arena->profile);
+
   /* we also check the statics now. <design/arena/#static.check> */
   CHECKL(BoolCheck(arenaRingInit));
   /* Can't CHECKD_NOSIG here because &arenaRing is never NULL and GCC
@@ -294,6 +299,10 @@ Res GlobalsInit(Globals arenaGlobals)
   RingInit(&arenaGlobals->globalRing);
 
   arenaGlobals->lock = NULL;
+  arenaGlobals->lockClaims = 0;
+  arenaGlobals->lockWaitTime = 0;
+  arenaGlobals->lockHoldTime = 0;
+  arenaGlobals->lockClaimed = 0;
 
   arenaGlobals->pollThreshold = 0.0;
   arenaGlobals->insidePoll = FALSE;
@@ -325,6 +334,7 @@ Res GlobalsInit(Globals arenaGlobals)
   arena->finalPool = NULL;
   arena->busyTraces = TraceSetEMPTY;    /* <code/trace.c> */
   arena->flippedTraces = TraceSetEMPTY; /* <code/trace.c> */
+  arena->flips = 0;
   arena->tracedWork = 0.0;
   arena->tracedTime = 0.0;
   arena->lastWorldCollect = ClockNow();
@@ -342,7 +352,12 @@ Res GlobalsInit(Globals arenaGlobals)
 
   for(rank = RankMIN; rank < RankLIMIT; ++rank)
     RingInit(&arena->greyRing[rank]);
-  STATISTIC(arena->writeBarrierHitCount = 0);
+  TraceStatsInit(&arena->traceStats);
+  arena->pauseStart = (Clock)0;
+  arena->phaseHook = NULL;
+  arena->phaseHookClosure = NULL;
+  arena->profile = NULL;
+  arena->histogramLength = 0;
   RingInit(&arena->chainRing);
 
   HistoryInit(ArenaHistory(arena));
@@ -425,7 +440,8 @@ void GlobalsFinish(Globals arenaGlobals)
   arena = GlobalsArena(arenaGlobals);
   AVERT(Globals, arenaGlobals);
 
-  STATISTIC(EVENT2(ArenaWriteFaults, arena, arena->writeBarrierHitCount));
+  STATISTIC(EVENT2(ArenaWriteFaults, arena,
+                   arena->traceStats.writeBarrierHitCount));
 
   arenaGlobals->sig = SigInvalid;
 
@@ -495,6 +511,9 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
     EVENT0(MessagesExist);
   MessageEmpty(arena);
 
+  /* discard the allocation profile <design/profile/> */
+  ProfileStop(arena);
+
   /* throw away the BT used by messages */
   if (arena->enabledMessageTypes != NULL) {
     ControlFree(arena, (void *)arena->enabledMessageTypes,
@@ -562,7 +581,11 @@ void ArenaEnter(Arena arena)
     recursively or not. */
 void ArenaEnterLock(Arena arena, Bool recursive)
 {
+  Globals globals;
   Lock lock;
+#if defined(LOCK_STATS)
+  EventClock start, claimed;
+#endif
 
   /* This check is safe to do outside the lock.  Unless the client
      is also calling ArenaDestroy, but that's a protocol violation by
@@ -574,11 +597,22 @@ void ArenaEnterLock(Arena arena, Bool recursive)
    * exception handler) and that code may enter the MPS. If we took
    * the lock first then this would deadlock. */
   StackProbe(StackProbeDEPTH);
-  lock = ArenaGlobals(arena)->lock;
+  globals = ArenaGlobals(arena);
+  lock = globals->lock;
   if(recursive) {
     LockClaimRecursive(lock);
   } else {
+#if defined(LOCK_STATS)
+    /* <design/arena/#lock.stats> */
+    EVENT_CLOCK(start);
+    LockClaim(lock);
+    EVENT_CLOCK(claimed);
+    ++globals->lockClaims;
+    globals->lockWaitTime += claimed - start;
+    globals->lockClaimed = claimed;
+#else
     LockClaim(lock);
+#endif
   }
   AVERT(Arena, arena); /* can't AVERT it until we've got the lock */
   if(recursive) {
@@ -607,11 +641,13 @@ void ArenaLeave(Arena arena)
 
 void ArenaLeaveLock(Arena arena, Bool recursive)
 {
+  Globals globals;
   Lock lock;
 
   AVERT(Arena, arena);
 
-  lock = ArenaGlobals(arena)->lock;
+  globals = ArenaGlobals(arena);
+  lock = globals->lock;
 
   if(recursive) {
     /* no need to leave shield */
@@ -622,6 +658,11 @@ void ArenaLeaveLock(Arena arena, Bool recursive)
   if(recursive) {
     LockReleaseRecursive(lock);
   } else {
+#if defined(LOCK_STATS)
+    EventClock released;
+    EVENT_CLOCK(released);
+    globals->lockHoldTime += released - globals->lockClaimed;
+#endif
     LockRelease(lock);
   }
 }
@@ -660,6 +701,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
 
     ArenaEnter(arena);     /* <design/arena/#lock.arena> */
     EVENT4(ArenaAccess, arena, ++count, addr, mode);
+    PROBE3(arena_access_begin, arena, addr, mode);
 
     /* @@@@ The code below assumes that Roots and Segs are disjoint. */
     /* It will fall over (in TraceSegAccess probably) if there is a */
@@ -681,6 +723,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
            or a fault in a nested exception handler: nothing to do now. */
       }
       EVENT4(ArenaAccess, arena, count, addr, mode);
+      PROBE3(arena_access_end, arena, addr, mode);
       ArenaLeave(arena);
       return TRUE;
     } else if (RootOfAddr(&root, arena, addr)) {
@@ -689,6 +732,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
       if (mode != AccessSetEMPTY)
         RootAccess(root, mode);
       EVENT4(ArenaAccess, arena, count, addr, mode);
+      PROBE3(arena_access_end, arena, addr, mode);
       ArenaLeave(arena);
       return TRUE;
     } else {
@@ -744,6 +788,7 @@ void (ArenaPoll)(Globals globals)
 
   /* fillMutatorSize has advanced; call TracePoll enough to catch up. */
   start = ClockNow();
+  arena->pauseStart = ClockNow();
 
   EVENT3(ArenaPoll, arena, start, FALSE);
 
@@ -783,6 +828,7 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   clocks_per_sec = ClocksPerSec();
 
   start = now = ClockNow();
+  arena->pauseStart = ClockNow();
   intervalEnd = start + (Clock)(interval * clocks_per_sec);
   AVER(intervalEnd >= start);
   availableEnd = start + (Clock)(interval * multiplier * clocks_per_sec);
@@ -1021,6 +1067,7 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
   res = WriteF(stream, depth + 2,
                "mpsVersion $S\n", (WriteFS)arenaGlobals->mpsVersionString,
                "lock $P\n", (WriteFP)arenaGlobals->lock,
+               "lockClaims $U\n", (WriteFU)arenaGlobals->lockClaims,
                "pollThreshold $U kB\n",
                (WriteFU)(arenaGlobals->pollThreshold / 1024),
                arenaGlobals->insidePoll ? "inside" : "outside", " poll\n",
@@ -0,0 +1,646 @@
+/* latbench.c -- GC pause latency benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark runs a steady-state mutator that keeps a live set of
+ * constant size while allocating at a controlled rate, and records
+ * every step in which the mutator was held up by the MPS for longer
+ * than a threshold: polls and collection steps on the allocation slow
+ * path, flips, and barrier hits.  It reports the distribution of these
+ * pauses and the minimum mutator utilization.  See
+ * <design/tests/#test.latency>.
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "mpm.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, sscanf, stderr */
+#include <stdlib.h> /* exit, EXIT_FAILURE, EXIT_SUCCESS, malloc, qsort */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+#define RESMUST(expr) \
+  do { \
+    mps_res_t res = (expr); \
+    if (res != MPS_RES_OK) { \
+      fprintf(stderr, #expr " returned %d\n", res); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+static mps_arena_t arena;
+static mps_pool_t pool;
+static mps_fmt_t format;
+static mps_chain_t chain;
+
+#define genLIMIT  100
+#define LINKS     4       /* references stored in each new object */
+
+static rnd_state_t seed = 0;      /* random number seed */
+static size_t live_size = 16ul * 1024 * 1024; /* size of live set */
+static size_t total = 256ul * 1024 * 1024; /* total to allocate */
+static double rate = 0.0;         /* allocation rate, bytes per second */
+static size_t maxslots = 16;      /* maximum slots in an object */
+static double pupdate = 0.5;      /* probability of updating an object */
+static double threshold = 10e-6;  /* shortest pause recorded, seconds */
+static unsigned ngen = 0;         /* number of generations specified */
+static mps_gen_param_s gen[genLIMIT]; /* generation parameters */
+static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
+static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
+static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static mps_bool_t json = FALSE;   /* print results as JSON */
+
+typedef mps_word_t obj_t;
+
+static obj_t *live;               /* the live set, a root */
+static size_t nlive;              /* number of objects in live set */
+static size_t committed_max;      /* peak committed memory, sampled */
+static double ticks_per_sec;      /* EVENT_CLOCK ticks per second */
+
+
+/* Pauses, in the order in which they happened. */
+
+typedef struct pause_s {
+  EventClock start, end;
+} pause_s;
+
+static pause_s *pauses;
+static size_t npauses, pauses_size;
+
+static void record_pause(EventClock start, EventClock end)
+{
+  if (npauses == pauses_size) {
+    pauses_size = pauses_size == 0 ? 1024 : pauses_size * 2;
+    pauses = realloc(pauses, pauses_size * sizeof pauses[0]);
+    if (pauses == NULL) {
+      fprintf(stderr, "out of memory recording pauses\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  pauses[npauses].start = start;
+  pauses[npauses].end = end;
+  ++npauses;
+}
+
+
+/* calibrate -- measure the rate of EVENT_CLOCK against clock()
+ *
+ * The benchmark is single-threaded and busy throughout, so processor
+ * time is a fair proxy for elapsed time.
+ */
+
+static void calibrate(void)
+{
+  clock_t start, begin, end;
+  EventClock ticks_begin, ticks_end;
+
+  start = clock();
+  while ((begin = clock()) == start)
+    NOOP; /* wait for the clock to tick */
+  EVENT_CLOCK(ticks_begin);
+  while ((end = clock()) - begin < CLOCKS_PER_SEC / 10)
+    NOOP;
+  EVENT_CLOCK(ticks_end);
+  ticks_per_sec = (double)(ticks_end - ticks_begin) * CLOCKS_PER_SEC
+    / (double)(end - begin);
+}
+
+
+static size_t veclen(obj_t v)
+{
+  return (size_t)(((mps_word_t *)v)[1] >> 2);
+}
+
+static obj_t mkvector(mps_ap_t ap, size_t n)
+{
+  mps_word_t v;
+  RESMUST(make_dylan_vector(&v, ap, n));
+  return v;
+}
+
+
+/* step -- one unit of mutator work
+ *
+ * Allocate an object that refers to some of the live set, and replace
+ * a random member of the live set with it.  With probability pupdate,
+ * also copy a reference from one live object into another, so that the
+ * mutator reads and writes old objects and may hit the barriers.
+ * Return the size allocated.
+ */
+
+static size_t step(mps_ap_t ap)
+{
+  size_t i, n = 1 + rnd() % maxslots;
+  obj_t v = mkvector(ap, n);
+
+  for (i = 0; i < n && i < LINKS; ++i)
+    DYLAN_VECTOR_SLOT(v, i) = live[rnd() % nlive];
+  live[rnd() % nlive] = v;
+
+  if (rnd_double() < pupdate) {
+    obj_t from = live[rnd() % nlive], to = live[rnd() % nlive];
+    DYLAN_VECTOR_SLOT(to, rnd() % veclen(to))
+      = DYLAN_VECTOR_SLOT(from, rnd() % veclen(from));
+  }
+
+  return (n + 2) * sizeof(mps_word_t);
+}
+
+
+/* paused_in -- time spent in pauses between ws and we
+ *
+ * Pause i is near the window; the search extends in both directions.
+ */
+
+static EventClock paused_in(EventClock ws, EventClock we, size_t i)
+{
+  EventClock paused = 0;
+
+  while (i > 0 && pauses[i - 1].end > ws)
+    --i;
+  for (; i < npauses && pauses[i].start < we; ++i)
+    if (pauses[i].end > ws)
+      paused += (pauses[i].end < we ? pauses[i].end : we)
+        - (pauses[i].start > ws ? pauses[i].start : ws);
+  return paused;
+}
+
+
+/* mmu -- minimum mutator utilization over windows of a given length
+ *
+ * The utilization of a window is the fraction of it not spent in
+ * pauses.  The minimum is attained by a window that starts at the
+ * start of a pause or ends at the end of one, so only those windows
+ * are considered.
+ */
+
+static double mmu(double window, EventClock begin, EventClock end)
+{
+  double length = window * ticks_per_sec, min = 1.0, util;
+  EventClock w, ws, we;
+  size_t i;
+
+  if (length > (double)(end - begin))
+    length = (double)(end - begin);
+  if (length < 1.0)
+    return 1.0;
+  w = (EventClock)length;
+
+  for (i = 0; i < npauses; ++i) {
+    /* Window starting at the start of pause i. */
+    ws = pauses[i].start;
+    if (ws > end - w)
+      ws = end - w;
+    util = 1.0 - (double)paused_in(ws, ws + w, i) / (double)w;
+    if (util < min)
+      min = util;
+
+    /* Window ending at the end of pause i. */
+    we = pauses[i].end;
+    if (we < begin + w)
+      we = begin + w;
+    util = 1.0 - (double)paused_in(we - w, we, i) / (double)w;
+    if (util < min)
+      min = util;
+  }
+  return min;
+}
+
+
+static int compare_clock(const void *a, const void *b)
+{
+  EventClock x = *(const EventClock *)a, y = *(const EventClock *)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* percentile -- nearest-rank percentile of sorted durations, in seconds */
+
+static double percentile(EventClock *sorted, size_t n, double q)
+{
+  size_t rank;
+  if (n == 0)
+    return 0.0;
+  rank = (size_t)(q / 100.0 * (double)n + 0.999999);
+  if (rank < 1)
+    rank = 1;
+  if (rank > n)
+    rank = n;
+  return (double)sorted[rank - 1] / ticks_per_sec;
+}
+
+
+/* report -- print the results of a test */
+
+static void report(const char *name, EventClock begin, EventClock end,
+                   size_t allocated)
+{
+  mps_arena_stats_s stats;
+  EventClock *durations = NULL, paused = 0;
+  double time = (double)(end - begin) / ticks_per_sec;
+  double p50, p99, p999, max, mmu1, mmu10, mmu100;
+  size_t i;
+
+  mps_arena_stats(arena, &stats);
+  if (npauses > 0) {
+    durations = malloc(npauses * sizeof durations[0]);
+    if (durations == NULL) {
+      fprintf(stderr, "out of memory reporting pauses\n");
+      exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < npauses; ++i) {
+      durations[i] = pauses[i].end - pauses[i].start;
+      paused += durations[i];
+    }
+    qsort(durations, npauses, sizeof durations[0], compare_clock);
+  }
+  p50 = percentile(durations, npauses, 50.0);
+  p99 = percentile(durations, npauses, 99.0);
+  p999 = percentile(durations, npauses, 99.9);
+  max = percentile(durations, npauses, 100.0);
+  mmu1 = mmu(0.001, begin, end);
+  mmu10 = mmu(0.01, begin, end);
+  mmu100 = mmu(0.1, begin, end);
+
+  if (json) {
+    printf("{\"benchmark\": \"latbench\", \"test\": \"%s\", "
+           "\"seed\": %lu, \"threads\": 1, \"time\": %g, "
+           "\"allocated\": %lu, \"committed_max\": %lu, "
+           "\"collections\": %lu, \"condemned\": %lu, ",
+           name, (unsigned long)seed, time, (unsigned long)allocated,
+           (unsigned long)committed_max, (unsigned long)stats.traces,
+           (unsigned long)stats.condemned_size);
+    printf("\"paused\": %g, \"p50\": %g, \"p99\": %g, \"p999\": %g, "
+           "\"max_pause\": %g, \"mmu_1ms\": %g, \"mmu_10ms\": %g, "
+           "\"mmu_100ms\": %g, \"pauses\": [",
+           (double)paused / ticks_per_sec, p50, p99, p999, max,
+           mmu1, mmu10, mmu100);
+    for (i = 0; i < npauses; ++i)
+      printf("%s%g", i == 0 ? "" : ", ",
+             (double)(pauses[i].end - pauses[i].start) / ticks_per_sec);
+    printf("]}\n");
+  } else {
+    printf("%s: %g\n", name, time);
+    printf("%s: allocated %lu, collections %lu, committed max %lu\n",
+           name, (unsigned long)allocated, (unsigned long)stats.traces,
+           (unsigned long)committed_max);
+    printf("%s: pauses %lu, total %g, p50 %g, p99 %g, p99.9 %g, max %g\n",
+           name, (unsigned long)npauses, (double)paused / ticks_per_sec,
+           p50, p99, p999, max);
+    printf("%s: mmu 1ms %.3f, 10ms %.3f, 100ms %.3f\n",
+           name, mmu1, mmu10, mmu100);
+  }
+  free(durations);
+}
+
+
+/* run -- run the steady-state mutator and measure its pauses */
+
+static void run(mps_ap_t ap, const char *name)
+{
+  EventClock begin, end, t0, t1, limit;
+  size_t i, allocated = 0;
+  unsigned long steps = 0;
+
+  /* Build the live set, untimed. */
+  nlive = live_size / ((maxslots / 2 + 3) * sizeof(mps_word_t));
+  if (nlive < 1)
+    nlive = 1;
+  live = malloc(nlive * sizeof live[0]);
+  if (live == NULL) {
+    fprintf(stderr, "out of memory allocating live set\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < nlive; ++i)
+    live[i] = DYLAN_INT(0);
+  {
+    mps_root_t root;
+    RESMUST(mps_root_create_area_tagged(&root, arena, mps_rank_exact(),
+                                        (mps_rm_t)0, live, live + nlive,
+                                        mps_scan_area_tagged,
+                                        (mps_word_t)1, (mps_word_t)0));
+    for (i = 0; i < nlive; ++i)
+      live[i] = mkvector(ap, 1 + rnd() % maxslots);
+
+    npauses = 0;
+    committed_max = 0;
+    EVENT_CLOCK(begin);
+    end = begin;
+    while (allocated < total) {
+      EVENT_CLOCK(t0);
+      allocated += step(ap);
+      EVENT_CLOCK(t1);
+      if ((double)(t1 - t0) >= threshold * ticks_per_sec) {
+        record_pause(t0, t1);
+        sample_committed(&committed_max, arena);
+      } else if (++steps % 1024 == 0) {
+        sample_committed(&committed_max, arena);
+      }
+      end = t1;
+      if (rate > 0.0) {
+        /* Wait until the allocation is on schedule. */
+        limit = begin + (EventClock)((double)allocated / rate
+                                     * ticks_per_sec);
+        while (end < limit)
+          EVENT_CLOCK(end);
+      }
+    }
+
+    mps_arena_park(arena);
+    report(name, begin, end, allocated);
+    mps_root_destroy(root);
+  }
+  free(live);
+}
+
+
+/* Setup MPS arena and call benchmark. */
+
+static void arena_setup(mps_pool_class_t pool_class, const char *name)
+{
+  mps_thr_t thread;
+  mps_root_t reg_root;
+  mps_ap_t ap;
+  void *marker = &marker;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
+    RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
+  } MPS_ARGS_END(args);
+  RESMUST(dylan_fmt(&format, arena));
+  RESMUST(dylan_make_wrappers());
+  if (ngen > 0)
+    RESMUST(mps_chain_create(&chain, arena, ngen, gen));
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    if (ngen > 0)
+      MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    RESMUST(mps_pool_create_k(&pool, arena, pool_class, args));
+  } MPS_ARGS_END(args);
+  RESMUST(mps_thread_reg(&thread, arena));
+  RESMUST(mps_root_create_thread(&reg_root, arena, thread, marker));
+  RESMUST(mps_ap_create_k(&ap, pool, mps_args_none));
+
+  run(ap, name);
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(reg_root);
+  mps_thread_dereg(thread);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  if (ngen > 0)
+    mps_chain_destroy(chain);
+  mps_arena_destroy(arena);
+}
+
+
+/* parse_size -- parse a size with an optional K, M or G suffix */
+
+static size_t parse_size(const char *s)
+{
+  char *p;
+  size_t size = (size_t)strtoul(s, &p, 10);
+  switch (toupper(*p)) {
+  case 'G': size <<= 30; break;
+  case 'M': size <<= 20; break;
+  case 'K': size <<= 10; break;
+  case '\0': break;
+  default:
+    fprintf(stderr, "Bad size %s\n", s);
+    exit(EXIT_FAILURE);
+  }
+  return size;
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"live-size",        required_argument, NULL, 'l'},
+  {"total",            required_argument, NULL, 'n'},
+  {"rate",             required_argument, NULL, 'r'},
+  {"max-slots",        required_argument, NULL, 's'},
+  {"pupdate",          required_argument, NULL, 'u'},
+  {"threshold",        required_argument, NULL, 'T'},
+  {"gen",              required_argument, NULL, 'g'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {"seed",             required_argument, NULL, 'x'},
+  {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"pause-time",       required_argument, NULL, 'P'},
+  {"json",             no_argument,       NULL, 'j'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_pool_class_t (*pool_class)(void);
+} pools[] = {
+  {"amc", mps_class_amc},
+  {"ams", mps_class_ams},
+  {"awl", mps_class_awl},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+  mps_bool_t seed_specified = FALSE;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "hl:n:r:s:u:T:g:m:x:zP:j",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 'l':
+      live_size = parse_size(optarg);
+      break;
+    case 'n':
+      total = parse_size(optarg);
+      break;
+    case 'r':
+      rate = (double)parse_size(optarg);
+      break;
+    case 's':
+      maxslots = (size_t)strtoul(optarg, NULL, 10);
+      if (maxslots < 1)
+        maxslots = 1;
+      break;
+    case 'u':
+      pupdate = strtod(optarg, NULL);
+      break;
+    case 'T':
+      threshold = strtod(optarg, NULL);
+      break;
+    case 'g':
+      if (ngen >= genLIMIT) {
+        fprintf(stderr, "exceeded genLIMIT\n");
+        return EXIT_FAILURE;
+      }
+      {
+        char *p;
+        size_t cap = 0;
+        double mort = 0.0;
+        cap = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': cap <<= 20; p++; break;
+        case 'M': cap <<= 10; p++; break;
+        case 'K': p++; break;
+        default: cap = 0; break;
+        }
+        if (sscanf(p, ",%lg", &mort) != 1 || cap == 0) {
+          fprintf(stderr, "Bad gen format '%s'\n"
+                  "Each gen option has format --gen=capacity[KMG],mortality\n"
+                  "e.g.: --gen=500K,0.85 --gen=20M,0.45\n", optarg);
+          return EXIT_FAILURE;
+        }
+        gen[ngen].mps_capacity = cap;
+        gen[ngen].mps_mortality = mort;
+        ngen++;
+      }
+      break;
+    case 'm':
+      arena_size = parse_size(optarg);
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    case 'z':
+      zoned = FALSE;
+      break;
+    case 'P':
+      pause_time = strtod(optarg, NULL);
+      break;
+    case 'j':
+      json = TRUE;
+      break;
+    default:
+      /* This is printed in parts to keep within the 509 character
+         limit for string literals in portable standard C. */
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -l n, --live-size=n[KMG]\n"
+              "    Size of the live set (default %lu).\n"
+              "  -n n, --total=n[KMG]\n"
+              "    Total to allocate (default %lu).\n"
+              "  -r n, --rate=n[KMG]\n"
+              "    Allocation rate per second, or 0 for no limit.\n"
+              "  -s n, --max-slots=n\n"
+              "    Maximum slots in an object (default %lu).\n"
+              "  -u p, --pupdate=p\n"
+              "    Probability of updating an object (default %g).\n",
+              argv[0],
+              (unsigned long)live_size,
+              (unsigned long)total,
+              (unsigned long)maxslots,
+              pupdate);
+      fprintf(stderr,
+              "  -T t, --threshold=t\n"
+              "    Shortest pause recorded in seconds (default %g).\n"
+              "  -g c,m, --gen=c[KMG],m\n"
+              "    Generation with capacity c (in Kb) and mortality m.\n"
+              "  -m n, --arena-size=n[KMG]\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n"
+              "  -z, --arena-unzoned\n"
+              "    Disable zoned allocation in the arena.\n",
+              threshold,
+              (unsigned long)arena_size);
+      fprintf(stderr,
+              "  -P t, --pause-time=t\n"
+              "    Maximum pause time in seconds (default %g).\n"
+              "  -j, --json\n"
+              "    Print results as JSON, one line per test.\n"
+              "Tests:\n"
+              "  amc   pool class AMC\n"
+              "  ams   pool class AMS\n"
+              "  awl   pool class AWL\n",
+              pause_time);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (!seed_specified && !json) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+
+  calibrate();
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(pools); ++i)
+      if (strcmp(argv[0], pools[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown pool test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    rnd_state_set(seed);
+    arena_setup(pools[i].pool_class(), pools[i].name);
+    --argc;
+    ++argv;
+  }
+
+  free(pauses);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -43,7 +43,7 @@
  * .ld.access: Accesses (reads and writes) to the ld structure must be
  * "wrapped" with an ShieldExpose/Cover pair if and only if the access
  * is taking place inside the arena.  Currently this is only the case for
- * LDReset.
+ * LDReset and LDIsStale.
  */
 
 #include "mpm.h"
@@ -243,9 +243,28 @@ Bool LDIsStaleAny(mps_ld_t ld, Arena arena)
 
 /* LDIsStale -- check whether a particular dependency is stale
  *
- * .stale.conservative: In fact we just ignore the address and test if
- * any dependency is stale. This is conservatively correct (no false
- * negatives) but provides a hook for future improvement.
+ * .stale.zone: First test if any dependency is stale, as
+ * LDIsStaleAny.  If not, then addr can't have moved either.
+ *
+ * .stale.seg: Otherwise the zone test may be a false positive: any
+ * object moved out of a zone in the dependency makes the whole
+ * dependency stale.  So look at the segment containing addr.  Moving
+ * pools stamp each segment they copy objects into with the current
+ * epoch (see amcSegFix), and a flip always advances the epoch (see
+ * LDAge) before any objects move.  If the block at addr has moved
+ * since the dependency's epoch, then addr is its new location and
+ * the stamp on its segment is later than that epoch.  If addr isn't
+ * in a segment, then there is no managed block there to have moved.
+ *
+ * .stale.seg.conservative: Any allocation into a segment that was
+ * once copied into looks moved, so this is still conservative (no
+ * false negatives), just much less so than the zone test.
+ *
+ * .stale.lock: Unlike LDIsStaleAny, this must be called with the
+ * arena lock held, because it looks up the segment.  The caller can
+ * call LDIsStaleAny first without the lock to avoid this in the
+ * common case.  The dependency may itself be in a segment, so it is
+ * read under .ld.access.
  *
  * .stale.no-arena-check: See .add.no-arena-check.
  *
@@ -253,8 +272,28 @@ Bool LDIsStaleAny(mps_ld_t ld, Arena arena)
  */
 Bool LDIsStale(mps_ld_t ld, Arena arena, Addr addr)
 {
-  UNUSED(addr);
-  return LDIsStaleAny(ld, arena);
+  Bool b, stale;
+  Seg seg;
+  Epoch epoch;
+
+  AVER(ld != NULL);
+  AVERT(Arena, arena);
+
+  b = SegOfAddr(&seg, arena, (Addr)ld);
+  if (b)
+    ShieldExpose(arena, seg);   /* .ld.access */
+  stale = LDIsStaleAny(ld, arena); /* .stale.zone */
+  epoch = ld->_epoch;
+  if (b)
+    ShieldCover(arena, seg);
+
+  if (!stale)
+    return FALSE;
+
+  /* .stale.seg */
+  if (!SegOfAddr(&seg, arena, addr))
+    return FALSE;
+  return SegMovedIn(seg) > epoch;
 }
 
 
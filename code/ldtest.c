@@ -0,0 +1,194 @@
+/* ldtest.c: LOCATION DEPENDENCY TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Allocate objects in an AMC pool, some referenced exactly and some
+ * ambiguously, add them all to a location dependency, and collect.
+ * Every object that moved must be reported stale.  Ambiguously
+ * referenced objects are pinned, and mps_ld_isstale_precise must not
+ * report an object that did not move as stale merely because objects
+ * in the same zones moved.  See <code/ld.c#stale.seg>.
+ */
+
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+#include "mpslib.h"
+#include "mps.h"
+
+#include <stdio.h> /* printf */
+
+
+#define testArenaSIZE   ((size_t)64<<20)
+#define OBJECTS         1000
+#define SLOTS           4
+#define COLLECTIONS     4
+
+
+static mps_word_t exactRoots[OBJECTS];
+static mps_word_t ambigRoots[OBJECTS];
+static mps_word_t exactOld[OBJECTS];
+static mps_word_t ambigOld[OBJECTS];
+
+
+/* check -- check the dependency against the objects' movement
+ *
+ * Return the number of objects that did not move but were reported
+ * stale.  If strict, there must be none.
+ */
+
+static size_t check(mps_ld_t ld, mps_arena_t arena,
+                    mps_word_t *roots, mps_word_t *old, mps_bool_t strict)
+{
+  size_t i, falsePositives = 0;
+
+  for (i = 0; i < OBJECTS; ++i) {
+    mps_bool_t stale = mps_ld_isstale_precise(ld, arena,
+                                              (mps_addr_t)roots[i]);
+    if (roots[i] != old[i]) {
+      Insist(stale);
+      Insist(mps_ld_isstale(ld, arena, (mps_addr_t)roots[i]));
+      Insist(mps_ld_isstale_any(ld, arena));
+    } else if (stale) {
+      Insist(!strict);
+      ++falsePositives;
+    }
+  }
+  return falsePositives;
+}
+
+
+static void test(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_ld_s ld;
+  size_t i, c, moved, unmoved, falsePositives;
+
+  for (i = 0; i < OBJECTS; ++i) {
+    die(make_dylan_vector(&exactRoots[i], ap, SLOTS), "make exact");
+    die(make_dylan_vector(&ambigRoots[i], ap, SLOTS), "make ambig");
+  }
+
+  for (c = 0; c < COLLECTIONS; ++c) {
+    mps_ld_reset(&ld, arena);
+    for (i = 0; i < OBJECTS; ++i) {
+      mps_ld_add(&ld, arena, (mps_addr_t)exactRoots[i]);
+      mps_ld_add(&ld, arena, (mps_addr_t)ambigRoots[i]);
+      exactOld[i] = exactRoots[i];
+      ambigOld[i] = ambigRoots[i];
+    }
+    for (i = 0; i < OBJECTS; ++i)
+      Insist(!mps_ld_isstale_precise(&ld, arena,
+                                     (mps_addr_t)exactRoots[i]));
+
+    die(mps_arena_collect(arena), "mps_arena_collect");
+
+    moved = 0;
+    unmoved = 0;
+    for (i = 0; i < OBJECTS; ++i) {
+      Insist(ambigRoots[i] == ambigOld[i]);
+      if (exactRoots[i] != exactOld[i])
+        ++moved;
+      else
+        ++unmoved;
+    }
+    Insist(moved > 0);
+
+    /* Nothing had been copied into the segments the objects were
+       allocated in before the first collection, so an object that
+       did not move in it can't be reported stale. */
+    falsePositives = check(&ld, arena, exactRoots, exactOld, c == 0);
+    falsePositives += check(&ld, arena, ambigRoots, ambigOld, c == 0);
+    printf("collection %lu: %lu moved, %lu unmoved, "
+           "%lu false positives\n",
+           (unsigned long)c, (unsigned long)moved,
+           (unsigned long)(unmoved + OBJECTS),
+           (unsigned long)falsePositives);
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+  mps_pool_t pool;
+  mps_fmt_t fmt;
+  mps_ap_t ap;
+  mps_root_t exactRoot, ambigRoot;
+
+  testlib_init(argc, argv);
+
+  die(mps_arena_create(&arena, mps_arena_class_vm(), testArenaSIZE),
+      "arena_create");
+  mps_arena_park(arena);
+  die(mps_root_create_area(&exactRoot, arena, mps_rank_exact(), 0,
+                           exactRoots, exactRoots + OBJECTS,
+                           mps_scan_area, NULL),
+      "root_create_area(exact)");
+  die(mps_root_create_area(&ambigRoot, arena, mps_rank_ambig(), 0,
+                           ambigRoots, ambigRoots + OBJECTS,
+                           mps_scan_area, NULL),
+      "root_create_area(ambig)");
+  die(mps_fmt_create_A(&fmt, arena, dylan_fmt_A()), "fmt_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, fmt);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+
+  test(arena, ap);
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(fmt);
+  mps_root_destroy(ambigRoot);
+  mps_root_destroy(exactRoot);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -133,6 +133,40 @@ extern void LockClaimGlobal(void);
 extern void LockReleaseGlobal(void);
 
 
+/*  LockClaimGlobalLeaf
+ *
+ *  This is called to claim the binary leaf global lock, and may only
+ *  be used if that lock is not already owned by the calling thread.
+ *  It must be matched by a call to LockReleaseGlobalLeaf.  The leaf
+ *  lock comes last in the locking order: it may be claimed while
+ *  holding any other lock, but no other lock may be claimed while it
+ *  is held.
+ */
+
+extern void LockClaimGlobalLeaf(void);
+
+
+/*  LockReleaseGlobalLeaf
+ *
+ *  This must only be used to release the binary leaf global lock
+ *  symmetrically with LockClaimGlobalLeaf.
+ */
+
+extern void LockReleaseGlobalLeaf(void);
+
+
+/*  LockClaimGlobalLeafUnlessOwned
+ *
+ *  This claims the binary leaf global lock as LockClaimGlobalLeaf does
+ *  and returns TRUE, unless the lock is already owned by the calling
+ *  thread, in which case it returns FALSE without claiming it.  This
+ *  is for the assertion handler, which may be entered while the lock
+ *  is held.
+ */
+
+extern Bool LockClaimGlobalLeafUnlessOwned(void);
+
+
 /* LockSetup -- one-time lock initialization */
 
 extern void LockSetup(void);
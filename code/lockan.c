@@ -106,12 +106,21 @@ static Lock globalLock = &globalLockStruct;
 
 static Lock globalRecLock = &globalRecursiveLockStruct;
 
+static LockStruct globalLeafLockStruct = {
+  LockSig,
+  0
+};
+
+static Lock globalLeafLock = &globalLeafLockStruct;
+
 void LockInitGlobal(void)
 {
   globalLock->claims = 0;
   LockInit(globalLock);
   globalRecLock->claims = 0;
   LockInit(globalRecLock);
+  globalLeafLock->claims = 0;
+  LockInit(globalLeafLock);
 }
 
 void (LockClaimGlobalRecursive)(void)
@@ -134,6 +143,24 @@ void (LockReleaseGlobal)(void)
   LockRelease(globalLock);
 }
 
+void (LockClaimGlobalLeaf)(void)
+{
+  LockClaim(globalLeafLock);
+}
+
+Bool (LockClaimGlobalLeafUnlessOwned)(void)
+{
+  if (globalLeafLock->claims > 0)
+    return FALSE;
+  LockClaim(globalLeafLock);
+  return TRUE;
+}
+
+void (LockReleaseGlobalLeaf)(void)
+{
+  LockRelease(globalLeafLock);
+}
+
 void LockSetup(void)
 {
   /* Nothing to do as ANSI platform does not have fork(). */
@@ -54,6 +54,11 @@ int main(int argc, char *argv[])
   Insist(!LockIsHeld(a));
   LockClaimGlobalRecursive();
   LockReleaseGlobal();
+  LockClaimGlobalLeaf();
+  Insist(!LockClaimGlobalLeafUnlessOwned());
+  LockReleaseGlobalLeaf();
+  Insist(LockClaimGlobalLeafUnlessOwned());
+  LockReleaseGlobalLeaf();
   LockClaimRecursive(b);
   Insist(LockIsHeld(b));
   LockFinish(a);
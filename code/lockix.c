@@ -201,19 +201,22 @@ Bool (LockIsHeld)(Lock lock)
 
 /* Global locks
  *
- * .global: The two "global" locks are statically allocated normal locks.
+ * .global: The three "global" locks are statically allocated normal locks.
  */
 
 static LockStruct globalLockStruct;
 static LockStruct globalRecLockStruct;
+static LockStruct globalLeafLockStruct;
 static Lock globalLock = &globalLockStruct;
 static Lock globalRecLock = &globalRecLockStruct;
+static Lock globalLeafLock = &globalLeafLockStruct;
 static pthread_once_t isGlobalLockInit = PTHREAD_ONCE_INIT;
 
 void LockInitGlobal(void)
 {
   LockInit(globalLock);
   LockInit(globalRecLock);
+  LockInit(globalLeafLock);
 }
 
 
@@ -259,6 +262,50 @@ void (LockReleaseGlobal)(void)
 }
 
 
+/* LockClaimGlobalLeaf -- claim the global leaf lock */
+
+void (LockClaimGlobalLeaf)(void)
+{
+  int res;
+
+  /* Ensure the global lock has been initialized */
+  res = pthread_once(&isGlobalLockInit, LockInitGlobal);
+  AVER(res == 0);
+  LockClaim(globalLeafLock);
+}
+
+
+/* LockClaimGlobalLeafUnlessOwned -- claim the global leaf lock if not owned
+ *
+ * Relies on the error-checking mutex to detect that the calling thread
+ * owns the lock already.
+ */
+
+Bool (LockClaimGlobalLeafUnlessOwned)(void)
+{
+  int res;
+
+  res = pthread_once(&isGlobalLockInit, LockInitGlobal);
+  AVER(res == 0);
+  AVERT(Lock, globalLeafLock);
+  res = pthread_mutex_lock(&globalLeafLock->mut);
+  if (res == EDEADLK)
+    return FALSE;
+  AVER(res == 0);
+  AVER(globalLeafLock->claims == 0);
+  globalLeafLock->claims = 1;
+  return TRUE;
+}
+
+
+/* LockReleaseGlobalLeaf -- release the global leaf lock */
+
+void (LockReleaseGlobalLeaf)(void)
+{
+  LockRelease(globalLeafLock);
+}
+
+
 /* LockSetup -- one-time lock initialization */
 
 void LockSetup(void)
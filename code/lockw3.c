@@ -123,8 +123,10 @@ Bool (LockIsHeld)(Lock lock)
 
 static LockStruct globalLockStruct;
 static LockStruct globalRecLockStruct;
+static LockStruct globalLeafLockStruct;
 static Lock globalLock = &globalLockStruct;
 static Lock globalRecLock = &globalRecLockStruct;
+static Lock globalLeafLock = &globalLeafLockStruct;
 static Bool globalLockInit = FALSE; /* TRUE iff initialized */
 
 void LockInitGlobal(void)
@@ -133,6 +135,8 @@ void LockInitGlobal(void)
   LockInit(globalLock);
   globalRecLock->claims = 0;
   LockInit(globalRecLock);
+  globalLeafLock->claims = 0;
+  LockInit(globalLeafLock);
   globalLockInit = TRUE;
 }
 
@@ -190,6 +194,36 @@ void (LockReleaseGlobal)(void)
   LockRelease(globalLock);
 }
 
+void (LockClaimGlobalLeaf)(void)
+{
+  lockEnsureGlobalLock();
+  AVER(globalLockInit);
+  LockClaim(globalLeafLock);
+}
+
+/* The critical section is recursive, so if the calling thread owned
+   the lock already, it finds the claim count already set. */
+
+Bool (LockClaimGlobalLeafUnlessOwned)(void)
+{
+  lockEnsureGlobalLock();
+  AVER(globalLockInit);
+  AVERT(Lock, globalLeafLock);
+  EnterCriticalSection(&globalLeafLock->cs);
+  if (globalLeafLock->claims > 0) {
+    LeaveCriticalSection(&globalLeafLock->cs);
+    return FALSE;
+  }
+  globalLeafLock->claims = 1;
+  return TRUE;
+}
+
+void (LockReleaseGlobalLeaf)(void)
+{
+  AVER(globalLockInit);
+  LockRelease(globalLeafLock);
+}
+
 void LockSetup(void)
 {
   /* Nothing to do as MPS does not support fork() on Windows. */
@@ -145,6 +145,7 @@ static void GenDescInit(GenDesc gen, GenParamStruct *params)
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->activeTraces = TraceSetEMPTY;
+  gen->collections = 0;
   for (ti = 0; ti < TraceLIMIT; ++ti)
     RingInit(&gen->trace[ti].traceRing);
   gen->sig = GenDescSig;
@@ -198,6 +199,7 @@ void GenDescStartTrace(GenDesc gen, Trace trace)
 
   AVER(!TraceSetIsMember(gen->activeTraces, trace));
   gen->activeTraces = TraceSetAdd(gen->activeTraces, trace);
+  ++gen->collections;
   genTrace = &gen->trace[trace->ti];
   AVER(RingIsSingle(&genTrace->traceRing));
   RingAppend(&trace->genRing, &genTrace->traceRing);
@@ -304,6 +306,7 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
                "  capacity $U\n", (WriteFW)gen->capacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
                "  activeTraces $B\n", (WriteFB)gen->activeTraces,
+               "  collections $U\n", (WriteFU)gen->collections,
                NULL);
   if (res != ResOK)
     return res;
@@ -381,6 +384,9 @@ Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
   for (i = 0; i < genCount; ++i)
     GenDescInit(&gens[i], &params[i]);
   ChainInit(chain, arena, gens, genCount);
+  for (i = 0; i < genCount; ++i)
+    EVENT5(GenInit, chain, &gens[i], i, gens[i].capacity,
+           gens[i].mortality);
 
   *chainReturn = chain;
   return ResOK;
@@ -532,6 +538,7 @@ Res PoolGenInit(PoolGen pgen, GenDesc gen, Pool pool)
   AVERT(PoolGen, pgen);
 
   RingAppend(&gen->locusRing, &pgen->genRing);
+  EVENT2(PoolGenInit, pool, gen);
   return ResOK;
 }
 
@@ -824,6 +831,50 @@ void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
 }
 
 
+/* poolGenIterateGen -- visit the PoolGens of a pool in a generation */
+
+static void poolGenIterateGen(GenDesc gen, Pool pool, Chain chain,
+                              Index index, PoolGenVisitor visitor,
+                              void *closure)
+{
+  Ring node, nextNode;
+
+  RING_FOR(node, &gen->locusRing, nextNode) {
+    PoolGen pgen = RING_ELT(PoolGen, genRing, node);
+    if (pgen->pool == pool)
+      visitor(pgen, chain, index, closure);
+  }
+}
+
+
+/* PoolGenIterate -- visit the PoolGens of a pool
+ *
+ * Calls the visitor for each PoolGen belonging to the pool, passing
+ * the chain and the index of its generation in the chain, in chain
+ * order, or NULL and 0 for the arena's top generation, which is
+ * visited last.  The visitor must not create or destroy PoolGens.
+ */
+
+void PoolGenIterate(Pool pool, PoolGenVisitor visitor, void *closure)
+{
+  Arena arena;
+  Ring node, nextNode;
+
+  AVERT(Pool, pool);
+  AVER(FUNCHECK(visitor));
+  /* closure is arbitrary and can't be checked */
+
+  arena = PoolArena(pool);
+  RING_FOR(node, &arena->chainRing, nextNode) {
+    Chain chain = RING_ELT(Chain, chainRing, node);
+    Index i;
+    for (i = 0; i < chain->genCount; ++i)
+      poolGenIterateGen(&chain->gens[i], pool, chain, i, visitor, closure);
+  }
+  poolGenIterateGen(&arena->topGen, pool, NULL, 0, visitor, closure);
+}
+
+
 /* PoolGenDescribe -- describe a PoolGen */
 
 Res PoolGenDescribe(PoolGen pgen, mps_lib_FILE *stream, Count depth)
@@ -48,6 +48,7 @@ typedef struct GenDescStruct {
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
   RingStruct segRing; /* Ring of GCSegs in this generation */
   TraceSet activeTraces; /* set of traces collecting this generation */
+  Count collections;    /* number of traces that condemned this generation */
   GenTraceStruct trace[TraceLIMIT];
 } GenDescStruct;
 
@@ -124,6 +125,10 @@ extern void PoolGenAccountForSegSplit(PoolGen pgen);
 extern void PoolGenAccountForSegMerge(PoolGen pgen);
 extern Res PoolGenDescribe(PoolGen gen, mps_lib_FILE *stream, Count depth);
 
+typedef void (*PoolGenVisitor)(PoolGen pgen, Chain chain, Index index,
+                               void *closure);
+extern void PoolGenIterate(Pool pool, PoolGenVisitor visitor, void *closure);
+
 #endif /* locus_h */
 
 
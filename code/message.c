@@ -74,6 +74,10 @@ Bool MessageClassCheck(MessageClass klass)
   CHECKL(FUNCHECK(klass->gcCondemnedSize));
   CHECKL(FUNCHECK(klass->gcNotCondemnedSize));
   CHECKL(FUNCHECK(klass->gcStartWhy));
+  CHECKL(FUNCHECK(klass->gcPhaseTime));
+  CHECKL(FUNCHECK(klass->gcMaxPause));
+  CHECKL(FUNCHECK(klass->gcHistogramLength));
+  CHECKL(FUNCHECK(klass->gcHistogramEntry));
   CHECKL(klass->endSig == MessageClassSig);
 
   return TRUE;
@@ -368,6 +372,44 @@ const char *MessageGCStartWhy(Message message)
   return (*message->klass->gcStartWhy)(message);
 }
 
+Clock MessageGCPhaseTime(Message message, TracePhase phase)
+{
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+  AVER(phase < TracePhaseLIMIT);
+
+  return (*message->klass->gcPhaseTime)(message, phase);
+}
+
+Clock MessageGCMaxPause(Message message)
+{
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+
+  return (*message->klass->gcMaxPause)(message);
+}
+
+Count MessageGCHistogramLength(Message message)
+{
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+
+  return (*message->klass->gcHistogramLength)(message);
+}
+
+void MessageGCHistogramEntry(Addr *klassReturn, Count *countReturn,
+                             Size *sizeReturn, Message message, Index i)
+{
+  AVER(klassReturn != NULL);
+  AVER(countReturn != NULL);
+  AVER(sizeReturn != NULL);
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+
+  (*message->klass->gcHistogramEntry)(klassReturn, countReturn, sizeReturn,
+                                      message, i);
+}
+
 
 /* Message Method Stubs, Type-specific
  *
@@ -424,6 +466,50 @@ const char *MessageNoGCStartWhy(Message message)
   return NULL;
 }
 
+Clock MessageNoGCPhaseTime(Message message, TracePhase phase)
+{
+  AVERT(Message, message);
+  UNUSED(message);
+  UNUSED(phase);
+
+  NOTREACHED;
+
+  return (Clock)0;
+}
+
+Clock MessageNoGCMaxPause(Message message)
+{
+  AVERT(Message, message);
+  UNUSED(message);
+
+  NOTREACHED;
+
+  return (Clock)0;
+}
+
+Count MessageNoGCHistogramLength(Message message)
+{
+  AVERT(Message, message);
+  UNUSED(message);
+
+  NOTREACHED;
+
+  return (Count)0;
+}
+
+void MessageNoGCHistogramEntry(Addr *klassReturn, Count *countReturn,
+                               Size *sizeReturn, Message message, Index i)
+{
+  AVER(klassReturn != NULL);
+  AVER(countReturn != NULL);
+  AVER(sizeReturn != NULL);
+  AVERT(Message, message);
+  UNUSED(message);
+  UNUSED(i);
+
+  NOTREACHED;
+}
+
 
 /* C. COPYRIGHT AND LICENSE
  *
@@ -37,6 +37,10 @@ static MessageClassStruct DFMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGCPhaseTime,        /* GCPhaseTime */
+  MessageNoGCMaxPause,         /* GCMaxPause */
+  MessageNoGCHistogramLength,  /* GCHistogramLength */
+  MessageNoGCHistogramEntry,   /* GCHistogramEntry */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -53,6 +57,10 @@ static MessageClassStruct DGCMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNoteCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGCPhaseTime,        /* GCPhaseTime */
+  MessageNoGCMaxPause,         /* GCMaxPause */
+  MessageNoGCHistogramLength,  /* GCHistogramLength */
+  MessageNoGCHistogramEntry,   /* GCHistogramEntry */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -34,6 +34,46 @@ unsigned CheckLevel = CHECKLEVEL_DYNAMIC;
 #endif
 
 
+/* CheckSample* -- sampled consistency checking
+ *
+ * See CHECK_SAMPLE in check.h and <design/check/#sampled>.
+ * CheckSampleInterval is the number of calls between samples, or zero
+ * if no samples are to be taken.
+ */
+
+#if defined(AVER_AND_CHECK_SAMPLED)
+
+static size_t CheckSampleInterval = CHECK_SAMPLE_INTERVAL;
+size_t CheckSampleCountdown = CHECK_SAMPLE_INTERVAL;
+
+void CheckSampleBegin(void)
+{
+  if (CheckSampleInterval == 0) {
+    CheckSampleCountdown = (size_t)-1;
+  } else {
+    CheckSampleCountdown = CheckSampleInterval;
+    CheckLevel = CHECKLEVEL_SAMPLED;
+  }
+}
+
+/* CheckSampleEnd does not restore the level saved by CheckSampleBegin,
+ * because another thread may have raised it meanwhile, and restoring
+ * it might leave checking raised for good. */
+
+void CheckSampleEnd(void)
+{
+  CheckLevel = CheckLevelMINIMAL;
+}
+
+void CheckSampleSet(size_t interval)
+{
+  CheckSampleInterval = interval;
+  CheckSampleCountdown = interval == 0 ? (size_t)-1 : interval;
+}
+
+#endif /* AVER_AND_CHECK_SAMPLED */
+
+
 /* MPMCheck -- test MPM assumptions */
 
 Bool MPMCheck(void)
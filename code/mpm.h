@@ -23,6 +23,7 @@
 #include "check.h"
 
 #include "event.h"
+#include "probe.h"
 #include "lock.h"
 #include "prmc.h"
 #include "prot.h"
@@ -236,6 +237,8 @@ extern Res PoolTraceBegin(Pool pool, Trace trace);
 extern void PoolFreeWalk(Pool pool, FreeBlockVisitor f, void *p);
 extern Size PoolTotalSize(Pool pool);
 extern Size PoolFreeSize(Pool pool);
+extern void PoolFreeStats(FreeStats stats, Pool pool, Size size);
+extern void PoolFreeLog(Pool pool, Size size);
 
 extern Res PoolAbsInit(Pool pool, Arena arena, PoolClass klass, ArgList arg);
 extern void PoolAbsFinish(Inst inst);
@@ -271,7 +274,12 @@ extern Size PoolNoSize(Pool pool);
 /* See .critical.macros. */
 #define PoolFreeMacro(pool, old, size) Method(Pool, pool, free)(pool, old, size)
 #if !defined(AVER_AND_CHECK_ALL)
-#define PoolFree(pool, old, size) PoolFreeMacro(pool, old, size)
+#define PoolFree(pool, old, size) \
+  BEGIN \
+    PoolFreeMacro(pool, old, size); \
+    if (EVENT_KIND_ENABLED(Object)) \
+      EVENT3(PoolFree, pool, old, size); \
+  END
 #endif /* !defined(AVER_AND_CHECK_ALL) */
 
 /* Abstract Pool Classes Interface -- see <code/poolabs.c> */
@@ -317,6 +325,12 @@ extern Size MessageGCLiveSize(Message message);
 extern Size MessageGCCondemnedSize(Message message);
 extern Size MessageGCNotCondemnedSize(Message message);
 extern const char *MessageGCStartWhy(Message message);
+extern Clock MessageGCPhaseTime(Message message, TracePhase phase);
+extern Clock MessageGCMaxPause(Message message);
+extern Count MessageGCHistogramLength(Message message);
+extern void MessageGCHistogramEntry(Addr *klassReturn, Count *countReturn,
+                                    Size *sizeReturn, Message message,
+                                    Index i);
 /* -- Message Method Stubs, Type-specific */
 extern void MessageNoFinalizationRef(Ref *refReturn,
                                      Arena arena, Message message);
@@ -324,6 +338,12 @@ extern Size MessageNoGCLiveSize(Message message);
 extern Size MessageNoGCCondemnedSize(Message message);
 extern Size MessageNoGCNotCondemnedSize(Message message);
 extern const char *MessageNoGCStartWhy(Message message);
+extern Clock MessageNoGCPhaseTime(Message message, TracePhase phase);
+extern Clock MessageNoGCMaxPause(Message message);
+extern Count MessageNoGCHistogramLength(Message message);
+extern void MessageNoGCHistogramEntry(Addr *klassReturn, Count *countReturn,
+                                      Size *sizeReturn, Message message,
+                                      Index i);
 
 
 /* Trace Interface -- see <code/trace.c> */
@@ -369,6 +389,7 @@ extern Bool TraceCheck(Trace trace);
 extern Res TraceCreate(Trace *traceReturn, Arena arena, int why);
 extern void TraceDestroyInit(Trace trace);
 extern void TraceDestroyFinished(Trace trace);
+extern void TraceStatsInit(TraceStats stats);
 
 extern Bool TraceIsEmpty(Trace trace);
 extern Res TraceAddWhite(Trace trace, Seg seg);
@@ -382,6 +403,8 @@ extern Rank TraceRankForAccess(Arena arena, Seg seg);
 extern void TraceSegAccess(Arena arena, Seg seg, AccessSet mode);
 
 extern void TraceAdvance(Trace trace);
+extern void TraceSetPhaseHook(Arena arena, TracePhaseHook hook,
+                              void *closure);
 extern Res TraceStartCollectAll(Trace *traceReturn, Arena arena, int why);
 extern Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth);
 
@@ -395,6 +418,11 @@ extern void TracePostMessage(Trace trace);  /* trace end */
 extern Bool TraceIdMessagesCheck(Arena arena, TraceId ti);
 extern Res TraceIdMessagesCreate(Arena arena, TraceId ti);
 extern void TraceIdMessagesDestroy(Arena arena, TraceId ti);
+extern void TraceSetHistogramLength(Arena arena, Count length);
+extern void TraceHistogramCreate(Trace trace);
+extern void TraceHistogramDestroy(Trace trace);
+extern void TraceHistogramAdd(Trace trace, Format format, Addr ref,
+                              Size size);
 
 /* Equivalent to <code/mps.h> MPS_SCAN_BEGIN */
 
@@ -487,6 +515,7 @@ extern void GlobalsReinitializeAll(void);
 #define ArenaEpoch(arena)       (ArenaHistory(arena)->epoch) /* .epoch.ts */
 #define ArenaTrace(arena, ti)   (&(arena)->trace[ti])
 #define ArenaZoneShift(arena)   ((arena)->zoneShift)
+#define ArenaTraceStats(arena)  (&(arena)->traceStats)
 #define ArenaStripeSize(arena)  ((Size)1 << ArenaZoneShift(arena))
 #define ArenaGrainSize(arena)   ((arena)->grainSize)
 #define ArenaGreyRing(arena, rank) (&(arena)->greyRing[rank])
@@ -657,6 +686,7 @@ extern void SegBlacken(Seg seg, TraceSet traceSet);
 extern Res SegScan(Bool *totalReturn, Seg seg, ScanState ss);
 extern Res SegFix(Seg seg, ScanState ss, Addr *refIO);
 extern Res SegFixEmergency(Seg seg, ScanState ss, Addr *refIO);
+extern Res SegEphemerons(Seg seg, ScanState ss);
 extern void SegReclaim(Seg seg, Trace trace);
 extern void SegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
                     void *v, size_t s);
@@ -696,6 +726,7 @@ extern Addr (SegLimit)(Seg seg);
 #define SegGrey(seg)            RVALUE((TraceSet)(seg)->grey)
 #define SegWhite(seg)           RVALUE((TraceSet)(seg)->white)
 #define SegNailed(seg)          RVALUE((TraceSet)(seg)->nailed)
+#define SegMovedIn(seg)         RVALUE((seg)->movedIn)
 #define SegPoolRing(seg)        (&(seg)->poolRing)
 #define SegOfPoolRing(node)     RING_ELT(Seg, poolRing, (node))
 #define SegOfGreyRing(node)     (&(RING_ELT(GCSeg, greyRing, (node)) \
@@ -707,6 +738,7 @@ extern Addr (SegLimit)(Seg seg);
 #define SegSetSM(seg, mode)     ((void)((seg)->sm = BS_BITFIELD(Access, (mode))))
 #define SegSetDepth(seg, d)     ((void)((seg)->depth = BITFIELD(unsigned, (d), ShieldDepthWIDTH)))
 #define SegSetNailed(seg, ts)   ((void)((seg)->nailed = BS_BITFIELD(Trace, (ts))))
+#define SegSetMovedIn(seg, e)   ((void)((seg)->movedIn = (e)))
 
 
 /* Buffer Interface -- see <code/buffer.c> */
@@ -808,6 +840,26 @@ extern Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth);
 extern Res FormatScan(Format format, ScanState ss, Addr base, Addr limit);
 
 
+/* Allocation Profiler -- see <code/profile.c> */
+
+extern Bool ProfileCheck(Profile profile);
+extern Res ProfileStart(Arena arena, Size interval, Count length,
+                        ProfileStackMethod stack, void *closure);
+extern void ProfileStop(Arena arena);
+extern Size ProfileInterval(Profile profile);
+extern Bool ProfileReserve(Index *indexReturn, Profile profile,
+                           Buffer buffer, Size size);
+extern void ProfileCommit(Profile profile, Index index, Buffer buffer,
+                          Addr ref, Addr klass);
+extern void ProfileCancel(Profile profile, Index index, Buffer buffer);
+extern Res ProfileScan(ScanState ss, Profile profile);
+extern void ProfileWalk(Profile profile, mps_profile_visitor_t visitor,
+                        void *closure);
+extern Res ProfileWrite(Profile profile, mps_lib_FILE *stream);
+
+#define ArenaProfile(arena) ((arena)->profile)
+
+
 /* Reference Interface -- see <code/ref.c> */
 
 extern Bool RankCheck(Rank rank);
@@ -15,6 +15,7 @@
 #include "mpslib.h"
 #include "testlib.h"
 
+#include <limits.h> /* CHAR_BIT */
 #include <stdio.h> /* printf */
 
 
@@ -34,6 +35,37 @@ static void check_allocated_size(mps_pool_t pool, size_t allocated)
 }
 
 
+/* check_free_stats -- check the summary of the pool's free blocks
+ *
+ * If exact is true, the pool's free blocks must account for all of
+ * its free memory.
+ */
+
+static void check_free_stats(mps_pool_t pool, mps_bool_t exact)
+{
+  mps_pool_free_stats_s stats;
+  size_t i, blocks = 0, size = 0;
+
+  mps_pool_free_stats(pool, &stats);
+  Insist(stats.total_size == mps_pool_total_size(pool));
+  Insist(stats.free_size == mps_pool_free_size(pool));
+  Insist(stats.free_block_size <= stats.free_size);
+  Insist(!exact || stats.free_block_size == stats.free_size);
+  Insist(stats.largest <= stats.free_block_size);
+  for (i = 0; i < MPS_FREE_BUCKETS; ++i) {
+    if (stats.count[i] > 0) {
+      Insist(stats.size[i] >= stats.count[i] << i);
+      Insist(i + 1 >= sizeof(size_t) * CHAR_BIT
+             || stats.size[i] < stats.count[i] << (i + 1));
+    }
+    blocks += stats.count[i];
+    size += stats.size[i];
+  }
+  Insist(blocks == stats.free_blocks);
+  Insist(size == stats.free_block_size);
+}
+
+
 /* stress -- create a pool of the requested type and allocate in it */
 
 static mps_res_t stress(mps_arena_t arena, mps_pool_debug_option_s *options,
@@ -70,6 +102,7 @@ static mps_res_t stress(mps_arena_t arena, mps_pool_debug_option_s *options,
   }
 
   mps_pool_check_fenceposts(pool);
+  mps_pool_check_free_space(pool);
 
   for (k=0; k<testLOOPS; ++k) {
     /* shuffle all the objects */
@@ -103,6 +136,7 @@ static mps_res_t stress(mps_arena_t arena, mps_pool_debug_option_s *options,
       allocated += alignUp(ss[i], align) + debugOverhead;
     }
     check_allocated_size(pool, allocated);
+    check_free_stats(pool, pool_class != mps_class_mfs());
   }
    
   die(PoolDescribe(pool, mps_lib_get_stdout(), 0), "PoolDescribe");
@@ -227,6 +261,10 @@ int main(int argc, char *argv[])
   
   testlib_init(argc, argv);
 
+  /* Has no effect unless the MPS was built with CONFIG_ASSERT_SAMPLED,
+     in which case every tenth check is thorough. */
+  mps_check_sample_set(10);
+
   arena_grain_size = rnd_grain(testArenaSIZE);
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
@@ -23,6 +23,7 @@
 
 #include "config.h"
 #include "mpmtypes.h"
+#include "clock.h"
 
 #include "protocol.h"
 #include "ring.h"
@@ -154,6 +155,12 @@ typedef struct MessageClassStruct {
   /* methods specific to MessageTypeGCSTART */
   MessageGCStartWhyMethod gcStartWhy;
 
+  /* more methods specific to MessageTypeGC */
+  MessageGCPhaseTimeMethod gcPhaseTime;
+  MessageGCMaxPauseMethod gcMaxPause;
+  MessageGCHistogramLengthMethod gcHistogramLength;
+  MessageGCHistogramEntryMethod gcHistogramEntry;
+
   Sig endSig;                   /* <design/message/#class.sig.double> */
 } MessageClassStruct;
 
@@ -206,6 +213,7 @@ typedef struct SegClassStruct {
   SegScanMethod scan;           /* find references during tracing */
   SegFixMethod fix;             /* referent reachable during tracing */
   SegFixMethod fixEmergency;    /* as fix, no failure allowed */
+  SegEphemeronsMethod ephemerons; /* preserve values of reachable keys */
   SegReclaimMethod reclaim;     /* reclaim dead objects after tracing */
   SegWalkMethod walk;           /* walk over a segment */
   Sig sig;                      /* .class.end-sig */
@@ -225,6 +233,7 @@ typedef struct SegStruct {      /* segment structure */
   Tract firstTract;             /* first tract of segment */
   RingStruct poolRing;          /* link in list of segs in pool */
   Addr limit;                   /* limit of segment */
+  Epoch movedIn;                /* last epoch objects moved in, <code/ld.c#stale.seg> */
   unsigned depth : ShieldDepthWIDTH; /* see design.mps.shield.def.depth */
   BOOLFIELD(queued);            /* in shield queue? */
   AccessSet pm : AccessLIMIT;   /* protection mode, <code/shield.c> */
@@ -325,6 +334,9 @@ typedef struct BufferStruct {
   Addr poolLimit;               /* the pool's idea of the limit */
   Align alignment;              /* allocation alignment */
   unsigned rampCount;           /* see <code/buffer.c#ramp.hack> */
+  Addr sampleBase;              /* <design/profile/#buffer> */
+  Size sampleRemaining;         /* bytes from sampleBase to next sample */
+  Index sampleIndex;            /* sample of reserved object, if SAMPLED */
 } BufferStruct;
 
 
@@ -382,6 +394,10 @@ typedef struct mps_fmt_s {
  * is not used in the public MPS, but is needed by the transforms
  * extension.
  *
+ * .ss.fix-slot: The fixSlot member is the address of the reference
+ * that _mps_fix2 is fixing, for fix methods that need to know where
+ * the reference lives. See <design/trace/#fix.slot>.
+ *
  * .ss.zone: For binary compatibility, the zone shift is exported as
  * a word rather than a shift, so that the external mps_ss_s is a uniform
  * three-word structure.  See <code/mps.h#ss> and <design/interface-c>.
@@ -404,22 +420,55 @@ typedef struct ScanStateStruct {
   Arena arena;                  /* owning arena */
   SegFixMethod fix;             /* third stage fix function */
   void *fixClosure;             /* see .ss.fix-closure */
+  Addr fixSlot;                 /* see .ss.fix-slot */
   TraceSet traces;              /* traces to scan for */
   Rank rank;                    /* reference rank of scanning */
   Bool wasMarked;               /* design.mps.fix.protocol.was-ready */
   RefSet fixedSummary;          /* accumulated summary of fixed references */
-  STATISTIC_DECL(Count fixRefCount) /* refs which pass zone check */
-  STATISTIC_DECL(Count segRefCount) /* refs which refer to segs */
-  STATISTIC_DECL(Count whiteSegRefCount) /* refs which refer to white segs */
-  STATISTIC_DECL(Count nailCount) /* segments nailed by ambig refs */
-  STATISTIC_DECL(Count snapCount) /* refs snapped to forwarded objs */
-  STATISTIC_DECL(Count forwardedCount) /* objects preserved by moving */
-  STATISTIC_DECL(Count preservedInPlaceCount) /* objects preserved in place */
+  Count fixRefCount;            /* refs which pass zone check */
+  Count segRefCount;            /* refs which refer to segs */
+  Count whiteSegRefCount;       /* refs which refer to white segs */
+  Count nailCount;              /* segments nailed by ambig refs */
+  Count snapCount;              /* refs snapped to forwarded objs */
+  Count forwardedCount;         /* objects preserved by moving */
+  Count preservedInPlaceCount;  /* objects preserved in place */
   STATISTIC_DECL(Size copiedSize) /* bytes copied */
   Size scannedSize;             /* bytes scanned */
 } ScanStateStruct;
 
 
+/* TraceStatsStruct -- cumulative tracer statistics
+ *
+ * .trace-stats: The counters of each trace are added to the arena's
+ * totals when the trace finishes.  These counters are kept in all
+ * varieties; see <design/trace/#stats>.  Keep in sync with
+ * <code/mps.h#arena-stats>.
+ */
+
+typedef struct TraceStatsStruct {
+  Count traces;                 /* traces finished */
+  Size condemnedSize;           /* bytes condemned */
+  Count rootScanCount;          /* number of roots scanned */
+  Size rootScanSize;            /* total size of scanned roots */
+  Count segScanCount;           /* number of segs scanned */
+  Size segScanSize;             /* total size of scanned segments */
+  Count pointlessScanCount;     /* pointless seg scans */
+  Count fixRefCount;            /* refs which pass zone check */
+  Count segRefCount;            /* refs which refer to segs */
+  Count whiteSegRefCount;       /* refs which refer to white segs */
+  Count nailCount;              /* segments nailed by ambig refs */
+  Count snapCount;              /* refs snapped to forwarded objs */
+  Count forwardedCount;         /* objects preserved by moving */
+  Size forwardedSize;           /* bytes preserved by moving */
+  Count preservedInPlaceCount;  /* objects preserved in place */
+  Size preservedInPlaceSize;    /* bytes preserved in place */
+  Count reclaimCount;           /* segments reclaimed */
+  Size reclaimSize;             /* bytes reclaimed */
+  Count readBarrierHitCount;    /* read barrier faults */
+  Count writeBarrierHitCount;   /* write barrier hits */
+} TraceStatsStruct;
+
+
 /* TraceStruct -- tracer state structure */
 
 #define TraceSig ((Sig)0x51924ACE) /* SIGnature TRACE */
@@ -434,6 +483,8 @@ typedef struct TraceStruct {
   TraceState state;             /* current state of trace */
   Rank band;                    /* current band */
   Bool firstStretch;            /* in first stretch of band (see accessor) */
+  Bool ephemeronsTraced;        /* ephemeron pass has run? */
+  Count ephemeronRefCount;      /* whiteSegRefCount after the last pass */
   SegFixMethod fix;             /* fix method to apply to references */
   void *fixClosure;             /* see .ss.fix-closure */
   RingStruct genRing;           /* ring of generations condemned for trace */
@@ -444,28 +495,32 @@ typedef struct TraceStruct {
   Work quantumWork;             /* tracing work to be done in each poll */
   STATISTIC_DECL(Count greySegCount) /* number of grey segs */
   STATISTIC_DECL(Count greySegMax) /* max number of grey segs */
-  STATISTIC_DECL(Count rootScanCount) /* number of roots scanned */
+  Count rootScanCount;          /* number of roots scanned */
   Count rootScanSize;           /* total size of scanned roots */
   STATISTIC_DECL(Size rootCopiedSize) /* bytes copied by scanning roots */
-  STATISTIC_DECL(Count segScanCount) /* number of segs scanned */
+  Count segScanCount;           /* number of segs scanned */
   Count segScanSize;            /* total size of scanned segments */
   STATISTIC_DECL(Size segCopiedSize) /* bytes copied by scanning segments */
   STATISTIC_DECL(Count singleScanCount) /* number of single refs scanned */
   STATISTIC_DECL(Count singleScanSize) /* total size of single refs scanned */
   STATISTIC_DECL(Size singleCopiedSize) /* bytes copied by scanning single refs */
-  STATISTIC_DECL(Count fixRefCount) /* refs which pass zone check */
-  STATISTIC_DECL(Count segRefCount) /* refs which refer to segs */
-  STATISTIC_DECL(Count whiteSegRefCount) /* refs which refer to white segs */
-  STATISTIC_DECL(Count nailCount) /* segments nailed by ambig refs */
-  STATISTIC_DECL(Count snapCount) /* refs snapped to forwarded objs */
-  STATISTIC_DECL(Count readBarrierHitCount) /* read barrier faults */
-  STATISTIC_DECL(Count pointlessScanCount) /* pointless seg scans */
-  STATISTIC_DECL(Count forwardedCount) /* objects preserved by moving */
+  Count fixRefCount;            /* refs which pass zone check */
+  Count segRefCount;            /* refs which refer to segs */
+  Count whiteSegRefCount;       /* refs which refer to white segs */
+  Count nailCount;              /* segments nailed by ambig refs */
+  Count snapCount;              /* refs snapped to forwarded objs */
+  Count readBarrierHitCount;    /* read barrier faults */
+  Count pointlessScanCount;     /* pointless seg scans */
+  Count forwardedCount;         /* objects preserved by moving */
   Size forwardedSize;           /* bytes preserved by moving */
-  STATISTIC_DECL(Count preservedInPlaceCount) /* objects preserved in place */
+  Count preservedInPlaceCount;  /* objects preserved in place */
   Size preservedInPlaceSize;    /* bytes preserved in place */
-  STATISTIC_DECL(Count reclaimCount) /* segments reclaimed */
-  STATISTIC_DECL(Count reclaimSize) /* bytes reclaimed */
+  Count reclaimCount;           /* segments reclaimed */
+  Size reclaimSize;             /* bytes reclaimed */
+  Clock condemnClock;           /* when condemnation began */
+  Clock phaseTime[TracePhaseLIMIT]; /* time spent in each phase */
+  Clock maxPause;               /* longest pause <design/trace/#phase.pause> */
+  Histogram histogram;          /* NULL or <design/message-gc/#histogram> */
 } TraceStruct;
 
 
@@ -508,6 +563,10 @@ typedef struct GlobalsStruct {
   /* general fields (<code/global.c>) */
   RingStruct globalRing;        /* node in global ring of arenas */
   Lock lock;                    /* arena's lock */
+  Count lockClaims;             /* <design/arena/#lock.stats> */
+  EventClock lockWaitTime;      /* time waiting to claim the lock */
+  EventClock lockHoldTime;      /* time holding the lock */
+  EventClock lockClaimed;       /* when the lock was last claimed */
 
   /* polling fields (<code/global.c>) */
   double pollThreshold;         /* <design/arena/#poll> */
@@ -699,6 +758,42 @@ typedef struct HistoryStruct {
 } HistoryStruct;  
 
 
+/* ProfileStruct -- sampling allocation profiler
+ *
+ * See <design/profile/>, <code/profile.c>.
+ *
+ * The references to the sampled objects are kept in a separate array
+ * from the sample descriptions so that they can be fixed as an area.
+ */
+
+#define ProfileSig      ((Sig)0x5199F0F1) /* SIGnature PROFIle */
+
+typedef struct ProfileSampleStruct {
+  unsigned state;               /* ProfileSample{FREE,PENDING,COMMITTED} */
+  Buffer buffer;                /* buffer with reservation, if PENDING */
+  Size size;                    /* size of sampled object */
+  Addr klass;                   /* class of object, if COMMITTED */
+  Count traces;                 /* traces finished when committed */
+  Count depth;                  /* number of frames in stack */
+  Word stack[ProfileDEPTH];     /* stack when object was reserved */
+} ProfileSampleStruct;
+
+typedef struct ProfileStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  Size interval;                /* mean bytes allocated between samples */
+  Count length;                 /* number of samples in table */
+  Index next;                   /* where to look for a free sample */
+  ProfileStackMethod stack;     /* client function to get stack, or NULL */
+  void *stackClosure;           /* closure argument to stack */
+  Ref *refs;                    /* sampled objects <design/profile/#weak> */
+  ProfileSample samples;        /* sample descriptions */
+  Count sampled;                /* objects sampled */
+  Count dropped;                /* samples dropped for lack of space */
+  SortStruct sortStruct;        /* workspace for ProfileWrite */
+} ProfileStruct;
+
+
 /* MVFFStruct -- MVFF (Manual Variable First Fit) pool outer structure
  *
  * The signature is placed at the end, see
@@ -795,8 +890,15 @@ typedef struct mps_arena_s {
   /* trace fields (<code/trace.c>) */
   TraceSet busyTraces;          /* set of running traces */
   TraceSet flippedTraces;       /* set of running and flipped traces */
+  Count flips;                  /* flips so far, <design/poolawl/#load.fast> */
   TraceStruct trace[TraceLIMIT]; /* trace structures.  See
                                    <design/trace/#intance.limit> */
+  TraceStatsStruct traceStats;  /* totals of finished traces */
+  Clock pauseStart;             /* start of current pause <design/trace/#phase.pause> */
+  TracePhaseHook phaseHook;     /* NULL or <design/trace/#phase.hook> */
+  void *phaseHookClosure;       /* closure argument to phaseHook */
+  Profile profile;              /* NULL or <design/profile/> */
+  Count histogramLength;        /* 0 or <design/message-gc/#histogram> */
 
   /* trace ancillary fields (<code/traceanc.c>) */
   TraceStartMessage tsMessage[TraceLIMIT];  /* <design/message-gc/> */
@@ -808,7 +910,6 @@ typedef struct mps_arena_s {
   Clock lastWorldCollect;
 
   RingStruct greyRing[RankLIMIT]; /* ring of grey segments at each rank */
-  STATISTIC_DECL(Count writeBarrierHitCount) /* write barrier hits */
   RingStruct chainRing;         /* ring of chains */
 
   struct HistoryStruct historyStruct;
@@ -50,6 +50,8 @@ typedef mps_arg_s ArgStruct;
 typedef mps_arg_s *Arg;
 typedef mps_arg_s *ArgList;
 typedef mps_key_t Key;
+typedef mps_pool_free_stats_s FreeStatsStruct;
+typedef mps_pool_free_stats_s *FreeStats;
 
 typedef Word RefSet;                    /* design.mps.refset */
 typedef Word ZoneSet;                   /* design.mps.refset */
@@ -60,6 +62,7 @@ typedef Size Epoch;                     /* design.mps.ld */
 typedef unsigned TraceId;               /* <design/trace/> */
 typedef unsigned TraceSet;              /* <design/trace/> */
 typedef unsigned TraceState;            /* <design/trace/> */
+typedef unsigned TracePhase;            /* <design/trace/#phase> */
 typedef unsigned AccessSet;             /* <design/type/#access-set> */
 typedef unsigned Attr;                  /* <design/type/#attr> */
 typedef unsigned RootVar;               /* <design/type/#rootvar> */
@@ -77,6 +80,7 @@ typedef Pool AbstractPool;
 typedef struct mps_pool_class_s *PoolClass;  /* <code/poolclas.c> */
 typedef struct TraceStruct *Trace;      /* <design/trace/> */
 typedef struct ScanStateStruct *ScanState; /* <design/trace/> */
+typedef struct TraceStatsStruct *TraceStats; /* <design/trace/#stats> */
 typedef struct mps_chain_s *Chain;      /* <design/trace/> */
 typedef struct TractStruct *Tract;      /* <design/arena/> */
 typedef struct ChunkStruct *Chunk;      /* <code/tract.c> */
@@ -107,6 +111,8 @@ typedef unsigned FindDelete;            /* <design/land/> */
 typedef struct ShieldStruct *Shield; /* design.mps.shield */
 typedef struct HistoryStruct *History;  /* design.mps.arena.ld */
 typedef struct PoolGenStruct *PoolGen;  /* <design/strategy/> */
+typedef struct ProfileStruct *Profile;  /* <design/profile/> */
+typedef struct ProfileSampleStruct *ProfileSample; /* <design/profile/> */
 
 
 /* Arena*Method -- see <code/mpmst.h#ArenaClassStruct> */
@@ -139,6 +145,16 @@ typedef void (*ArenaVMContractedCallback)(Arena arena, Addr base, Size size);
 typedef Res (*TraceFixMethod)(ScanState ss, Ref *refIO);
 
 
+/* TracePhaseHook -- see <design/trace/#phase.hook> */
+
+typedef void (*TracePhaseHook)(Arena arena, TracePhase phase, void *closure);
+
+
+/* ProfileStackMethod -- see <design/profile/#stack> */
+
+typedef Count (*ProfileStackMethod)(Word *stack, Count depth, void *closure);
+
+
 /* Heap Walker */
 
 /* This type is used by the PoolClass method Walk */
@@ -177,6 +193,7 @@ typedef void (*SegGreyenMethod)(Seg seg, Trace trace);
 typedef void (*SegBlackenMethod)(Seg seg, TraceSet traceSet);
 typedef Res (*SegScanMethod)(Bool *totalReturn, Seg seg, ScanState ss);
 typedef Res (*SegFixMethod)(Seg seg, ScanState ss, Ref *refIO);
+typedef Res (*SegEphemeronsMethod)(Seg seg, ScanState ss);
 typedef void (*SegReclaimMethod)(Seg seg, Trace trace);
 typedef void (*SegWalkMethod)(Seg seg, Format format, FormattedObjectsVisitor f,
                               void *v, size_t s);
@@ -237,11 +254,19 @@ typedef Size (*MessageGCLiveSizeMethod)(Message message);
 typedef Size (*MessageGCCondemnedSizeMethod)(Message message);
 typedef Size (*MessageGCNotCondemnedSizeMethod)(Message message);
 typedef const char * (*MessageGCStartWhyMethod)(Message message);
+typedef Clock (*MessageGCPhaseTimeMethod)(Message message, TracePhase phase);
+typedef Clock (*MessageGCMaxPauseMethod)(Message message);
+typedef Count (*MessageGCHistogramLengthMethod)(Message message);
+typedef void (*MessageGCHistogramEntryMethod)(Addr *klassReturn,
+                                              Count *countReturn,
+                                              Size *sizeReturn,
+                                              Message message, Index i);
 
 /* Message Types -- <design/message/> and elsewhere */
 
 typedef struct TraceStartMessageStruct *TraceStartMessage;
 typedef struct TraceMessageStruct *TraceMessage;  /* trace end */
+typedef struct HistogramStruct *Histogram; /* <design/message-gc/#histogram> */
 
 
 /* Land*Method -- see <design/land/> */
@@ -297,6 +322,7 @@ enum {
 #define BufferModeFLIPPED       ((BufferMode)(1<<1))
 #define BufferModeLOGGED        ((BufferMode)(1<<2))
 #define BufferModeTRANSITION    ((BufferMode)(1<<3))
+#define BufferModeSAMPLED       ((BufferMode)(1<<4))
 
 
 /* Rank constants -- see <design/type/#rank> */
@@ -355,6 +381,22 @@ enum {
 };
 
 
+/* TracePhases -- see <design/trace/#phase> */
+/* These definitions must match <code/mps.h#gc.phase>. */
+/* This is checked by <code/mpsi.c#check>. */
+
+enum {
+  TracePhaseCONDEMN,
+  TracePhaseFLIP,
+  TracePhaseSCAN,
+  TracePhaseRECLAIM,
+  TracePhaseLIMIT
+};
+
+/* Passed to the phase hook when a trace finishes; it has no time. */
+#define TracePhaseEND   TracePhaseLIMIT
+
+
 /* TraceStart reasons: the trigger that caused a trace to start. */
 /* Make these specific trigger names, not broad categories; */
 /* and if a new trigger is added, add a new reason. */
@@ -54,8 +54,10 @@
 #include "ring.c"
 #include "shield.c"
 #include "ld.c"
+#include "profile.c"
 #include "event.c"
 #include "sac.c"
+#include "addrtab.c"
 #include "message.c"
 #include "poolmrg.c"
 #include "poolmfs.c"
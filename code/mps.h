@@ -56,6 +56,7 @@ typedef mps_pool_class_t mps_class_t;      /* deprecated alias */
 typedef struct mps_thr_s    *mps_thr_t;    /* thread registration */
 typedef struct mps_ap_s     *mps_ap_t;     /* allocation point */
 typedef struct mps_ld_s     *mps_ld_t;     /* location dependency */
+typedef struct mps_addrtab_s *mps_addrtab_t; /* address table */
 typedef struct mps_ss_s     *mps_ss_t;     /* scan state */
 typedef struct mps_message_s
   *mps_message_t;                          /* message */
@@ -461,6 +462,36 @@ extern size_t mps_arena_spare_commit_limit(mps_arena_t);
 extern double mps_arena_pause_time(mps_arena_t);
 extern void mps_arena_pause_time_set(mps_arena_t, double);
 
+/* .arena-stats: Keep in sync with <code/mpmst.h#trace-stats>, and see
+ * <design/arena/#lock.stats>. */
+typedef struct mps_arena_stats_s {
+  size_t traces;                /* traces finished */
+  size_t condemned_size;        /* bytes condemned */
+  size_t root_scans;            /* roots scanned */
+  size_t root_scan_size;        /* bytes of roots scanned */
+  size_t seg_scans;             /* segments scanned */
+  size_t seg_scan_size;         /* bytes of segments scanned */
+  size_t pointless_scans;       /* segments scanned without fixing a ref */
+  size_t fix_refs;              /* refs which passed the zone check */
+  size_t seg_refs;              /* ... and which referred to segments */
+  size_t white_seg_refs;        /* ... and which referred to white segments */
+  size_t nails;                 /* segments nailed by ambiguous refs */
+  size_t snaps;                 /* refs snapped to forwarded objects */
+  size_t forwarded;             /* objects preserved by moving */
+  size_t forwarded_size;        /* bytes preserved by moving */
+  size_t preserved_in_place;    /* objects preserved in place */
+  size_t preserved_in_place_size; /* bytes preserved in place */
+  size_t reclaimed_segs;        /* segments reclaimed */
+  size_t reclaimed_size;        /* bytes reclaimed */
+  size_t read_barrier_hits;     /* read barrier faults */
+  size_t write_barrier_hits;    /* write barrier faults */
+  size_t lock_claims;           /* claims of the arena lock */
+  double lock_wait_ticks;       /* event clock ticks waiting for lock */
+  double lock_hold_ticks;       /* event clock ticks holding lock */
+} mps_arena_stats_s;
+
+extern void mps_arena_stats(mps_arena_t, mps_arena_stats_s *);
+
 extern mps_bool_t mps_arena_busy(mps_arena_t);
 extern mps_bool_t mps_arena_has_addr(mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_pool(mps_pool_t *, mps_arena_t, mps_addr_t);
@@ -500,6 +531,20 @@ extern void mps_pool_destroy(mps_pool_t);
 extern size_t mps_pool_total_size(mps_pool_t);
 extern size_t mps_pool_free_size(mps_pool_t);
 
+#define MPS_FREE_BUCKETS 64
+
+typedef struct mps_pool_free_stats_s {
+  size_t total_size;            /* total memory allocated from arena */
+  size_t free_size;             /* free memory, as mps_pool_free_size */
+  size_t free_blocks;           /* number of free blocks found */
+  size_t free_block_size;       /* total size of free blocks found */
+  size_t largest;               /* size of largest free block */
+  size_t count[MPS_FREE_BUCKETS]; /* free blocks of size [2^i, 2^(i+1)) */
+  size_t size[MPS_FREE_BUCKETS]; /* total size of those blocks */
+} mps_pool_free_stats_s;
+
+extern void mps_pool_free_stats(mps_pool_t, mps_pool_free_stats_s *);
+
 
 /* Chains */
 
@@ -513,6 +558,24 @@ extern mps_res_t mps_chain_create(mps_chain_t *, mps_arena_t,
                                   size_t, mps_gen_param_s *);
 extern void mps_chain_destroy(mps_chain_t);
 
+typedef struct mps_gen_stats_s {
+  mps_chain_t chain;            /* chain, or NULL for the top generation */
+  size_t gen;                   /* index of generation in chain */
+  size_t capacity;              /* capacity of generation in bytes */
+  double mortality;             /* predicted mortality of generation */
+  size_t collections;           /* times generation was condemned */
+  size_t segs;                  /* segments */
+  size_t total_size;            /* bytes in segments */
+  size_t free_size;             /* bytes free or lost to fragmentation */
+  size_t buffered_size;         /* bytes in buffers */
+  size_t new_size;              /* bytes allocated since last condemned */
+  size_t old_size;              /* bytes allocated before last condemned */
+  size_t new_deferred_size;     /* new bytes, accounting deferred */
+  size_t old_deferred_size;     /* old bytes, accounting deferred */
+} mps_gen_stats_s;
+
+extern size_t mps_pool_gen_stats(mps_pool_t, mps_gen_stats_s *, size_t);
+
 
 /* Manual Allocation */
 
@@ -725,6 +788,19 @@ extern void mps_ld_add(mps_ld_t, mps_arena_t, mps_addr_t);
 extern void mps_ld_merge(mps_ld_t, mps_arena_t, mps_ld_t);
 extern mps_bool_t mps_ld_isstale(mps_ld_t, mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_ld_isstale_any(mps_ld_t, mps_arena_t);
+extern mps_bool_t mps_ld_isstale_precise(mps_ld_t, mps_arena_t,
+                                         mps_addr_t);
+
+
+/* Address Tables */
+
+extern mps_res_t mps_addrtab_create(mps_addrtab_t *, mps_arena_t);
+extern void mps_addrtab_destroy(mps_addrtab_t);
+extern mps_bool_t mps_addrtab_lookup(mps_addr_t *, mps_addrtab_t,
+                                     mps_addr_t);
+extern mps_res_t mps_addrtab_define(mps_addrtab_t, mps_addr_t, mps_addr_t);
+extern mps_bool_t mps_addrtab_remove(mps_addrtab_t, mps_addr_t);
+extern size_t mps_addrtab_count(mps_addrtab_t);
 
 extern mps_word_t mps_collections(mps_arena_t);
 
@@ -748,12 +824,33 @@ extern mps_clock_t mps_message_clock(mps_arena_t, mps_message_t);
 /* -- mps_message_type_finalization */
 extern void mps_message_finalization_ref(mps_addr_t *,
                                          mps_arena_t, mps_message_t);
+extern size_t mps_message_finalization_drain(mps_addr_t *, size_t,
+                                            mps_arena_t);
 
 /* -- mps_message_type_gc */
 extern size_t mps_message_gc_live_size(mps_arena_t, mps_message_t);
 extern size_t mps_message_gc_condemned_size(mps_arena_t, mps_message_t);
 extern size_t mps_message_gc_not_condemned_size(mps_arena_t,
                                                 mps_message_t);
+extern double mps_message_gc_phase_time(mps_arena_t, mps_message_t,
+                                        unsigned);
+extern double mps_message_gc_max_pause(mps_arena_t, mps_message_t);
+extern size_t mps_message_gc_histogram_length(mps_arena_t, mps_message_t);
+extern void mps_message_gc_histogram_entry(mps_arena_t, mps_message_t,
+                                           size_t, mps_addr_t *,
+                                           size_t *, size_t *);
+extern void mps_arena_gc_histogram_set(mps_arena_t, size_t);
+
+/* .gc.phase: Keep in sync with TracePhase* in <code/mpmtypes.h> */
+#define MPS_GC_PHASE_CONDEMN 0
+#define MPS_GC_PHASE_FLIP    1
+#define MPS_GC_PHASE_SCAN    2
+#define MPS_GC_PHASE_RECLAIM 3
+#define MPS_GC_PHASE_END     4
+
+typedef void (*mps_gc_phase_hook_t)(mps_arena_t, unsigned, void *);
+extern void mps_arena_gc_phase_hook_set(mps_arena_t, mps_gc_phase_hook_t,
+                                        void *);
 
 /* -- mps_message_type_gc_start */
 extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
@@ -763,6 +860,8 @@ extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
 
 extern mps_res_t mps_finalize(mps_arena_t, mps_addr_t *);
 extern mps_res_t mps_definalize(mps_arena_t, mps_addr_t *);
+extern mps_res_t mps_finalize_many(mps_arena_t, mps_addr_t *, size_t);
+extern mps_res_t mps_definalize_many(mps_arena_t, mps_addr_t *, size_t);
 
 
 /* Telemetry */
@@ -775,6 +874,21 @@ extern mps_label_t mps_telemetry_intern(const char *);
 extern void mps_telemetry_label(mps_addr_t, mps_label_t);
 extern void mps_telemetry_flush(void);
 
+/* Keep in sync with EventOutputMode* in <code/event.h> */
+#define MPS_TELEMETRY_OUTPUT_SYNC  0
+#define MPS_TELEMETRY_OUTPUT_BLOCK 1
+#define MPS_TELEMETRY_OUTPUT_DROP  2
+#define MPS_TELEMETRY_OUTPUT_RING  3
+
+extern mps_res_t mps_telemetry_output_set(unsigned);
+extern mps_bool_t mps_telemetry_output_write(void);
+extern size_t mps_telemetry_output_dropped(void);
+
+
+/* Consistency checking */
+
+extern void mps_check_sample_set(size_t);
+
 
 /* Heap Walking */
 
@@ -796,6 +910,23 @@ extern void mps_arena_roots_walk(mps_arena_t,
                                  void *, size_t);
 
 
+/* Allocation Profiling */
+
+struct mps_lib_stream_s; /* see <code/mpslib.h> */
+
+typedef size_t (*mps_profile_stack_t)(mps_word_t *, size_t, void *);
+typedef void (*mps_profile_visitor_t)(mps_addr_t, size_t, mps_addr_t,
+                                      size_t, const mps_word_t *, size_t,
+                                      void *);
+extern mps_res_t mps_arena_profile_start(mps_arena_t, size_t, size_t,
+                                         mps_profile_stack_t, void *);
+extern void mps_arena_profile_stop(mps_arena_t);
+extern void mps_arena_profile_walk(mps_arena_t, mps_profile_visitor_t,
+                                   void *);
+extern mps_res_t mps_arena_profile_write(mps_arena_t,
+                                         struct mps_lib_stream_s *);
+
+
 /* Allocation debug options */
 
 
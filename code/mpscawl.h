@@ -12,11 +12,19 @@
 extern const struct mps_key_s _mps_key_AWL_FIND_DEPENDENT;
 #define MPS_KEY_AWL_FIND_DEPENDENT (&_mps_key_AWL_FIND_DEPENDENT)
 #define MPS_KEY_AWL_FIND_DEPENDENT_FIELD addr_method
+extern const struct mps_key_s _mps_key_AWL_EPHEMERON;
+#define MPS_KEY_AWL_EPHEMERON (&_mps_key_AWL_EPHEMERON)
+#define MPS_KEY_AWL_EPHEMERON_FIELD b
+extern const struct mps_key_s _mps_key_AWL_LOAD_BARRIER;
+#define MPS_KEY_AWL_LOAD_BARRIER (&_mps_key_AWL_LOAD_BARRIER)
+#define MPS_KEY_AWL_LOAD_BARRIER_FIELD b
 
 extern mps_pool_class_t mps_class_awl(void);
 
 typedef mps_addr_t (*mps_awl_find_dependent_t)(mps_addr_t addr);
 
+extern mps_addr_t mps_awl_load(mps_pool_t pool, mps_addr_t *slot);
+
 #endif /* mpscawl_h */
 
 
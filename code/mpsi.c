@@ -47,6 +47,7 @@
 #include "mpm.h"
 #include "mps.h"
 #include "sac.h"
+#include "addrtab.h"
 
 #include <stdarg.h>
 
@@ -83,6 +84,14 @@ static Bool mpsi_check(void)
   CHECKL((int)MessageTypeGCSTART
          == (int)_mps_MESSAGE_TYPE_GC_START);
 
+  /* Check that external and internal trace phases match. */
+  /* See <code/mps.h#gc.phase> and <code/mpmtypes.h>. */
+  CHECKL((int)TracePhaseCONDEMN == (int)MPS_GC_PHASE_CONDEMN);
+  CHECKL((int)TracePhaseFLIP == (int)MPS_GC_PHASE_FLIP);
+  CHECKL((int)TracePhaseSCAN == (int)MPS_GC_PHASE_SCAN);
+  CHECKL((int)TracePhaseRECLAIM == (int)MPS_GC_PHASE_RECLAIM);
+  CHECKL((int)TracePhaseEND == (int)MPS_GC_PHASE_END);
+
   /* The external idea of a word width and the internal one */
   /* had better match.  See <design/interface-c/#cons>. */
   CHECKL(sizeof(mps_word_t) == sizeof(void *));
@@ -97,6 +106,10 @@ static Bool mpsi_check(void)
   /* and <design/interface-c/#pun.size>. */
   CHECKL(COMPATTYPE(size_t, Size));
 
+  /* There must be a bucket in the free block histogram for every */
+  /* possible size.  See <code/pool.c#PoolFreeStats>. */
+  CHECKL(MPS_WORD_WIDTH <= MPS_FREE_BUCKETS);
+
   /* Clock values are passed from external to internal and back */
   /* out to external. */
   CHECKL(COMPATTYPE(mps_clock_t, Clock));
@@ -390,6 +403,47 @@ void mps_arena_destroy(mps_arena_t arena)
 }
 
 
+/* mps_arena_stats -- return cumulative tracer and lock statistics
+ *
+ * See <design/trace/#stats> and <design/arena/#lock.stats>.
+ */
+
+void mps_arena_stats(mps_arena_t arena, mps_arena_stats_s *stats_o)
+{
+  TraceStats stats;
+
+  AVER(stats_o != NULL);
+
+  ArenaEnter(arena);
+  stats = ArenaTraceStats(arena);
+  stats_o->traces = (size_t)stats->traces;
+  stats_o->condemned_size = (size_t)stats->condemnedSize;
+  stats_o->root_scans = (size_t)stats->rootScanCount;
+  stats_o->root_scan_size = (size_t)stats->rootScanSize;
+  stats_o->seg_scans = (size_t)stats->segScanCount;
+  stats_o->seg_scan_size = (size_t)stats->segScanSize;
+  stats_o->pointless_scans = (size_t)stats->pointlessScanCount;
+  stats_o->fix_refs = (size_t)stats->fixRefCount;
+  stats_o->seg_refs = (size_t)stats->segRefCount;
+  stats_o->white_seg_refs = (size_t)stats->whiteSegRefCount;
+  stats_o->nails = (size_t)stats->nailCount;
+  stats_o->snaps = (size_t)stats->snapCount;
+  stats_o->forwarded = (size_t)stats->forwardedCount;
+  stats_o->forwarded_size = (size_t)stats->forwardedSize;
+  stats_o->preserved_in_place = (size_t)stats->preservedInPlaceCount;
+  stats_o->preserved_in_place_size = (size_t)stats->preservedInPlaceSize;
+  stats_o->reclaimed_segs = (size_t)stats->reclaimCount;
+  stats_o->reclaimed_size = (size_t)stats->reclaimSize;
+  stats_o->read_barrier_hits = (size_t)stats->readBarrierHitCount;
+  stats_o->write_barrier_hits = (size_t)stats->writeBarrierHitCount;
+  /* Includes the claim by this function, which is still held. */
+  stats_o->lock_claims = (size_t)ArenaGlobals(arena)->lockClaims;
+  stats_o->lock_wait_ticks = (double)ArenaGlobals(arena)->lockWaitTime;
+  stats_o->lock_hold_ticks = (double)ArenaGlobals(arena)->lockHoldTime;
+  ArenaLeave(arena);
+}
+
+
 /* mps_arena_busy -- is the arena part way through an operation? */
 
 mps_bool_t mps_arena_busy(mps_arena_t arena)
@@ -708,6 +762,8 @@ mps_res_t mps_pool_create_k(mps_pool_t *mps_pool_o, mps_arena_t arena,
   AVERT(ArgList, args);
 
   res = PoolCreate(&pool, arena, pool_class, args);
+  if (res == ResOK)
+    EVENT3(PoolCreateClient, pool, arena, pool_class);
 
   ArenaLeave(arena);
 
@@ -766,6 +822,24 @@ size_t mps_pool_free_size(mps_pool_t pool)
 }
 
 
+/* mps_pool_free_stats -- summarise the free blocks in a pool */
+
+void mps_pool_free_stats(mps_pool_t pool, mps_pool_free_stats_s *stats_o)
+{
+  Arena arena;
+
+  AVER(TESTT(Pool, pool));
+  AVER(stats_o != NULL);
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+
+  PoolFreeStats(stats_o, pool, 0);
+
+  ArenaLeave(arena);
+}
+
+
 mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
 {
   Arena arena;
@@ -1651,6 +1725,10 @@ void mps_thread_dereg(mps_thr_t thread)
   ThreadDeregister(thread, arena);
 
   ArenaLeave(arena);
+
+  /* Give up this thread's event buffer, in case the thread is exiting.
+     See <design/telemetry/#thread.release>. */
+  EventThreadBufferRelease();
 }
 
 void mps_ld_reset(mps_ld_t ld, mps_arena_t arena)
@@ -1691,7 +1769,8 @@ mps_bool_t mps_ld_isstale(mps_ld_t ld, mps_arena_t arena,
 {
   Bool b;
 
-  b = LDIsStale(ld, arena, (Addr)addr);
+  UNUSED(addr);
+  b = LDIsStaleAny(ld, arena);
 
   return (mps_bool_t)b;
 }
@@ -1705,6 +1784,151 @@ mps_bool_t mps_ld_isstale_any(mps_ld_t ld, mps_arena_t arena)
   return (mps_bool_t)b;
 }
 
+
+/* mps_ld_isstale_precise -- check whether a dependency on addr is stale
+ *
+ * The zone test is lock-free (see <design/interface-c/#lock-free>),
+ * so the lock is only needed to refine a stale answer by looking at
+ * the segment containing addr. See <code/ld.c#stale.lock>.  */
+
+mps_bool_t mps_ld_isstale_precise(mps_ld_t ld, mps_arena_t arena,
+                                  mps_addr_t addr)
+{
+  Bool b;
+
+  b = LDIsStaleAny(ld, arena);
+  if (b) {
+    ArenaEnter(arena);
+    b = LDIsStale(ld, arena, (Addr)addr);
+    ArenaLeave(arena);
+  }
+
+  return (mps_bool_t)b;
+}
+
+
+/* mps_addrtab_create -- create an address table
+ *
+ * See <design/addrtab/>.
+ */
+
+mps_res_t mps_addrtab_create(mps_addrtab_t *tab_o, mps_arena_t arena)
+{
+  AddrTab tab;
+  Res res;
+
+  ArenaEnter(arena);
+
+  AVER(tab_o != NULL);
+  res = AddrTabCreate(&tab, arena);
+
+  ArenaLeave(arena);
+  if (res != ResOK)
+    return (mps_res_t)res;
+  *tab_o = (mps_addrtab_t)tab;
+  return MPS_RES_OK;
+}
+
+
+/* mps_addrtab_destroy -- destroy an address table */
+
+void mps_addrtab_destroy(mps_addrtab_t mps_tab)
+{
+  AddrTab tab = (AddrTab)mps_tab;
+  Arena arena;
+
+  AVER(TESTT(AddrTab, tab));
+  arena = AddrTabArena(tab);
+
+  ArenaEnter(arena);
+  AddrTabDestroy(tab);
+  ArenaLeave(arena);
+}
+
+
+/* mps_addrtab_lookup -- look up the value associated with a key */
+
+mps_bool_t mps_addrtab_lookup(mps_addr_t *value_o, mps_addrtab_t mps_tab,
+                              mps_addr_t key)
+{
+  AddrTab tab = (AddrTab)mps_tab;
+  Arena arena;
+  Addr value;
+  Bool b;
+
+  AVER(TESTT(AddrTab, tab));
+  arena = AddrTabArena(tab);
+
+  ArenaEnter(arena);
+
+  AVER(value_o != NULL);
+  b = AddrTabLookup(&value, tab, (Addr)key);
+
+  ArenaLeave(arena);
+
+  if (b)
+    *value_o = (mps_addr_t)value;
+  return (mps_bool_t)b;
+}
+
+
+/* mps_addrtab_define -- associate a value with a key */
+
+mps_res_t mps_addrtab_define(mps_addrtab_t mps_tab, mps_addr_t key,
+                             mps_addr_t value)
+{
+  AddrTab tab = (AddrTab)mps_tab;
+  Arena arena;
+  Res res;
+
+  AVER(TESTT(AddrTab, tab));
+  arena = AddrTabArena(tab);
+
+  ArenaEnter(arena);
+  res = AddrTabDefine(tab, (Addr)key, (Addr)value);
+  ArenaLeave(arena);
+
+  return (mps_res_t)res;
+}
+
+
+/* mps_addrtab_remove -- remove a key and its value */
+
+mps_bool_t mps_addrtab_remove(mps_addrtab_t mps_tab, mps_addr_t key)
+{
+  AddrTab tab = (AddrTab)mps_tab;
+  Arena arena;
+  Bool b;
+
+  AVER(TESTT(AddrTab, tab));
+  arena = AddrTabArena(tab);
+
+  ArenaEnter(arena);
+  b = AddrTabRemove(tab, (Addr)key);
+  ArenaLeave(arena);
+
+  return (mps_bool_t)b;
+}
+
+
+/* mps_addrtab_count -- return the number of keys in a table */
+
+size_t mps_addrtab_count(mps_addrtab_t mps_tab)
+{
+  AddrTab tab = (AddrTab)mps_tab;
+  Arena arena;
+  Count count;
+
+  AVER(TESTT(AddrTab, tab));
+  arena = AddrTabArena(tab);
+
+  ArenaEnter(arena);
+  count = AddrTabCount(tab);
+  ArenaLeave(arena);
+
+  return (size_t)count;
+}
+
 mps_res_t mps_fix(mps_ss_t mps_ss, mps_addr_t *ref_io)
 {
   mps_res_t res;
@@ -1756,6 +1980,71 @@ mps_res_t mps_definalize(mps_arena_t arena, mps_addr_t *refref)
 }
 
 
+/* mps_finalize_many -- register an array of objects for finalization
+ *
+ * Either all the objects are registered, or none are.
+ */
+
+mps_res_t mps_finalize_many(mps_arena_t arena, mps_addr_t *refs,
+                            size_t count)
+{
+  Res res = ResOK;
+  Addr object;
+  Index i;
+
+  AVER(refs != NULL || count == 0);
+
+  ArenaEnter(arena);
+
+  for (i = 0; i < count; ++i) {
+    object = (Addr)ArenaPeek(arena, (Ref *)&refs[i]);
+    res = ArenaFinalize(arena, object);
+    if (res != ResOK)
+      break;
+  }
+  if (res != ResOK) {
+    while (i > 0) {
+      Res undo;
+      --i;
+      object = (Addr)ArenaPeek(arena, (Ref *)&refs[i]);
+      undo = ArenaDefinalize(arena, object);
+      AVER(undo == ResOK);
+    }
+  }
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* mps_definalize_many -- deregister an array of objects
+ *
+ * Every object is deregistered once if it can be; the result is
+ * MPS_RES_FAIL if any of them was not registered.
+ */
+
+mps_res_t mps_definalize_many(mps_arena_t arena, mps_addr_t *refs,
+                              size_t count)
+{
+  Res res = ResOK;
+  Addr object;
+  Index i;
+
+  AVER(refs != NULL || count == 0);
+
+  ArenaEnter(arena);
+
+  for (i = 0; i < count; ++i) {
+    object = (Addr)ArenaPeek(arena, (Ref *)&refs[i]);
+    if (ArenaDefinalize(arena, object) != ResOK)
+      res = ResFAIL;
+  }
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
 /* Messages */
 
 
@@ -1894,6 +2183,37 @@ void mps_message_finalization_ref(mps_addr_t *mps_addr_return,
   ArenaLeave(arena);
 }
 
+/* mps_message_finalization_drain -- get and discard many finalization
+ * messages
+ *
+ * Stores the finalization references from up to count messages in
+ * refs, and returns the number stored.
+ */
+
+size_t mps_message_finalization_drain(mps_addr_t *refs, size_t count,
+                                      mps_arena_t arena)
+{
+  Message message;
+  Ref ref;
+  Index i;
+
+  AVER(refs != NULL || count == 0);
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  for (i = 0; i < count; ++i) {
+    if (!MessageGet(&message, arena, MessageTypeFINALIZATION))
+      break;
+    MessageFinalizationRef(&ref, arena, message);
+    ArenaPoke(arena, (Ref *)&refs[i], ref);
+    MessageDiscard(arena, message);
+  }
+
+  ArenaLeave(arena);
+  return (size_t)i;
+}
+
 /* -- mps_message_type_gc */
 
 size_t mps_message_gc_live_size(mps_arena_t arena,
@@ -1938,6 +2258,102 @@ size_t mps_message_gc_not_condemned_size(mps_arena_t arena,
   return (size_t)size;
 }
 
+/* The trace measures times with ClockNow, and they are converted to
+ * seconds here. See <design/trace/#phase.time>. */
+
+double mps_message_gc_phase_time(mps_arena_t arena,
+                                 mps_message_t message,
+                                 unsigned phase)
+{
+  Clock time;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  AVER(phase < TracePhaseLIMIT);
+  time = MessageGCPhaseTime(message, phase);
+
+  ArenaLeave(arena);
+  return (double)time / (double)ClocksPerSec();
+}
+
+double mps_message_gc_max_pause(mps_arena_t arena,
+                                mps_message_t message)
+{
+  Clock time;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  time = MessageGCMaxPause(message);
+
+  ArenaLeave(arena);
+  return (double)time / (double)ClocksPerSec();
+}
+
+size_t mps_message_gc_histogram_length(mps_arena_t arena,
+                                       mps_message_t message)
+{
+  Count length;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  length = MessageGCHistogramLength(message);
+
+  ArenaLeave(arena);
+  return (size_t)length;
+}
+
+void mps_message_gc_histogram_entry(mps_arena_t arena,
+                                    mps_message_t message, size_t i,
+                                    mps_addr_t *klass_o, size_t *count_o,
+                                    size_t *size_o)
+{
+  Addr klass;
+  Count count;
+  Size size;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  AVER(klass_o != NULL);
+  AVER(count_o != NULL);
+  AVER(size_o != NULL);
+  MessageGCHistogramEntry(&klass, &count, &size, message, (Index)i);
+
+  ArenaLeave(arena);
+
+  *klass_o = (mps_addr_t)klass;
+  *count_o = (size_t)count;
+  *size_o = (size_t)size;
+}
+
+/* mps_arena_gc_histogram_set -- set maximum classes in GC histograms
+ *
+ * See <design/message-gc/#histogram>.
+ */
+
+void mps_arena_gc_histogram_set(mps_arena_t arena, size_t length)
+{
+  ArenaEnter(arena);
+  TraceSetHistogramLength(arena, (Count)length);
+  ArenaLeave(arena);
+}
+
+/* mps_arena_gc_phase_hook_set -- set function called at phase boundaries
+ *
+ * See <design/trace/#phase.hook>.
+ */
+
+void mps_arena_gc_phase_hook_set(mps_arena_t arena, mps_gc_phase_hook_t hook,
+                                 void *closure)
+{
+  ArenaEnter(arena);
+  TraceSetPhaseHook(arena, (TracePhaseHook)hook, closure);
+  ArenaLeave(arena);
+}
+
 /* -- mps_message_type_gc_start */
 
 const char *mps_message_gc_start_why(mps_arena_t arena,
@@ -1995,7 +2411,95 @@ void mps_telemetry_label(mps_addr_t addr, mps_label_t intern_id)
 void mps_telemetry_flush(void)
 {
   /* Telemetry does its own concurrency control, so none here. */
-  EventSync();
+  EventDrain();
+}
+
+mps_res_t mps_telemetry_output_set(unsigned mode)
+{
+  AVER(MPS_TELEMETRY_OUTPUT_SYNC == EventOutputModeSYNC);
+  AVER(MPS_TELEMETRY_OUTPUT_BLOCK == EventOutputModeBLOCK);
+  AVER(MPS_TELEMETRY_OUTPUT_DROP == EventOutputModeDROP);
+  AVER(MPS_TELEMETRY_OUTPUT_RING == EventOutputModeRING);
+  return (mps_res_t)EventOutputSet((EventOutputMode)mode);
+}
+
+mps_bool_t mps_telemetry_output_write(void)
+{
+  return (mps_bool_t)EventOutputWrite();
+}
+
+size_t mps_telemetry_output_dropped(void)
+{
+  return (size_t)EventDropped();
+}
+
+
+/* mps_check_sample_set -- set the interval between sampled checks
+ *
+ * This has no effect unless the MPS was built with
+ * CONFIG_ASSERT_SAMPLED.  See <design/check/#sampled>.
+ */
+
+void mps_check_sample_set(size_t interval)
+{
+#if defined(AVER_AND_CHECK_SAMPLED)
+  CheckSampleSet(interval);
+#else
+  UNUSED(interval);
+#endif
+}
+
+
+/* Allocation Profiling -- see <design/profile/> */
+
+mps_res_t mps_arena_profile_start(mps_arena_t arena, size_t interval,
+                                  size_t length, mps_profile_stack_t stack,
+                                  void *closure)
+{
+  Res res;
+
+  ArenaEnter(arena);
+  AVER(interval > 0);
+  AVER(length > 0);
+  res = ProfileStart(arena, (Size)interval, (Count)length,
+                     (ProfileStackMethod)stack, closure);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+void mps_arena_profile_stop(mps_arena_t arena)
+{
+  ArenaEnter(arena);
+  ProfileStop(arena);
+  ArenaLeave(arena);
+}
+
+void mps_arena_profile_walk(mps_arena_t arena, mps_profile_visitor_t visitor,
+                            void *closure)
+{
+  Profile profile;
+
+  ArenaEnter(arena);
+  AVER(FUNCHECK(visitor));
+  profile = ArenaProfile(arena);
+  if (profile != NULL)
+    ProfileWalk(profile, visitor, closure);
+  ArenaLeave(arena);
+}
+
+mps_res_t mps_arena_profile_write(mps_arena_t arena,
+                                  struct mps_lib_stream_s *stream)
+{
+  Profile profile;
+  Res res = ResFAIL;
+
+  ArenaEnter(arena);
+  AVER(stream != NULL);
+  profile = ArenaProfile(arena);
+  if (profile != NULL)
+    res = ProfileWrite(profile, stream);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
 }
 
 
@@ -2152,6 +2656,65 @@ void mps_chain_destroy(mps_chain_t chain)
 }
 
 
+/* mps_pool_gen_stats -- report the generations of a pool
+ *
+ * Fills in up to count entries of the array stats_o, and returns the
+ * number of generations in the pool.
+ */
+
+typedef struct poolGenStatsClosureStruct {
+  mps_gen_stats_s *stats;       /* array to fill in */
+  size_t count;                 /* length of array */
+  size_t found;                 /* generations found so far */
+} poolGenStatsClosureStruct, *poolGenStatsClosure;
+
+static void poolGenStatsVisit(PoolGen pgen, Chain chain, Index index,
+                              void *closure)
+{
+  poolGenStatsClosure psc = closure;
+  if (psc->found < psc->count) {
+    mps_gen_stats_s *stats = &psc->stats[psc->found];
+    GenDesc gen = pgen->gen;
+    stats->chain = (mps_chain_t)chain;
+    stats->gen = (size_t)index;
+    stats->capacity = (size_t)gen->capacity;
+    stats->mortality = gen->mortality;
+    stats->collections = (size_t)gen->collections;
+    stats->segs = (size_t)pgen->segs;
+    stats->total_size = (size_t)pgen->totalSize;
+    stats->free_size = (size_t)pgen->freeSize;
+    stats->buffered_size = (size_t)pgen->bufferedSize;
+    stats->new_size = (size_t)pgen->newSize;
+    stats->old_size = (size_t)pgen->oldSize;
+    stats->new_deferred_size = (size_t)pgen->newDeferredSize;
+    stats->old_deferred_size = (size_t)pgen->oldDeferredSize;
+  }
+  ++psc->found;
+}
+
+size_t mps_pool_gen_stats(mps_pool_t pool, mps_gen_stats_s *stats_o,
+                          size_t count)
+{
+  Arena arena;
+  poolGenStatsClosureStruct pscStruct;
+
+  AVER(TESTT(Pool, pool));
+  AVER(stats_o != NULL || count == 0);
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+
+  pscStruct.stats = stats_o;
+  pscStruct.count = count;
+  pscStruct.found = 0;
+  PoolGenIterate(pool, poolGenStatsVisit, &pscStruct);
+
+  ArenaLeave(arena);
+
+  return pscStruct.found;
+}
+
+
 /* _mps_args_set_key -- set the key for a keyword argument 
  *
  * This sets the key for the i'th keyword argument in the array args,
@@ -233,7 +233,9 @@ Res PoolAlloc(Addr *pReturn, Pool pool, Size size)
   /* it all in the fillMutatorSize field. */
   ArenaGlobals(PoolArena(pool))->fillMutatorSize += size;
 
-  EVENT3(PoolAlloc, pool, *pReturn, size);
+  /* See <design/telemetry/#replay.capture>. */
+  if (EVENT_KIND_ENABLED(Object))
+    EVENT3(PoolAlloc, pool, *pReturn, size);
 
   return ResOK;
 }
@@ -252,7 +254,8 @@ void (PoolFree)(Pool pool, Addr old, Size size)
 
   PoolFreeMacro(pool, old, size);
  
-  EVENT3(PoolFree, pool, old, size);
+  if (EVENT_KIND_ENABLED(Object))
+    EVENT3(PoolFree, pool, old, size);
 }
 
 
@@ -302,6 +305,82 @@ Size PoolFreeSize(Pool pool)
 }
 
 
+/* PoolFreeStats -- summarise the free blocks in a pool
+ *
+ * Walks the free blocks in the pool (see PoolFreeWalk) and fills in
+ * the total and largest size, and a histogram of the sizes by power
+ * of two. The summary is also logged as a PoolFreeStats event, with
+ * a PoolFreeBucket event for each non-empty bucket. size is the size
+ * of the request that made the pool grow, or zero for a snapshot not
+ * caused by growth. See <design/pool/#free-stats>.
+ */
+
+static void poolFreeStatsVisit(Addr base, Addr limit, Pool pool, void *p)
+{
+  FreeStats stats = p;
+  Size size = AddrOffset(base, limit);
+  Shift shift;
+
+  AVER(base < limit);
+  UNUSED(pool);
+
+  shift = SizeFloorLog2(size);
+  AVER(shift < MPS_FREE_BUCKETS);
+  ++ stats->free_blocks;
+  stats->free_block_size += size;
+  if (size > stats->largest)
+    stats->largest = size;
+  ++ stats->count[shift];
+  stats->size[shift] += size;
+}
+
+void PoolFreeStats(FreeStats stats, Pool pool, Size size)
+{
+  Index i;
+
+  AVER(stats != NULL);
+  AVERT(Pool, pool);
+
+  stats->total_size = PoolTotalSize(pool);
+  stats->free_size = PoolFreeSize(pool);
+  stats->free_blocks = 0;
+  stats->free_block_size = 0;
+  stats->largest = 0;
+  for (i = 0; i < MPS_FREE_BUCKETS; ++i) {
+    stats->count[i] = 0;
+    stats->size[i] = 0;
+  }
+
+  PoolFreeWalk(pool, poolFreeStatsVisit, stats);
+
+  EVENT7(PoolFreeStats, pool, size, stats->total_size, stats->free_size,
+         stats->free_blocks, stats->free_block_size, stats->largest);
+  for (i = 0; i < MPS_FREE_BUCKETS; ++i)
+    if (stats->count[i] > 0)
+      EVENT4(PoolFreeBucket, pool, i, stats->count[i], stats->size[i]);
+}
+
+
+/* PoolFreeLog -- log the free blocks in a pool that is about to grow
+ *
+ * Manual pool classes call this just before they allocate memory from
+ * the arena, so that the telemetry stream shows whether the pool grew
+ * because its free space was fragmented. Walking the free blocks is
+ * costly, so this does nothing unless Pool events are enabled.
+ */
+
+void PoolFreeLog(Pool pool, Size size)
+{
+  AVERT(Pool, pool);
+  AVER(size > 0);
+
+  if (EVENT_KIND_ENABLED(Pool)) {
+    FreeStatsStruct statsStruct;
+    PoolFreeStats(&statsStruct, pool, size);
+  }
+}
+
+
 /* PoolDescribe -- describe a pool */
 
 Res PoolDescribe(Pool pool, mps_lib_FILE *stream, Count depth)
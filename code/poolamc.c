@@ -1194,7 +1194,7 @@ static Res amcSegWhiten(Seg seg, Trace trace)
                                 bufferScanLimit,
                                 BufferLimit(buffer));
             }
-            STATISTIC(++trace->nailCount);
+            ++trace->nailCount;
             SegSetNailed(seg, TraceSetSingle(trace));
           } else {
             /* Segment is nailed already, cannot create a nailboard */
@@ -1585,7 +1585,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
       res = amcSegCreateNailboard(seg);
       if(res != ResOK)
         return res;
-      STATISTIC(++ss->nailCount);
+      ++ss->nailCount;
       SegSetNailed(seg, TraceSetUnion(SegNailed(seg), ss->traces));
     }
     amcSegFixInPlace(seg, ss, refIO);
@@ -1643,7 +1643,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
     AVER_CRITICAL(buffer != NULL);
 
     length = AddrOffset(ref, clientQ);  /* .exposed.seg */
-    STATISTIC(++ss->forwardedCount);
+    ++ss->forwardedCount;
     do {
       res = BUFFER_RESERVE(&newBase, buffer, length);
       if (res != ResOK)
@@ -1663,6 +1663,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
         AVER_CRITICAL(SegRankSet(toSeg) == RankSetEMPTY);
       }
       SegSetGrey(toSeg, TraceSetUnion(SegGrey(toSeg), grey));
+      SegSetMovedIn(toSeg, ArenaEpoch(arena)); /* <code/ld.c#stale.seg> */
 
       /* <design/trace/#fix.copy> */
       (void)AddrCopy(newBase, base, length);  /* .exposed.seg */
@@ -1673,6 +1674,8 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
     STATISTIC(ss->copiedSize += length);
     TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
       MustBeA(amcSeg, seg)->forwarded[ti] += length;
+      if (trace->histogram != NULL)
+        TraceHistogramAdd(trace, format, ref, length);  /* .exposed.seg */
     TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
 
     (*format->move)(ref, newRef);  /* .exposed.seg */
@@ -1681,7 +1684,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
   } else {
     /* reference to broken heart (which should be snapped out -- */
     /* consider adding to (non-existent) snap-out cache here) */
-    STATISTIC(++ss->snapCount);
+    ++ss->snapCount;
   }
 
   /* .fix.update: update the reference to whatever the above code */
@@ -1703,7 +1706,7 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
   Addr p, limit;
   Arena arena;
   Format format;
-  STATISTIC_DECL(Size bytesReclaimed = (Size)0)
+  Size bytesReclaimed = (Size)0;
   Count preservedInPlaceCount = (Count)0;
   Size preservedInPlaceSize = (Size)0;
   AMC amc = MustBeA(AMCZPool, pool);
@@ -1746,11 +1749,12 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     if(preserve) {
       ++preservedInPlaceCount;
       preservedInPlaceSize += length;
+      TraceHistogramAdd(trace, format, clientP, length);
       if (padLength > 0) {
         /* Replace run of forwarding pointers and unreachable objects
          * with a padding object. */
         (*format->pad)(padBase, padLength);
-        STATISTIC(bytesReclaimed += padLength);
+        bytesReclaimed += padLength;
         padLength = 0;
       }
       padBase = q;
@@ -1767,7 +1771,7 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     /* Replace final run of forwarding pointers and unreachable
      * objects with a padding object. */
     (*format->pad)(padBase, padLength);
-    STATISTIC(bytesReclaimed += padLength);
+    bytesReclaimed += padLength;
   }
   ShieldCover(arena, seg);
 
@@ -1778,9 +1782,9 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     MustBeA(amcSeg, seg)->board = NULL;
   }
 
-  STATISTIC(AVER(bytesReclaimed <= SegSize(seg)));
-  STATISTIC(trace->reclaimSize += bytesReclaimed);
-  STATISTIC(trace->preservedInPlaceCount += preservedInPlaceCount);
+  AVER(bytesReclaimed <= SegSize(seg));
+  trace->reclaimSize += bytesReclaimed;
+  trace->preservedInPlaceCount += preservedInPlaceCount;
   pgen = &amcSegGen(seg)->pgen;
   if (SegBuffer(&buffer, seg)) {
     /* Any allocation in the buffer was white, so needs to be
@@ -1841,7 +1845,7 @@ static void amcSegReclaim(Seg seg, Trace trace)
   /* segs should have been nailed anyway). */
   AVER(!SegHasBuffer(seg));
 
-  STATISTIC(trace->reclaimSize += SegSize(seg));
+  trace->reclaimSize += SegSize(seg);
 
   GenDescSurvived(gen->pgen.gen, trace, amcseg->forwarded[trace->ti], 0);
   PoolGenFree(&gen->pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
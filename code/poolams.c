@@ -1487,7 +1487,7 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
       if (ss->rank == RankWEAK) { /* then splat the reference */
         *refIO = (Ref)0;
       } else {
-        STATISTIC(++ss->preservedInPlaceCount); /* Size updated on reclaim */
+        ++ss->preservedInPlaceCount; /* Size updated on reclaim */
         if (SegRankSet(seg) == RankSetEMPTY && ss->rank != RankAMBIG) {
           /* <design/poolams/#fix.to-black> */
           Addr clientNext, next;
@@ -1554,6 +1554,57 @@ static void amsSegBlacken(Seg seg, TraceSet traceSet)
 }
 
 
+/* amsSegHistogram -- count the preserved objects for the histogram
+ *
+ * AMS records marks in bit tables rather than objects, so the
+ * segment has to be walked to find the class and size of each
+ * preserved object.  See <design/message-gc/#histogram>.
+ */
+
+static void amsSegHistogram(Seg seg, Trace trace)
+{
+  AMSSeg amsseg = MustBeA(AMSSeg, seg);
+  Pool pool = SegPool(seg);
+  Format format = pool->format;
+  Arena arena = PoolArena(pool);
+  Addr object, limit;
+  Buffer buffer;
+  Bool hasBuffer = SegBuffer(&buffer, seg);
+
+  AVER(amsseg->colourTablesInUse);
+
+  ShieldExpose(arena, seg);
+  object = SegBase(seg);
+  limit = SegLimit(seg);
+  while (object < limit) {
+    Addr clientObject, next;
+    Index i;
+
+    if (hasBuffer
+        && object == BufferScanLimit(buffer)
+        && BufferScanLimit(buffer) != BufferLimit(buffer))
+    {
+      /* skip over buffered area */
+      object = BufferLimit(buffer);
+      continue;
+    }
+    i = PoolIndexOfAddr(SegBase(seg), pool, object);
+    if (!AMS_ALLOCED(seg, i)) {
+      object = AddrAdd(object, PoolAlignment(pool));
+      continue;
+    }
+    clientObject = AddrAdd(object, format->headerSize);
+    next = AddrSub((*format->skip)(clientObject), format->headerSize);
+    AVER(AddrIsAligned(next, PoolAlignment(pool)));
+    if (!AMS_IS_WHITE(seg, i))
+      TraceHistogramAdd(trace, format, clientObject,
+                        AddrOffset(object, next));
+    object = next;
+  }
+  ShieldCover(arena, seg);
+}
+
+
 /* amsSegReclaim -- the segment reclamation method */
 
 static void amsSegReclaim(Seg seg, Trace trace)
@@ -1572,6 +1623,9 @@ static void amsSegReclaim(Seg seg, Trace trace)
   AVER(!amsseg->marksChanged); /* there must be nothing grey */
   grains = amsseg->grains;
 
+  if (trace->histogram != NULL)
+    amsSegHistogram(seg, trace);
+
   /* Loop over all white blocks and splat them, if it's a debug class. */
   debug = Method(Pool, pool, debugMixin)(pool);
   if (debug != NULL) {
@@ -1608,7 +1662,7 @@ static void amsSegReclaim(Seg seg, Trace trace)
   amsseg->oldGrains -= reclaimedGrains;
   amsseg->freeGrains += reclaimedGrains;
   PoolGenAccountForReclaim(pgen, PoolGrainsSize(pool, reclaimedGrains), FALSE);
-  STATISTIC(trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains));
+  trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains);
   /* preservedInPlaceCount is updated on fix */
   preservedInPlaceSize = PoolGrainsSize(pool, amsseg->oldGrains);
   GenDescSurvived(pgen->gen, trace, 0, preservedInPlaceSize);
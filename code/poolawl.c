@@ -58,7 +58,11 @@ static void awlSegGreyen(Seg seg, Trace trace);
 static void awlSegBlacken(Seg seg, TraceSet traceSet);
 static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss);
 static Res awlSegFix(Seg seg, ScanState ss, Ref *refIO);
+static Res awlSegEphemerons(Seg seg, ScanState ss);
 static void awlSegReclaim(Seg seg, Trace trace);
+static void awlSegSetSummary(Seg seg, RefSet summary);
+static void awlSegSetGrey(Seg seg, TraceSet grey);
+static void awlSegFlip(Seg seg, Trace trace);
 static void awlSegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
                        void *p, size_t s);
 
@@ -101,6 +105,10 @@ typedef struct AWLPoolStruct {
   PoolGen pgen;             /* NULL or pointer to pgenStruct */
   Count succAccesses;       /* number of successive single accesses */
   FindDependentFunction findDependent; /*  to find a dependent object */
+  Bool ephemeron;           /* weak objects are ephemeron keys? */
+  BT ephemeronDead;         /* unreachable keys of one object */
+  Count ephemeronWords;     /* words covered by ephemeronDead */
+  Bool loadBarrier;         /* weak segments use a software load barrier? */
   awlStatTotalStruct stats;
   Sig sig;                  /* <code/misc.h#sig> */
 } AWLPoolStruct, *AWL;
@@ -277,6 +285,9 @@ DEFINE_CLASS(Seg, AWLSeg, klass)
   klass->instClassStruct.finish = AWLSegFinish;
   klass->size = sizeof(AWLSegStruct);
   klass->init = AWLSegInit;
+  klass->setSummary = awlSegSetSummary;
+  klass->setGrey = awlSegSetGrey;
+  klass->flip = awlSegFlip;
   klass->bufferFill = awlSegBufferFill;
   klass->bufferEmpty = awlSegBufferEmpty;
   klass->access = awlSegAccess;
@@ -286,6 +297,7 @@ DEFINE_CLASS(Seg, AWLSeg, klass)
   klass->scan = awlSegScan;
   klass->fix = awlSegFix;
   klass->fixEmergency = awlSegFix;
+  klass->ephemerons = awlSegEphemerons;
   klass->reclaim = awlSegReclaim;
   klass->walk = awlSegWalk;
   AVERT(SegClass, klass);
@@ -533,11 +545,15 @@ static Addr awlNoDependent(Addr addr)
 /* AWLInit -- initialize an AWL pool */
 
 ARG_DEFINE_KEY(AWL_FIND_DEPENDENT, Fun);
+ARG_DEFINE_KEY(AWL_EPHEMERON, Bool);
+ARG_DEFINE_KEY(AWL_LOAD_BARRIER, Bool);
 
 static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   AWL awl;
   FindDependentFunction findDependent = awlNoDependent;
+  Bool ephemeron = FALSE;
+  Bool loadBarrier = FALSE;
   Chain chain;
   Res res;
   ArgStruct arg;
@@ -550,6 +566,10 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   if (ArgPick(&arg, args, MPS_KEY_AWL_FIND_DEPENDENT))
     findDependent = (FindDependentFunction)arg.val.addr_method;
+  if (ArgPick(&arg, args, MPS_KEY_AWL_EPHEMERON))
+    ephemeron = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_AWL_LOAD_BARRIER))
+    loadBarrier = arg.val.b;
   if (ArgPick(&arg, args, MPS_KEY_CHAIN))
     chain = arg.val.chain;
   else {
@@ -571,6 +591,12 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   AVER(FUNCHECK(findDependent));
   awl->findDependent = findDependent;
+  AVERT(Bool, ephemeron);
+  awl->ephemeron = ephemeron;
+  awl->ephemeronDead = NULL;
+  awl->ephemeronWords = 0;
+  AVERT(Bool, loadBarrier);
+  awl->loadBarrier = loadBarrier;
 
   AVERT(Chain, chain);
   AVER(gen <= ChainGens(chain));
@@ -623,6 +649,9 @@ static void AWLFinish(Inst inst)
                 PoolGrainsSize(pool, awlseg->newGrains),
                 FALSE);
   }
+  if (awl->ephemeronDead != NULL)
+    ControlFree(PoolArena(pool), awl->ephemeronDead,
+                BTSize(awl->ephemeronWords));
   awl->sig = SigInvalid;
   PoolGenFinish(awl->pgen);
 
@@ -630,6 +659,34 @@ static void AWLFinish(Inst inst)
 }
 
 
+/* awlEphemeronReserve -- make room to probe keys in a segment
+ *
+ * An ephemeron key object can be as large as its segment, and probing
+ * it must not allocate, so the pool keeps a table big enough for its
+ * largest weak segment. See <design/poolawl/#ephemeron.dead>.
+ */
+
+static Res awlEphemeronReserve(Pool pool, Size segSize)
+{
+  AWL awl = MustBeA(AWLPool, pool);
+  Arena arena = PoolArena(pool);
+  Count words = segSize / sizeof(Word);
+  void *p;
+  Res res;
+
+  if (words <= awl->ephemeronWords)
+    return ResOK;
+  res = ControlAlloc(&p, arena, BTSize(words));
+  if (res != ResOK)
+    return res;
+  if (awl->ephemeronDead != NULL)
+    ControlFree(arena, awl->ephemeronDead, BTSize(awl->ephemeronWords));
+  awl->ephemeronDead = p;
+  awl->ephemeronWords = words;
+  return ResOK;
+}
+
+
 /* awlBufferFill -- BufferFill method for AWL */
 
 static Res awlBufferFill(Addr *baseReturn, Addr *limitReturn,
@@ -640,6 +697,7 @@ static Res awlBufferFill(Addr *baseReturn, Addr *limitReturn,
   Ring node, nextNode;
   RankSet rankSet;
   Seg seg;
+  Size segSize;
   Bool b;
 
   AVER(baseReturn != NULL);
@@ -657,10 +715,15 @@ static Res awlBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
 
   /* No segment had enough space, so make a new one. */
+  segSize = SizeArenaGrains(size, PoolArena(pool));
+  if (awl->ephemeron && RankSetIsMember(rankSet, RankWEAK)) {
+    res = awlEphemeronReserve(pool, segSize);
+    if (res != ResOK)
+      return res;
+  }
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, awlKeySegRankSet, u, BufferRankSet(buffer));
-    res = PoolGenAlloc(&seg, awl->pgen, CLASS(AWLSeg),
-                       SizeArenaGrains(size, PoolArena(pool)), args);
+    res = PoolGenAlloc(&seg, awl->pgen, CLASS(AWLSeg), segSize, args);
   } MPS_ARGS_END(args);
   if (res != ResOK)
     return res;
@@ -848,6 +911,26 @@ static void awlSegBlacken(Seg seg, TraceSet traceSet)
 }
 
 
+/* awlEphemeronValues -- is a dependent segment one of ephemeron values?
+ *
+ * The values of the ephemeron keys in a key object are the weak
+ * references at the same offsets in its dependent object, which must
+ * be in a weak segment of an AWL pool that does not itself hold
+ * ephemeron keys. See <design/poolawl/#ephemeron.values>.
+ */
+
+static Bool awlEphemeronValues(AWL *awlReturn, Seg seg)
+{
+  Pool pool = SegPool(seg);
+  if (!IsA(AWLPool, pool)
+      || !RankSetIsMember(SegRankSet(seg), RankWEAK)
+      || MustBeA(AWLPool, pool)->ephemeron)
+    return FALSE;
+  *awlReturn = MustBeA(AWLPool, pool);
+  return TRUE;
+}
+
+
 /* awlScanObject -- scan a single object */
 /* base and limit are both offset by the header size */
 
@@ -877,6 +960,16 @@ static Res awlScanObject(Arena arena, AWL awl, ScanState ss,
 
   res = FormatScan(format, ss, base, limit);
 
+  /* <design/poolawl/#ephemeron.strong> */
+  if (res == ResOK && dependent && awl->ephemeron && ss->rank != RankWEAK) {
+    AWL valueAWL;
+    if (awlEphemeronValues(&valueAWL, dependentSeg)) {
+      Format valueFormat = SegPool(dependentSeg)->format;
+      res = awlScanObject(arena, valueAWL, ss, valueFormat, dependentObject,
+                          (*valueFormat->skip)(dependentObject));
+    }
+  }
+
   if (dependent)
     ShieldCover(arena, dependentSeg);
 
@@ -992,6 +1085,201 @@ static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
 }
 
 
+/* awlEphemeronStruct -- state of the ephemeron pass over one object
+ *
+ * See <design/poolawl/#ephemeron.pass>.
+ */
+
+typedef struct awlEphemeronStruct {
+  SegFixMethod fix;         /* the scan state's own fix method */
+  void *fixClosure;         /* and its closure */
+  Addr base;                /* object whose slots are being fixed */
+  Addr limit;               /* limit of that object */
+  BT dead;                  /* word offsets of unreachable keys */
+  Count words;              /* words in the key object */
+} awlEphemeronStruct, *awlEphemeron;
+
+
+/* awlEphemeronSlot -- find the word offset of a slot in the object */
+
+static Bool awlEphemeronSlot(Index *indexReturn, awlEphemeron eph, Addr addr)
+{
+  Size offset;
+
+  if (addr < eph->base || addr >= eph->limit)
+    return FALSE;
+  offset = AddrOffset(eph->base, addr);
+  if (offset % sizeof(Word) != 0 || offset / sizeof(Word) >= eph->words)
+    return FALSE;
+  *indexReturn = offset / sizeof(Word);
+  return TRUE;
+}
+
+
+/* awlEphemeronKeyFix -- note which keys are unreachable
+ *
+ * Fixes a copy of the reference at RankWEAK, which neither preserves
+ * nor splats it, and records the slot if the referent has not been
+ * preserved. References from outside the key object cannot be
+ * matched with a value, and are ignored.
+ */
+
+static Res awlEphemeronKeyFix(Seg seg, ScanState ss, Ref *refIO)
+{
+  awlEphemeron eph = ss->fixClosure;
+  Ref ref = *refIO;
+  Index i;
+  Res res;
+
+  AVER(ss->rank == RankWEAK);
+  ss->wasMarked = TRUE;
+  res = (*eph->fix)(seg, ss, &ref);
+  if (res != ResOK)
+    return res;
+  if ((!ss->wasMarked || ref == (Ref)0)
+      && awlEphemeronSlot(&i, eph, ss->fixSlot))
+    BTSet(eph->dead, i);
+  return ResOK;
+}
+
+
+/* awlEphemeronValueFix -- fix the values of reachable keys
+ *
+ * Leaves a value alone if its key was found to be unreachable, so
+ * that the weak scan of the value object can splat it later. Fixes
+ * every other reference normally.
+ */
+
+static Res awlEphemeronValueFix(Seg seg, ScanState ss, Ref *refIO)
+{
+  awlEphemeron eph = ss->fixClosure;
+  Index i;
+
+  if (awlEphemeronSlot(&i, eph, ss->fixSlot) && BTGet(eph->dead, i))
+    return ResOK;
+  return (*eph->fix)(seg, ss, refIO);
+}
+
+
+/* awlEphemeronObject -- preserve the values of a reachable key object */
+
+static Res awlEphemeronObject(Arena arena, AWL awl, ScanState ss,
+                              Format format, Addr base, Addr limit)
+{
+  awlEphemeronStruct ephStruct;
+  awlEphemeron eph = &ephStruct;
+  Addr value;
+  Seg valueSeg;
+  AWL valueAWL;
+  Format valueFormat;
+  Res res;
+
+  value = awl->findDependent(base);
+  if (!SegOfAddr(&valueSeg, arena, value)
+      || !awlEphemeronValues(&valueAWL, valueSeg))
+    return ResOK;
+
+  eph->fix = ss->fix;
+  eph->fixClosure = ss->fixClosure;
+  eph->base = base;
+  eph->limit = limit;
+  eph->dead = awl->ephemeronDead;
+  eph->words = AddrOffset(base, limit) / sizeof(Word);
+  AVER(eph->words <= awl->ephemeronWords);
+  BTResRange(eph->dead, 0, eph->words);
+
+  /* Probe the keys. */
+  ss->fix = awlEphemeronKeyFix;
+  ss->fixClosure = eph;
+  res = FormatScan(format, ss, base, limit);
+  if (res != ResOK)
+    goto done;
+
+  /* Fix the values whose keys were not found to be unreachable. */
+  ShieldExpose(arena, valueSeg);
+  /* <design/poolawl/#fun.scan.pass.object.dependent.summary> */
+  SegSetSummary(valueSeg, RefSetUNIV);
+  valueFormat = SegPool(valueSeg)->format;
+  eph->base = value;
+  eph->limit = (*valueFormat->skip)(value);
+  ss->fix = awlEphemeronValueFix;
+  ss->rank = RankEXACT;
+  res = awlScanObject(arena, valueAWL, ss, valueFormat, eph->base, eph->limit);
+  ss->rank = RankWEAK;
+  ShieldCover(arena, valueSeg);
+
+done:
+  ss->fix = eph->fix;
+  ss->fixClosure = eph->fixClosure;
+  return res;
+}
+
+
+/* awlSegEphemerons -- preserve the values of reachable ephemeron keys
+ *
+ * Applies awlEphemeronObject to each grey object in the segment. The
+ * objects stay grey: they are scanned at RankWEAK in the weak band as
+ * usual. See <design/poolawl/#ephemeron>.
+ */
+
+static Res awlSegEphemerons(Seg seg, ScanState ss)
+{
+  AWLSeg awlseg = MustBeA(AWLSeg, seg);
+  Pool pool = SegPool(seg);
+  AWL awl = MustBeA(AWLPool, pool);
+  Arena arena = PoolArena(pool);
+  Format format = pool->format;
+  Addr base = SegBase(seg);
+  Addr limit = SegLimit(seg);
+  Addr bufferScanLimit;
+  Buffer buffer;
+  Bool scanAllObjects;
+  Addr p;
+  Res res = ResOK;
+
+  AVERT(ScanState, ss);
+
+  if (!awl->ephemeron)
+    return ResOK;
+
+  scanAllObjects =
+    (TraceSetDiff(ss->traces, SegWhite(seg)) != TraceSetEMPTY);
+  if (SegBuffer(&buffer, seg) && BufferScanLimit(buffer) != BufferLimit(buffer))
+    bufferScanLimit = BufferScanLimit(buffer);
+  else
+    bufferScanLimit = limit;
+
+  ShieldExpose(arena, seg);
+  p = base;
+  while (p < limit) {
+    Index i;
+    Addr hp, objectLimit;
+
+    if (p == bufferScanLimit) {
+      p = BufferLimit(buffer);
+      continue;
+    }
+    i = PoolIndexOfAddr(base, pool, p);
+    if (!BTGet(awlseg->alloc, i)) {
+      p = AddrAdd(p, PoolAlignment(pool));
+      continue;
+    }
+    hp = AddrAdd(p, format->headerSize);
+    objectLimit = (format->skip)(hp);
+    if (scanAllObjects
+        || (BTGet(awlseg->mark, i) && !BTGet(awlseg->scanned, i))) {
+      res = awlEphemeronObject(arena, awl, ss, format, hp, objectLimit);
+      if (res != ResOK)
+        break;
+    }
+    p = AddrSub(objectLimit, format->headerSize);
+  }
+  ShieldCover(arena, seg);
+
+  return res;
+}
+
+
 /* awlSegFix -- Fix method for AWL segments */
 
 static Res awlSegFix(Seg seg, ScanState ss, Ref *refIO)
@@ -1046,6 +1334,67 @@ static Res awlSegFix(Seg seg, ScanState ss, Ref *refIO)
 }
 
 
+/* awlSegSetSummary -- set the summary of an AWL segment
+ *
+ * Segments of ephemeron keys always have the universal summary, so
+ * that they are grey in every trace and are never blackened without
+ * being scanned, either of which would lose the values of their
+ * reachable keys. See <design/poolawl/#ephemeron.summary>.
+ */
+
+static void awlSegSetSummary(Seg seg, RefSet summary)
+{
+  if (MustBeA(AWLPool, SegPool(seg))->ephemeron
+      && RankSetIsMember(SegRankSet(seg), RankWEAK))
+    summary = RefSetUNIV;
+  NextMethod(Seg, AWLSeg, setSummary)(seg, summary);
+}
+
+
+/* awlSegHasLoadBarrier -- is segment guarded by the load barrier?
+ *
+ * Weak segments of a pool created with MPS_KEY_AWL_LOAD_BARRIER are
+ * never read-protected: the client promises to load references from
+ * them only via mps_awl_load. See <design/poolawl/#load>.
+ */
+
+static Bool awlSegHasLoadBarrier(Seg seg)
+{
+  return MustBeA(AWLPool, SegPool(seg))->loadBarrier
+    && RankSetIsMember(SegRankSet(seg), RankWEAK);
+}
+
+
+/* awlSegSetGrey -- change the greyness of an AWL segment
+ *
+ * Segments with a load barrier bypass the MutatorSeg method, which
+ * raises and lowers the read barrier.
+ */
+
+static void awlSegSetGrey(Seg seg, TraceSet grey)
+{
+  if (awlSegHasLoadBarrier(seg))
+    NextMethod(Seg, MutatorSeg, setGrey)(seg, grey);
+  else
+    NextMethod(Seg, AWLSeg, setGrey)(seg, grey);
+}
+
+
+/* awlSegFlip -- update barriers for a trace that's about to flip
+ *
+ * As awlSegSetGrey, segments with a load barrier don't get a read
+ * barrier at flip.
+ */
+
+static void awlSegFlip(Seg seg, Trace trace)
+{
+  if (awlSegHasLoadBarrier(seg))
+    NextMethod(Seg, MutatorSeg, flip)(seg, trace);
+  else
+    NextMethod(Seg, AWLSeg, flip)(seg, trace);
+}
+
+
 /* awlSegReclaim -- reclaim dead objects in an AWL segment */
 
 static void awlSegReclaim(Seg seg, Trace trace)
@@ -1092,6 +1441,8 @@ static void awlSegReclaim(Seg seg, Trace trace)
       BTSetRange(awlseg->scanned, i, j);
       ++preservedInPlaceCount;
       preservedInPlaceSize += AddrOffset(p, q);
+      TraceHistogramAdd(trace, format, AddrAdd(p, format->headerSize),
+                        AddrOffset(p, q));
     } else {
       BTResRange(awlseg->mark, i, j);
       BTSetRange(awlseg->scanned, i, j);
@@ -1108,8 +1459,8 @@ static void awlSegReclaim(Seg seg, Trace trace)
   awlseg->freeGrains += reclaimedGrains;
   PoolGenAccountForReclaim(pgen, PoolGrainsSize(pool, reclaimedGrains), FALSE);
 
-  STATISTIC(trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains));
-  STATISTIC(trace->preservedInPlaceCount += preservedInPlaceCount);
+  trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains);
+  trace->preservedInPlaceCount += preservedInPlaceCount;
   GenDescSurvived(pgen->gen, trace, 0, preservedInPlaceSize);
   SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
 
@@ -1262,6 +1613,72 @@ mps_pool_class_t mps_class_awl(void)
 }
 
 
+/* awlLoad -- load a reference through the load barrier
+ *
+ * If the slot is in a weak segment that is grey for a flipped trace,
+ * its reference may not have been fixed yet, so fix it just as if the
+ * mutator had hit a read barrier. See <design/poolawl/#load.slow>.
+ */
+
+static Ref awlLoad(Pool pool, Ref *slot)
+{
+  Arena arena = PoolArena(pool);
+  TraceSet flipped = arena->flippedTraces;
+  Seg seg;
+
+  AVER(MustBeA(AWLPool, pool)->loadBarrier);
+  AVER(AddrIsAligned(slot, sizeof(Ref)));
+
+  if (flipped != TraceSetEMPTY
+      && SegOfAddr(&seg, arena, (Addr)slot)
+      && SegPool(seg) == pool
+      && awlSegHasLoadBarrier(seg)
+      && TraceSetInter(SegGrey(seg), flipped) != TraceSetEMPTY)
+  {
+    TraceScanSingleRef(flipped, TraceRankForAccess(arena, seg),
+                       arena, seg, slot);
+  }
+  return *slot;
+}
+
+
+/* mps_awl_load -- load a reference from a weak object
+ *
+ * When no trace is flipped, the reference in the slot is valid and
+ * the load needs no lock. The flip count is read before and after the
+ * slot, like a sequence lock, so that a flip in between sends the load
+ * to the slow path. See <design/poolawl/#load.fast>.
+ */
+
+mps_addr_t mps_awl_load(mps_pool_t pool, mps_addr_t *slot)
+{
+  Arena arena;
+  mps_addr_t ref;
+
+#if defined(LOAD_ACQUIRE)
+  {
+    Count flips;
+    arena = PoolArena(pool);
+    flips = LOAD_ACQUIRE(arena->flips);
+    if (LOAD_ACQUIRE(arena->flippedTraces) == TraceSetEMPTY) {
+      ref = LOAD_ACQUIRE(*slot);
+      if (LOAD_ACQUIRE(arena->flips) == flips)
+        return ref;
+    }
+  }
+#endif
+
+  arena = PoolArena(pool);
+  ArenaEnter(arena);
+  AVER(TESTT(Pool, pool));
+  AVER(slot != NULL);
+  ref = (mps_addr_t)awlLoad(pool, (Ref *)slot);
+  ArenaLeave(arena);
+
+  return ref;
+}
+
+
 /* AWLCheck -- check an AWL pool */
 
 ATTRIBUTE_UNUSED
@@ -1274,6 +1691,9 @@ static Bool AWLCheck(AWL awl)
     CHECKD(PoolGen, awl->pgen);
   /* Nothing to check about succAccesses. */
   CHECKL(FUNCHECK(awl->findDependent));
+  CHECKL(BoolCheck(awl->ephemeron));
+  CHECKL((awl->ephemeronDead == NULL) == (awl->ephemeronWords == 0));
+  CHECKL(BoolCheck(awl->loadBarrier));
   /* Don't bother to check stats. */
   return TRUE;
 }
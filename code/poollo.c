@@ -355,6 +355,8 @@ static void loSegReclaim(Seg seg, Trace trace)
     if(BTGet(loseg->mark, i)) {
       ++preservedInPlaceCount;
       preservedInPlaceSize += AddrOffset(p, q);
+      TraceHistogramAdd(trace, format, AddrAdd(p, format->headerSize),
+                        AddrOffset(p, q));
     } else {
       Index j = PoolIndexOfAddr(base, pool, q);
       /* This object is not marked, so free it */
@@ -371,8 +373,8 @@ static void loSegReclaim(Seg seg, Trace trace)
   loseg->freeGrains += reclaimedGrains;
   PoolGenAccountForReclaim(pgen, PoolGrainsSize(pool, reclaimedGrains), FALSE);
 
-  STATISTIC(trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains));
-  STATISTIC(trace->preservedInPlaceCount += preservedInPlaceCount);
+  trace->reclaimSize += PoolGrainsSize(pool, reclaimedGrains);
+  trace->preservedInPlaceCount += preservedInPlaceCount;
   GenDescSurvived(pgen->gen, trace, 0, preservedInPlaceSize);
   SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
 
@@ -31,6 +31,7 @@
 #include "ring.h"
 #include "mpm.h"
 #include "poolmrg.h"
+#include "table.h"
 
 SRCID(poolmrg, "$Id$");
 
@@ -50,6 +51,7 @@ enum {
 typedef struct LinkStruct *Link;
 typedef struct LinkStruct {
   int state;                     /* Free, Prefinal, Final */
+  struct LinkStruct *next;       /* next guardian for same object */
   union LinkStructUnion {
     MessageStruct messageStruct; /* state = Final */
     RingStruct linkRing;         /* state one of {Free, Prefinal} */
@@ -92,6 +94,28 @@ static Ref MRGRefPartRef(Arena arena, RefPart refPart)
   return ref;
 }
 
+/* mrgRefPartPeek -- read the reference without fixing it
+ *
+ * Unlike MRGRefPartRef, this doesn't bring the reference up to date
+ * if its segment is grey for a flipped trace, and so doesn't preserve
+ * the object it refers to. See <design/poolmrg/#index.flipped>.
+ */
+static Ref mrgRefPartPeek(Arena arena, RefPart refPart)
+{
+  Seg seg = NULL;       /* suppress "may be used uninitialized" */
+  Bool b;
+  Ref ref;
+
+  AVER(refPart != NULL);
+
+  b = SegOfAddr(&seg, arena, (Addr)refPart);
+  AVER(b);
+  ShieldExpose(arena, seg);
+  ref = refPart->ref;
+  ShieldCover(arena, seg);
+  return ref;
+}
+
 static Ref *MRGRefPartRefAddr(RefPart refPart)
 {
   AVER(refPart != NULL);
@@ -117,6 +141,9 @@ typedef struct MRGStruct {
   RingStruct freeRing;      /* <design/poolmrg/#poolstruct.free> */
   RingStruct refRing;       /* <design/poolmrg/#poolstruct.refring> */
   Size extendBy;            /* <design/poolmrg/#extend> */
+  Table index;              /* <design/poolmrg/#index>, or NULL */
+  Bool indexValid;          /* index matches entry ring? */
+  Count indexRemoved;       /* entries removed since index was built */
   Sig sig;                  /* <code/mps.h#sig> */
 } MRGStruct;
 
@@ -140,6 +167,9 @@ static Bool MRGCheck(MRG mrg)
   CHECKD_NOSIG(Ring, &mrg->freeRing);
   CHECKD_NOSIG(Ring, &mrg->refRing);
   CHECKL(mrg->extendBy == ArenaGrainSize(PoolArena(pool)));
+  CHECKL(mrg->index == NULL || TableCheck(mrg->index));
+  CHECKL(BoolCheck(mrg->indexValid));
+  CHECKL(!mrg->indexValid || mrg->index != NULL);
   return TRUE;
 }
 
@@ -420,6 +450,7 @@ static void MRGGuardianInit(MRG mrg, Link link, RefPart refPart)
 
   RingInit(&link->the.linkRing);
   link->state = MRGGuardianFREE;
+  link->next = NULL;
   RingAppend(&mrg->freeRing, &link->the.linkRing);
   /* <design/poolmrg/#free.overwrite> */
   MRGRefPartSetRef(PoolArena(MustBeA(AbstractPool, mrg)), refPart, 0);
@@ -492,6 +523,10 @@ static MessageClassStruct MRGMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGCPhaseTime,        /* GCPhaseTime */
+  MessageNoGCMaxPause,         /* GCMaxPause */
+  MessageNoGCHistogramLength,  /* GCHistogramLength */
+  MessageNoGCHistogramEntry,   /* GCHistogramEntry */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -568,20 +603,32 @@ failLinkSegAlloc:
 }
 
 
-/* MRGFinalize -- finalize the indexth guardian in the segment */
+static void mrgIndexRemove(MRG mrg, Link link, Ref ref);
+static void mrgIndexMove(MRG mrg, Link link, Ref oldRef, Ref newRef);
+
+
+/* MRGFinalize -- finalize the indexth guardian in the segment
+ *
+ * ref is the reference the guardian had before it was fixed, which is
+ * its key in the index.
+ */
 
-static void MRGFinalize(Arena arena, MRGLinkSeg linkseg, Index indx)
+static void MRGFinalize(Arena arena, MRGLinkSeg linkseg, Index indx,
+                        Ref ref)
 {
+  MRG mrg = MustBeA(MRGPool, SegPool(MustBeA(Seg, linkseg)));
   Link link;
   Message message;
 
-  AVER(indx < MRGGuardiansPerSeg(MustBeA(MRGPool, SegPool(MustBeA(Seg, linkseg)))));
+  AVER(indx < MRGGuardiansPerSeg(mrg));
 
   link = linkOfIndex(linkseg, indx);
 
   /* only finalize it if it hasn't been finalized already */
   if (link->state != MRGGuardianFINAL) {
     AVER(link->state == MRGGuardianPREFINAL);
+    /* <design/poolmrg/#index.finalize> */
+    mrgIndexRemove(mrg, link, ref);
     RingRemove(&link->the.linkRing);
     RingFinish(&link->the.linkRing);
     link->state = MRGGuardianFINAL;
@@ -614,14 +661,16 @@ static Res mrgRefSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   AVER(nGuardians > 0);
   TRACE_SCAN_BEGIN(ss) {
     for(i=0; i < nGuardians; ++i) {
+      Link link = linkOfIndex(linkseg, i);
       refPart = refPartOfIndex(refseg, i);
 
       /* free guardians are not scanned */
-      if (linkOfIndex(linkseg, i)->state != MRGGuardianFREE) {
-        ss->wasMarked = TRUE;
+      if (link->state != MRGGuardianFREE) {
         /* .ref.direct: We can access the reference directly */
         /* because we are in a scan and the shield is exposed. */
-        if (TRACE_FIX1(ss, refPart->ref)) {
+        Ref ref = refPart->ref;
+        ss->wasMarked = TRUE;
+        if (TRACE_FIX1(ss, ref)) {
           res = TRACE_FIX2(ss, &(refPart->ref));
           if (res != ResOK) {
             *totalReturn = FALSE;
@@ -629,7 +678,11 @@ static Res mrgRefSegScan(Bool *totalReturn, Seg seg, ScanState ss)
           }
 
           if (ss->rank == RankFINAL && !ss->wasMarked) { /* .improve.rank */
-            MRGFinalize(arena, linkseg, i);
+            MRGFinalize(arena, linkseg, i, ref);
+          } else if (refPart->ref != ref
+                     && link->state == MRGGuardianPREFINAL) {
+            /* <design/poolmrg/#index.move> */
+            mrgIndexMove(mrg, link, ref, refPart->ref);
           }
         }
         ss->scannedSize += sizeof *refPart;
@@ -663,6 +716,9 @@ static Res MRGInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   RingInit(&mrg->freeRing);
   RingInit(&mrg->refRing);
   mrg->extendBy = ArenaGrainSize(PoolArena(pool));
+  mrg->index = NULL;
+  mrg->indexValid = FALSE;
+  mrg->indexRemoved = 0;
 
   SetClassOfPoly(pool, CLASS(MRGPool));
   mrg->sig = MRGSig;
@@ -714,6 +770,9 @@ static void MRGFinish(Inst inst)
     MRGSegPairDestroy(refseg);
   }
 
+  if (mrg->index != NULL)
+    TableDestroy(mrg->index);
+
   mrg->sig = SigInvalid;
   RingFinish(&mrg->refRing);
   /* <design/poolmrg/#trans.no-finish> */
@@ -722,6 +781,226 @@ static void MRGFinish(Inst inst)
 }
 
 
+/* Guardian index -- <design/poolmrg/#index>
+ *
+ * The index maps the address of each object that has a Prefinal
+ * guardian to one such guardian. Further guardians for the same
+ * object are chained through their next fields.
+ */
+
+static void *mrgIndexAlloc(void *closure, size_t size)
+{
+  void *p;
+  Res res;
+
+  res = ControlAlloc(&p, (Arena)closure, size);
+  if (res != ResOK)
+    return NULL;
+  return p;
+}
+
+static void mrgIndexFree(void *closure, void *p, size_t size)
+{
+  ControlFree((Arena)closure, p, size);
+}
+
+
+/* mrgIndexAdd -- add a Prefinal guardian to the index */
+
+static Res mrgIndexAdd(MRG mrg, Link link, Ref ref)
+{
+  TableValue value;
+
+  AVER(mrg->indexValid);
+  AVER(link->state == MRGGuardianPREFINAL);
+  AVER(ref != 0);
+
+  if (TableLookup(&value, mrg->index, (TableKey)ref)) {
+    link->next = value;
+    return TableRedefine(mrg->index, (TableKey)ref, link);
+  }
+  link->next = NULL;
+  return TableDefine(mrg->index, (TableKey)ref, link);
+}
+
+
+/* mrgIndexRemove -- remove a Prefinal guardian from the index
+ *
+ * ref is the key under which the guardian was added. If the guardian
+ * can't be found the index is marked invalid, to be rebuilt.
+ */
+
+static void mrgIndexRemove(MRG mrg, Link link, Ref ref)
+{
+  TableValue value;
+  Link prev;
+  Res res;
+
+  if (!mrg->indexValid)
+    return;
+  if (!TableLookup(&value, mrg->index, (TableKey)ref)) {
+    mrg->indexValid = FALSE;
+    return;
+  }
+
+  prev = value;
+  if (prev == link) {
+    if (link->next != NULL) {
+      res = TableRedefine(mrg->index, (TableKey)ref, link->next);
+    } else {
+      res = TableRemove(mrg->index, (TableKey)ref);
+      ++mrg->indexRemoved;
+    }
+    AVER(res == ResOK);
+  } else {
+    while (prev->next != link) {
+      if (prev->next == NULL) {
+        mrg->indexValid = FALSE;
+        return;
+      }
+      prev = prev->next;
+    }
+    prev->next = link->next;
+  }
+  link->next = NULL;
+}
+
+
+/* mrgIndexMove -- re-key a Prefinal guardian whose object moved
+ *
+ * <design/poolmrg/#index.move>. Called when scanning a guardian fixes
+ * its reference from oldRef to newRef. Entry into the table may need
+ * to allocate, and if that fails the index is rebuilt later.
+ */
+
+static void mrgIndexMove(MRG mrg, Link link, Ref oldRef, Ref newRef)
+{
+  AVER(link->state == MRGGuardianPREFINAL);
+  AVER(oldRef != newRef);
+
+  mrgIndexRemove(mrg, link, oldRef);
+  if (mrg->indexValid && mrgIndexAdd(mrg, link, newRef) != ResOK)
+    mrg->indexValid = FALSE;
+}
+
+
+/* mrgIndexFlipped -- re-key the guardian of an object moved by a trace
+ *
+ * <design/poolmrg/#index.flipped>. Called when obj is missing from the
+ * index while a trace is flipped. If the trace moved obj, a guardian
+ * that hasn't been scanned yet may still refer to the old copy. A weak
+ * fix of a copy of each such reference finds where its object went
+ * without preserving it, and only the guardian that refers to obj is
+ * fixed in place. Returns TRUE if a guardian was re-keyed.
+ */
+
+static Bool mrgIndexFlipped(MRG mrg, Ref obj)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
+  Count nGuardians = MRGGuardiansPerSeg(mrg);
+  Ring node, nextNode;
+  Seg seg;
+
+  /* Nothing has moved to obj during this trace, so it isn't registered. */
+  if (!SegOfAddr(&seg, arena, (Addr)obj)
+      || SegMovedIn(seg) < ArenaEpoch(arena))
+    return FALSE;
+
+  RING_FOR(node, &mrg->refRing, nextNode) {
+    MRGRefSeg refseg = RING_ELT(MRGRefSeg, mrgRing, node);
+    Seg refSeg = MustBeA(Seg, refseg);
+    Index i;
+
+    if (TraceSetInter(SegGrey(refSeg), arena->flippedTraces)
+        == TraceSetEMPTY)
+      continue;
+    for (i = 0; i < nGuardians; ++i) {
+      Link link = linkOfIndex(refseg->linkSeg, i);
+      RefPart refPart = refPartOfIndex(refseg, i);
+      Ref oldRef, ref;
+
+      if (link->state != MRGGuardianPREFINAL)
+        continue;
+      oldRef = mrgRefPartPeek(arena, refPart);
+      if (oldRef == obj)
+        continue;
+      ref = oldRef;
+      TraceScanSingleRef(arena->flippedTraces, RankWEAK, arena, refSeg, &ref);
+      if (ref == obj) {
+        /* Fix the guardian at the trace's band, as a read would. */
+        ref = MRGRefPartRef(arena, refPart);
+        AVER(ref == obj);
+        mrgIndexMove(mrg, link, oldRef, obj);
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+
+/* mrgIndexBuild -- build the index afresh from the entry ring
+ *
+ * <design/poolmrg/#index.build>. The table keys exclude 0 and 1,
+ * neither of which can be the address of an object in the arena.
+ */
+
+static Res mrgIndexBuild(MRG mrg)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
+  Ring node, nextNode;
+  Count count = 0;
+  Res res;
+
+  mrg->indexValid = FALSE;
+  if (mrg->index != NULL) {
+    TableDestroy(mrg->index);
+    mrg->index = NULL;
+  }
+
+  RING_FOR(node, &mrg->entryRing, nextNode)
+    ++count;
+  res = TableCreate(&mrg->index, count + 1, mrgIndexAlloc, mrgIndexFree,
+                    arena, (TableKey)0, (TableKey)1);
+  if (res != ResOK) {
+    mrg->index = NULL;
+    return res;
+  }
+
+  mrg->indexRemoved = 0;
+  mrg->indexValid = TRUE;
+  RING_FOR(node, &mrg->entryRing, nextNode) {
+    Link link = linkOfRing(node);
+    RefPart refPart = MRGRefPartOfLink(link, arena);
+    /* <design/poolmrg/#index.flipped> */
+    res = mrgIndexAdd(mrg, link, mrgRefPartPeek(arena, refPart));
+    if (res != ResOK) {
+      mrg->indexValid = FALSE;
+      return res;
+    }
+  }
+
+  return ResOK;
+}
+
+
+/* mrgIndexReady -- ensure that the index is up to date
+ *
+ * Returns TRUE if the index can be used, FALSE if it is out of date
+ * and could not be rebuilt.
+ */
+
+static Bool mrgIndexReady(MRG mrg)
+{
+  if (mrg->indexValid
+      /* <design/poolmrg/#index.deleted> */
+      && mrg->indexRemoved <= mrg->index->length / 8)
+    return TRUE;
+
+  return mrgIndexBuild(mrg) == ResOK;
+}
+
+
 /* MRGRegister -- register an object for finalization */
 
 Res MRGRegister(Pool pool, Ref ref)
@@ -756,26 +1035,27 @@ Res MRGRegister(Pool pool, Ref ref)
   refPart = MRGRefPartOfLink(link, arena);
   MRGRefPartSetRef(arena, refPart, ref);
 
+  /* <design/poolmrg/#index.register> */
+  if (mrg->indexValid && mrgIndexAdd(mrg, link, ref) != ResOK)
+    mrg->indexValid = FALSE;
+
   return ResOK;
 }
 
 
-/* MRGDeregister -- deregister (once) an object for finalization
+/* mrgDeregisterSearch -- deregister by searching all guardians
  *
- * TODO: Definalization loops over all finalizable objects in the heap,
- * and so using it could accidentally be disastrous for performance.
- * See job003953 and back out changelist 187123 if this is fixed.
+ * This is only used if the index can't be built, for example
+ * because the control pool is out of memory. It loops over all
+ * finalizable objects in the heap.
  */
 
-Res MRGDeregister(Pool pool, Ref obj)
+static Res mrgDeregisterSearch(MRG mrg, Ref obj)
 {
-  MRG mrg = MustBeA(MRGPool, pool);
-  Arena arena = PoolArena(pool);
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
   Ring node, nextNode;
   Count nGuardians;       /* guardians per seg */
 
-  /* Can't check obj */
-
   nGuardians = MRGGuardiansPerSeg(mrg);
 
   /* map over the segments */
@@ -807,6 +1087,58 @@ Res MRGDeregister(Pool pool, Ref obj)
 }
 
 
+/* MRGDeregister -- deregister (once) an object for finalization
+ *
+ * Looks up the object in the index, which takes constant time
+ * except when the index must be rebuilt. See
+ * <design/poolmrg/#index>.
+ */
+
+Res MRGDeregister(Pool pool, Ref obj)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Arena arena = PoolArena(pool);
+  TableValue value;
+  Link link;
+  RefPart refPart;
+  Res res;
+
+  /* Can't check obj */
+
+  if (!mrgIndexReady(mrg))
+    return mrgDeregisterSearch(mrg, obj);
+
+  if (!TableLookup(&value, mrg->index, (TableKey)obj)) {
+    /* <design/poolmrg/#index.flipped> */
+    if (arena->flippedTraces == TraceSetEMPTY
+        || !mrgIndexFlipped(mrg, obj))
+      return ResFAIL;
+    if (!mrg->indexValid)
+      return mrgDeregisterSearch(mrg, obj);
+    if (!TableLookup(&value, mrg->index, (TableKey)obj))
+      return ResFAIL;
+  }
+  link = value;
+  AVER(link->state == MRGGuardianPREFINAL);
+  refPart = MRGRefPartOfLink(link, arena);
+  AVER_CRITICAL(MRGRefPartRef(arena, refPart) == obj);
+
+  if (link->next != NULL) {
+    res = TableRedefine(mrg->index, (TableKey)obj, link->next);
+  } else {
+    res = TableRemove(mrg->index, (TableKey)obj);
+    ++mrg->indexRemoved;
+  }
+  AVER(res == ResOK);
+  link->next = NULL;
+
+  RingRemove(&link->the.linkRing);
+  RingFinish(&link->the.linkRing);
+  MRGGuardianInit(mrg, link, refPart);
+  return ResOK;
+}
+
+
 /* MRGDescribe -- describe an MRG pool
  *
  * This could be improved by implementing MRGSegDescribe
@@ -855,6 +1187,11 @@ static Res MRGDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
       return res;
   }
 
+  /* Reading the references may have fixed some of them without
+   * updating their keys in the index. See <design/poolmrg/#index.flipped>. */
+  if (arena->flippedTraces != TraceSetEMPTY)
+    mrg->indexValid = FALSE;
+
   return ResOK;
 }
 
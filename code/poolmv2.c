@@ -41,6 +41,7 @@ static void MVTFree(Pool pool, Addr base, Size size);
 static Res MVTDescribe(Inst inst, mps_lib_FILE *stream, Count depth);
 static Size MVTTotalSize(Pool pool);
 static Size MVTFreeSize(Pool pool);
+static void MVTFreeWalk(Pool pool, FreeBlockVisitor f, void *p);
 static Res MVTSegAlloc(Seg *segReturn, MVT mvt, Size size);
 
 static void MVTSegFree(MVT mvt, Seg seg);
@@ -149,6 +150,7 @@ DEFINE_CLASS(Pool, MVTPool, klass)
   klass->bufferEmpty = MVTBufferEmpty;
   klass->totalSize = MVTTotalSize;
   klass->freeSize = MVTFreeSize;
+  klass->freewalk = MVTFreeWalk;
   AVERT(PoolClass, klass);
 }
 
@@ -508,6 +510,7 @@ static Res MVTOversizeFill(Addr *baseReturn,
 
   alignedSize = SizeArenaGrains(minSize, PoolArena(MVTPool(mvt)));
 
+  PoolFreeLog(MVTPool(mvt), minSize);
   res = MVTSegAlloc(&seg, mvt, alignedSize);
   if (res != ResOK)
     return res;
@@ -673,6 +676,7 @@ static Res MVTSegFill(Addr *baseReturn, Addr *limitReturn,
   Seg seg;
   Addr base, limit;
 
+  PoolFreeLog(MVTPool(mvt), minSize);
   res = MVTSegAlloc(&seg, mvt, fillSize);
   if (res != ResOK)
     return res;
@@ -1024,6 +1028,48 @@ static Size MVTFreeSize(Pool pool)
 }
 
 
+/* MVTFreeWalk -- walk the free blocks in the pool
+ *
+ * The free blocks are those in the free land and the splinter. Blocks
+ * in the ABQ are also in the free land, so they are not visited
+ * separately. Memory lost to fragmentation (see MVTOversizeFill) is
+ * not in any block, and is not visited.
+ */
+
+typedef struct MVTFreeWalkClosureStruct {
+  Pool pool;
+  FreeBlockVisitor f;
+  void *p;
+} MVTFreeWalkClosureStruct, *MVTFreeWalkClosure;
+
+static Bool MVTFreeWalkVisitor(Land land, Range range, void *closure)
+{
+  MVTFreeWalkClosure cl = closure;
+  AVERT(Land, land);
+  cl->f(RangeBase(range), RangeLimit(range), cl->pool, cl->p);
+  return TRUE;
+}
+
+static void MVTFreeWalk(Pool pool, FreeBlockVisitor f, void *p)
+{
+  MVT mvt;
+  MVTFreeWalkClosureStruct clStruct;
+
+  AVERT(Pool, pool);
+  mvt = PoolMVT(pool);
+  AVERT(MVT, mvt);
+  AVER(FUNCHECK(f));
+  /* p is arbitrary, hence can't be checked. */
+
+  clStruct.pool = pool;
+  clStruct.f = f;
+  clStruct.p = p;
+  (void)LandIterate(MVTFreeLand(mvt), MVTFreeWalkVisitor, &clStruct);
+  if (mvt->splinter)
+    f(mvt->splinterBase, mvt->splinterLimit, pool, p);
+}
+
+
 /* MVTDescribe -- describe an MVT pool */
 
 static Res MVTDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
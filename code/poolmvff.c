@@ -201,6 +201,7 @@ static Res MVFFExtend(Range rangeReturn, MVFF mvff, Size size)
 
   allocSize = SizeArenaGrains(allocSize, arena);
 
+  PoolFreeLog(pool, size);
   res = ArenaAlloc(&base, MVFFLocusPref(mvff), allocSize, pool);
   if (res != ResOK) {
     /* try again with a range just large enough for object */
@@ -630,6 +631,40 @@ static Size MVFFFreeSize(Pool pool)
 }
 
 
+/* MVFFFreeWalk -- walk the free blocks in the pool */
+
+typedef struct MVFFFreeWalkClosureStruct {
+  Pool pool;
+  FreeBlockVisitor f;
+  void *p;
+} MVFFFreeWalkClosureStruct, *MVFFFreeWalkClosure;
+
+static Bool mvffFreeWalkVisitor(Land land, Range range, void *closure)
+{
+  MVFFFreeWalkClosure cl = closure;
+  AVERT(Land, land);
+  cl->f(RangeBase(range), RangeLimit(range), cl->pool, cl->p);
+  return TRUE;
+}
+
+static void MVFFFreeWalk(Pool pool, FreeBlockVisitor f, void *p)
+{
+  MVFF mvff;
+  MVFFFreeWalkClosureStruct clStruct;
+
+  AVERT(Pool, pool);
+  mvff = PoolMVFF(pool);
+  AVERT(MVFF, mvff);
+  AVER(FUNCHECK(f));
+  /* p is arbitrary, hence can't be checked. */
+
+  clStruct.pool = pool;
+  clStruct.f = f;
+  clStruct.p = p;
+  (void)LandIterate(MVFFFreeLand(mvff), mvffFreeWalkVisitor, &clStruct);
+}
+
+
 /* MVFFDescribe -- describe an MVFF pool */
 
 static Res MVFFDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
@@ -693,6 +728,7 @@ DEFINE_CLASS(Pool, MVFFPool, klass)
   klass->bufferFill = MVFFBufferFill;
   klass->totalSize = MVFFTotalSize;
   klass->freeSize = MVFFFreeSize;
+  klass->freewalk = MVFFFreeWalk;
   AVERT(PoolClass, klass);
 }
 
@@ -0,0 +1,101 @@
+/* probe.h: STATIC PROBE INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Statically defined tracing probes let external tools such
+ * as perf, bpftrace and SystemTap attach to the MPS at places where it
+ * may cause latency, without enabling the telemetry stream (see
+ * <code/event.h>).  They are compiled in if CONFIG_PROBE_SDT is defined
+ * (see <code/config.h>) and otherwise expand to nothing.
+ *
+ * .cost: A probe is a single no-op instruction and a note in the
+ * object file describing where to find its arguments, so probes may
+ * be left in hot-variety builds.  The arguments are evaluated only if
+ * CONFIG_PROBE_SDT is defined, so they must not have side effects.
+ *
+ * .args: Arguments must be integers or pointers: <sys/sdt.h> passes
+ * them in registers or memory operands and does not support floating
+ * point.  The note for each probe site records the size and
+ * signedness of its arguments, so every site of a probe should pass
+ * arguments of the same types (cast constants, for example).
+ *
+ * .names: All probes belong to the "mps" provider, so they appear in
+ * "perf list" as sdt_mps:<name> once the library has been added with
+ * "perf buildid-cache --add".  The probes are listed in the manual
+ * (see manual/source/topic/telemetry.rst).
+ */
+
+#ifndef probe_h
+#define probe_h
+
+#include "config.h"
+#include "misc.h"
+
+
+#if defined(PROBE_SDT)
+
+#include <sys/sdt.h>
+
+#define PROBE0(name)                 DTRACE_PROBE(mps, name)
+#define PROBE1(name, p1)             DTRACE_PROBE1(mps, name, p1)
+#define PROBE2(name, p1, p2)         DTRACE_PROBE2(mps, name, p1, p2)
+#define PROBE3(name, p1, p2, p3)     DTRACE_PROBE3(mps, name, p1, p2, p3)
+
+#elif defined(PROBE_NONE)
+
+#define PROBE0(name)                 NOOP
+#define PROBE1(name, p1)             NOOP
+#define PROBE2(name, p1, p2)         NOOP
+#define PROBE3(name, p1, p2, p3)     NOOP
+
+#else
+
+#error "No static probe configuration."
+
+#endif
+
+
+#endif /* probe_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,501 @@
+/* profile.c: SAMPLING ALLOCATION PROFILER
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Attribute allocation in automatically managed pools to the
+ * client code that did it, by recording the stack and class of a
+ * sample of the objects allocated through allocation points, and
+ * tracking which of the sampled objects survive collection.
+ *
+ * .design: See <design/profile/>.  The buffer module decides which
+ * objects to sample (see <code/buffer.c#sample>); this module keeps
+ * the table of samples.
+ */
+
+#include "mpm.h"
+
+SRCID(profile, "$Id$");
+
+
+/* Sample states -- see <design/profile/#state> */
+
+enum {
+  ProfileSampleFREE,            /* unused */
+  ProfileSamplePENDING,         /* object reserved but not committed */
+  ProfileSampleCOMMITTED        /* object committed; may have died */
+};
+
+
+Bool ProfileCheck(Profile profile)
+{
+  CHECKS(Profile, profile);
+  CHECKU(Arena, profile->arena);
+  CHECKL(profile->interval > 0);
+  CHECKL(profile->length > 0);
+  CHECKL(profile->next < profile->length);
+  CHECKL(profile->refs != NULL);
+  CHECKL(profile->samples != NULL);
+  /* stack and stackClosure can't be checked */
+  return TRUE;
+}
+
+
+/* ProfileStart -- start sampling allocation in an arena
+ *
+ * If the arena is already being profiled, the existing samples are
+ * discarded.
+ */
+
+Res ProfileStart(Arena arena, Size interval, Count length,
+                 ProfileStackMethod stack, void *closure)
+{
+  Profile profile;
+  Ref *refs;
+  ProfileSample samples;
+  void *p;
+  Index i;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(interval > 0);
+  AVER(interval <= SizeMAX / 2);
+  AVER(length > 0);
+
+  if (length > SizeMAX / sizeof(ProfileSampleStruct))
+    return ResRESOURCE;
+
+  res = ControlAlloc(&p, arena, sizeof(ProfileStruct));
+  if (res != ResOK)
+    goto failProfile;
+  profile = p;
+  res = ControlAlloc(&p, arena, length * sizeof(Ref));
+  if (res != ResOK)
+    goto failRefs;
+  refs = p;
+  res = ControlAlloc(&p, arena, length * sizeof(ProfileSampleStruct));
+  if (res != ResOK)
+    goto failSamples;
+  samples = p;
+
+  for (i = 0; i < length; ++i) {
+    refs[i] = (Ref)0;
+    samples[i].state = ProfileSampleFREE;
+    samples[i].buffer = NULL;
+  }
+
+  profile->arena = arena;
+  profile->interval = interval;
+  profile->length = length;
+  profile->next = 0;
+  profile->stack = stack;
+  profile->stackClosure = closure;
+  profile->refs = refs;
+  profile->samples = samples;
+  profile->sampled = 0;
+  profile->dropped = 0;
+  profile->sig = ProfileSig;
+  AVERT(Profile, profile);
+
+  ProfileStop(arena);
+  arena->profile = profile;
+  return ResOK;
+
+failSamples:
+  ControlFree(arena, refs, length * sizeof(Ref));
+failRefs:
+  ControlFree(arena, profile, sizeof(ProfileStruct));
+failProfile:
+  return res;
+}
+
+
+/* ProfileStop -- stop sampling allocation and discard the samples
+ *
+ * Buffers that have a sample reserved notice that the profile has
+ * gone when the object is committed.  See <design/profile/#stop>.
+ */
+
+void ProfileStop(Arena arena)
+{
+  Profile profile;
+
+  AVERT(Arena, arena);
+
+  profile = ArenaProfile(arena);
+  if (profile == NULL)
+    return;
+  AVERT(Profile, profile);
+
+  arena->profile = NULL;
+  profile->sig = SigInvalid;
+  ControlFree(arena, profile->samples,
+              profile->length * sizeof(ProfileSampleStruct));
+  ControlFree(arena, profile->refs, profile->length * sizeof(Ref));
+  ControlFree(arena, profile, sizeof(ProfileStruct));
+}
+
+
+/* ProfileInterval -- choose number of bytes to allocate before next sample
+ *
+ * The interval is uniformly distributed between 1 and twice the mean
+ * interval, so that sampling doesn't fall into step with a regular
+ * allocation pattern.
+ */
+
+Size ProfileInterval(Profile profile)
+{
+  AVERT(Profile, profile);
+  return 1 + (Size)(RandomWord() % (2 * profile->interval - 1));
+}
+
+
+/* ProfileReserve -- start a sample of an object being reserved
+ *
+ * Find an unused sample, or one whose object has died, and record the
+ * size of the object and the client's stack.  Return FALSE if there
+ * is no room in the table.
+ */
+
+Bool ProfileReserve(Index *indexReturn, Profile profile, Buffer buffer,
+                    Size size)
+{
+  Index i, n;
+
+  AVER(indexReturn != NULL);
+  AVERT(Profile, profile);
+  AVERT(Buffer, buffer);
+  AVER(size > 0);
+
+  for (n = 0; n < profile->length; ++n) {
+    ProfileSample sample;
+    i = (profile->next + n) % profile->length;
+    sample = &profile->samples[i];
+    if (sample->state == ProfileSampleFREE
+        || (sample->state == ProfileSampleCOMMITTED
+            && profile->refs[i] == (Ref)0))
+    {
+      sample->state = ProfileSamplePENDING;
+      sample->buffer = buffer;
+      sample->size = size;
+      sample->klass = (Addr)0;
+      sample->traces = 0;
+      sample->depth = 0;
+      if (profile->stack != NULL) {
+        sample->depth = (*profile->stack)(sample->stack, ProfileDEPTH,
+                                          profile->stackClosure);
+        AVER(sample->depth <= ProfileDEPTH);
+      }
+      profile->refs[i] = (Ref)0;
+      profile->next = (i + 1) % profile->length;
+      *indexReturn = i;
+      return TRUE;
+    }
+  }
+
+  ++profile->dropped;
+  return FALSE;
+}
+
+
+/* ProfileCommit -- finish the sample of a committed object
+ *
+ * ref is the client pointer to the object.  The sample is ignored if
+ * it doesn't belong to the buffer, which happens if profiling was
+ * restarted while the object was reserved.
+ */
+
+void ProfileCommit(Profile profile, Index index, Buffer buffer,
+                   Addr ref, Addr klass)
+{
+  ProfileSample sample;
+
+  AVERT(Profile, profile);
+  AVERT(Buffer, buffer);
+  AVER(ref != (Addr)0);
+
+  if (index >= profile->length)
+    return;
+  sample = &profile->samples[index];
+  if (sample->state != ProfileSamplePENDING || sample->buffer != buffer)
+    return;
+
+  sample->state = ProfileSampleCOMMITTED;
+  sample->buffer = NULL;
+  sample->klass = klass;
+  sample->traces = profile->arena->traceStats.traces;
+  profile->refs[index] = (Ref)ref;
+  ++profile->sampled;
+}
+
+
+/* ProfileCancel -- abandon the sample of an object that wasn't committed */
+
+void ProfileCancel(Profile profile, Index index, Buffer buffer)
+{
+  ProfileSample sample;
+
+  AVERT(Profile, profile);
+  AVERT(Buffer, buffer);
+
+  if (index >= profile->length)
+    return;
+  sample = &profile->samples[index];
+  if (sample->state == ProfileSamplePENDING && sample->buffer == buffer) {
+    sample->state = ProfileSampleFREE;
+    sample->buffer = NULL;
+  }
+}
+
+
+/* ProfileScan -- fix the references to the sampled objects
+ *
+ * Called by the tracer with a weak scan state after all strong
+ * references have been found, so that references to dead objects
+ * are replaced by null.  See <design/profile/#weak>.
+ */
+
+Res ProfileScan(ScanState ss, Profile profile)
+{
+  AVERT(ScanState, ss);
+  AVERT(Profile, profile);
+  AVER(ss->rank == RankWEAK);
+
+  return TraceScanArea(ss, (Word *)profile->refs,
+                       (Word *)(profile->refs + profile->length),
+                       mps_scan_area, NULL);
+}
+
+
+/* profileFinishTraces -- finish any trace that has flipped
+ *
+ * See <design/profile/#finish>.
+ */
+
+static void profileFinishTraces(Profile profile)
+{
+  Arena arena = profile->arena;
+  Globals globals = ArenaGlobals(arena);
+  Bool clamped;
+
+  if (arena->flippedTraces == TraceSetEMPTY)
+    return;
+
+  clamped = globals->clamped;
+  ArenaPark(globals);
+  globals->clamped = clamped;
+}
+
+
+/* ProfileWalk -- call visitor for each committed sample */
+
+void ProfileWalk(Profile profile, mps_profile_visitor_t visitor,
+                 void *closure)
+{
+  Index i;
+
+  AVERT(Profile, profile);
+  AVER(FUNCHECK(visitor));
+
+  profileFinishTraces(profile);
+  for (i = 0; i < profile->length; ++i) {
+    ProfileSample sample = &profile->samples[i];
+    if (sample->state == ProfileSampleCOMMITTED)
+      (*visitor)((mps_addr_t)profile->refs[i], (size_t)sample->size,
+                 (mps_addr_t)sample->klass,
+                 (size_t)(profile->arena->traceStats.traces
+                          - sample->traces),
+                 sample->stack, (size_t)sample->depth, closure);
+  }
+}
+
+
+/* profileStackCompare -- compare the stacks of two samples */
+
+static Compare profileStackCompare(ProfileSample a, ProfileSample b)
+{
+  Index i;
+
+  if (a->depth != b->depth)
+    return a->depth < b->depth ? CompareLESS : CompareGREATER;
+  for (i = 0; i < a->depth; ++i)
+    if (a->stack[i] != b->stack[i])
+      return a->stack[i] < b->stack[i] ? CompareLESS : CompareGREATER;
+  return CompareEQUAL;
+}
+
+
+/* profileCompare -- order samples by stack, for ProfileWrite
+ *
+ * QuickSort requires that only identical elements compare equal, so
+ * samples with the same stack are ordered by their position in the
+ * table.
+ */
+
+static Compare profileCompare(void *left, void *right, void *closure)
+{
+  ProfileSample a = left, b = right;
+  Compare cmp;
+
+  UNUSED(closure);
+
+  cmp = profileStackCompare(a, b);
+  if (cmp != CompareEQUAL || a == b)
+    return cmp;
+  return a < b ? CompareLESS : CompareGREATER;
+}
+
+
+/* profileWriteAddress -- write a stack frame address for pprof
+ *
+ * The pprof tool requires lower case hexadecimal, which WriteF
+ * doesn't produce.
+ */
+
+static Res profileWriteAddress(mps_lib_FILE *stream, Word w)
+{
+  static const char digit[16 + 1] = "0123456789abcdef";
+  char buf[MPS_WORD_WIDTH / 4 + 4];
+  Index i = sizeof buf - 1;
+
+  buf[i] = '\0';
+  do {
+    buf[--i] = digit[w % 16];
+    w /= 16;
+  } while (w > 0);
+  buf[--i] = 'x';
+  buf[--i] = '0';
+  buf[--i] = ' ';
+  if (mps_lib_fputs(&buf[i], stream) == mps_lib_EOF)
+    return ResIO;
+  return ResOK;
+}
+
+
+/* ProfileWrite -- write the samples as a heap profile for pprof
+ *
+ * See <design/profile/#write> for the format.
+ */
+
+Res ProfileWrite(Profile profile, mps_lib_FILE *stream)
+{
+  Arena arena;
+  void **array;
+  void *p;
+  Count count = 0, live = 0;
+  Index i, j, k;
+  Size size = 0, liveSize = 0;
+  Res res;
+
+  AVERT(Profile, profile);
+  AVER(stream != NULL);
+
+  profileFinishTraces(profile);
+  arena = profile->arena;
+  res = ControlAlloc(&p, arena, profile->length * sizeof(void *));
+  if (res != ResOK)
+    return res;
+  array = p;
+
+  for (i = 0; i < profile->length; ++i) {
+    ProfileSample sample = &profile->samples[i];
+    if (sample->state == ProfileSampleCOMMITTED) {
+      array[count] = sample;
+      ++count;
+      size += sample->size;
+      if (profile->refs[i] != (Ref)0) {
+        ++live;
+        liveSize += sample->size;
+      }
+    }
+  }
+  QuickSort(array, count, profileCompare, NULL, &profile->sortStruct);
+
+  res = WriteF(stream, 0,
+               "heap profile: $U: $U [$U: $U] @ heap_v2/$U\n",
+               (WriteFU)live, (WriteFU)liveSize,
+               (WriteFU)count, (WriteFU)size,
+               (WriteFU)profile->interval,
+               NULL);
+  if (res != ResOK)
+    goto failWrite;
+
+  /* Write one line for each distinct stack. */
+  for (i = 0; i < count; i = j) {
+    ProfileSample first = array[i];
+    live = 0;
+    liveSize = 0;
+    size = 0;
+    for (j = i;
+         j < count && profileStackCompare(first, array[j]) == CompareEQUAL;
+         ++j)
+    {
+      ProfileSample sample = array[j];
+      size += sample->size;
+      if (profile->refs[sample - profile->samples] != (Ref)0) {
+        ++live;
+        liveSize += sample->size;
+      }
+    }
+    res = WriteF(stream, 0, "$U: $U [$U: $U] @",
+                 (WriteFU)live, (WriteFU)liveSize,
+                 (WriteFU)(j - i), (WriteFU)size,
+                 NULL);
+    if (res != ResOK)
+      goto failWrite;
+    for (k = 0; k < first->depth; ++k) {
+      res = profileWriteAddress(stream, first->stack[k]);
+      if (res != ResOK)
+        goto failWrite;
+    }
+    res = WriteF(stream, 0, "\n", NULL);
+    if (res != ResOK)
+      goto failWrite;
+  }
+
+failWrite:
+  ControlFree(arena, array, profile->length * sizeof(void *));
+  return res;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,278 @@
+/* proftest.c: SAMPLING ALLOCATION PROFILER TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Allocate objects from two "sites", keeping the objects from one
+ * site alive and dropping those from the other, then collect and
+ * check that the samples attribute the objects to the right site and
+ * that only the samples from the kept site survive.  See
+ * <design/profile/>.
+ */
+
+#include "mps.h"
+#include "mpsavm.h"
+#include "mpscamc.h"
+#include "mpscams.h"
+#include "mpslib.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+
+
+#define testArenaSIZE   ((size_t)16 << 20)
+#define keepCOUNT       2000
+#define dropCOUNT       20000
+#define slotsMAX        32
+#define sampleINTERVAL  ((size_t)4096)
+#define sampleCOUNT     4096
+#define siteKEEP        ((mps_word_t)0x1000)
+#define siteDROP        ((mps_word_t)0x2000)
+#define siteCALLER      ((mps_word_t)0xabc0)
+
+static mps_gen_param_s testChain[1] = {{ 1024, 0.9 }};
+static mps_word_t site;            /* site of current allocation */
+static unsigned long stackCalls;   /* calls to stack function */
+static mps_addr_t kept[keepCOUNT]; /* objects kept alive */
+
+
+/* stack -- report the site as the stack of the allocation */
+
+static size_t stack(mps_word_t *pcs, size_t depth, void *closure)
+{
+  Insist(closure == &stackCalls);
+  Insist(depth >= 2);
+  ++stackCalls;
+  pcs[0] = site;
+  pcs[1] = siteCALLER;
+  return 2;
+}
+
+
+/* Totals of samples found by visit */
+
+typedef struct totals_s {
+  size_t keepLive, keepDead, dropLive, dropDead;
+  size_t bytes;
+} totals_s;
+
+
+/* visit -- check one sample and add it to the totals */
+
+static void visit(mps_addr_t addr, size_t size, mps_addr_t klass,
+                  size_t age, const mps_word_t *pcs, size_t depth,
+                  void *closure)
+{
+  totals_s *totals = closure;
+
+  Insist(depth == 2);
+  Insist(pcs[1] == siteCALLER);
+  Insist(size >= 2 * sizeof(mps_word_t));
+  Insist(size <= (slotsMAX + 2) * sizeof(mps_word_t));
+  Insist(klass != NULL);
+  Insist(age >= 1); /* there has been a collection since */
+  totals->bytes += size;
+
+  if (pcs[0] == siteKEEP) {
+    if (addr == NULL) {
+      ++totals->keepDead;
+    } else {
+      size_t i;
+      for (i = 0; i < keepCOUNT; ++i)
+        if (kept[i] == addr)
+          break;
+      Insist(i < keepCOUNT);
+      Insist(*(mps_addr_t *)addr == klass);
+      ++totals->keepLive;
+    }
+  } else {
+    Insist(pcs[0] == siteDROP);
+    if (addr == NULL)
+      ++totals->dropDead;
+    else
+      ++totals->dropLive;
+  }
+}
+
+
+/* make -- allocate a vector at a site */
+
+static mps_addr_t make(mps_ap_t ap, mps_word_t s, size_t *bytesIO)
+{
+  size_t slots = rnd() % (slotsMAX + 1);
+  mps_word_t v;
+
+  site = s;
+  die(make_dylan_vector(&v, ap, slots), "make_dylan_vector");
+  *bytesIO += (slots + 2) * sizeof(mps_word_t);
+  return (mps_addr_t)v;
+}
+
+
+/* test -- profile allocation in one pool class */
+
+static void test(mps_arena_t arena, mps_pool_class_t pool_class)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  mps_arena_stats_s before, profiled, after;
+  totals_s totals = {0, 0, 0, 0, 0}, flipped = {0, 0, 0, 0, 0};
+  size_t bytes = 0, samples, expected;
+  size_t i, k = 0;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, 1, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, pool_class, args), "pool_create");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&ap, pool, mps_args_none), "ap_create");
+
+  for (i = 0; i < keepCOUNT; ++i)
+    kept[i] = NULL;
+  die(mps_root_create_table(&root, arena, mps_rank_exact(), 0,
+                            kept, keepCOUNT), "root_create_table");
+
+  stackCalls = 0;
+  die(mps_arena_profile_start(arena, sampleINTERVAL, sampleCOUNT,
+                              stack, &stackCalls),
+      "mps_arena_profile_start");
+
+  /* Interleave kept and dropped objects so that both sites share
+     segments. */
+  for (i = 0; i < dropCOUNT; ++i) {
+    (void)make(ap, siteDROP, &bytes);
+    if (i % (dropCOUNT / keepCOUNT) == 0 && k < keepCOUNT) {
+      kept[k] = make(ap, siteKEEP, &bytes);
+      ++k;
+    }
+  }
+  site = 0;
+
+  mps_arena_collect(arena);
+  mps_arena_profile_walk(arena, visit, &totals);
+
+  samples = totals.keepLive + totals.keepDead
+    + totals.dropLive + totals.dropDead;
+  expected = bytes / sampleINTERVAL;
+  printf("allocated %lu bytes, expected %lu samples\n",
+         (unsigned long)bytes, (unsigned long)expected);
+  printf("kept site: %lu live, %lu dead\n",
+         (unsigned long)totals.keepLive, (unsigned long)totals.keepDead);
+  printf("dropped site: %lu live, %lu dead\n",
+         (unsigned long)totals.dropLive, (unsigned long)totals.dropDead);
+
+  Insist(stackCalls >= samples);
+  Insist(samples > expected / 2);
+  Insist(samples < expected * 2);
+  Insist(totals.keepLive > 0);
+  Insist(totals.keepDead == 0);
+  /* A few dropped objects may be kept alive by ambiguous references. */
+  Insist(totals.dropDead > totals.dropLive);
+
+  die(mps_arena_profile_write(arena, mps_lib_get_stdout()),
+      "mps_arena_profile_write");
+
+  /* Walk again between the flip and the reclaim of a collection: the
+     kept objects must be found at their new addresses.  See
+     <design/profile/#finish>. */
+  mps_arena_start_collect(arena);
+  mps_arena_profile_walk(arena, visit, &flipped);
+  Insist(flipped.keepLive == totals.keepLive);
+  Insist(flipped.keepDead == 0);
+  mps_arena_park(arena);
+
+  /* The profile is not a root, so the same roots are scanned with
+     and without it.  See <design/profile/#weak>. */
+  mps_arena_stats(arena, &before);
+  mps_arena_collect(arena);
+  mps_arena_stats(arena, &profiled);
+  mps_arena_profile_stop(arena);
+  mps_arena_collect(arena);
+  mps_arena_stats(arena, &after);
+  Insist(profiled.root_scans - before.root_scans
+         == after.root_scans - profiled.root_scans);
+
+  mps_root_destroy(root);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+  mps_root_t stackRoot;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackRoot, arena, thread, &arena),
+      "root_create_thread");
+
+  test(arena, mps_class_amc());
+  test(arena, mps_class_ams());
+
+  mps_root_destroy(stackRoot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -1,59 +1,50 @@
 /* replay.c: Allocation replayer
- * Copyright (c) 2001-2014 Ravenbrook Limited.  See end of file for license.
+ * Copyright (c) 2001-2026 Ravenbrook Limited.  See end of file for license.
  *
  * $Id$
+ *
+ * Reads a telemetry stream and replays the allocation it records
+ * against a fresh arena, reporting the time taken and the memory
+ * used.  See <design/telemetry/#replay> and "Replaying allocation" in
+ * the Telemetry chapter of the reference manual.
  */
 
 #include "config.h"
-/* override variety setting for EVENT */
-#define EVENT
-
+#include "eventdef.h"
 #include "eventcom.h"
-#include "eventpro.h"
 #include "eventrep.h"
-#include "mpmtypes.h"
 
 #include <stddef.h> /* for size_t */
 #include <stdio.h> /* for printf */
 #include <stdarg.h> /* for va_list */
 #include <stdlib.h> /* for EXIT_FAILURE */
 #include <string.h> /* for strcmp */
+#include <time.h> /* for clock */
 #include "mpstd.h"
 
-
-#if defined(MPS_OS_W3) && defined(MPS_ARCH_I6)
-#define PRIuLONGEST "llu"
-#define PRIXPTR     "016llX"
-typedef unsigned long long ulongest_t;
-#else
-#define PRIuLONGEST "lu"
-#define PRIXPTR     "08lX"
-typedef unsigned long ulongest_t;
-#endif
-
-
-typedef unsigned long ulong;
+#define DEFAULT_TELEMETRY_FILENAME "mpsio.log"
+#define TELEMETRY_FILENAME_ENVAR   "MPS_TELEMETRY_FILENAME"
 
 
 /* command-line arguments */
 
-static char *prog; /* program name */
-
-
-/* Globals */
+static const char *prog; /* program name */
+static EventRepClass replayClass = EventRepClassLOG;
+static size_t arenaSize = 0;
+static size_t commitLimit = 0;
+static size_t extendBy = 0;
+static size_t spareCommitLimit = 0;
 
-static Word eventTime = 0; /* current event time */
 
-
-/* error -- error signalling */
+/* everror -- flush stdout, message to stderr, exit */
 
 ATTRIBUTE_FORMAT((printf, 1, 2))
-static void error(const char *format, ...)
+static void everror(const char *format, ...)
 {
   va_list args;
 
   fflush(stdout); /* sync */
-  fprintf(stderr, "%s: @%"PRIuLONGEST" ", prog, (ulongest_t)eventTime);
+  fprintf(stderr, "%s: ", prog);
   va_start(args, format);
   vfprintf(stderr, format, args);
   fprintf(stderr, "\n");
@@ -67,8 +58,9 @@ static void error(const char *format, ...)
 static void usage(void)
 {
   fprintf(stderr,
-          "Usage: %s [-f logfile] [-p] [-?]\n"
-          "See guide.mps.telemetry for instructions.\n",
+          "Usage: %s [-f logfile] [-p mvff|mvt] [-a arenasize] "
+          "[-l commitlimit] [-e extendby] [-s sparecommitlimit] [-h]\n"
+          "See \"Telemetry\" in the reference manual for instructions.\n",
           prog);
 }
 
@@ -78,7 +70,19 @@ static void usage(void)
 static void usageError(void)
 {
   usage();
-  error("Bad usage");
+  everror("Bad usage");
+}
+
+
+/* parseSize -- parse a size argument */
+
+static size_t parseSize(const char *arg)
+{
+  char *end;
+  unsigned long n = strtoul(arg, &end, 10);
+  if (end == arg || *end != '\0' || n == 0)
+    usageError();
+  return (size_t)n;
 }
 
 
@@ -86,14 +90,14 @@ static void usageError(void)
 
 static char *parseArgs(int argc, char *argv[])
 {
-  char *name = "mpsio.log";
+  char *name = NULL;
   int i = 1;
- 
+
   if (argc >= 1)
     prog = argv[0];
   else
     prog = "unknown";
- 
+
   while (i < argc) { /* consider argument i */
     if (argv[i][0] == '-') { /* it's an option argument */
       switch (argv[i][1]) {
@@ -101,12 +105,51 @@ static char *parseArgs(int argc, char *argv[])
         ++ i;
         if (i == argc)
           usageError();
-        else  
+        else
           name = argv[i];
-        break;  
+        break;
+      case 'p': /* pool class */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else if (strcmp(argv[i], "mvff") == 0)
+          replayClass = EventRepClassMVFF;
+        else if (strcmp(argv[i], "mvt") == 0)
+          replayClass = EventRepClassMVT;
+        else
+          usageError();
+        break;
+      case 'a': /* arena size */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          arenaSize = parseSize(argv[i]);
+        break;
+      case 'l': /* commit limit */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          commitLimit = parseSize(argv[i]);
+        break;
+      case 'e': /* MVFF extendBy */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          extendBy = parseSize(argv[i]);
+        break;
+      case 's': /* spare commit limit */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          spareCommitLimit = parseSize(argv[i]);
+        break;
       case '?': case 'h': /* help */
         usage();
-        break;
+        exit(EXIT_SUCCESS);
       default:
         usageError();
       }
@@ -117,38 +160,83 @@ static char *parseArgs(int argc, char *argv[])
 }
 
 
-/* readLog -- read and parse log */
-
+/* readLog -- read the whole log into memory */
 
-static void readLog(EventProc proc)
+static char *readLog(size_t *sizeReturn, FILE *stream)
 {
-  while (TRUE) {
-    Event event;
-    Res res;
-
-    res = EventRead(&event, proc);
-    if (res == ResFAIL)
-      break; /* eof */
-    if (res != ResOK)
-      error("Truncated log");
-    eventTime = event->any.clock;
-    EventRecord(proc, event, eventTime);
-    EventReplay(event, eventTime);
-    EventDestroy(proc, event);
+  char *log = NULL;
+  size_t size = 0, capacity = 0;
+
+  for (;;) {
+    size_t n;
+    if (size == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 20 : capacity * 2;
+      log = realloc(log, capacity);
+      if (log == NULL)
+        everror("Out of memory for log");
+    }
+    n = fread(log + size, 1, capacity - size, stream);
+    size += n;
+    if (size < capacity) {
+      if (ferror(stream))
+        everror("I/O error reading log");
+      break;
+    }
   }
+  *sizeReturn = size;
+  return log;
 }
 
 
-/* logReader -- reader function for a file log */
+/* Event index
+ *
+ * Events are replayed in timestamp order, not in the order they
+ * appear in the log.  See <design/telemetry/#replay.order>.
+ */
 
-static FILE *input;
+typedef struct EventIndexStruct {
+  EventClock clock;     /* timestamp of event */
+  size_t offset;        /* position of event in log */
+} EventIndexStruct, *EventIndex;
 
-static Res logReader(void *file, void *p, size_t len)
+static int indexCompare(const void *a, const void *b)
 {
-  size_t n;
+  const EventIndexStruct *ia = a, *ib = b;
+  if (ia->clock != ib->clock)
+    return ia->clock < ib->clock ? -1 : 1;
+  if (ia->offset != ib->offset)
+    return ia->offset < ib->offset ? -1 : 1;
+  return 0;
+}
 
-  n = fread(p, 1, len, (FILE *)file);
-  return (n < len) ? (feof((FILE *)file) ? ResFAIL : ResIO) : ResOK;
+static EventIndex indexLog(size_t *countReturn, const char *log, size_t size)
+{
+  EventIndex index = NULL;
+  size_t count = 0, capacity = 0, pos = 0;
+
+  while (size - pos >= sizeof(EventAnyStruct)) {
+    EventAnyStruct any;
+    (void)memcpy(&any, log + pos, sizeof any);
+    if (any.size < sizeof any || any.size > sizeof(EventUnion))
+      everror("Corrupt log: invalid event size %u", (unsigned)any.size);
+    if (size - pos < any.size)
+      break;
+    if (count == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 16 : capacity * 2;
+      index = realloc(index, capacity * sizeof *index);
+      if (index == NULL)
+        everror("Out of memory for event index");
+    }
+    index[count].clock = any.clock;
+    index[count].offset = pos;
+    ++count;
+    pos += any.size;
+  }
+  if (pos != size)
+    everror("Truncated log");
+  qsort(index, count, sizeof *index, indexCompare);
+  *countReturn = count;
+  return index;
 }
 
 
@@ -156,39 +244,68 @@ static Res logReader(void *file, void *p, size_t len)
 
 int main(int argc, char *argv[])
 {
-  char *filename;
-  EventProc proc;
+  const char *filename;
+  FILE *input;
+  char *log;
+  size_t size, count, i;
+  EventIndex index;
+  clock_t start, finish;
   Res res;
 
-  filename = parseArgs(argc,argv);
+  filename = parseArgs(argc, argv);
+  if (!filename) {
+    filename = getenv(TELEMETRY_FILENAME_ENVAR);
+    if (!filename)
+      filename = DEFAULT_TELEMETRY_FILENAME;
+  }
 
   if (strcmp(filename, "-") == 0)
     input = stdin;
   else {
     input = fopen(filename, "rb");
     if (input == NULL)
-      error("unable to open \"%s\"\n", filename);
+      everror("unable to open \"%s\"", filename);
   }
-
-  res = EventProcCreate(&proc, logReader, (void *)input);
-  if (res != ResOK)
-    error("Can't init EventProc module: error %d.", res);
-
-  res = EventRepInit();
+  log = readLog(&size, input);
+  if (input != stdin)
+    (void)fclose(input);
+  index = indexLog(&count, log, size);
+
+  /* Ensure no telemetry output from the replay itself, which would
+     overwrite the log if it's the default. */
+  if (setenv("MPS_TELEMETRY_CONTROL", "0", 1) != 0)
+    everror("failed to set MPS_TELEMETRY_CONTROL");
+
+  res = EventRepInit(replayClass, arenaSize, commitLimit, extendBy,
+                     spareCommitLimit);
   if (res != ResOK)
-    error("Can't init EventRep module: error %d.", res);
-
-  readLog(proc);
+    everror("Can't init EventRep module: error %d.", res);
+
+  start = clock();
+  for (i = 0; i < count; ++i) {
+    EventUnion eventUnion;
+    EventAnyStruct any;
+    const char *p = log + index[i].offset;
+    (void)memcpy(&any, p, sizeof any);
+    (void)memcpy(&eventUnion, p, any.size);
+    EventReplay(&eventUnion);
+  }
+  finish = clock();
 
+  EventRepReport();
   EventRepFinish();
-  EventProcDestroy(proc);
+  printf("Replay time: %.3f s\n",
+         (double)(finish - start) / (double)CLOCKS_PER_SEC);
+
+  free(index);
+  free(log);
   return EXIT_SUCCESS;
 }
 
 
 /* C. COPYRIGHT AND LICENSE
  *
- * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * Copyright (C) 2001-2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
  * All rights reserved.  This is an open source license.  Contact
  * Ravenbrook for commercial licensing options.
  * 
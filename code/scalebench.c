@@ -0,0 +1,564 @@
+/* scalebench.c -- multi-threaded mutator scalability benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark runs the same mutator in 1, 2, 4, ... threads over a
+ * shared heap, each thread with its own allocation point, stack root
+ * and live set, and reports how allocation throughput, contention for
+ * the arena lock, barrier hits and flip time change with the number of
+ * threads.  Each thread does the same amount of work, so with perfect
+ * scaling the elapsed time would not change.  See
+ * <design/tests/#test.scale>.
+ */
+
+#define CONFIG_STATS_LOCK /* <design/arena/#lock.stats.config> */
+#include "mps.c"
+#include "testlib.h"
+#include "testthr.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "mpm.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, stderr */
+#include <stdlib.h> /* exit, EXIT_FAILURE, EXIT_SUCCESS, malloc, strtoul */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+#define RESMUST(expr) \
+  do { \
+    mps_res_t res = (expr); \
+    if (res != MPS_RES_OK) { \
+      fprintf(stderr, #expr " returned %d\n", res); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+static mps_arena_t arena;
+static mps_pool_t pool;
+static mps_fmt_t format;
+
+#define nthreadsLIMIT 256
+#define LINKS     4       /* references stored in each new object */
+
+static rnd_state_t seed = 0;      /* random number seed */
+static unsigned nthreads[nthreadsLIMIT] = {1, 2, 4, 8}; /* thread counts */
+static size_t ncounts = 4;        /* number of thread counts */
+static size_t live_size = 4ul * 1024 * 1024; /* live set per thread */
+static size_t total = 32ul * 1024 * 1024; /* to allocate per thread */
+static size_t maxslots = 16;      /* maximum slots in an object */
+static double pupdate = 0.5;      /* probability of updating an object */
+static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
+static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
+static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static mps_bool_t json = FALSE;   /* print results as JSON */
+
+typedef mps_word_t obj_t;
+
+static size_t committed_max;      /* peak committed memory, sampled */
+static double ticks_per_sec;      /* EVENT_CLOCK ticks per second */
+static volatile int go;           /* set when the threads may start */
+
+
+/* calibrate -- measure the rate of EVENT_CLOCK against clock()
+ *
+ * This is done before any mutator threads are started, so processor
+ * time is a fair proxy for elapsed time.
+ */
+
+static void calibrate(void)
+{
+  clock_t start, begin, end;
+  EventClock ticks_begin, ticks_end;
+
+  start = clock();
+  while ((begin = clock()) == start)
+    NOOP; /* wait for the clock to tick */
+  EVENT_CLOCK(ticks_begin);
+  while ((end = clock()) - begin < CLOCKS_PER_SEC / 10)
+    NOOP;
+  EVENT_CLOCK(ticks_end);
+  ticks_per_sec = (double)(ticks_end - ticks_begin) * CLOCKS_PER_SEC
+    / (double)(end - begin);
+}
+
+
+/* The state of each mutator thread. */
+
+typedef struct mutator_s {
+  testthr_t thread;
+  obj_t *live;                    /* this thread's live set */
+  size_t nlive;                   /* number of objects in live set */
+  mps_ap_t ap;
+  unsigned long rnd;              /* random number state */
+  volatile int ready;             /* live set built, waiting for go */
+  size_t allocated;               /* bytes allocated in timed part */
+} mutator_s, *mutator_t;
+
+
+/* mrnd -- per-thread random number generator
+ *
+ * rnd() keeps its state in a global, which the threads would contend
+ * for, so each thread has its own xorshift generator, seeded from rnd().
+ */
+
+static unsigned long mrnd(mutator_t m)
+{
+  unsigned long x = m->rnd;
+  x ^= (x << 13) & 0xFFFFFFFFul;
+  x ^= x >> 17;
+  x ^= (x << 5) & 0xFFFFFFFFul;
+  m->rnd = x;
+  return x;
+}
+
+static double mrnd_double(mutator_t m)
+{
+  return (double)mrnd(m) / 4294967296.0;
+}
+
+
+static size_t veclen(obj_t v)
+{
+  return (size_t)(((mps_word_t *)v)[1] >> 2);
+}
+
+static obj_t mkvector(mps_ap_t ap, size_t n)
+{
+  mps_word_t v;
+  RESMUST(make_dylan_vector(&v, ap, n));
+  return v;
+}
+
+
+/* step -- one unit of mutator work
+ *
+ * As in latbench: allocate an object that refers to some of the live
+ * set, replace a random member of the live set with it, and sometimes
+ * copy a reference from one live object to another.
+ */
+
+static size_t step(mutator_t m)
+{
+  size_t i, n = 1 + mrnd(m) % maxslots;
+  obj_t v = mkvector(m->ap, n);
+
+  for (i = 0; i < n && i < LINKS; ++i)
+    DYLAN_VECTOR_SLOT(v, i) = m->live[mrnd(m) % m->nlive];
+  m->live[mrnd(m) % m->nlive] = v;
+
+  if (mrnd_double(m) < pupdate) {
+    obj_t from = m->live[mrnd(m) % m->nlive];
+    obj_t to = m->live[mrnd(m) % m->nlive];
+    DYLAN_VECTOR_SLOT(to, mrnd(m) % veclen(to))
+      = DYLAN_VECTOR_SLOT(from, mrnd(m) % veclen(from));
+  }
+
+  return (n + 2) * sizeof(mps_word_t);
+}
+
+
+/* mutator -- the body of each mutator thread */
+
+static void *mutator(void *p)
+{
+  mutator_t m = p;
+  mps_thr_t thread;
+  mps_root_t reg_root, live_root;
+  void *marker = &marker;
+  size_t i, allocated = 0;
+  unsigned long steps = 0;
+
+  RESMUST(mps_thread_reg(&thread, arena));
+  RESMUST(mps_root_create_thread(&reg_root, arena, thread, marker));
+  RESMUST(mps_ap_create_k(&m->ap, pool, mps_args_none));
+  for (i = 0; i < m->nlive; ++i)
+    m->live[i] = DYLAN_INT(0);
+  RESMUST(mps_root_create_area_tagged(&live_root, arena, mps_rank_exact(),
+                                      (mps_rm_t)0, m->live,
+                                      m->live + m->nlive,
+                                      mps_scan_area_tagged,
+                                      (mps_word_t)1, (mps_word_t)0));
+  for (i = 0; i < m->nlive; ++i)
+    m->live[i] = mkvector(m->ap, 1 + mrnd(m) % maxslots);
+
+  m->ready = 1;
+  while (!go)
+    NOOP; /* wait for the other threads to be ready */
+
+  while (allocated < total) {
+    allocated += step(m);
+    if (++steps % 1024 == 0)
+      sample_committed(&committed_max, arena);
+  }
+  m->allocated = allocated;
+
+  mps_root_destroy(live_root);
+  mps_ap_destroy(m->ap);
+  mps_root_destroy(reg_root);
+  mps_thread_dereg(thread);
+  return NULL;
+}
+
+
+/* report -- print the results of a run */
+
+static void report(const char *name, unsigned n, double time,
+                   size_t allocated, mps_arena_stats_s *before,
+                   mps_arena_stats_s *after)
+{
+  mps_message_t message;
+  double flip_time = 0.0, flip_max = 0.0;
+  double lock_wait = (after->lock_wait_ticks - before->lock_wait_ticks)
+    / ticks_per_sec;
+  double lock_hold = (after->lock_hold_ticks - before->lock_hold_ticks)
+    / ticks_per_sec;
+  size_t collections = after->traces - before->traces;
+  size_t read_hits = after->read_barrier_hits - before->read_barrier_hits;
+  size_t write_hits = after->write_barrier_hits - before->write_barrier_hits;
+  const char *sep = "";
+
+  if (json)
+    printf("{\"benchmark\": \"scalebench\", \"test\": \"%s\", "
+           "\"seed\": %lu, \"threads\": %u, \"time\": %g, "
+           "\"allocated\": %lu, \"throughput\": %g, "
+           "\"committed_max\": %lu, \"collections\": %lu, "
+           "\"condemned\": %lu, ",
+           name, (unsigned long)seed, n, time, (unsigned long)allocated,
+           (double)allocated / time, (unsigned long)committed_max,
+           (unsigned long)collections,
+           (unsigned long)(after->condemned_size - before->condemned_size));
+  if (json)
+    printf("\"lock_claims\": %lu, \"lock_wait\": %g, \"lock_hold\": %g, "
+           "\"read_barrier_hits\": %lu, \"write_barrier_hits\": %lu, "
+           "\"pauses\": [",
+           (unsigned long)(after->lock_claims - before->lock_claims),
+           lock_wait, lock_hold,
+           (unsigned long)read_hits, (unsigned long)write_hits);
+  while (mps_message_get(&message, arena, mps_message_type_gc())) {
+    double flip = mps_message_gc_phase_time(arena, message,
+                                            MPS_GC_PHASE_FLIP);
+    flip_time += flip;
+    if (flip > flip_max)
+      flip_max = flip;
+    if (json) {
+      printf("%s%g", sep, mps_message_gc_max_pause(arena, message));
+      sep = ", ";
+    }
+    mps_message_discard(arena, message);
+  }
+  if (json) {
+    printf("], \"flip_time\": %g, \"flip_max\": %g}\n", flip_time, flip_max);
+  } else {
+    printf("%s/%u: %g\n", name, n, time);
+    printf("%s/%u: throughput %g MB/s, %g MB/s per thread\n",
+           name, n, (double)allocated / time / 1048576.0,
+           (double)allocated / time / 1048576.0 / n);
+    printf("%s/%u: lock claims %lu, wait %.1f%% of thread time, "
+           "held %.1f%% of time\n",
+           name, n, (unsigned long)(after->lock_claims - before->lock_claims),
+           100.0 * lock_wait / (time * n), 100.0 * lock_hold / time);
+    printf("%s/%u: barrier hits %lu read, %lu write; collections %lu, "
+           "flip time %g, max %g\n",
+           name, n, (unsigned long)read_hits, (unsigned long)write_hits,
+           (unsigned long)collections, flip_time, flip_max);
+  }
+}
+
+
+/* run -- run the benchmark with n threads */
+
+static void run(mps_pool_class_t pool_class, const char *name, unsigned n)
+{
+  mutator_t mutators;
+  mps_arena_stats_s before, after;
+  EventClock begin, end;
+  size_t allocated = 0;
+  unsigned i;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
+    RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
+  } MPS_ARGS_END(args);
+  RESMUST(dylan_fmt(&format, arena));
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    RESMUST(mps_pool_create_k(&pool, arena, pool_class, args));
+  } MPS_ARGS_END(args);
+  mps_message_type_enable(arena, mps_message_type_gc());
+
+  mutators = malloc(n * sizeof mutators[0]);
+  if (mutators == NULL) {
+    fprintf(stderr, "out of memory allocating threads\n");
+    exit(EXIT_FAILURE);
+  }
+  go = 0;
+  committed_max = 0;
+  for (i = 0; i < n; ++i) {
+    mutator_t m = &mutators[i];
+    m->nlive = live_size / ((maxslots / 2 + 3) * sizeof(mps_word_t));
+    if (m->nlive < 1)
+      m->nlive = 1;
+    m->live = malloc(m->nlive * sizeof m->live[0]);
+    if (m->live == NULL) {
+      fprintf(stderr, "out of memory allocating live set\n");
+      exit(EXIT_FAILURE);
+    }
+    m->rnd = rnd();
+    m->ready = 0;
+    m->allocated = 0;
+    testthr_create(&m->thread, mutator, m);
+  }
+
+  /* Let the threads build their live sets before starting the clock. */
+  for (i = 0; i < n; ++i)
+    while (!mutators[i].ready)
+      NOOP;
+  mps_arena_stats(arena, &before);
+  EVENT_CLOCK(begin);
+  go = 1;
+  for (i = 0; i < n; ++i)
+    testthr_join(&mutators[i].thread, NULL);
+  EVENT_CLOCK(end);
+  mps_arena_stats(arena, &after);
+
+  for (i = 0; i < n; ++i) {
+    allocated += mutators[i].allocated;
+    free(mutators[i].live);
+  }
+  free(mutators);
+
+  mps_arena_park(arena);
+  report(name, n, (double)(end - begin) / ticks_per_sec, allocated,
+         &before, &after);
+
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(arena);
+}
+
+
+/* parse_size -- parse a size with an optional K, M or G suffix */
+
+static size_t parse_size(const char *s)
+{
+  char *p;
+  size_t size = (size_t)strtoul(s, &p, 10);
+  switch (toupper(*p)) {
+  case 'G': size <<= 30; break;
+  case 'M': size <<= 20; break;
+  case 'K': size <<= 10; break;
+  case '\0': break;
+  default:
+    fprintf(stderr, "Bad size %s\n", s);
+    exit(EXIT_FAILURE);
+  }
+  return size;
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"nthreads",         required_argument, NULL, 't'},
+  {"live-size",        required_argument, NULL, 'l'},
+  {"total",            required_argument, NULL, 'n'},
+  {"max-slots",        required_argument, NULL, 's'},
+  {"pupdate",          required_argument, NULL, 'u'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {"seed",             required_argument, NULL, 'x'},
+  {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"pause-time",       required_argument, NULL, 'P'},
+  {"json",             no_argument,       NULL, 'j'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_pool_class_t (*pool_class)(void);
+} pools[] = {
+  {"amc", mps_class_amc},
+  {"ams", mps_class_ams},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+  size_t j;
+  mps_bool_t seed_specified = FALSE;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "ht:l:n:s:u:m:x:zP:j",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 't': {
+        char *p = optarg;
+        ncounts = 0;
+        do {
+          if (ncounts >= nthreadsLIMIT) {
+            fprintf(stderr, "exceeded nthreadsLIMIT\n");
+            return EXIT_FAILURE;
+          }
+          nthreads[ncounts] = (unsigned)strtoul(p, &p, 10);
+          if (nthreads[ncounts] == 0) {
+            fprintf(stderr, "Bad thread counts %s\n", optarg);
+            return EXIT_FAILURE;
+          }
+          ++ncounts;
+        } while (*p++ == ',');
+      }
+      break;
+    case 'l':
+      live_size = parse_size(optarg);
+      break;
+    case 'n':
+      total = parse_size(optarg);
+      break;
+    case 's':
+      maxslots = (size_t)strtoul(optarg, NULL, 10);
+      if (maxslots < 1)
+        maxslots = 1;
+      break;
+    case 'u':
+      pupdate = strtod(optarg, NULL);
+      break;
+    case 'm':
+      arena_size = parse_size(optarg);
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    case 'z':
+      zoned = FALSE;
+      break;
+    case 'P':
+      pause_time = strtod(optarg, NULL);
+      break;
+    case 'j':
+      json = TRUE;
+      break;
+    default:
+      /* This is printed in parts to keep within the 509 character
+         limit for string literals in portable standard C. */
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -t n,..., --nthreads=n,...\n"
+              "    Thread counts to run with (default 1,2,4,8).\n"
+              "  -l n, --live-size=n[KMG]\n"
+              "    Size of the live set per thread (default %lu).\n"
+              "  -n n, --total=n[KMG]\n"
+              "    Total to allocate per thread (default %lu).\n"
+              "  -s n, --max-slots=n\n"
+              "    Maximum slots in an object (default %lu).\n",
+              argv[0],
+              (unsigned long)live_size,
+              (unsigned long)total,
+              (unsigned long)maxslots);
+      fprintf(stderr,
+              "  -u p, --pupdate=p\n"
+              "    Probability of updating an object (default %g).\n"
+              "  -m n, --arena-size=n[KMG]\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n"
+              "  -z, --arena-unzoned\n"
+              "    Disable zoned allocation in the arena.\n"
+              "  -P t, --pause-time=t\n"
+              "    Maximum pause time in seconds (default %g).\n",
+              pupdate,
+              (unsigned long)arena_size,
+              pause_time);
+      fprintf(stderr,
+              "  -j, --json\n"
+              "    Print results as JSON, one line per run.\n"
+              "Tests:\n"
+              "  amc   pool class AMC\n"
+              "  ams   pool class AMS\n");
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (!seed_specified && !json) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+
+  calibrate();
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(pools); ++i)
+      if (strcmp(argv[0], pools[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown pool test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    for (j = 0; j < ncounts; ++j) {
+      rnd_state_set(seed);
+      run(pools[i].pool_class(), pools[i].name, nthreads[j]);
+    }
+    --argc;
+    ++argv;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -123,6 +123,7 @@ static Res segAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   limit = AddrAdd(base, size);
   seg->limit = limit;
+  seg->movedIn = 0;
   seg->rankSet = RankSetEMPTY;
   seg->white = TraceSetEMPTY;
   seg->nailed = TraceSetEMPTY;
@@ -441,6 +442,7 @@ static Res segAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "grey $B\n", (WriteFB)seg->grey,
                "white $B\n", (WriteFB)seg->white,
                "nailed $B\n", (WriteFB)seg->nailed,
+               "movedIn $U\n", (WriteFU)seg->movedIn,
                "rankSet",
                seg->rankSet == RankSetEMPTY ? " EMPTY" : "",
                BS_IS_MEMBER(seg->rankSet, RankAMBIG) ? " AMBIG" : "",
@@ -812,6 +814,24 @@ Res SegFixEmergency(Seg seg, ScanState ss, Addr *refIO)
 }
 
 
+/* SegEphemerons -- preserve the values of reachable ephemeron keys
+ *
+ * See <design/trace/#ephemeron>.
+ */
+
+Res SegEphemerons(Seg seg, ScanState ss)
+{
+  AVERT(Seg, seg);
+  AVERT(ScanState, ss);
+  AVER(PoolArena(SegPool(seg)) == ss->arena);
+  AVER(ss->rank == RankWEAK);
+  AVER(RankSetIsMember(SegRankSet(seg), RankWEAK));
+  AVER(TraceSetInter(SegGrey(seg), ss->traces) != TraceSetEMPTY);
+
+  return Method(Seg, seg, ephemerons)(seg, ss);
+}
+
+
 /* SegReclaim -- reclaim a segment */
 
 void SegReclaim(Seg seg, Trace trace)
@@ -871,6 +891,7 @@ Bool SegCheck(Seg seg)
   CHECKU(Pool, pool);
   arena = PoolArena(pool);
   CHECKU(Arena, arena);
+  CHECKL(seg->movedIn <= ArenaHistory(arena)->epoch);
   CHECKL(AddrIsArenaGrain(TractBase(seg->firstTract), arena));
   CHECKL(AddrIsArenaGrain(seg->limit, arena));
   CHECKL(seg->limit > TractBase(seg->firstTract));
@@ -880,8 +901,8 @@ Bool SegCheck(Seg seg)
    * pool. Note that even if the CHECKs are compiled away there is
    * still a significant cost in looping over the tracts, hence the
    * guard. See job003778. */
-#if defined(AVER_AND_CHECK_ALL)
-  {
+#if defined(AVER_AND_CHECK_ALL) || defined(AVER_AND_CHECK_SAMPLED)
+  if (CHECKLEVEL != CheckLevelMINIMAL) {
     Tract tract;
     Addr addr;
     TRACT_TRACT_FOR(tract, addr, arena, seg->firstTract, seg->limit) {
@@ -894,7 +915,7 @@ Bool SegCheck(Seg seg)
     }
     CHECKL(addr == seg->limit);
   }
-#endif  /* AVER_AND_CHECK_ALL */
+#endif  /* AVER_AND_CHECK_ALL || AVER_AND_CHECK_SAMPLED */
 
   /* The segment must belong to some pool, so it should be on a */
   /* pool's segment ring.  (Actually, this isn't true just after */
@@ -1115,6 +1136,8 @@ static Res segTrivMerge(Seg seg, Seg segHi,
   /* no need to update fields which match. See .similar */
 
   seg->limit = limit;
+  if (segHi->movedIn > seg->movedIn)
+    seg->movedIn = segHi->movedIn; /* <code/ld.c#stale.seg> */
   TRACT_FOR(tract, addr, arena, mid, limit) {
     AVERT(Tract, tract);
     AVER(segHi == TractSeg(tract));
@@ -1180,6 +1203,7 @@ static Res segTrivSplit(Seg seg, Seg segHi,
 
   InstInit(CouldBeA(Inst, segHi));
   segHi->limit = limit;
+  segHi->movedIn = seg->movedIn;
   segHi->rankSet = seg->rankSet;
   segHi->white = seg->white;
   segHi->nailed = seg->nailed;
@@ -1394,6 +1418,16 @@ static Res segNoFix(Seg seg, ScanState ss, Ref *refIO)
 }
 
 
+/* segTrivEphemerons -- ephemerons method for segs without ephemerons */
+
+static Res segTrivEphemerons(Seg seg, ScanState ss)
+{
+  AVERT(Seg, seg);
+  AVERT(ScanState, ss);
+  return ResOK;
+}
+
+
 /* segNoReclaim -- reclaim method for non-GC segs */
 
 static void segNoReclaim(Seg seg, Trace trace)
@@ -2083,6 +2117,7 @@ Bool SegClassCheck(SegClass klass)
   CHECKL(FUNCHECK(klass->scan));
   CHECKL(FUNCHECK(klass->fix));
   CHECKL(FUNCHECK(klass->fixEmergency));
+  CHECKL(FUNCHECK(klass->ephemerons));
   CHECKL(FUNCHECK(klass->reclaim));
   CHECKL(FUNCHECK(klass->walk));
 
@@ -2135,6 +2170,7 @@ DEFINE_CLASS(Seg, Seg, klass)
   klass->scan = segNoScan;
   klass->fix = segNoFix;
   klass->fixEmergency = segNoFix;
+  klass->ephemerons = segTrivEphemerons;
   klass->reclaim = segNoReclaim;
   klass->walk = segTrivWalk;
   klass->sig = SegClassSig;
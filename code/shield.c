@@ -95,8 +95,8 @@ Bool ShieldCheck(Shield shield)
   /* This is too expensive to check all the time since we have an
      expanding shield queue that often has 16K elements instead of
      16. */
-#if defined(AVER_AND_CHECK_ALL)
-  {
+#if defined(AVER_AND_CHECK_ALL) || defined(AVER_AND_CHECK_SAMPLED)
+  if (CHECKLEVEL != CheckLevelMINIMAL) {
     Count unsynced = 0;
     Index i;
     for (i = 0; i < shield->limit; ++i) {
@@ -611,15 +611,22 @@ void (ShieldEnter)(Arena arena)
  *
  * The basic idea is to iterate over *all* segments and check
  * consistency with the arena and shield queue.
+ *
+ * In a sampled checking build, this check is run after a sampled
+ * fraction of flushes, but not before, because ShieldFlush may be
+ * called while a queued segment is being finished and is no longer on
+ * its pool's ring.  See <design/check/#sampled>.
  */
 
-#if defined(SHIELD_DEBUG)
+#if defined(SHIELD_DEBUG) || defined(AVER_AND_CHECK_SAMPLED)
 static void shieldDebugCheck(Arena arena)
 {
   Shield shield;
   Seg seg;
   Count queued = 0;
+  Count entries = 0;
   Count depth = 0;
+  Index i;
 
   AVERT(Arena, arena);
   shield = ArenaShield(arena);
@@ -640,8 +647,16 @@ static void shieldDebugCheck(Arena arena)
       }
     } while(SegNext(&seg, arena, seg));
 
+  /* Flushed entries are set to NULL by shieldDequeue, so the queue
+     may have fewer segments than its limit. */
+  for (i = 0; i < shield->limit; ++i)
+    if (shield->queue[i] != NULL) {
+      AVER(shield->queue[i]->queued);
+      ++entries;
+    }
+
   AVER(depth == shield->depth);
-  AVER(queued == shield->limit);
+  AVER(queued == entries);
 }
 #endif
 
@@ -673,8 +688,10 @@ void (ShieldFlush)(Arena arena)
 #endif
   shieldFlushEntries(shield);
   AVER(shield->unsynced == 0); /* everything back in sync */
-#ifdef SHIELD_DEBUG
+#if defined(SHIELD_DEBUG)
   shieldDebugCheck(arena);
+#elif defined(AVER_AND_CHECK_SAMPLED)
+  CHECK_SAMPLE(shieldDebugCheck(arena), NOOP);
 #endif
 }
 
@@ -70,6 +70,22 @@ void StackHot(void **stackOut);
 
 #define STACK_CONTEXT_SAVE(sc) ((void)_setjmp((sc)->jumpBuffer))
 
+#elif defined(MPS_OS_LI) && (defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL))
+
+/* GNU libc's setjmp mangles the frame pointer before saving it in the
+ * jump buffer (see PTR_MANGLE in sysdeps/x86_64/setjmp.S), so if the
+ * mutator is compiled without frame pointers and keeps a reference in
+ * that register, the reference would not be found.
+ * __builtin_unwind_init forces the function to save all callee-save
+ * registers in its own frame, where they are scanned. See
+ * design.mps.stack-scan.sol.setjmp.mangle. */
+
+#define STACK_CONTEXT_SAVE(sc) \
+  BEGIN \
+    __builtin_unwind_init(); \
+    (void)setjmp((sc)->jumpBuffer); \
+  END
+
 #else  /* other platforms */
 
 #define STACK_CONTEXT_SAVE(sc) ((void)setjmp((sc)->jumpBuffer))
@@ -110,7 +110,7 @@ static TableEntry tableFind(Table table, TableKey key, Bool skip_deleted)
     Word k = table->array[i].key;
     if (k == key ||
         k == table->unusedKey ||
-        (!skip_deleted && key == table->deletedKey))
+        (!skip_deleted && k == table->deletedKey))
       return &table->array[i];
     i = (i + (hash | 1)) & mask; /* .find.visit */
   } while(i != hash);
@@ -249,8 +249,11 @@ Res TableCreate(Table *tableReturn, Count length,
   AVERT(Table, table);
 
   res = TableGrow(table, length);
-  if (res != ResOK)
+  if (res != ResOK) {
+    table->sig = SigInvalid;
+    tableFree(allocClosure, table, sizeof(TableStruct));
     return res;
+  }
  
   *tableReturn = table;
   return ResOK;
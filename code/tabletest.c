@@ -0,0 +1,180 @@
+/* tabletest.c: TABLE TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .overview: Tests the closed hash table in <code/table.c>, which is
+ * used by the MPS internally, against an array of the keys that should
+ * be defined.
+ */
+
+#include "mpm.h"
+#include "table.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* free, malloc */
+
+
+#define unusedKEY   ((TableKey)0)
+#define deletedKEY  ((TableKey)1)
+#define keyCOUNT    64
+#define opCOUNT     100000
+
+
+/* tableAlloc, tableFree -- allocate with malloc
+ *
+ * If closure is not NULL, it points to a count of the blocks
+ * allocated and not freed, and to the number of allocations that may
+ * succeed before one fails.
+ */
+
+typedef struct allocs_s {
+  size_t live;                  /* blocks allocated and not freed */
+  size_t left;                  /* allocations before one fails */
+} allocs_s;
+
+static void *tableAlloc(void *closure, size_t size)
+{
+  allocs_s *allocs = closure;
+  void *p;
+  if (allocs != NULL) {
+    if (allocs->left == 0)
+      return NULL;
+    --allocs->left;
+  }
+  p = malloc(size);
+  if (p != NULL && allocs != NULL)
+    ++allocs->live;
+  return p;
+}
+
+static void tableFree(void *closure, void *p, size_t size)
+{
+  allocs_s *allocs = closure;
+  testlib_unused(size);
+  if (allocs != NULL) {
+    Insist(allocs->live > 0);
+    --allocs->live;
+  }
+  free(p);
+}
+
+
+/* test_create_fail -- TableCreate frees what it allocated on failure
+ *
+ * Allocation of the table structure succeeds and allocation of its
+ * slots fails.  This is a regression test for TableCreate, which
+ * leaked the table structure in this case.
+ */
+
+static void test_create_fail(void)
+{
+  Table table;
+  allocs_s allocs;
+  Res res;
+
+  allocs.live = 0;
+  allocs.left = 1;
+  res = TableCreate(&table, keyCOUNT, tableAlloc, tableFree, &allocs,
+                    unusedKEY, deletedKEY);
+  cdie(res == ResMEMORY, "TableCreate should fail");
+  cdie(allocs.live == 0, "TableCreate leaked");
+}
+
+
+/* test_churn -- define and remove many distinct keys
+ *
+ * The number of keys defined at once is small, so the table does not
+ * grow, and the slots of removed keys must be reused.  This is a
+ * regression test for tableFind, which did not find deleted slots for
+ * reuse, so that the table ran out of slots.
+ */
+
+static void test_churn(void)
+{
+  Table table;
+  TableKey defined[keyCOUNT];
+  TableKey next = deletedKEY + 1;
+  Count length;
+  size_t i, op;
+
+  die(TableCreate(&table, keyCOUNT, tableAlloc, tableFree, NULL,
+                  unusedKEY, deletedKEY), "TableCreate");
+  length = table->length;
+
+  for (i = 0; i < keyCOUNT; ++i)
+    defined[i] = unusedKEY;
+
+  for (op = 0; op < opCOUNT; ++op) {
+    TableValue value;
+    i = rnd() % keyCOUNT;
+    if (defined[i] == unusedKEY) {
+      defined[i] = next++;
+      die(TableDefine(table, defined[i], (TableValue)i), "TableDefine");
+    } else {
+      cdie(TableLookup(&value, table, defined[i]), "TableLookup");
+      cdie(value == (TableValue)i, "value");
+      die(TableRemove(table, defined[i]), "TableRemove");
+      cdie(!TableLookup(&value, table, defined[i]), "removed");
+      defined[i] = unusedKEY;
+    }
+  }
+
+  cdie(table->length == length, "table grew");
+  TableDestroy(table);
+}
+
+
+int main(int argc, char *argv[])
+{
+  testlib_init(argc, argv);
+
+  test_churn();
+  test_create_fail();
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
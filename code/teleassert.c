@@ -0,0 +1,159 @@
+/* teleassert.c: FLIGHT RECORDER ASSERTION TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * A child process logs events in the ring output mode, and then fails
+ * an assertion while holding the leaf global lock, as it would if the
+ * assertion were in the telemetry system.  The assertion handler
+ * (testlib's, which flushes telemetry as the default handler does)
+ * must dump the flight recorder and abort, rather than failing again
+ * when it claims the lock.  See
+ * <design/telemetry/#ring.assert.held>.
+ *
+ * This test uses fork(), so it is Unix-only.
+ */
+
+#include "mpm.h"
+#include "event.h"
+#include "lock.h"
+#include "mps.h"
+#include "mpsavm.h"
+#include "mpslib.h"
+#include "testlib.h"
+
+#include <signal.h> /* SIGABRT */
+#include <stdio.h> /* fopen, fread, printf */
+#include <stdlib.h> /* getenv */
+#include <sys/wait.h> /* waitpid */
+#include <unistd.h> /* alarm, fork */
+
+
+#define COUNT 100000
+#define TIMEOUT 60 /* seconds before the child is presumed to be stuck */
+#define USER_KIND ((mps_word_t)1 << 6) /* see eventcom.h */
+
+
+static void child(void)
+{
+  mps_arena_t arena;
+  mps_label_t label;
+  mps_res_t res;
+  unsigned long i;
+
+  (void)alarm(TIMEOUT);
+
+  die(mps_arena_create_k(&arena, mps_arena_class_vm(), mps_args_none),
+      "arena_create");
+  mps_telemetry_set(USER_KIND);
+  label = mps_telemetry_intern("teleassert");
+  res = mps_telemetry_output_set(MPS_TELEMETRY_OUTPUT_RING);
+  if (res == MPS_RES_UNIMPL)
+    exit(EXIT_SUCCESS);
+  die(res, "mps_telemetry_output_set(RING)");
+
+  /* Log enough events that the per-thread buffer fills up several
+     times, so that the queue has something in it. */
+  for (i = 0; i < COUNT; ++i)
+    mps_telemetry_label((mps_addr_t)&i, label);
+
+  LockClaimGlobalLeaf();
+  mps_lib_assert_fail(__FILE__, __LINE__, "teleassert");
+  LockReleaseGlobalLeaf();
+  error("assertion handler returned");
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *filename;
+  EventAnyStruct header;
+  FILE *f;
+  unsigned long labels;
+  Bool init;
+  pid_t pid;
+  int stat;
+
+  testlib_init(argc, argv);
+
+  pid = fork();
+  cdie(pid >= 0, "fork failed");
+  if (pid == 0) {
+    child();
+    return EXIT_FAILURE;
+  }
+
+  cdie(pid == waitpid(pid, &stat, 0), "waitpid failed");
+  if (WIFEXITED(stat) && WEXITSTATUS(stat) == EXIT_SUCCESS) {
+    printf("%s: ring output not available in this variety.\n", argv[0]);
+  } else {
+    cdie(WIFSIGNALED(stat), "child did not abort");
+    cdie(WTERMSIG(stat) == SIGABRT, "child did not abort");
+
+    /* The labels were logged in the ring mode, so they can only be in
+       the dump, after the EventInit event written by eventRingHeader. */
+    filename = getenv("MPS_TELEMETRY_FILENAME");
+    if (filename == NULL)
+      filename = "mpsio.log";
+    f = fopen(filename, "rb");
+    cdie(f != NULL, "no telemetry written");
+    labels = 0;
+    init = FALSE;
+    while (fread(&header, sizeof header, 1, f) == 1) {
+      cdie(header.size >= sizeof header, "bad event size");
+      if (header.code == EventEventInitCode)
+        init = TRUE;
+      else if (init && header.code == EventLabelCode)
+        ++labels;
+      cdie(fseek(f, (long)(header.size - sizeof header), SEEK_CUR) == 0,
+           "fseek");
+    }
+    Insist(labels > 0);
+    (void)fclose(f);
+  }
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
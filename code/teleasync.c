@@ -0,0 +1,161 @@
+/* teleasync.c: ASYNCHRONOUS TELEMETRY OUTPUT TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Several threads log events while another thread writes the telemetry
+ * output queue to the telemetry stream.  In the block mode no events
+ * may be lost; in the drop mode, with nobody writing the queue, events
+ * must be dropped rather than blocking the logging threads; in the
+ * ring mode, old events are overwritten until the flight recorder is
+ * dumped.  See <design/telemetry/#async>.
+ */
+
+#include "mps.h"
+#include "mpsavm.h"
+#include "testlib.h"
+#include "testthr.h"
+
+#include <stdio.h> /* printf */
+
+
+#define nTHREADS 4
+#define COUNT 20000
+#define DROP_COUNT 100000
+#define USER_KIND ((mps_word_t)1 << 6) /* see eventcom.h */
+
+static mps_arena_t arena;
+static mps_label_t label;
+static volatile int done;
+
+
+static void *logger(void *p)
+{
+  mps_thr_t thread;
+  unsigned long i;
+
+  die(mps_thread_reg(&thread, arena), "mps_thread_reg");
+  for (i = 0; i < COUNT; ++i)
+    mps_telemetry_label((mps_addr_t)p, label);
+  mps_thread_dereg(thread);
+  return NULL;
+}
+
+
+static void *writer(void *p)
+{
+  testlib_unused(p);
+  while (!done)
+    (void)mps_telemetry_output_write();
+  while (mps_telemetry_output_write()) {
+    /* write the rest of the queue */
+  }
+  return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+  testthr_t t[nTHREADS], w;
+  mps_res_t res;
+  size_t dropped;
+  unsigned long i;
+
+  testlib_init(argc, argv);
+
+  die(mps_arena_create_k(&arena, mps_arena_class_vm(), mps_args_none),
+      "arena_create");
+  mps_telemetry_set(USER_KIND);
+  label = mps_telemetry_intern("teleasync");
+
+  res = mps_telemetry_output_set(MPS_TELEMETRY_OUTPUT_BLOCK);
+  if (res == MPS_RES_UNIMPL) {
+    printf("%s: asynchronous output not available in this variety.\n",
+           argv[0]);
+    goto done;
+  }
+  die(res, "mps_telemetry_output_set(BLOCK)");
+
+  done = 0;
+  testthr_create(&w, writer, NULL);
+  for (i = 0; i < nTHREADS; ++i)
+    testthr_create(&t[i], logger, &t[i]);
+  for (i = 0; i < nTHREADS; ++i)
+    testthr_join(&t[i], NULL);
+  mps_telemetry_flush();
+  done = 1;
+  testthr_join(&w, NULL);
+  Insist(mps_telemetry_output_dropped() == 0);
+
+  /* With nobody writing the queue, it fills up and events are dropped. */
+  die(mps_telemetry_output_set(MPS_TELEMETRY_OUTPUT_DROP),
+      "mps_telemetry_output_set(DROP)");
+  for (i = 0; i < DROP_COUNT; ++i)
+    mps_telemetry_label((mps_addr_t)&i, label);
+  mps_telemetry_flush();
+  dropped = mps_telemetry_output_dropped();
+  Insist(dropped > 0);
+  printf("%s: dropped %lu events.\n", argv[0], (unsigned long)dropped);
+
+  /* In the ring mode, events are neither written nor dropped until the
+     flight recorder is dumped. */
+  die(mps_telemetry_output_set(MPS_TELEMETRY_OUTPUT_RING),
+      "mps_telemetry_output_set(RING)");
+  for (i = 0; i < DROP_COUNT; ++i)
+    mps_telemetry_label((mps_addr_t)&i, label);
+  Insist(!mps_telemetry_output_write());
+  Insist(mps_telemetry_output_dropped() == dropped);
+  mps_telemetry_flush();
+
+  die(mps_telemetry_output_set(MPS_TELEMETRY_OUTPUT_SYNC),
+      "mps_telemetry_output_set(SYNC)");
+
+done:
+  mps_telemetry_reset(USER_KIND);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -265,6 +265,16 @@ rnd_state_t rnd_seed(void)
 }
 
 
+/* sample_committed -- update a peak of committed memory */
+
+void sample_committed(size_t *maxIO, mps_arena_t arena)
+{
+  size_t committed = mps_arena_committed(arena);
+  if (committed > *maxIO)
+    *maxIO = committed;
+}
+
+
 /* randomize -- randomize the generator, or initialize to replay
  *
  * There have been 3 versions of the rnd-states reported by this 
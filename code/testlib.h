@@ -266,6 +266,17 @@ extern size_t rnd_align(size_t min, size_t max);
 extern double rnd_pause_time(void);
 
 
+/* sample_committed -- update a peak of committed memory
+ *
+ * sample_committed(&max, arena) sets max to the arena's committed
+ * memory, as returned by mps_arena_committed, if that is larger.
+ * Benchmarks call it periodically, so the peak is a sample, not an
+ * exact high-water mark. The update of max is not atomic.
+ */
+
+extern void sample_committed(size_t *maxIO, mps_arena_t arena);
+
+
 /* randomize -- randomize the generator, or initialize to replay
  *
  * randomize(argc, argv) randomizes the rnd generator (using time(3))
@@ -24,7 +24,8 @@ void traceBandFirstStretchDone(Trace);
 enum {
   traceAccountingPhaseRootScan = 1,
   traceAccountingPhaseSegScan,
-  traceAccountingPhaseSingleScan
+  traceAccountingPhaseSingleScan,
+  traceAccountingPhaseProfileScan
 };
 typedef int traceAccountingPhase;
 
@@ -75,6 +76,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
      TraceFix. */
   ss->fix = NULL;
   ss->fixClosure = NULL;
+  ss->fixSlot = NULL;
   TRACE_SET_ITER(ti, trace, ts, arena) {
     if (ss->fix == NULL) {
       ss->fix = trace->fix;
@@ -99,13 +101,13 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   ss->arena = arena;
   ss->wasMarked = TRUE;
   ScanStateSetWhite(ss, white);
-  STATISTIC(ss->fixRefCount = (Count)0);
-  STATISTIC(ss->segRefCount = (Count)0);
-  STATISTIC(ss->whiteSegRefCount = (Count)0);
-  STATISTIC(ss->nailCount = (Count)0);
-  STATISTIC(ss->snapCount = (Count)0);
-  STATISTIC(ss->forwardedCount = (Count)0);
-  STATISTIC(ss->preservedInPlaceCount = (Count)0);
+  ss->fixRefCount = (Count)0;
+  ss->segRefCount = (Count)0;
+  ss->whiteSegRefCount = (Count)0;
+  ss->nailCount = (Count)0;
+  ss->snapCount = (Count)0;
+  ss->forwardedCount = (Count)0;
+  ss->preservedInPlaceCount = (Count)0;
   STATISTIC(ss->copiedSize = (Size)0);
   ss->scannedSize = (Size)0; /* see .work */
   ss->sig = ScanStateSig;
@@ -153,6 +155,7 @@ Bool TraceCheck(Trace trace)
   CHECKL(trace == &trace->arena->trace[trace->ti]);
   CHECKL(TraceSetIsMember(trace->arena->busyTraces, trace));
   CHECKL(ZoneSetSub(trace->mayMove, trace->white));
+  CHECKL(BoolCheck(trace->ephemeronsTraced));
   CHECKD_NOSIG(Ring, &trace->genRing);
   /* Use trace->state to check more invariants. */
   switch(trace->state) {
@@ -269,13 +272,13 @@ static void traceUpdateCounts(Trace trace, ScanState ss,
     case traceAccountingPhaseRootScan: {
       trace->rootScanSize += ss->scannedSize;
       STATISTIC(trace->rootCopiedSize += ss->copiedSize);
-      STATISTIC(++trace->rootScanCount);
+      ++trace->rootScanCount;
       break;
     }
     case traceAccountingPhaseSegScan: {
       trace->segScanSize += ss->scannedSize; /* see .work */
       STATISTIC(trace->segCopiedSize += ss->copiedSize);
-      STATISTIC(++trace->segScanCount);
+      ++trace->segScanCount;
       break;
     }
     case traceAccountingPhaseSingleScan: {
@@ -283,16 +286,21 @@ static void traceUpdateCounts(Trace trace, ScanState ss,
       STATISTIC(trace->singleCopiedSize += ss->copiedSize);
       break;
     }
+    case traceAccountingPhaseProfileScan: {
+      /* The profile is not a root, and is not work: see
+         <design/profile/#weak>. */
+      break;
+    }
     default:
       NOTREACHED;
   }
-  STATISTIC(trace->fixRefCount += ss->fixRefCount);
-  STATISTIC(trace->segRefCount += ss->segRefCount);
-  STATISTIC(trace->whiteSegRefCount += ss->whiteSegRefCount);
-  STATISTIC(trace->nailCount += ss->nailCount);
-  STATISTIC(trace->snapCount += ss->snapCount);
-  STATISTIC(trace->forwardedCount += ss->forwardedCount);
-  STATISTIC(trace->preservedInPlaceCount += ss->preservedInPlaceCount);
+  trace->fixRefCount += ss->fixRefCount;
+  trace->segRefCount += ss->segRefCount;
+  trace->whiteSegRefCount += ss->whiteSegRefCount;
+  trace->nailCount += ss->nailCount;
+  trace->snapCount += ss->snapCount;
+  trace->forwardedCount += ss->forwardedCount;
+  trace->preservedInPlaceCount += ss->preservedInPlaceCount;
 }
 
 
@@ -387,6 +395,52 @@ Res TraceAddWhite(Trace trace, Seg seg)
 }
 
 
+/* tracePhaseBegin -- call the phase hook, if any
+ *
+ * See <design/trace/#phase.hook>.
+ */
+
+static void tracePhaseBegin(Trace trace, TracePhase phase)
+{
+  Arena arena = trace->arena;
+
+  AVER(phase <= TracePhaseEND);
+  if (arena->phaseHook != NULL)
+    (*arena->phaseHook)(arena, phase, arena->phaseHookClosure);
+}
+
+
+/* traceTime -- account for time spent in a phase of a trace
+ *
+ * Add the time since start to the time spent by the trace in the
+ * phase, and note the length of the current pause. See
+ * <design/trace/#phase.time>.
+ */
+
+static void traceTime(Trace trace, TracePhase phase, Clock start)
+{
+  Clock now = ClockNow();
+  Clock pause = now - trace->arena->pauseStart;
+
+  AVER(phase < TracePhaseLIMIT);
+  trace->phaseTime[phase] += now - start;
+  if (pause > trace->maxPause)
+    trace->maxPause = pause;
+}
+
+
+/* TraceSetPhaseHook -- set the function called at phase boundaries */
+
+void TraceSetPhaseHook(Arena arena, TracePhaseHook hook, void *closure)
+{
+  AVERT(Arena, arena);
+  AVER(hook == NULL || FUNCHECK(hook));
+
+  arena->phaseHook = hook;
+  arena->phaseHookClosure = closure;
+}
+
+
 /* TraceCondemnStart -- start selecting generations to condemn for a trace */
 
 void TraceCondemnStart(Trace trace)
@@ -395,6 +449,9 @@ void TraceCondemnStart(Trace trace)
   AVER(trace->state == TraceINIT);
   AVER(trace->white == ZoneSetEMPTY);
   AVER(RingIsSingle(&trace->genRing));
+
+  tracePhaseBegin(trace, TracePhaseCONDEMN);
+  trace->condemnClock = ClockNow();
 }
 
 
@@ -589,18 +646,22 @@ static Res traceFlip(Trace trace)
   Rank rank;
   struct rootFlipClosureStruct rfc;
   Res res;
+  Clock start;
 
   AVERT(Trace, trace);
   rfc.ts = TraceSetSingle(trace);
 
   arena = trace->arena;
   rfc.arena = arena;
+  tracePhaseBegin(trace, TracePhaseFLIP);
+  start = ClockNow();
   ShieldHold(arena);
 
   AVER(trace->state == TraceUNFLIPPED);
   AVER(!TraceSetIsMember(arena->flippedTraces, trace));
 
   EVENT2(TraceFlipBegin, trace, arena);
+  PROBE1(trace_flip_begin, trace);
 
   traceFlipBuffers(ArenaGlobals(arena));
 
@@ -649,14 +710,19 @@ static Res traceFlip(Trace trace)
   /* Mark the trace as flipped. */
   trace->state = TraceFLIPPED;
   arena->flippedTraces = TraceSetAdd(arena->flippedTraces, trace);
+  ++arena->flips; /* <design/poolawl/#load.fast> */
 
   EVENT2(TraceFlipEnd, trace, arena);
+  PROBE1(trace_flip_end, trace);
 
   ShieldRelease(arena);
+  traceTime(trace, TracePhaseFLIP, start);
+  tracePhaseBegin(trace, TracePhaseSCAN);
   return ResOK;
 
 failRootFlip:
   ShieldRelease(arena);
+  traceTime(trace, TracePhaseFLIP, start);
   return res;
 }
 
@@ -692,6 +758,7 @@ Res TraceCreate(Trace *traceReturn, Arena arena, int why)
 {
   TraceId ti;
   Trace trace;
+  TracePhase phase;
 
   AVER(traceReturn != NULL);
   AVERT(Arena, arena);
@@ -713,6 +780,8 @@ found:
   trace->ti = ti;
   trace->state = TraceINIT;
   trace->band = RankMIN;
+  trace->ephemeronsTraced = FALSE;
+  trace->ephemeronRefCount = (Count)0;
   trace->fix = SegFix;
   trace->fixClosure = NULL;
   RingInit(&trace->genRing);
@@ -723,31 +792,37 @@ found:
   trace->quantumWork = (Work)0; /* computed in TraceStart */
   STATISTIC(trace->greySegCount = (Count)0);
   STATISTIC(trace->greySegMax = (Count)0);
-  STATISTIC(trace->rootScanCount = (Count)0);
+  trace->rootScanCount = (Count)0;
   trace->rootScanSize = (Size)0;
   STATISTIC(trace->rootCopiedSize = (Size)0);
-  STATISTIC(trace->segScanCount = (Count)0);
+  trace->segScanCount = (Count)0;
   trace->segScanSize = (Size)0; /* see .work */
   STATISTIC(trace->segCopiedSize = (Size)0);
   STATISTIC(trace->singleScanCount = (Count)0);
   STATISTIC(trace->singleScanSize = (Size)0);
   STATISTIC(trace->singleCopiedSize = (Size)0);
-  STATISTIC(trace->fixRefCount = (Count)0);
-  STATISTIC(trace->segRefCount = (Count)0);
-  STATISTIC(trace->whiteSegRefCount = (Count)0);
-  STATISTIC(trace->nailCount = (Count)0);
-  STATISTIC(trace->snapCount = (Count)0);
-  STATISTIC(trace->readBarrierHitCount = (Count)0);
-  STATISTIC(trace->pointlessScanCount = (Count)0);
-  STATISTIC(trace->forwardedCount = (Count)0);
+  trace->fixRefCount = (Count)0;
+  trace->segRefCount = (Count)0;
+  trace->whiteSegRefCount = (Count)0;
+  trace->nailCount = (Count)0;
+  trace->snapCount = (Count)0;
+  trace->readBarrierHitCount = (Count)0;
+  trace->pointlessScanCount = (Count)0;
+  trace->forwardedCount = (Count)0;
   trace->forwardedSize = (Size)0; /* see .message.data */
-  STATISTIC(trace->preservedInPlaceCount = (Count)0);
+  trace->preservedInPlaceCount = (Count)0;
   trace->preservedInPlaceSize = (Size)0;  /* see .message.data */
-  STATISTIC(trace->reclaimCount = (Count)0);
-  STATISTIC(trace->reclaimSize = (Size)0);
+  trace->reclaimCount = (Count)0;
+  trace->reclaimSize = (Size)0;
+  trace->condemnClock = (Clock)0;
+  for (phase = 0; phase < TracePhaseLIMIT; ++phase)
+    trace->phaseTime[phase] = (Clock)0;
+  trace->maxPause = (Clock)0;
+  trace->histogram = NULL;
   trace->sig = TraceSig;
   arena->busyTraces = TraceSetAdd(arena->busyTraces, trace);
   AVERT(Trace, trace);
+  TraceHistogramCreate(trace);
 
   EVENT3(TraceCreate, trace, arena, (EventFU)why);
 
@@ -787,6 +862,8 @@ static void traceDestroyCommon(Trace trace)
   }
   RingFinish(&trace->genRing);
 
+  TraceHistogramDestroy(trace);
+
   /* Ensure that address space is returned to the operating system for
    * traces that don't have any condemned objects (there might be
    * manually allocated objects that were freed). See job003999. */
@@ -801,7 +878,14 @@ static void traceDestroyCommon(Trace trace)
 
   trace->sig = SigInvalid;
   trace->arena->busyTraces = TraceSetDel(trace->arena->busyTraces, trace);
+  /* The release makes the trace's changes to weak references visible
+     to mps_awl_load. See <design/poolawl/#load.fast>. */
+#if defined(STORE_RELEASE)
+  STORE_RELEASE(trace->arena->flippedTraces,
+                TraceSetDel(trace->arena->flippedTraces, trace));
+#else
   trace->arena->flippedTraces = TraceSetDel(trace->arena->flippedTraces, trace);
+#endif
 }
 
 
@@ -818,6 +902,62 @@ void TraceDestroyInit(Trace trace)
 }
 
 
+/* TraceStatsInit -- initialize cumulative tracer statistics */
+
+void TraceStatsInit(TraceStats stats)
+{
+  stats->traces = (Count)0;
+  stats->condemnedSize = (Size)0;
+  stats->rootScanCount = (Count)0;
+  stats->rootScanSize = (Size)0;
+  stats->segScanCount = (Count)0;
+  stats->segScanSize = (Size)0;
+  stats->pointlessScanCount = (Count)0;
+  stats->fixRefCount = (Count)0;
+  stats->segRefCount = (Count)0;
+  stats->whiteSegRefCount = (Count)0;
+  stats->nailCount = (Count)0;
+  stats->snapCount = (Count)0;
+  stats->forwardedCount = (Count)0;
+  stats->forwardedSize = (Size)0;
+  stats->preservedInPlaceCount = (Count)0;
+  stats->preservedInPlaceSize = (Size)0;
+  stats->reclaimCount = (Count)0;
+  stats->reclaimSize = (Size)0;
+  stats->readBarrierHitCount = (Count)0;
+  stats->writeBarrierHitCount = (Count)0;
+}
+
+
+/* traceStatsAccumulate -- add a finished trace's counters to the totals
+ *
+ * See <design/trace/#stats>.
+ */
+
+static void traceStatsAccumulate(TraceStats stats, Trace trace)
+{
+  ++stats->traces;
+  stats->condemnedSize += trace->condemned;
+  stats->rootScanCount += trace->rootScanCount;
+  stats->rootScanSize += trace->rootScanSize;
+  stats->segScanCount += trace->segScanCount;
+  stats->segScanSize += trace->segScanSize;
+  stats->pointlessScanCount += trace->pointlessScanCount;
+  stats->fixRefCount += trace->fixRefCount;
+  stats->segRefCount += trace->segRefCount;
+  stats->whiteSegRefCount += trace->whiteSegRefCount;
+  stats->nailCount += trace->nailCount;
+  stats->snapCount += trace->snapCount;
+  stats->forwardedCount += trace->forwardedCount;
+  stats->forwardedSize += trace->forwardedSize;
+  stats->preservedInPlaceCount += trace->preservedInPlaceCount;
+  stats->preservedInPlaceSize += trace->preservedInPlaceSize;
+  stats->reclaimCount += trace->reclaimCount;
+  stats->reclaimSize += trace->reclaimSize;
+  stats->readBarrierHitCount += trace->readBarrierHitCount;
+}
+
+
 /* TraceDestroyFinished -- destroy a trace object in state FINISHED
  *
  * Finish and deallocate a Trace object, freeing up a TraceId.
@@ -851,21 +991,54 @@ void TraceDestroyFinished(Trace trace)
   STATISTIC(EVENT3(TraceStatReclaim, trace,
                    trace->reclaimCount, trace->reclaimSize));
 
+  traceStatsAccumulate(&trace->arena->traceStats, trace);
+
   traceDestroyCommon(trace);
 }
 
 
+/* traceScanProfile -- fix the references in the allocation profile
+ *
+ * The profile's references are weak, so they are fixed when there is
+ * nothing grey left for the trace, and references to dead objects are
+ * replaced by null.  See <design/profile/#weak>.
+ */
+
+static void traceScanProfile(Trace trace)
+{
+  Arena arena = trace->arena;
+  Profile profile = ArenaProfile(arena);
+  ScanStateStruct ss;
+  Res res;
+
+  if (profile == NULL)
+    return;
+
+  ScanStateInit(&ss, TraceSetSingle(trace), arena, RankWEAK, trace->white);
+  res = ProfileScan(&ss, profile);
+  AVER(res == ResOK); /* weak fixes never copy, so can't fail */
+  traceSetUpdateCounts(TraceSetSingle(trace), arena, &ss,
+                       traceAccountingPhaseProfileScan);
+  ScanStateFinish(&ss);
+}
+
+
 /* traceReclaim -- reclaim the remaining objects white for this trace */
 
 static void traceReclaim(Trace trace)
 {
   Arena arena;
   Ring genNode, genNext;
+  Clock start;
 
   AVER(trace->state == TraceRECLAIM);
 
+  tracePhaseBegin(trace, TracePhaseRECLAIM);
+  start = ClockNow();
   EVENT1(TraceReclaim, trace);
 
+  traceScanProfile(trace);
+
   arena = trace->arena;
   RING_FOR(genNode, &trace->genRing, genNext) {
     Ring segNode, segNext;
@@ -879,7 +1052,7 @@ static void traceReclaim(Trace trace)
       if (TraceSetIsMember(SegWhite(seg), trace)) {
         Addr base = SegBase(seg);
         AVER_CRITICAL(PoolHasAttr(SegPool(seg), AttrGC));
-        STATISTIC(++trace->reclaimCount);
+        ++trace->reclaimCount;
         SegReclaim(seg, trace);
 
         /* If the segment still exists, it should no longer be white. */
@@ -902,10 +1075,14 @@ static void traceReclaim(Trace trace)
   trace->state = TraceFINISHED;
 
   ArenaCompact(arena, trace);  /* let arenavm drop chunks */
+  traceTime(trace, TracePhaseRECLAIM, start);
+  PROBE2(trace_end, trace, trace->reclaimSize);
 
   TracePostMessage(trace);  /* trace end */
   /* Immediately pre-allocate messages for next time; failure is okay */
   (void)TraceIdMessagesCreate(arena, trace->ti);
+
+  tracePhaseBegin(trace, TracePhaseEND);
 }
 
 /* TraceRankForAccess -- Returns rank to scan at if we hit a barrier.
@@ -916,6 +1093,11 @@ static void traceReclaim(Trace trace)
  * .scan.conservative: It's safe to scan at EXACT unless the band is
  * WEAK and in that case the segment should be weak.
  * 
+ * If the trace band is AMBIG then the trace has flipped but has not
+ * yet looked for grey segments, so the band is about to become EXACT.
+ * This happens when the mutator runs between the flip and the first
+ * scan, for example after mps_arena_step with a zero interval.
+ *
  * If the trace band is EXACT then we scan EXACT. This might prevent
  * finalisation messages and may preserve objects pointed to only by weak
  * references but tough luck -- the mutator wants to look.
@@ -955,8 +1137,6 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
   rankSet = SegRankSet(seg);
   switch(band) {
   case RankAMBIG:
-    NOTREACHED;
-    break;
   case RankEXACT:
     return RankEXACT;
   case RankFINAL:
@@ -977,6 +1157,62 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
   return RankEXACT;
 }
  
+/* traceEphemeronsSegRes -- trace ephemeron values in a weak segment */
+
+static Res traceEphemeronsSegRes(TraceSet ts, Arena arena, Seg seg)
+{
+  ScanStateStruct ssStruct;
+  ScanState ss = &ssStruct;
+  Res res;
+
+  ScanStateInit(ss, ts, arena, RankWEAK, traceSetWhiteUnion(ts, arena));
+  res = SegEphemerons(seg, ss);
+  if (ss->scannedSize > 0)
+    traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
+  ScanStateFinish(ss);
+  return res;
+}
+
+
+/* traceEphemerons -- trace the values of reachable ephemeron keys
+ *
+ * Called when a strong band has run out of grey segments. Gives each
+ * weak segment that is grey for the trace the chance to preserve the
+ * values of those of its ephemeron keys that have been found to be
+ * reachable. Anything so preserved is greyed in the usual way. Returns
+ * FALSE without doing anything if no reference to the white set has
+ * been fixed since the last pass, as then no key can have become
+ * reachable. See <design/trace/#ephemeron>.
+ */
+
+static Bool traceEphemerons(Arena arena, Trace trace)
+{
+  TraceSet ts = TraceSetSingle(trace);
+  Ring node, nextNode;
+
+  if (trace->ephemeronsTraced
+      && trace->whiteSegRefCount == trace->ephemeronRefCount)
+    return FALSE;
+
+  RING_FOR(node, ArenaGreyRing(arena, RankWEAK), nextNode) {
+    Seg seg = SegOfGreyRing(node);
+    if (TraceSetIsMember(SegGrey(seg), trace)) {
+      Res res = traceEphemeronsSegRes(ts, arena, seg);
+      if (ResIsAllocFailure(res)) {
+        ArenaSetEmergency(arena, TRUE);
+        res = traceEphemeronsSegRes(ts, arena, seg);
+      }
+      /* Should be OK in emergency mode. */
+      AVER(res == ResOK);
+    }
+  }
+
+  trace->ephemeronsTraced = TRUE;
+  trace->ephemeronRefCount = trace->whiteSegRefCount;
+  return TRUE;
+}
+
+
 /* traceFindGrey -- find a grey segment
  *
  * This function finds the next segment to scan.  It does this according
@@ -1070,6 +1306,12 @@ static Bool traceFindGrey(Seg *segReturn, Rank *rankReturn,
     }
     /* .check.ambig.not */
     AVER(RingIsSingle(ArenaGreyRing(arena, RankAMBIG)));
+    /* .ephemeron: Before leaving a strong band, preserve the values of
+     * ephemeron keys that it found to be reachable, and look again.
+     * The band is finished when there is nothing more to scan and no
+     * need for another pass. */
+    if (band != RankWEAK && traceEphemerons(arena, trace))
+      continue;
     if(!traceBandAdvance(trace)) {
       /* No grey segments for this trace. */
       return FALSE;
@@ -1151,18 +1393,12 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
 
     traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
     /* Count segments scanned pointlessly */
-    STATISTIC({
+    if (ss->whiteSegRefCount == 0) {
       TraceId ti; Trace trace;
-      Count whiteSegRefCount = 0;
-
       TRACE_SET_ITER(ti, trace, ts, arena)
-        whiteSegRefCount += trace->whiteSegRefCount;
+        ++trace->pointlessScanCount;
       TRACE_SET_ITER_END(ti, trace, ts, arena);
-      if(whiteSegRefCount == 0)
-        TRACE_SET_ITER(ti, trace, ts, arena)
-          ++trace->pointlessScanCount;
-        TRACE_SET_ITER_END(ti, trace, ts, arena);
-    });
+    }
 
     /* Following is true whether or not scan was total. */
     /* See <design/scan/#summary.subset>. */
@@ -1273,6 +1509,7 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
     /* Pick set of traces to scan for: */
     traces = arena->flippedTraces;
     rank = TraceRankForAccess(arena, seg);
+    arena->pauseStart = ClockNow();
     res = traceScanSeg(traces, rank, arena, seg);      
 
     /* Allocation failures should be handled my emergency mode, and we don't
@@ -1285,15 +1522,16 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
     /* can go ahead and access it. */
     AVER(TraceSetInter(SegGrey(seg), traces) == TraceSetEMPTY);
 
-    STATISTIC({
+    {
       Trace trace;
       TraceId ti;
       TRACE_SET_ITER(ti, trace, traces, arena)
         ++trace->readBarrierHitCount;
+        traceTime(trace, TracePhaseSCAN, arena->pauseStart);
       TRACE_SET_ITER_END(ti, trace, traces, arena);
-    });
+    }
   } else {              /* write barrier */
-    STATISTIC(++arena->writeBarrierHitCount);
+    ++arena->traceStats.writeBarrierHitCount;
   }
 
   /* The write barrier handling must come after the read barrier, */
@@ -1341,7 +1579,7 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
                              ZoneSetAddAddr(ss->arena, ZoneSetEMPTY, ref)) !=
                 ZoneSetEMPTY);
 
-  STATISTIC(++ss->fixRefCount);
+  ++ss->fixRefCount;
   EVENT4(TraceFix, ss, mps_ref_io, ref, ss->rank);
 
   /* This sequence of tests is equivalent to calling TractOfAddr(),
@@ -1378,17 +1616,17 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
   if (TraceSetInter(SegWhite(seg), ss->traces) == TraceSetEMPTY) {
     /* Reference points to a segment that is not white for any of the
      * active traces. See <design/trace/#fix.tractofaddr> */
-    STATISTIC({
-      ++ss->segRefCount;
-      EVENT1(TraceFixSeg, seg);
-    });
+    ++ss->segRefCount;
+    EVENT1(TraceFixSeg, seg);
     goto done;
   }
 
-  STATISTIC(++ss->segRefCount);
-  STATISTIC(++ss->whiteSegRefCount);
+  ++ss->segRefCount;
+  ++ss->whiteSegRefCount;
   EVENT1(TraceFixSeg, seg);
   EVENT0(TraceFixWhite);
+  /* <design/trace/#fix.slot> */
+  ss->fixSlot = (Addr)mps_ref_io;
   res = (*ss->fix)(seg, ss, &ref);
   if (res != ResOK) {
     /* SegFixEmergency must not fail. */
@@ -1602,7 +1840,8 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
   res = RootsIterate(ArenaGlobals(arena), rootGrey, (void *)trace);
   AVER(res == ResOK);
 
-  STATISTIC(EVENT2(ArenaWriteFaults, arena, arena->writeBarrierHitCount));
+  STATISTIC(EVENT2(ArenaWriteFaults, arena,
+                   arena->traceStats.writeBarrierHitCount));
 
   /* Calculate the rate of scanning. */
   {
@@ -1631,6 +1870,8 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
 
   trace->state = TraceUNFLIPPED;
   TracePostStartMessage(trace);
+  PROBE3(trace_start, trace, trace->why, trace->condemned);
+  traceTime(trace, TracePhaseCONDEMN, trace->condemnClock);
 
   /* All traces must flip at beginning at the moment. */
   return traceFlip(trace);
@@ -1667,10 +1908,12 @@ void TraceAdvance(Trace trace)
 
     if (traceFindGrey(&seg, &rank, arena, trace->ti)) {
       Res res;
+      Clock start = ClockNow();
       res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
       /* Allocation failures should be handled by emergency mode, and we
        * don't expect any other error in a normal GC trace. */
       AVER(res == ResOK);
+      traceTime(trace, TracePhaseSCAN, start);
     } else {
       trace->state = TraceRECLAIM;
     }
@@ -1786,12 +2029,14 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
   AVER(arena->busyTraces == TraceSetSingle(trace));
   oldWork = traceWork(trace);
   endWork = oldWork + trace->quantumWork;
+  PROBE2(trace_poll_begin, trace, trace->quantumWork);
   do {
     TraceAdvance(trace);
   } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
   newWork = traceWork(trace);
   AVER(newWork >= oldWork);
   work = newWork - oldWork;
+  PROBE2(trace_poll_end, trace, work);
   if (trace->state == TraceFINISHED)
     TraceDestroyFinished(trace);
   *workReturn = work;
@@ -12,6 +12,8 @@
  *
  *   - TraceStartMessage.  Posted when a trace starts.
  *
+ *   - Histogram.  Live objects by class, for the trace end message.
+ *
  *   - TraceMessage.  Posted when a trace ends.
  *
  *   - TraceIdMessages.  Pre-allocated messages for traceid.
@@ -119,6 +121,10 @@ static MessageClassStruct TraceStartMessageClassStruct = {
   MessageNoGCCondemnedSize,      /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize,   /* GCNotCondemnedSize */
   TraceStartMessageWhy,          /* GCStartWhy */
+  MessageNoGCPhaseTime,          /* GCPhaseTime */
+  MessageNoGCMaxPause,           /* GCMaxPause */
+  MessageNoGCHistogramLength,    /* GCHistogramLength */
+  MessageNoGCHistogramEntry,     /* GCHistogramEntry */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
 
@@ -251,6 +257,195 @@ void TracePostStartMessage(Trace trace)
 
 
 
+/* --------  Histogram  -------- */
+
+
+/* Histogram -- live objects by class
+ *
+ * The histogram is an open-addressed hash table mapping class to the
+ * number and total size of the objects preserved by a trace.  It has
+ * twice as many slots as the maximum number of classes, so that it
+ * never fills up.  Objects whose class is NULL, or that arrive when
+ * the maximum number of classes has been reached, are counted in the
+ * "other" entry.  See <design/message-gc/#histogram>.
+ */
+
+#define HistogramSig ((Sig)0x5191579A) /* SIGnature HISTogrAm */
+
+typedef struct HistogramEntryStruct {
+  Addr klass;                   /* class of objects, or NULL if unused */
+  Count count;                  /* number of objects */
+  Size size;                    /* total size of objects */
+} HistogramEntryStruct, *HistogramEntry;
+
+typedef struct HistogramStruct {
+  Sig sig;                      /* <design/sig/> */
+  Count length;                 /* maximum number of classes */
+  Count slots;                  /* number of slots in table */
+  Count count;                  /* number of classes in table */
+  HistogramEntryStruct other;   /* objects of other classes */
+  HistogramEntry table;         /* hash table, follows this structure */
+} HistogramStruct;
+
+#define histogramSize(slots) \
+  (sizeof(HistogramStruct) + (slots) * sizeof(HistogramEntryStruct))
+
+ATTRIBUTE_UNUSED
+static Bool HistogramCheck(Histogram hist)
+{
+  CHECKS(Histogram, hist);
+  CHECKL(hist->length > 0);
+  CHECKL(hist->count <= hist->length);
+  CHECKL(hist->count <= hist->slots);
+  CHECKL(hist->other.klass == NULL);
+  CHECKL(hist->table == (HistogramEntry)(hist + 1));
+  return TRUE;
+}
+
+
+/* TraceSetHistogramLength -- set maximum number of classes, or 0
+ *
+ * Takes effect from the next trace.
+ */
+
+void TraceSetHistogramLength(Arena arena, Count length)
+{
+  AVERT(Arena, arena);
+  AVER(length <= (SizeMAX / sizeof(HistogramEntryStruct) - 1) / 2);
+  arena->histogramLength = length;
+}
+
+
+/* TraceHistogramCreate -- give the trace a histogram, if wanted
+ *
+ * Failure to allocate the histogram is not an error: the trace end
+ * message will have an empty histogram.
+ */
+
+void TraceHistogramCreate(Trace trace)
+{
+  Arena arena;
+  Histogram hist;
+  Count slots;
+  Index i;
+  void *p;
+  Res res;
+
+  AVERT(Trace, trace);
+  AVER(trace->histogram == NULL);
+  arena = trace->arena;
+
+  if (arena->histogramLength == 0)
+    return;
+
+  slots = arena->histogramLength * 2;
+  res = ControlAlloc(&p, arena, histogramSize(slots));
+  if (res != ResOK)
+    return;
+  hist = p;
+  hist->length = arena->histogramLength;
+  hist->slots = slots;
+  hist->count = 0;
+  hist->other.klass = NULL;
+  hist->other.count = 0;
+  hist->other.size = 0;
+  hist->table = (HistogramEntry)(hist + 1);
+  for (i = 0; i < slots; ++i) {
+    hist->table[i].klass = NULL;
+    hist->table[i].count = 0;
+    hist->table[i].size = 0;
+  }
+  hist->sig = HistogramSig;
+  AVERT(Histogram, hist);
+  trace->histogram = hist;
+}
+
+
+/* histogramDestroy -- free a histogram */
+
+static void histogramDestroy(Arena arena, Histogram hist)
+{
+  AVERT(Histogram, hist);
+  hist->sig = SigInvalid;
+  ControlFree(arena, hist, histogramSize(hist->slots));
+}
+
+
+/* TraceHistogramDestroy -- free the trace's histogram, if any */
+
+void TraceHistogramDestroy(Trace trace)
+{
+  AVERT(Trace, trace);
+  if (trace->histogram != NULL) {
+    histogramDestroy(trace->arena, trace->histogram);
+    trace->histogram = NULL;
+  }
+}
+
+
+/* TraceHistogramAdd -- count an object preserved by the trace
+ *
+ * ref is the client pointer to an object of the given size in a pool
+ * with the given format.  The pool must have exposed the segment.
+ */
+
+void TraceHistogramAdd(Trace trace, Format format, Addr ref, Size size)
+{
+  Histogram hist;
+  HistogramEntry entry;
+  Addr klass;
+  Index i;
+
+  AVERT_CRITICAL(Trace, trace);
+  hist = trace->histogram;
+  if (hist == NULL)
+    return;
+  AVERT_CRITICAL(Histogram, hist);
+  AVERT_CRITICAL(Format, format);
+
+  klass = (Addr)(*format->klass)(ref);
+  entry = &hist->other;
+  if (klass != NULL) {
+    /* The table is never full, so this finds klass or a free slot. */
+    i = ((Word)klass >> 3) % hist->slots;
+    while (hist->table[i].klass != klass && hist->table[i].klass != NULL)
+      i = (i + 1) % hist->slots;
+    if (hist->table[i].klass == klass) {
+      entry = &hist->table[i];
+    } else if (hist->count < hist->length) {
+      entry = &hist->table[i];
+      entry->klass = klass;
+      ++hist->count;
+    }
+  }
+  ++entry->count;
+  entry->size += size;
+}
+
+
+/* histogramCompact -- move the classes to the start of the table
+ *
+ * After this, the histogram can't be added to, but the classes can
+ * be looked up by index.
+ */
+
+static void histogramCompact(Histogram hist)
+{
+  Index i, j = 0;
+
+  AVERT(Histogram, hist);
+  for (i = 0; i < hist->slots; ++i)
+    if (hist->table[i].klass != NULL) {
+      hist->table[j] = hist->table[i];
+      ++j;
+    }
+  AVER(j == hist->count);
+  for (i = j; i < hist->slots; ++i)
+    hist->table[i].klass = NULL;
+}
+
+
+
 /* --------  TraceMessage (trace end)  -------- */
 
 
@@ -281,6 +476,9 @@ typedef struct TraceMessageStruct  {
   Size liveSize;
   Size condemnedSize;
   Size notCondemnedSize;
+  Clock phaseTime[TracePhaseLIMIT];
+  Clock maxPause;
+  Histogram histogram;          /* NULL or compacted histogram */
   MessageStruct messageStruct;
 } TraceMessageStruct;
 
@@ -310,6 +508,8 @@ static void TraceMessageDelete(Message message)
   AVERT(TraceMessage, tMessage);
 
   arena = MessageArena(message);
+  if (tMessage->histogram != NULL)
+    histogramDestroy(arena, tMessage->histogram);
   tMessage->sig = SigInvalid;
   MessageFinish(message);
 
@@ -349,6 +549,68 @@ static Size TraceMessageNotCondemnedSize(Message message)
   return tMessage->notCondemnedSize;
 }
 
+static Clock TraceMessagePhaseTime(Message message, TracePhase phase)
+{
+  TraceMessage tMessage;
+
+  AVERT(Message, message);
+  AVER(phase < TracePhaseLIMIT);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+
+  return tMessage->phaseTime[phase];
+}
+
+static Clock TraceMessageMaxPause(Message message)
+{
+  TraceMessage tMessage;
+
+  AVERT(Message, message);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+
+  return tMessage->maxPause;
+}
+
+static Count TraceMessageHistogramLength(Message message)
+{
+  TraceMessage tMessage;
+  Histogram hist;
+
+  AVERT(Message, message);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+
+  hist = tMessage->histogram;
+  if (hist == NULL)
+    return 0;
+  return hist->count + (hist->other.count > 0 ? 1 : 0);
+}
+
+static void TraceMessageHistogramEntry(Addr *klassReturn,
+                                       Count *countReturn,
+                                       Size *sizeReturn,
+                                       Message message, Index i)
+{
+  TraceMessage tMessage;
+  Histogram hist;
+  HistogramEntry entry;
+
+  AVERT(Message, message);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+  AVER(i < TraceMessageHistogramLength(message));
+
+  hist = tMessage->histogram;
+  if (i < hist->count)
+    entry = &hist->table[i];
+  else
+    entry = &hist->other;
+  *klassReturn = entry->klass;
+  *countReturn = entry->count;
+  *sizeReturn = entry->size;
+}
+
 static MessageClassStruct TraceMessageClassStruct = {
   MessageClassSig,               /* sig */
   "TraceGC",                     /* name */
@@ -359,11 +621,17 @@ static MessageClassStruct TraceMessageClassStruct = {
   TraceMessageCondemnedSize,     /* GCCondemnedSize */
   TraceMessageNotCondemnedSize,  /* GCNotCondemnedSize */
   MessageNoGCStartWhy,           /* GCStartWhy */
+  TraceMessagePhaseTime,         /* GCPhaseTime */
+  TraceMessageMaxPause,          /* GCMaxPause */
+  TraceMessageHistogramLength,   /* GCHistogramLength */
+  TraceMessageHistogramEntry,    /* GCHistogramEntry */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
 
 static void traceMessageInit(Arena arena, TraceMessage tMessage)
 {
+  TracePhase phase;
+
   AVERT(Arena, arena);
 
   MessageInit(arena, TraceMessageMessage(tMessage),
@@ -371,6 +639,10 @@ static void traceMessageInit(Arena arena, TraceMessage tMessage)
   tMessage->liveSize = (Size)0;
   tMessage->condemnedSize = (Size)0;
   tMessage->notCondemnedSize = (Size)0;
+  for (phase = 0; phase < TracePhaseLIMIT; ++phase)
+    tMessage->phaseTime[phase] = (Clock)0;
+  tMessage->maxPause = (Clock)0;
+  tMessage->histogram = NULL;
 
   tMessage->sig = TraceMessageSig;
   AVERT(TraceMessage, tMessage);
@@ -380,7 +652,10 @@ static void traceMessageInit(Arena arena, TraceMessage tMessage)
  *
  * .message.data: The trace end message contains the live size
  * (forwardedSize + preservedInPlaceSize), the condemned size
- * (condemned), and the not-condemned size (notCondemned).
+ * (condemned), the not-condemned size (notCondemned), the time spent
+ * in each phase, the longest pause (see <design/trace/#phase>), and
+ * the histogram of preserved objects, if any, which the message now
+ * owns (see <design/message-gc/#histogram>).
  */
 
 void TracePostMessage(Trace trace)
@@ -388,6 +663,7 @@ void TracePostMessage(Trace trace)
   Arena arena;
   TraceId ti;
   TraceMessage tMessage;
+  TracePhase phase;
 
   AVERT(Trace, trace);
   AVER(trace->state == TraceFINISHED);
@@ -405,6 +681,14 @@ void TracePostMessage(Trace trace)
     tMessage->liveSize = trace->forwardedSize + trace->preservedInPlaceSize;
     tMessage->condemnedSize = trace->condemned;
     tMessage->notCondemnedSize = trace->notCondemned;
+    for (phase = 0; phase < TracePhaseLIMIT; ++phase)
+      tMessage->phaseTime[phase] = trace->phaseTime[phase];
+    tMessage->maxPause = trace->maxPause;
+    if (trace->histogram != NULL) {
+      histogramCompact(trace->histogram);
+      tMessage->histogram = trace->histogram;
+      trace->histogram = NULL;
+    }
 
     arena->tMessage[ti] = NULL;
     MessagePost(arena, TraceMessageMessage(tMessage));
@@ -576,6 +860,7 @@ void ArenaPark(Globals globals)
 
   globals->clamped = TRUE;
   start = ClockNow();
+  arena->pauseStart = ClockNow();
 
   while(arena->busyTraces != TraceSetEMPTY) {
     /* Advance all active traces. */
@@ -662,6 +947,7 @@ Res ArenaStartCollect(Globals globals, int why)
   arena = GlobalsArena(globals);
 
   ArenaPark(globals);
+  arena->pauseStart = ClockNow();
   res = TraceStartCollectAll(&trace, arena, why);
   if(res != ResOK)
     goto failStart;
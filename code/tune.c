@@ -0,0 +1,1445 @@
+/* tune.c: Collection parameter tuner
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * $Id$
+ *
+ * Reads a telemetry stream, builds a model of the program's
+ * collections, and searches for generation chain and arena parameters
+ * that minimise the collection time or the peak memory, subject to a
+ * pause constraint.  The manual pools in the stream are tuned by
+ * repeated replay.  See <design/telemetry/#tune> and "Tuning
+ * parameters" in the Telemetry chapter of the reference manual.
+ */
+
+#include "config.h"
+#include "eventdef.h"
+#include "eventcom.h"
+#include "eventrep.h"
+#include "table.h"
+#include "testlib.h" /* for ulongest_t and associated print formats */
+#include "misc.h" /* for NELEMS */
+
+#include <math.h> /* for ceil, exp */
+#include <stddef.h> /* for size_t */
+#include <stdio.h> /* for printf */
+#include <stdarg.h> /* for va_list */
+#include <stdlib.h> /* for EXIT_FAILURE */
+#include <string.h> /* for strcmp */
+#include <time.h> /* for clock */
+#include "mpstd.h"
+
+#define DEFAULT_TELEMETRY_FILENAME "mpsio.log"
+#define TELEMETRY_FILENAME_ENVAR   "MPS_TELEMETRY_FILENAME"
+
+#define CHAINS_MAX  16          /* chains that can be tuned */
+#define GENS_MAX    8           /* generations in a tuned chain */
+#define TRACES_MAX  8           /* traces tracked at once */
+#define COHORTS_MAX 256         /* cohorts simulated in a generation */
+#define STEPS_MAX   ((double)((unsigned long)1 << 18)) /* simulated steps */
+#define FACTORS     7           /* candidate capacities per generation */
+#define FACTOR_ONE  3           /* index of the logged capacity */
+#define PASSES_MAX  4           /* coordinate descent passes */
+#define PAUSES      5           /* candidate pause times */
+#define MiB         ((double)((unsigned long)1 << 20))
+
+
+/* command-line arguments */
+
+static const char *prog; /* program name */
+static Bool minimiseMemory = FALSE; /* objective is peak memory, not time */
+static double pauseLimit = ARENA_DEFAULT_PAUSE_TIME; /* longest pause */
+static Bool replaySearch = TRUE; /* tune manual pools by replay */
+
+
+/* everror -- flush stdout, message to stderr, exit */
+
+ATTRIBUTE_FORMAT((printf, 1, 2))
+static void everror(const char *format, ...)
+{
+  va_list args;
+
+  fflush(stdout); /* sync */
+  fprintf(stderr, "%s: ", prog);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+  exit(EXIT_FAILURE);
+}
+
+
+/* usage -- usage message */
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "Usage: %s [-f logfile] [-m time|memory] [-P pause] [-R] [-h]\n"
+          "See \"Telemetry\" in the reference manual for instructions.\n",
+          prog);
+}
+
+
+/* usageError -- explain usage and error */
+
+static void usageError(void)
+{
+  usage();
+  everror("Bad usage");
+}
+
+
+/* parseArgs -- parse command line arguments, return log file name */
+
+static char *parseArgs(int argc, char *argv[])
+{
+  char *name = NULL;
+  int i = 1;
+
+  if (argc >= 1)
+    prog = argv[0];
+  else
+    prog = "unknown";
+
+  while (i < argc) { /* consider argument i */
+    if (argv[i][0] == '-') { /* it's an option argument */
+      switch (argv[i][1]) {
+      case 'f': /* file name */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else
+          name = argv[i];
+        break;
+      case 'm': /* objective */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else if (strcmp(argv[i], "time") == 0)
+          minimiseMemory = FALSE;
+        else if (strcmp(argv[i], "memory") == 0)
+          minimiseMemory = TRUE;
+        else
+          usageError();
+        break;
+      case 'P': /* pause constraint */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else {
+          char *end;
+          pauseLimit = strtod(argv[i], &end);
+          if (end == argv[i] || *end != '\0' || pauseLimit <= 0.0)
+            usageError();
+        }
+        break;
+      case 'R': /* no replay */
+        replaySearch = FALSE;
+        break;
+      case '?': case 'h': /* help */
+        usage();
+        exit(EXIT_SUCCESS);
+      default:
+        usageError();
+      }
+    } /* if option */
+    ++ i;
+  }
+  return name;
+}
+
+
+/* readLog -- read the whole log into memory */
+
+static char *readLog(size_t *sizeReturn, FILE *stream)
+{
+  char *log = NULL;
+  size_t size = 0, capacity = 0;
+
+  for (;;) {
+    size_t n;
+    if (size == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 20 : capacity * 2;
+      log = realloc(log, capacity);
+      if (log == NULL)
+        everror("Out of memory for log");
+    }
+    n = fread(log + size, 1, capacity - size, stream);
+    size += n;
+    if (size < capacity) {
+      if (ferror(stream))
+        everror("I/O error reading log");
+      break;
+    }
+  }
+  *sizeReturn = size;
+  return log;
+}
+
+
+/* Event index
+ *
+ * Events are analysed in timestamp order, as in the replayer.  See
+ * <design/telemetry/#replay.order>.
+ */
+
+typedef struct EventIndexStruct {
+  EventClock clock;     /* timestamp of event */
+  size_t offset;        /* position of event in log */
+} EventIndexStruct, *EventIndex;
+
+static int indexCompare(const void *a, const void *b)
+{
+  const EventIndexStruct *ia = a, *ib = b;
+  if (ia->clock != ib->clock)
+    return ia->clock < ib->clock ? -1 : 1;
+  if (ia->offset != ib->offset)
+    return ia->offset < ib->offset ? -1 : 1;
+  return 0;
+}
+
+static EventIndex indexLog(size_t *countReturn, const char *log, size_t size)
+{
+  EventIndex index = NULL;
+  size_t count = 0, capacity = 0, pos = 0;
+
+  while (size - pos >= sizeof(EventAnyStruct)) {
+    EventAnyStruct any;
+    (void)memcpy(&any, log + pos, sizeof any);
+    if (any.size < sizeof any || any.size > sizeof(EventUnion))
+      everror("Corrupt log: invalid event size %u", (unsigned)any.size);
+    if (size - pos < any.size)
+      break;
+    if (count == capacity) {
+      capacity = capacity == 0 ? (size_t)1 << 16 : capacity * 2;
+      index = realloc(index, capacity * sizeof *index);
+      if (index == NULL)
+        everror("Out of memory for event index");
+    }
+    index[count].clock = any.clock;
+    index[count].offset = pos;
+    ++count;
+    pos += any.size;
+  }
+  if (pos != size)
+    everror("Truncated log");
+  qsort(index, count, sizeof *index, indexCompare);
+  *countReturn = count;
+  return index;
+}
+
+static void indexEvent(EventUnion *eventReturn, const char *log,
+                       EventIndex index, size_t i)
+{
+  EventAnyStruct any;
+  const char *p = log + index[i].offset;
+  (void)memcpy(&any, p, sizeof any);
+  (void)memcpy(eventReturn, p, any.size);
+}
+
+
+/* Samples -- a growable array of doubles */
+
+typedef struct SamplesStruct {
+  size_t count, capacity;
+  double *value;
+} SamplesStruct, *Samples;
+
+static void samplesAdd(Samples samples, double value)
+{
+  if (samples->count == samples->capacity) {
+    samples->capacity = samples->capacity == 0 ? 256 : samples->capacity * 2;
+    samples->value = realloc(samples->value,
+                             samples->capacity * sizeof(double));
+    if (samples->value == NULL)
+      everror("Out of memory for samples");
+  }
+  samples->value[samples->count] = value;
+  ++samples->count;
+}
+
+static int doubleCompare(const void *a, const void *b)
+{
+  const double *da = a, *db = b;
+  return *da < *db ? -1 : *da > *db ? 1 : 0;
+}
+
+/* samplesPercentile -- return a percentile of the samples, which are
+ * sorted in place */
+
+static double samplesPercentile(Samples samples, double percentile)
+{
+  size_t i;
+  if (samples->count == 0)
+    return 0.0;
+  qsort(samples->value, samples->count, sizeof(double), doubleCompare);
+  i = (size_t)(percentile / 100.0 * (double)(samples->count - 1) + 0.5);
+  return samples->value[i];
+}
+
+
+/* Profile of the program
+ *
+ * The analysis of the telemetry stream results in these structures.
+ * See <design/telemetry/#tune.profile>.
+ */
+
+typedef struct GenStatsStruct {
+  void *logGen;         /* generation in the log */
+  double capacity;      /* logged capacity, in bytes */
+  double mortality;     /* logged initial mortality */
+  double condemned;     /* bytes condemned */
+  double survived;      /* bytes forwarded or preserved */
+} GenStatsStruct, *GenStats;
+
+typedef struct ChainStatsStruct {
+  void *logChain;       /* chain in the log */
+  size_t genCount;      /* number of generations */
+  GenStatsStruct gen[GENS_MAX];
+  double allocated;     /* bytes allocated by the mutator */
+  Bool moving;          /* has a pool that copies survivors */
+} ChainStatsStruct, *ChainStats;
+
+typedef struct PoolStatsStruct {
+  ChainStats chain;     /* chain whose nursery the pool allocates in */
+  size_t serial;        /* serial of generation the pool allocates in */
+  Bool moving;          /* copies survivors */
+} PoolStatsStruct, *PoolStats;
+
+typedef struct TraceRecStruct {
+  void *logTrace;       /* trace in the log, or NULL if slot is free */
+  EventClock start;     /* time of TraceStart */
+  EventClock end;       /* time of TraceDestroy */
+  Bool destroyed;       /* TraceDestroy seen */
+  double condemned;     /* bytes condemned */
+  double survived;      /* bytes surviving */
+  double pollTicks;     /* time in polls attributed to this trace */
+} TraceRecStruct, *TraceRec;
+
+static ChainStatsStruct chains[CHAINS_MAX];
+static size_t chainCount = 0;
+static Table poolTable;         /* logged pool -> PoolStats */
+static Table bufferTable;       /* logged mutator buffer -> PoolStats */
+static TraceRecStruct traces[TRACES_MAX];
+
+static Word clocksPerSec = 0;   /* mps_clock() ticks per second */
+static Bool haveSync = FALSE;   /* syncFirst and syncLast are valid */
+static EventClock syncFirstEvent, syncLastEvent; /* event clock ... */
+static Word syncFirstMPS, syncLastMPS; /* ... and mps_clock() at same time */
+static EventClock firstClock, lastClock; /* span of the stream */
+static double loggedPauseTime = ARENA_DEFAULT_PAUSE_TIME;
+
+static Bool inPoll = FALSE;
+static EventClock pollBegin;    /* event clock at start of poll */
+static Word pollStart;          /* mps_clock() at start of poll */
+static Bool inAccess = FALSE;
+static EventClock accessBegin;  /* event clock at start of access */
+static Word accessCount;        /* count of access in progress */
+static Bool inFlip = FALSE;
+static EventClock flipBegin;    /* event clock at start of flip */
+
+static SamplesStruct traceCondemned, traceSurvived, traceTicks;
+static SamplesStruct pollTicks; /* duration of polls that did work */
+static double pollTicksTotal = 0.0;
+static double accessTicksTotal = 0.0, accessTicksMax = 0.0;
+static double flipTicksMax = 0.0;
+static unsigned long accessCountTotal = 0;
+
+
+/* table support, as in eventrep.c */
+
+static void *tableAlloc(void *closure, size_t size)
+{
+  void *p;
+  testlib_unused(closure);
+  p = malloc(size);
+  if (p == NULL)
+    everror("Out of memory for table");
+  return p;
+}
+
+static void tableFree(void *closure, void *p, size_t size)
+{
+  testlib_unused(closure);
+  testlib_unused(size);
+  free(p);
+}
+
+static Table tableCreate(Count length)
+{
+  Table table;
+  Res res;
+
+  res = TableCreate(&table, length, tableAlloc, tableFree, NULL,
+                    (TableKey)-1, (TableKey)-2);
+  if (res != ResOK)
+    everror("Can't create table: error %d.", res);
+  return table;
+}
+
+
+/* chainLookup -- find or create the statistics for a logged chain */
+
+static ChainStats chainLookup(void *logChain)
+{
+  size_t i;
+  ChainStats chain;
+
+  for (i = 0; i < chainCount; ++i)
+    if (chains[i].logChain == logChain)
+      return &chains[i];
+  if (chainCount == CHAINS_MAX)
+    return NULL;
+  chain = &chains[chainCount];
+  ++chainCount;
+  chain->logChain = logChain;
+  chain->genCount = 0;
+  chain->allocated = 0.0;
+  chain->moving = FALSE;
+  return chain;
+}
+
+
+/* genLookup -- find the chain and serial of a logged generation
+ *
+ * Returns NULL for generations that aren't in any chain that is
+ * tuned, such as the arena's top generation.
+ */
+
+static ChainStats genLookup(size_t *serialReturn, void *logGen)
+{
+  size_t i, j;
+
+  for (i = 0; i < chainCount; ++i)
+    for (j = 0; j < chains[i].genCount; ++j)
+      if (chains[i].gen[j].logGen == logGen) {
+        *serialReturn = j;
+        return &chains[i];
+      }
+  return NULL;
+}
+
+
+/* poolLookup -- find or create the statistics for a logged pool */
+
+static PoolStats poolLookup(void *logPool)
+{
+  void *entry;
+  PoolStats pool;
+  Res res;
+
+  if (TableLookup(&entry, poolTable, (TableKey)logPool))
+    return entry;
+  pool = malloc(sizeof *pool);
+  if (pool == NULL)
+    everror("Out of memory for pool");
+  pool->chain = NULL;
+  pool->serial = GENS_MAX;
+  pool->moving = FALSE;
+  res = TableDefine(poolTable, (TableKey)logPool, pool);
+  if (res != ResOK)
+    everror("Can't define pool: error %d.", res);
+  return pool;
+}
+
+
+/* traceLookup -- find the record of an active trace */
+
+static TraceRec traceLookup(void *logTrace)
+{
+  size_t i;
+  for (i = 0; i < TRACES_MAX; ++i)
+    if (traces[i].logTrace == logTrace && !traces[i].destroyed)
+      return &traces[i];
+  return NULL;
+}
+
+
+/* traceFinish -- record a finished trace as a sample for the cost model
+ *
+ * A trace that made progress in polls is charged for the time spent
+ * in those polls; a trace that didn't (because it was run to
+ * completion by mps_arena_collect or mps_arena_park) is charged for
+ * its whole duration.
+ */
+
+static void traceFinish(TraceRec trace)
+{
+  double ticks = trace->pollTicks;
+  if (ticks == 0.0)
+    ticks = (double)(trace->end - trace->start);
+  samplesAdd(&traceCondemned, trace->condemned);
+  samplesAdd(&traceSurvived, trace->survived);
+  samplesAdd(&traceTicks, ticks);
+  trace->logTrace = NULL;
+}
+
+
+/* syncClocks -- note a pair of simultaneous event and mps_clock times */
+
+static void syncClocks(EventClock eventClock, Word mpsClock)
+{
+  if (!haveSync) {
+    syncFirstEvent = eventClock;
+    syncFirstMPS = mpsClock;
+    haveSync = TRUE;
+  }
+  syncLastEvent = eventClock;
+  syncLastMPS = mpsClock;
+}
+
+
+/* analyse -- add an event to the profile */
+
+static void analyse(Event event)
+{
+  EventClock now = event->any.clock;
+  ChainStats chain;
+  PoolStats pool;
+  TraceRec trace;
+  void *entry;
+  size_t serial, i;
+  Res res;
+
+  lastClock = now;
+  switch (event->any.code) {
+  case EventEventInitCode:
+    clocksPerSec = event->EventInit.f6;
+    break;
+  case EventEventClockSyncCode:
+    syncClocks(now, event->EventClockSync.f0);
+    break;
+  case EventPauseTimeSetCode:
+    loggedPauseTime = event->PauseTimeSet.f1;
+    break;
+  case EventGenInitCode: /* chain, gen, serial, capacity, mortality */
+    serial = (size_t)event->GenInit.f2;
+    chain = chainLookup(event->GenInit.f0);
+    if (chain == NULL || serial >= GENS_MAX)
+      break;
+    chain->gen[serial].logGen = event->GenInit.f1;
+    chain->gen[serial].capacity = (double)event->GenInit.f3;
+    chain->gen[serial].mortality = event->GenInit.f4;
+    chain->gen[serial].condemned = 0.0;
+    chain->gen[serial].survived = 0.0;
+    if (serial >= chain->genCount)
+      chain->genCount = serial + 1;
+    break;
+  case EventPoolGenInitCode: /* pool, gen */
+    chain = genLookup(&serial, event->PoolGenInit.f1);
+    if (chain != NULL) {
+      pool = poolLookup(event->PoolGenInit.f0);
+      if (serial < pool->serial) {
+        pool->chain = chain;
+        pool->serial = serial;
+        chain->moving = chain->moving || pool->moving;
+      }
+    }
+    break;
+  case EventPoolInitAMCCode: /* pool, format */
+    /* AMC copies survivors to the next generation. */
+    pool = poolLookup(event->PoolInitAMC.f0);
+    pool->moving = TRUE;
+    if (pool->chain != NULL)
+      pool->chain->moving = TRUE;
+    break;
+  case EventPoolInitAMCZCode: /* pool, format */
+    pool = poolLookup(event->PoolInitAMCZ.f0);
+    pool->moving = TRUE;
+    if (pool->chain != NULL)
+      pool->chain->moving = TRUE;
+    break;
+  case EventBufferInitCode: /* buffer, pool, isMutator */
+    if (event->BufferInit.f2
+        && TableLookup(&entry, poolTable, (TableKey)event->BufferInit.f1)) {
+      res = TableRedefine(bufferTable, (TableKey)event->BufferInit.f0, entry);
+      if (res != ResOK)
+        res = TableDefine(bufferTable, (TableKey)event->BufferInit.f0,
+                          entry);
+      if (res != ResOK)
+        everror("Can't define buffer: error %d.", res);
+    }
+    break;
+  case EventBufferFinishCode: /* buffer */
+    if (TableLookup(&entry, bufferTable, (TableKey)event->BufferFinish.f0))
+      (void)TableRemove(bufferTable, (TableKey)event->BufferFinish.f0);
+    break;
+  case EventBufferFillCode: /* buffer, size, base, filled */
+    if (TableLookup(&entry, bufferTable, (TableKey)event->BufferFill.f0)) {
+      pool = entry;
+      if (pool->chain != NULL && pool->serial == 0)
+        pool->chain->allocated += (double)event->BufferFill.f3;
+    }
+    break;
+  case EventBufferEmptyCode: /* buffer, spare */
+    if (TableLookup(&entry, bufferTable, (TableKey)event->BufferEmpty.f0)) {
+      pool = entry;
+      if (pool->chain != NULL && pool->serial == 0)
+        pool->chain->allocated -= (double)event->BufferEmpty.f1;
+    }
+    break;
+  case EventTraceStartCode: /* trace, mortality, finishingTime, condemned, ... */
+    for (i = 0; i < TRACES_MAX; ++i)
+      if (traces[i].logTrace == NULL)
+        break;
+    if (i == TRACES_MAX)
+      everror("Too many traces at once");
+    trace = &traces[i];
+    trace->logTrace = event->TraceStart.f0;
+    trace->start = now;
+    trace->end = now;
+    trace->destroyed = FALSE;
+    trace->condemned = (double)event->TraceStart.f3;
+    trace->survived = 0.0;
+    trace->pollTicks = 0.0;
+    break;
+  case EventTraceEndGenCode:
+    /* trace, gen, condemned, forwarded, preservedInPlace, mortality */
+    trace = traceLookup(event->TraceEndGen.f0);
+    if (trace != NULL)
+      trace->survived += (double)(event->TraceEndGen.f3
+                                  + event->TraceEndGen.f4);
+    chain = genLookup(&serial, event->TraceEndGen.f1);
+    if (chain != NULL) {
+      chain->gen[serial].condemned += (double)event->TraceEndGen.f2;
+      chain->gen[serial].survived += (double)(event->TraceEndGen.f3
+                                              + event->TraceEndGen.f4);
+    }
+    break;
+  case EventTraceFlipBeginCode: /* trace, arena */
+    inFlip = TRUE;
+    flipBegin = now;
+    break;
+  case EventTraceFlipEndCode: /* trace, arena */
+    if (inFlip && (double)(now - flipBegin) > flipTicksMax)
+      flipTicksMax = (double)(now - flipBegin);
+    inFlip = FALSE;
+    break;
+  case EventTraceDestroyCode: /* trace */
+    trace = traceLookup(event->TraceDestroy.f0);
+    if (trace != NULL) {
+      trace->end = now;
+      trace->destroyed = TRUE;
+      if (!inPoll)
+        traceFinish(trace);
+    }
+    break;
+  case EventArenaPollCode: /* arena, start, workWasDone */
+    if (!inPoll || event->ArenaPoll.f1 != pollStart) {
+      /* Start of poll: the start field is mps_clock() at this time. */
+      inPoll = TRUE;
+      pollBegin = now;
+      pollStart = event->ArenaPoll.f1;
+      syncClocks(now, pollStart);
+    } else {
+      double ticks = (double)(now - pollBegin);
+      size_t active = 0;
+      inPoll = FALSE;
+      if (!event->ArenaPoll.f2)
+        break;
+      samplesAdd(&pollTicks, ticks);
+      pollTicksTotal += ticks;
+      for (i = 0; i < TRACES_MAX; ++i)
+        if (traces[i].logTrace != NULL)
+          ++active;
+      for (i = 0; i < TRACES_MAX; ++i)
+        if (traces[i].logTrace != NULL) {
+          traces[i].pollTicks += ticks / (double)active;
+          if (traces[i].destroyed)
+            traceFinish(&traces[i]);
+        }
+    }
+    break;
+  case EventArenaAccessCode: /* arena, count, addr, mode */
+    if (!inAccess) {
+      inAccess = TRUE;
+      accessBegin = now;
+      accessCount = event->ArenaAccess.f1;
+    } else if (event->ArenaAccess.f1 == accessCount) {
+      double ticks = (double)(now - accessBegin);
+      inAccess = FALSE;
+      accessTicksTotal += ticks;
+      if (ticks > accessTicksMax)
+        accessTicksMax = ticks;
+      ++accessCountTotal;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+
+/* Cost model
+ *
+ * The time taken by a collection is modelled as a cost per byte
+ * condemned plus a cost per byte surviving, fitted to the traces in
+ * the stream by least squares.  Each increment of collection work
+ * costs the mutator some barrier hits, modelled as a fixed overhead
+ * per increment.  See <design/telemetry/#tune.cost>.
+ */
+
+typedef struct CostStruct {
+  double ticksPerSec;   /* event clock ticks per second */
+  double condemned;     /* seconds per byte condemned */
+  double survived;      /* seconds per byte surviving */
+  double increment;     /* seconds of overhead per increment */
+  double flipMax;       /* longest flip, in seconds */
+  double accessMax;     /* longest barrier hit, in seconds */
+} CostStruct, *Cost;
+
+static void costFit(Cost cost)
+{
+  double cc = 0.0, cs = 0.0, ss = 0.0, ct = 0.0, st = 0.0, det;
+  size_t i;
+
+  cost->ticksPerSec = (double)clocksPerSec;
+  if (haveSync && syncLastMPS > syncFirstMPS && clocksPerSec > 0)
+    cost->ticksPerSec = (double)(syncLastEvent - syncFirstEvent)
+      / ((double)(syncLastMPS - syncFirstMPS) / (double)clocksPerSec);
+  if (cost->ticksPerSec <= 0.0)
+    everror("Can't calibrate event clock: no EventInit event in log");
+
+  for (i = 0; i < traceTicks.count; ++i) {
+    double c = traceCondemned.value[i], s = traceSurvived.value[i];
+    double t = traceTicks.value[i] / cost->ticksPerSec;
+    cc += c * c; cs += c * s; ss += s * s; ct += c * t; st += s * t;
+  }
+  det = cc * ss - cs * cs;
+  cost->condemned = 0.0;
+  cost->survived = 0.0;
+  if (det > 1e-9 * cc * ss) {
+    cost->condemned = (ct * ss - st * cs) / det;
+    cost->survived = (st * cc - ct * cs) / det;
+  }
+  if (cost->condemned <= 0.0 || cost->survived < 0.0) {
+    /* Fall back to charging for bytes condemned only. */
+    cost->condemned = cc > 0.0 ? ct / cc : 0.0;
+    cost->survived = 0.0;
+  }
+  cost->increment = pollTicks.count == 0 ? 0.0
+    : accessTicksTotal / cost->ticksPerSec / (double)pollTicks.count;
+  cost->flipMax = flipTicksMax / cost->ticksPerSec;
+  cost->accessMax = accessTicksMax / cost->ticksPerSec;
+}
+
+
+/* Simulation
+ *
+ * A chain is simulated by allocating in steps of a fixed quantum,
+ * each step making a cohort of objects born at the same time, whose
+ * surviving fraction at age a (measured in bytes allocated since) is
+ * p + (1 - p) exp(-a / tau).  A generation is collected when its new
+ * size reaches its capacity, as in policyCondemnChain, and survivors
+ * are promoted to the next generation; those from the last generation
+ * are promoted to the arena's top generation, which is not collected.
+ * See <design/telemetry/#tune.sim>.
+ */
+
+typedef struct ModelStruct {
+  double p;             /* fraction of bytes that are long-lived */
+  double tau;           /* decay scale of the rest, in bytes */
+  double quantum;       /* bytes allocated per simulated step */
+  double allocated;     /* total bytes to allocate */
+  Bool moving;          /* survivors are copied */
+  Cost cost;            /* cost model */
+  double pause[PAUSES]; /* candidate pause times */
+} ModelStruct, *Model;
+
+typedef struct SimResultStruct {
+  double work;          /* collection work, in seconds */
+  double maxWork;       /* work of the largest collection, in seconds */
+  double increments[PAUSES]; /* increments for each pause time */
+  double peak;          /* peak memory, in bytes */
+  double condemned[GENS_MAX], survived[GENS_MAX];
+  unsigned long collections;
+} SimResultStruct, *SimResult;
+
+typedef struct CohortStruct {
+  double birth;         /* time of birth, in bytes allocated */
+  double size;          /* bytes allocated */
+  double occupied;      /* bytes occupied, as of last collection */
+} CohortStruct, *Cohort;
+
+typedef struct SimGenStruct {
+  size_t count;
+  double occupied;      /* total bytes occupied by cohorts */
+  CohortStruct cohort[COHORTS_MAX];
+} SimGenStruct, *SimGen;
+
+static SimGenStruct simGen[GENS_MAX];
+
+static double survival(Model model, double age)
+{
+  return model->p + (1.0 - model->p) * exp(-age / model->tau);
+}
+
+/* simGenAdd -- add a cohort to a generation, halving the number of
+ * cohorts by merging neighbours if it is full */
+
+static void simGenAdd(SimGen gen, double birth, double size,
+                      double occupied)
+{
+  Cohort c;
+  if (gen->count == COHORTS_MAX) {
+    size_t i;
+    for (i = 0; i < COHORTS_MAX / 2; ++i) {
+      Cohort a = &gen->cohort[2 * i], b = &gen->cohort[2 * i + 1];
+      c = &gen->cohort[i];
+      c->birth = (a->birth * a->size + b->birth * b->size)
+        / (a->size + b->size);
+      c->size = a->size + b->size;
+      c->occupied = a->occupied + b->occupied;
+    }
+    gen->count = COHORTS_MAX / 2;
+  }
+  c = &gen->cohort[gen->count];
+  c->birth = birth;
+  c->size = size;
+  c->occupied = occupied;
+  ++gen->count;
+  gen->occupied += occupied;
+}
+
+static void simulate(SimResult result, Model model, size_t genCount,
+                     const double *capacity)
+{
+  double now = 0.0, total = 0.0;
+  size_t i, j, k;
+
+  result->work = 0.0;
+  result->maxWork = 0.0;
+  for (k = 0; k < PAUSES; ++k)
+    result->increments[k] = 0.0;
+  result->peak = 0.0;
+  result->collections = 0;
+  for (i = 0; i < genCount; ++i) {
+    simGen[i].count = 0;
+    simGen[i].occupied = 0.0;
+    result->condemned[i] = 0.0;
+    result->survived[i] = 0.0;
+  }
+
+  while (now < model->allocated) {
+    now += model->quantum;
+    simGenAdd(&simGen[0], now - model->quantum / 2, model->quantum,
+              model->quantum);
+    total += model->quantum;
+    if (total > result->peak)
+      result->peak = total;
+
+    if (simGen[0].occupied >= capacity[0]) {
+      double condemned = 0.0, survived = 0.0, work;
+      size_t top = genCount;
+      do
+        --top;
+      while (simGen[top].occupied < capacity[top]);
+      for (i = top + 1; i-- > 0;) {
+        SimGen gen = &simGen[i];
+        for (j = 0; j < gen->count; ++j) {
+          Cohort c = &gen->cohort[j];
+          double alive = c->size * survival(model, now - c->birth);
+          if (alive > c->occupied)
+            alive = c->occupied;
+          result->condemned[i] += c->occupied;
+          result->survived[i] += alive;
+          condemned += c->occupied;
+          survived += alive;
+          if (i + 1 < genCount)
+            simGenAdd(&simGen[i + 1], c->birth, c->size, alive);
+        }
+        gen->count = 0;
+        gen->occupied = 0.0;
+      }
+      if (model->moving && total + survived > result->peak)
+        result->peak = total + survived;
+      total += survived - condemned;
+      work = model->cost->condemned * condemned
+        + model->cost->survived * survived;
+      result->work += work;
+      if (work > result->maxWork)
+        result->maxWork = work;
+      for (k = 0; k < PAUSES; ++k)
+        result->increments[k] += work > 0.0
+          ? ceil(work / model->pause[k]) : 1.0;
+      ++result->collections;
+    }
+  }
+}
+
+
+/* simTime, simPause -- predicted collection time and longest pause */
+
+static double simTime(Model model, SimResult result, size_t k)
+{
+  return result->work + model->cost->increment * result->increments[k];
+}
+
+static double simPause(Model model, SimResult result, size_t k)
+{
+  double pause = result->maxWork;
+  if (pause > model->pause[k])
+    pause = model->pause[k];
+  if (pause < model->cost->flipMax)
+    pause = model->cost->flipMax;
+  if (pause < model->cost->accessMax)
+    pause = model->cost->accessMax;
+  return pause;
+}
+
+
+/* Search
+ *
+ * The lifetime model is fitted to the survival observed in each
+ * generation by a grid search over p and tau.  Then, for each
+ * candidate pause time, each generation's capacity in turn is tried at
+ * FACTORS multiples of its logged capacity with the others held fixed,
+ * until a pass over the generations changes nothing or PASSES_MAX
+ * passes have been made.  Trying every combination would take
+ * FACTORS^genCount simulations.  See <design/telemetry/#tune.search>.
+ */
+
+static const double pGrid[] = {
+  0.0, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5, 0.7, 0.9
+};
+
+static const double factor[FACTORS] = {
+  0.125, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0
+};
+
+typedef struct BestStruct {
+  Bool found;
+  size_t index[GENS_MAX];       /* factor index for each generation */
+  double capacity[GENS_MAX];
+  double time, pause;
+  SimResultStruct result;
+} BestStruct, *Best;
+
+typedef struct TuneStruct {
+  ModelStruct model;
+  SimResultStruct logged;       /* simulation of logged parameters */
+  BestStruct best[PAUSES];      /* best configuration for each pause */
+} TuneStruct, *Tune;
+
+static TuneStruct tunes[CHAINS_MAX];
+
+static void fitLifetimes(Model model, ChainStats chain)
+{
+  double capacity[GENS_MAX], bestError = -1.0, bestP = 0.0, bestTau = 1.0;
+  SimResultStruct result;
+  size_t i, j, k;
+
+  for (i = 0; i < chain->genCount; ++i)
+    capacity[i] = chain->gen[i].capacity;
+  for (i = 0; i < NELEMS(pGrid); ++i) {
+    for (j = 0; j < 21; ++j) {
+      double error = 0.0;
+      model->p = pGrid[i];
+      model->tau = capacity[0] * ldexp(1.0, (int)j - 8);
+      simulate(&result, model, chain->genCount, capacity);
+      for (k = 0; k < chain->genCount; ++k) {
+        GenStats gen = &chain->gen[k];
+        if (gen->condemned > 0.0) {
+          double observed = gen->survived / gen->condemned;
+          double predicted = result.condemned[k] > 0.0
+            ? result.survived[k] / result.condemned[k] : 1.0;
+          error += (observed - predicted) * (observed - predicted);
+        }
+      }
+      if (bestError < 0.0 || error < bestError) {
+        bestError = error;
+        bestP = model->p;
+        bestTau = model->tau;
+      }
+    }
+  }
+  model->p = bestP;
+  model->tau = bestTau;
+}
+
+static Bool better(Best best, double time, SimResult result)
+{
+  if (!best->found)
+    return TRUE;
+  if (minimiseMemory)
+    return result->peak < best->result.peak
+      || (result->peak == best->result.peak && time < best->time);
+  return time < best->time
+    || (time == best->time && result->peak < best->result.peak);
+}
+
+/* consider -- simulate a configuration and keep it where it is best
+ *
+ * Returns TRUE if it is the new best configuration for pause k.
+ */
+
+static Bool consider(Tune tune, ChainStats chain, size_t index[], size_t k)
+{
+  Model model = &tune->model;
+  SimResultStruct result;
+  double capacity[GENS_MAX];
+  Bool improved = FALSE;
+  size_t i, j;
+
+  for (i = 0; i < chain->genCount; ++i)
+    capacity[i] = chain->gen[i].capacity * factor[index[i]];
+  simulate(&result, model, chain->genCount, capacity);
+  for (j = 0; j < PAUSES; ++j) {
+    Best best = &tune->best[j];
+    double time = simTime(model, &result, j);
+    double pause = simPause(model, &result, j);
+    if (pause <= pauseLimit && better(best, time, &result)) {
+      best->found = TRUE;
+      best->time = time;
+      best->pause = pause;
+      best->result = result;
+      for (i = 0; i < chain->genCount; ++i) {
+        best->index[i] = index[i];
+        best->capacity[i] = capacity[i];
+      }
+      if (j == k)
+        improved = TRUE;
+    }
+  }
+  return improved;
+}
+
+static void search(Tune tune, ChainStats chain)
+{
+  Model model = &tune->model;
+  size_t index[GENS_MAX];
+  double capacity[GENS_MAX], minCapacity;
+  size_t i, k, pass;
+
+  minCapacity = chain->gen[0].capacity;
+  for (i = 0; i < chain->genCount; ++i) {
+    capacity[i] = chain->gen[i].capacity;
+    if (capacity[i] < minCapacity)
+      minCapacity = capacity[i];
+  }
+  model->allocated = chain->allocated;
+  model->moving = chain->moving;
+  model->quantum = minCapacity * factor[0] / 8.0;
+  if (model->allocated / model->quantum > STEPS_MAX)
+    model->quantum = model->allocated / STEPS_MAX;
+
+  fitLifetimes(model, chain);
+  simulate(&tune->logged, model, chain->genCount, capacity);
+
+  for (k = 0; k < PAUSES; ++k)
+    tune->best[k].found = FALSE;
+
+  /* Every simulation is offered to every pause, so the descent for
+     pause k starts from the best configuration found so far for it,
+     or from the logged capacities. */
+  for (k = 0; k < PAUSES; ++k) {
+    Bool changed = TRUE;
+    if (tune->best[k].found) {
+      for (i = 0; i < chain->genCount; ++i)
+        index[i] = tune->best[k].index[i];
+    } else {
+      for (i = 0; i < chain->genCount; ++i)
+        index[i] = FACTOR_ONE;
+      (void)consider(tune, chain, index, k);
+    }
+    for (pass = 0; changed && pass < PASSES_MAX; ++pass) {
+      changed = FALSE;
+      for (i = 0; i < chain->genCount; ++i) {
+        size_t current = index[i], chosen = index[i], f;
+        for (f = 0; f < FACTORS; ++f) {
+          if (f == current)
+            continue;
+          index[i] = f;
+          if (consider(tune, chain, index, k))
+            chosen = f;
+        }
+        index[i] = chosen;
+        if (chosen != current)
+          changed = TRUE;
+      }
+    }
+  }
+}
+
+
+/* Replay search
+ *
+ * The manual pools are replayed with candidate values of MVFF's
+ * extendBy and then of the arena's spare commit limit, one parameter
+ * at a time.  See <design/telemetry/#tune.replay>.
+ */
+
+typedef struct ReplayResultStruct {
+  size_t extendBy, spareCommitLimit; /* 0 means as logged */
+  double time;
+  size_t peakCommitted;
+} ReplayResultStruct, *ReplayResult;
+
+static void replay(ReplayResult result, const char *log, EventIndex index,
+                   size_t count, size_t extendBy, size_t spareCommitLimit)
+{
+  size_t i;
+  clock_t start;
+  Res res;
+
+  res = EventRepInit(EventRepClassLOG, 0, 0, extendBy, spareCommitLimit);
+  if (res != ResOK)
+    everror("Can't init EventRep module: error %d.", res);
+  start = clock();
+  for (i = 0; i < count; ++i) {
+    EventUnion eventUnion;
+    indexEvent(&eventUnion, log, index, i);
+    EventReplay(&eventUnion);
+  }
+  result->time = (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+  result->extendBy = extendBy;
+  result->spareCommitLimit = spareCommitLimit;
+  result->peakCommitted = EventRepPeakCommitted();
+  EventRepFinish();
+}
+
+static Bool replayBetter(ReplayResult a, ReplayResult b)
+{
+  if (minimiseMemory)
+    return a->peakCommitted < b->peakCommitted
+      || (a->peakCommitted == b->peakCommitted && a->time < b->time);
+  return a->time < b->time
+    || (a->time == b->time && a->peakCommitted < b->peakCommitted);
+}
+
+/* printSize -- print a replayed parameter
+ *
+ * A spare commit limit of 1 byte is used to mean none at all, since 0
+ * means the logged limit; see eventrep.h.
+ */
+
+static void printSize(size_t size)
+{
+  if (size == 0)
+    printf("%10s", "logged");
+  else
+    printf("%10"PRIuLONGEST, (ulongest_t)(size == 1 ? 0 : size));
+}
+
+static void printReplay(ReplayResult result)
+{
+  printf("  ");
+  printSize(result->extendBy);
+  printf("  ");
+  printSize(result->spareCommitLimit);
+  printf("  %8.3f  %14"PRIuLONGEST"\n", result->time,
+         (ulongest_t)result->peakCommitted);
+}
+
+static const size_t extendByGrid[] = {
+  (size_t)1 << 16, (size_t)1 << 18, (size_t)1 << 20, (size_t)1 << 22
+};
+
+static const size_t spareGrid[] = {
+  1, (size_t)1 << 20, (size_t)1 << 24, (size_t)1 << 26
+};
+
+static Bool replayTune(ReplayResult bestReturn, const char *log,
+                       EventIndex index, size_t count)
+{
+  ReplayResultStruct best, result;
+  size_t i;
+
+  /* Ensure no telemetry output from the replay itself, which would
+     overwrite the log if it's the default. */
+  if (setenv("MPS_TELEMETRY_CONTROL", "0", 1) != 0)
+    everror("failed to set MPS_TELEMETRY_CONTROL");
+
+  replay(&best, log, index, count, 0, 0);
+  if (EventRepPools() == 0)
+    return FALSE;
+  printf("\nReplay of manual pools (objective: %s):\n"
+         "    extendBy  spare limit    time/s  peak committed\n",
+         minimiseMemory ? "peak committed" : "time");
+  printReplay(&best);
+  for (i = 0; i < NELEMS(extendByGrid); ++i) {
+    replay(&result, log, index, count, extendByGrid[i], 0);
+    printReplay(&result);
+    if (replayBetter(&result, &best))
+      best = result;
+  }
+  for (i = 0; i < NELEMS(spareGrid); ++i) {
+    replay(&result, log, index, count, best.extendBy, spareGrid[i]);
+    printReplay(&result);
+    if (replayBetter(&result, &best))
+      best = result;
+  }
+  *bestReturn = best;
+  return TRUE;
+}
+
+
+/* report -- print the profile and the recommended parameters */
+
+static void printPercent(const char *label, double numerator,
+                         double denominator)
+{
+  if (denominator > 0.0)
+    printf("%s%5.1f%%", label, 100.0 * numerator / denominator);
+  else
+    printf("%s%6s", label, "-");
+}
+
+static void reportProfile(Cost cost)
+{
+  double logTime = (double)(lastClock - firstClock) / cost->ticksPerSec;
+  double traceTime = 0.0;
+  size_t i;
+
+  if (traceTicks.count == 0) {
+    printf("Log: %.3f s, no collections\n", logTime);
+    return;
+  }
+  for (i = 0; i < traceTicks.count; ++i)
+    traceTime += traceTicks.value[i] / cost->ticksPerSec;
+  printf("Log: %.3f s, %lu collections taking %.3f s"
+         " (%.3f s in %lu increments), %lu barrier hits\n",
+         logTime, (unsigned long)traceTicks.count, traceTime,
+         pollTicksTotal / cost->ticksPerSec,
+         (unsigned long)pollTicks.count, accessCountTotal);
+  printf("Pauses: p50 %.6f s, p99 %.6f s, max %.6f s;"
+         " longest flip %.6f s, longest barrier hit %.6f s\n",
+         samplesPercentile(&pollTicks, 50.0) / cost->ticksPerSec,
+         samplesPercentile(&pollTicks, 99.0) / cost->ticksPerSec,
+         samplesPercentile(&pollTicks, 100.0) / cost->ticksPerSec,
+         cost->flipMax, cost->accessMax);
+  printf("Cost model: %.3g ns per byte condemned, %.3g ns per byte"
+         " surviving, %.3g s per increment\n",
+         cost->condemned * 1e9, cost->survived * 1e9, cost->increment);
+}
+
+static void reportChain(size_t c, ChainStats chain, Tune tune, size_t k)
+{
+  Model model = &tune->model;
+  Best best = &tune->best[k];
+  size_t i;
+
+  printf("\nChain %lu: %lu generations, %.1f MiB allocated%s\n",
+         (unsigned long)c, (unsigned long)chain->genCount,
+         chain->allocated / MiB, chain->moving ? ", copying" : "");
+  printf("  Lifetime model: %.1f%% of bytes long-lived,"
+         " the rest decaying with scale %.2f MiB\n",
+         100.0 * model->p, model->tau / MiB);
+  printf("  %-10s %12s %10s %10s %12s %10s\n", "generation",
+         "logged/KiB", "observed", "simulated", "tuned/KiB", "predicted");
+  for (i = 0; i < chain->genCount; ++i) {
+    GenStats gen = &chain->gen[i];
+    printf("  %-10lu %12.0f", (unsigned long)i, gen->capacity / 1024.0);
+    printPercent("     ", gen->survived, gen->condemned);
+    printPercent("     ", tune->logged.survived[i],
+                 tune->logged.condemned[i]);
+    if (best->found) {
+      printf(" %12.0f", best->capacity[i] / 1024.0);
+      printPercent("     ", best->result.survived[i],
+                   best->result.condemned[i]);
+    }
+    printf("\n");
+  }
+  printf("  Logged parameters: %lu collections, %.3f s, peak %.1f MiB,"
+         " longest pause %.6f s\n",
+         tune->logged.collections, simTime(model, &tune->logged, 0),
+         tune->logged.peak / MiB, simPause(model, &tune->logged, 0));
+  if (best->found)
+    printf("  Tuned parameters:  %lu collections, %.3f s, peak %.1f MiB,"
+           " longest pause %.6f s\n",
+           best->result.collections, best->time,
+           best->result.peak / MiB, best->pause);
+}
+
+static void reportParameters(size_t k, double pauseTime,
+                             ReplayResult replayBest)
+{
+  double peak = 0.0;
+  size_t c, i;
+
+  printf("\nRecommended parameters (minimising %s, pauses at most"
+         " %g s):\n\n", minimiseMemory ? "peak memory" : "collection time",
+         pauseLimit);
+  for (c = 0; c < chainCount; ++c) {
+    ChainStats chain = &chains[c];
+    Best best = &tunes[c].best[k];
+    if (!best->found)
+      continue;
+    peak += best->result.peak;
+    printf("  mps_gen_param_s gen_params_%lu[] = {\n", (unsigned long)c);
+    for (i = 0; i < chain->genCount; ++i) {
+      double mortality = best->result.condemned[i] > 0.0
+        ? 1.0 - best->result.survived[i] / best->result.condemned[i]
+        : chain->gen[i].mortality;
+      printf("    { %.0f, %.2f },\n", ceil(best->capacity[i] / 1024.0),
+             mortality);
+    }
+    printf("  };\n  res = mps_chain_create(&chain_%lu, arena, %lu,"
+           " gen_params_%lu);\n\n", (unsigned long)c,
+           (unsigned long)chain->genCount, (unsigned long)c);
+  }
+  if (replayBest != NULL)
+    peak += (double)replayBest->peakCommitted;
+  printf("  MPS_ARGS_BEGIN(args) {\n");
+  if (peak > 0.0)
+    printf("    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, %.0f);\n",
+           ceil(peak / MiB) * MiB);
+  printf("    MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, %g);\n", pauseTime);
+  if (replayBest != NULL && replayBest->spareCommitLimit != 0)
+    printf("    MPS_ARGS_ADD(args, MPS_KEY_SPARE_COMMIT_LIMIT, %"
+           PRIuLONGEST");\n",
+           (ulongest_t)(replayBest->spareCommitLimit == 1
+                        ? 0 : replayBest->spareCommitLimit));
+  printf("    res = mps_arena_create_k(&arena, mps_arena_class_vm(), args);\n"
+         "  } MPS_ARGS_END(args);\n");
+  if (replayBest != NULL && replayBest->extendBy != 0)
+    printf("\n  /* in the arguments to mps_pool_create_k for each MVFF pool */\n"
+           "  MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, %"PRIuLONGEST");\n",
+           (ulongest_t)replayBest->extendBy);
+}
+
+
+/* main */
+
+int main(int argc, char *argv[])
+{
+  const char *filename;
+  FILE *input;
+  char *log;
+  size_t size, count, i, c, k, bestK = PAUSES;
+  EventIndex index;
+  CostStruct cost;
+  ReplayResultStruct replayBest;
+  Bool replayed = FALSE;
+  double bestObjective = 0.0;
+
+  filename = parseArgs(argc, argv);
+  if (!filename) {
+    filename = getenv(TELEMETRY_FILENAME_ENVAR);
+    if (!filename)
+      filename = DEFAULT_TELEMETRY_FILENAME;
+  }
+
+  if (strcmp(filename, "-") == 0)
+    input = stdin;
+  else {
+    input = fopen(filename, "rb");
+    if (input == NULL)
+      everror("unable to open \"%s\"", filename);
+  }
+  log = readLog(&size, input);
+  if (input != stdin)
+    (void)fclose(input);
+  index = indexLog(&count, log, size);
+  if (count == 0)
+    everror("Empty log");
+
+  poolTable = tableCreate((Count)1 << 4);
+  bufferTable = tableCreate((Count)1 << 6);
+  firstClock = index[0].clock;
+  for (i = 0; i < count; ++i) {
+    EventUnion eventUnion;
+    indexEvent(&eventUnion, log, index, i);
+    analyse(&eventUnion);
+  }
+
+  costFit(&cost);
+  reportProfile(&cost);
+
+  for (c = 0; c < chainCount; ++c) {
+    Model model = &tunes[c].model;
+    model->cost = &cost;
+    for (k = 0; k < PAUSES; ++k)
+      model->pause[k] = ldexp(pauseLimit, -(int)k);
+    if (chains[c].allocated > 0.0 && chains[c].genCount > 0
+        && traceTicks.count > 0 && cost.condemned > 0.0)
+      search(&tunes[c], &chains[c]);
+    else
+      for (k = 0; k < PAUSES; ++k)
+        tunes[c].best[k].found = FALSE;
+  }
+
+  /* Choose the pause time that gives the best overall objective. */
+  for (k = 0; k < PAUSES; ++k) {
+    double objective = 0.0;
+    Bool feasible = TRUE, any = FALSE;
+    for (c = 0; c < chainCount; ++c) {
+      Best best = &tunes[c].best[k];
+      if (tunes[c].model.allocated == 0.0)
+        continue;
+      if (!best->found) {
+        feasible = FALSE;
+        break;
+      }
+      any = TRUE;
+      objective += minimiseMemory ? best->result.peak : best->time;
+    }
+    if (feasible && any && (bestK == PAUSES || objective < bestObjective)) {
+      bestK = k;
+      bestObjective = objective;
+    }
+  }
+
+  if (bestK == PAUSES) {
+    if (chainCount == 0 || traceTicks.count == 0)
+      printf("No collections of generation chains in log.\n");
+    else
+      printf("No parameters meet the pause constraint of %g s.\n",
+             pauseLimit);
+    bestK = 0;
+  }
+  for (c = 0; c < chainCount; ++c)
+    if (tunes[c].model.allocated > 0.0)
+      reportChain(c, &chains[c], &tunes[c], bestK);
+
+  if (replaySearch)
+    replayed = replayTune(&replayBest, log, index, count);
+
+  reportParameters(bestK, ldexp(pauseLimit, -(int)bestK),
+                   replayed ? &replayBest : NULL);
+
+  free(index);
+  free(log);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -100,6 +100,7 @@ typedef struct object_stepper_data {
   size_t count;                 /* number of non-padding objects found */
   size_t objSize;               /* total size of non-padding objects */
   size_t padSize;               /* total size of padding objects */
+  mps_addr_t klass;             /* class of non-padding objects */
 } object_stepper_data_s, *object_stepper_data_t;
 
 static void object_stepper(mps_addr_t object, mps_fmt_t format,
@@ -134,6 +135,7 @@ static void object_stepper(mps_addr_t object, mps_fmt_t format,
     } else {
       ++ sd->count;
       sd->objSize += size;
+      sd->klass = (mps_addr_t)((mps_word_t *)object)[0];
     }      
 }
 
@@ -156,6 +158,54 @@ static void roots_stepper(mps_addr_t *ref, mps_root_t root, void *p, size_t s)
 }
 
 
+/* histogram_check -- check the histogram of a full collection
+ *
+ * After a full collection, the histogram in the GC message should
+ * count the same objects as a walk of the heap.
+ */
+
+static void histogram_check(mps_arena_t arena, object_stepper_data_t sd)
+{
+    mps_message_t message;
+    size_t i, length, count = 0, objSize = 0;
+    mps_bool_t found = FALSE;
+
+    mps_message_type_enable(arena, mps_message_type_gc());
+    mps_arena_gc_histogram_set(arena, 16);
+    mps_arena_collect(arena);
+    mps_arena_gc_histogram_set(arena, 0);
+
+    sd->count = 0;
+    sd->objSize = 0;
+    sd->padSize = 0;
+    mps_arena_formatted_objects_walk(arena, object_stepper, sd, sizeof *sd);
+
+    while (mps_message_get(&message, arena, mps_message_type_gc())) {
+        found = TRUE;
+        count = 0;
+        objSize = 0;
+        length = mps_message_gc_histogram_length(arena, message);
+        for (i = 0; i < length; ++i) {
+            mps_addr_t klass;
+            size_t n, size;
+            mps_message_gc_histogram_entry(arena, message, i,
+                                           &klass, &n, &size);
+            Insist(klass == sd->klass);
+            count += n;
+            objSize += size;
+        }
+        mps_message_discard(arena, message);
+    }
+    mps_message_type_disable(arena, mps_message_type_gc());
+    Insist(found);
+    printf("histogram: count=%lu size=%lu walk: count=%lu size=%lu\n",
+           (unsigned long)count, (unsigned long)objSize,
+           (unsigned long)sd->count, (unsigned long)sd->objSize);
+    Insist(count == sd->count);
+    Insist(objSize == sd->objSize);
+}
+
+
 /* test -- the body of the test */
 
 static void test(mps_arena_t arena, mps_pool_class_t pool_class)
@@ -241,6 +291,9 @@ static void test(mps_arena_t arena, mps_pool_class_t pool_class)
            (unsigned long)bufferSize);
     Insist(sd->objSize + sd->padSize + bufferSize == allocSize);
 
+    if (pool_class != mps_class_snc())
+        histogram_check(arena, sd);
+
     mps_ap_destroy(ap);
     mps_root_destroy(exactRoot);
     mps_pool_destroy(pool);
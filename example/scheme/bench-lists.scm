@@ -0,0 +1,55 @@
+;;; bench-lists.scm -- list benchmark for the Scheme interpreters
+;;; $Id$
+;;;
+;;; Build lists of pseudo-random numbers, sort them with a merge sort,
+;;; and map, reverse and append them. Almost every operation allocates
+;;; a pair or an integer, and the lists being sorted survive for a
+;;; while, so this measures the cost of medium-lived objects.
+
+(load "r4rs.scm")
+
+(define seed 12345)
+(define (random!)
+  (set! seed (remainder (+ (* seed 1103515245) 12345) 2147483648))
+  seed)
+
+(define (random-list n)
+  (define (loop n list)
+    (if (eqv? n 0) list (loop (- n 1) (cons (random!) list))))
+  (loop n '()))
+
+(define (merge a b)
+  (cond ((null? a) b)
+        ((null? b) a)
+        ((< (car a) (car b)) (cons (car a) (merge (cdr a) b)))
+        (else (cons (car b) (merge a (cdr b))))))
+
+(define (split list)
+  (if (or (null? list) (null? (cdr list)))
+      (cons list '())
+      (let ((rest (split (cddr list))))
+        (cons (cons (car list) (car rest))
+              (cons (cadr list) (cdr rest))))))
+
+(define (sort list)
+  (if (or (null? list) (null? (cdr list)))
+      list
+      (let ((halves (split list)))
+        (merge (sort (car halves)) (sort (cdr halves))))))
+
+(define (sorted? list)
+  (or (null? list) (null? (cdr list))
+      (and (not (< (cadr list) (car list))) (sorted? (cdr list)))))
+
+(define (repeat n thunk)
+  (if (> n 0)
+      (begin (thunk) (repeat (- n 1) thunk))))
+
+(repeat 20
+  (lambda ()
+    (let* ((list (random-list 1000))
+           (sorted (sort list)))
+      (if (not (sorted? sorted))
+          (error "sort failed"))
+      (if (not (eqv? (length (append (reverse sorted) (map - list))) 2000))
+          (error "append failed")))))
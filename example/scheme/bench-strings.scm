@@ -0,0 +1,52 @@
+;;; bench-strings.scm -- string benchmark for the Scheme interpreters
+;;; $Id$
+;;;
+;;; Convert numbers to strings and symbols, build strings by appending
+;;; them, and count them in hashtables. This allocates many leaf
+;;; objects of various sizes (strings, characters and integers), and
+;;; the hashtables hold references to short-lived keys.
+
+(load "r4rs.scm")
+
+(define (repeat n thunk)
+  (if (> n 0)
+      (begin (thunk) (repeat (- n 1) thunk))))
+
+(define (count-strings n)
+  (let ((table (make-hashtable string-hash string=?)))
+    (define (loop i)
+      (if (< i n)
+          (let* ((key (number->string (remainder (* i 7919) 1000)))
+                 (old (hashtable-ref table key 0)))
+            (hashtable-set! table key (+ old 1))
+            (loop (+ i 1)))))
+    (loop 0)
+    table))
+
+(define (count-symbols n)
+  (let ((table (make-eq-hashtable)))
+    (define (loop i)
+      (if (< i n)
+          (let* ((key (string->symbol
+                       (string-append "s" (number->string (remainder i 500)))))
+                 (old (hashtable-ref table key 0)))
+            (hashtable-set! table key (+ old 1))
+            (loop (+ i 1)))))
+    (loop 0)
+    table))
+
+(define (build-string n)
+  (define (loop i s)
+    (if (< i n)
+        (loop (+ i 1) (string-append s (number->string i 16)))
+        s))
+  (loop 0 ""))
+
+(repeat 10
+  (lambda ()
+    (if (not (eqv? (hashtable-size (count-strings 3000)) 1000))
+        (error "string hashtable failed"))
+    (if (not (eqv? (hashtable-size (count-symbols 3000)) 500))
+        (error "symbol hashtable failed"))
+    (if (not (eqv? (string-length (build-string 300)) 628))
+        (error "string-append failed"))))
@@ -0,0 +1,51 @@
+;;; bench-trees.scm -- binary trees benchmark for the Scheme interpreters
+;;; $Id$
+;;;
+;;; After John Ellis and Pete Kovac's GCBench: build and discard many
+;;; binary trees of various depths, top-down and bottom-up, while a
+;;; long-lived tree and a long-lived vector stay alive. This measures
+;;; how the memory manager copes with a mixture of short-lived and
+;;; long-lived objects.
+
+(load "r4rs.scm")
+
+(define (make-tree depth)
+  (if (eqv? depth 0)
+      (cons '() '())
+      (cons (make-tree (- depth 1)) (make-tree (- depth 1)))))
+
+;; Build a tree top-down by mutating its nodes.
+(define (populate! depth node)
+  (if (> depth 0)
+      (begin
+        (set-car! node (cons '() '()))
+        (set-cdr! node (cons '() '()))
+        (populate! (- depth 1) (car node))
+        (populate! (- depth 1) (cdr node)))))
+
+(define (tree-size tree)
+  (if (null? (car tree))
+      1
+      (+ 1 (+ (tree-size (car tree)) (tree-size (cdr tree))))))
+
+(define (repeat n thunk)
+  (if (> n 0)
+      (begin (thunk) (repeat (- n 1) thunk))))
+
+(define long-lived-tree (make-tree 14))
+(define long-lived-vector (make-vector 20000 0))
+(vector-fill! long-lived-vector long-lived-tree)
+
+;; For each depth, build enough trees to allocate about the same
+;; number of nodes.
+(define (time-construction depth)
+  (let ((iterations (quotient 65536 (tree-size (make-tree depth)))))
+    (repeat iterations (lambda () (populate! depth (cons '() '()))))
+    (repeat iterations (lambda () (make-tree depth)))))
+
+(for-each time-construction '(4 6 8 10 12))
+
+(if (not (eqv? (tree-size long-lived-tree) 32767))
+    (error "long-lived tree was damaged"))
+(if (not (eq? (vector-ref long-lived-vector 1000) long-lived-tree))
+    (error "long-lived vector was damaged"))
@@ -379,6 +379,7 @@ static char error_message[MSGMAX+1];
 static mps_arena_t arena;       /* the arena */
 static mps_pool_t obj_pool;     /* pool for ordinary Scheme objects */
 static mps_ap_t obj_ap;         /* allocation point used to allocate objects */
+static int report_pauses = 0;   /* -s option: report pauses on stderr */
 static mps_pool_t leaf_pool;    /* pool for leaf objects */
 static mps_ap_t leaf_ap;        /* allocation point for leaf objects */
 static mps_pool_t buckets_pool; /* pool for hash table buckets */
@@ -4256,6 +4257,13 @@ static void mps_chat(void)
       printf("  Why: %s\n", mps_message_gc_start_why(arena, message));
       printf("  Clock: %lu\n", (unsigned long)mps_message_clock(arena, message));
 
+    } else if (type == mps_message_type_gc() && report_pauses) {
+      /* With the -s option, report the longest pause in each
+         collection, so that the interpreter can be compared with other
+         memory managers. See tool/schemebench. */
+      fprintf(stderr, "pause %g\n",
+              mps_message_gc_max_pause(arena, message));
+
     } else if (type == mps_message_type_gc()) {
       size_t live = mps_message_gc_live_size(arena, message);
       size_t condemned = mps_message_gc_condemned_size(arena, message);
@@ -4454,7 +4462,7 @@ int main(int argc, char *argv[])
   void *marker = &marker;
   int ch;
   
-  while ((ch = getopt(argc, argv, "m:")) != -1)
+  while ((ch = getopt(argc, argv, "m:s")) != -1)
     switch (ch) {
     case 'm': {
         char *p;
@@ -4470,12 +4478,17 @@ int main(int argc, char *argv[])
         }
       }
       break;
+    case 's':
+      report_pauses = 1;
+      break;
     default:
       fprintf(stderr,
               "Usage: %s [option...] [file...]\n"
               "Options:\n"
               "  -m n, --arena-size=n[KMG]?\n"
-              "    Initial size of arena (default %lu).\n",
+              "    Initial size of arena (default %lu).\n"
+              "  -s\n"
+              "    Print the longest pause in each collection on exit.\n",
               argv[0],
               (unsigned long)arenasize);
       return EXIT_FAILURE;
@@ -4587,12 +4600,16 @@ int main(int argc, char *argv[])
 
   /* Make sure we can pick up finalization messages. */
   mps_message_type_enable(arena, mps_message_type_finalization());
+  if (report_pauses)
+    mps_message_type_enable(arena, mps_message_type_gc());
 
   /* Call the main program. A function call is required here so that
      'marker' reliably points into the stack below any potential roots
      in the main thread. See the section "Thread roots" in
      topic/root. */
   exit_code = start(argc, argv);
+  if (report_pauses)
+    mps_chat();
   
   /* Cleaning up the MPS object with destroy methods will allow the MPS to
      check final consistency and warn you about bugs.  It also allows the